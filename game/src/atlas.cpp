@@ -0,0 +1,126 @@
+#include "atlas.h"
+
+#include <cstring>
+#include <util/assert.h>
+#include <util/rect_packer.h>
+
+namespace {
+
+// Images are packed with a border of transparent pixels around them, so
+// filtering never picks up pixels from their neighbours.
+constexpr uint32_t atlas_padding = 1;
+constexpr uint32_t blank_size = 3;
+
+uint16_t toTextureCoordinate(uint32_t pixel, uint32_t size)
+{
+    return uint16_t((uint64_t(pixel) * 65535 + size / 2) / size);
+}
+
+Sprite makeSprite(uint16_t texture,
+                  uint32_t x,
+                  uint32_t y,
+                  uint32_t width,
+                  uint32_t height,
+                  uint32_t size)
+{
+    return Sprite{
+        texture,
+        toTextureCoordinate(x, size),
+        toTextureCoordinate(y, size),
+        toTextureCoordinate(x + width, size),
+        toTextureCoordinate(y + height, size)
+    };
+}
+
+void copyImage(uint32_t* pixels,
+               uint32_t size,
+               uint32_t x,
+               uint32_t y,
+               const Image& image)
+{
+    for (uint32_t row = 0; row < image.height; row++)
+    {
+        memcpy(pixels + (y + row) * size + x,
+               image.pixels + row * image.width,
+               image.width * sizeof(uint32_t));
+    }
+}
+
+}
+
+bool buildAtlas(uint32_t size,
+                const Image* images,
+                int32_t imageCount,
+                Sprite* sprites)
+{
+    ASSERT(size > 0);
+    ASSERT(imageCount >= 0);
+    ASSERT(imageCount == 0 || (images != nullptr && sprites != nullptr));
+
+    // Where each image goes, with the blank sprite last.
+    uint32_t* positions = new uint32_t[(imageCount + 1) * 2];
+    SkylineNode* nodes = new SkylineNode[size];
+    RectPacker packer = makeRectPacker(size, size, nodes, size);
+
+    bool packed = true;
+    for (int32_t index = 0; index <= imageCount && packed; index++)
+    {
+        const uint32_t width =
+            index < imageCount ? images[index].width : blank_size;
+        const uint32_t height =
+            index < imageCount ? images[index].height : blank_size;
+        ASSERT(width > 0 && height > 0);
+
+        packed = packRect(
+            packer,
+            width + atlas_padding * 2,
+            height + atlas_padding * 2,
+            positions[index * 2],
+            positions[index * 2 + 1]);
+    }
+    delete[] nodes;
+
+    if (!packed) {
+        delete[] positions;
+        return false;
+    }
+
+    uint32_t* pixels = new uint32_t[size * size]();
+    for (int32_t index = 0; index < imageCount; index++)
+    {
+        copyImage(pixels,
+                  size,
+                  positions[index * 2] + atlas_padding,
+                  positions[index * 2 + 1] + atlas_padding,
+                  images[index]);
+    }
+    const uint32_t blankX = positions[imageCount * 2] + atlas_padding;
+    const uint32_t blankY = positions[imageCount * 2 + 1] + atlas_padding;
+    for (uint32_t row = 0; row < blank_size; row++)
+    {
+        for (uint32_t column = 0; column < blank_size; column++)
+        {
+            pixels[(blankY + row) * size + blankX + column] = 0xFFFFFFFF;
+        }
+    }
+
+    const uint16_t texture = createTexture(size, size, pixels);
+    delete[] pixels;
+
+    for (int32_t index = 0; index < imageCount; index++)
+    {
+        sprites[index] = makeSprite(
+            texture,
+            positions[index * 2] + atlas_padding,
+            positions[index * 2 + 1] + atlas_padding,
+            images[index].width,
+            images[index].height,
+            size);
+    }
+    // Only the middle pixel of the blank block is used, so sampling right on
+    // its edges still hits white pixels.
+    setBlankSprite(makeSprite(texture, blankX + 1, blankY + 1, 1, 1, size));
+    delete[] positions;
+
+    return true;
+}
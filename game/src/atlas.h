@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "renderer.h"
+
+// RGBA pixels with 8 bits per channel, red in the lowest byte, starting at
+// the top row.
+struct Image
+{
+    uint32_t width;
+    uint32_t height;
+    const uint32_t* pixels;
+};
+
+// Packs the images into a single size by size texture and writes the sprite
+// of each image to sprites. The atlas also gets a solid white sprite that is
+// made the blank sprite of the renderer, so flat colored quads are drawn
+// from the same texture as the sprites. Returns false if the images do not
+// fit.
+bool buildAtlas(uint32_t size,
+                const Image* images,
+                int32_t imageCount,
+                Sprite* sprites);
@@ -0,0 +1,271 @@
+#include "audio.h"
+
+#include <atomic>
+#include <cstdio>
+#include <cstring>
+#include <profiler/profiler.h>
+#include <SDL.h>
+#include <synth/mixer.h>
+#include <synth/oscillator.h>
+#include <util/assert.h>
+#include <util/spsc_queue.h>
+
+namespace {
+
+constexpr size_t event_queue_capacity = 64;
+constexpr int32_t max_sound_count = 32;
+constexpr int32_t waveform_count = 4;
+constexpr float tone_frequency = 400;
+constexpr float tone_amplitude = 0.25f;
+
+struct QueuedEvent
+{
+    SoundEvent event;
+    uint64_t postedCounter;
+};
+
+SDL_AudioDeviceID device;
+uint32_t sampleRate;
+uint32_t bufferSampleCount;
+uint64_t counterFrequency;
+
+SpscQueue<QueuedEvent, event_queue_capacity> events;
+
+Wavetable wavetables[waveform_count];
+
+// Sounds are only added by the game thread. The event queue publishes them to
+// the audio thread before any event can refer to them.
+Sound sounds[max_sound_count];
+int32_t soundCount;
+
+// Only touched by the audio thread once the device is running.
+Oscillator tone;
+Envelope toneEnvelope;
+Mixer mixer;
+uint64_t lastCallbackCounter;
+
+// Written by the audio thread and read by the game thread.
+std::atomic<uint64_t> callbackCount;
+std::atomic<uint64_t> underrunCount;
+std::atomic<uint64_t> lastEventLatency;
+std::atomic<uint64_t> maxEventLatency;
+
+// Only touched by the thread posting events.
+uint64_t droppedEventCount;
+
+const Wavetable& getWavetable(Waveform waveform)
+{
+    Wavetable& wavetable = wavetables[int32_t(waveform)];
+    if (wavetable.sampleRate != sampleRate)
+        initWavetable(wavetable, waveform, sampleRate);
+    return wavetable;
+}
+
+SoundId addSound(int16_t* samples, int32_t sampleCount)
+{
+    ASSERT(soundCount < max_sound_count);
+    sounds[soundCount] = Sound{ samples, sampleCount };
+    return soundCount++;
+}
+
+float counterToMs(uint64_t counter)
+{
+    return counterFrequency != 0 ? float(counter * 1000.0 / counterFrequency) : 0;
+}
+
+void applyEvent(const QueuedEvent& queued, uint64_t now)
+{
+    const uint64_t latency = now - queued.postedCounter;
+    lastEventLatency.store(latency, std::memory_order_relaxed);
+    if (latency > maxEventLatency.load(std::memory_order_relaxed))
+        maxEventLatency.store(latency, std::memory_order_relaxed);
+
+    switch (queued.event.command)
+    {
+        case SoundCommand::StartTone: noteOn(toneEnvelope); break;
+        case SoundCommand::StopTone: noteOff(toneEnvelope); break;
+        case SoundCommand::PlaySound:
+            playSound(mixer,
+                      sounds[queued.event.sound],
+                      queued.event.volume,
+                      queued.event.looping);
+            break;
+        case SoundCommand::StopSound:
+            stopSound(mixer, sounds[queued.event.sound]);
+            break;
+    }
+}
+
+void audioCallback(void*, Uint8* stream, int length)
+{
+    PROFILE_THREAD("audio");
+    PROFILE_SCOPE("audio");
+
+    const uint64_t now = SDL_GetPerformanceCounter();
+    if (lastCallbackCounter != 0) {
+        const uint64_t expected =
+            (uint64_t(bufferSampleCount) * counterFrequency) / sampleRate;
+        if (now - lastCallbackCounter > 2 * expected)
+            underrunCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    lastCallbackCounter = now;
+    callbackCount.fetch_add(1, std::memory_order_relaxed);
+
+    QueuedEvent queued;
+    while (tryPop(events, queued))
+    {
+        applyEvent(queued, now);
+    }
+
+    int16_t* samples = reinterpret_cast<int16_t*>(stream);
+    const int sampleCount = length / int(sizeof(int16_t));
+    if (isActive(toneEnvelope)) {
+        renderTone(tone, toneEnvelope, samples, sampleCount);
+    } else {
+        for (int i = 0; i < sampleCount; i++)
+        {
+            samples[i] = 0;
+        }
+    }
+
+    mixVoices(mixer, samples, sampleCount);
+}
+
+}
+
+bool initAudio(uint32_t requestedSampleRate, uint32_t requestedBufferSampleCount)
+{
+    ASSERT(device == 0);
+    ASSERT(requestedBufferSampleCount > 0);
+    ASSERT((requestedBufferSampleCount & (requestedBufferSampleCount - 1)) == 0);
+
+    SDL_AudioSpec inputSpec, outputSpec;
+    inputSpec.freq = requestedSampleRate;
+    inputSpec.format = AUDIO_S16;
+    inputSpec.channels = 1;
+    inputSpec.samples = requestedBufferSampleCount;
+    inputSpec.callback = audioCallback;
+    inputSpec.userdata = nullptr;
+
+    device = SDL_OpenAudioDevice(
+        nullptr,
+        false,
+        &inputSpec,
+        &outputSpec,
+        SDL_AUDIO_ALLOW_FREQUENCY_CHANGE | SDL_AUDIO_ALLOW_SAMPLES_CHANGE);
+    if (device == 0) {
+        // TODO: Logging.
+        fprintf(stderr, "Opening audio device failed: %s\n", SDL_GetError());
+        return false;
+    }
+
+    sampleRate = outputSpec.freq;
+    bufferSampleCount = outputSpec.samples;
+    counterFrequency = SDL_GetPerformanceFrequency();
+
+    // The device starts out paused, so the audio thread is not running yet.
+    tone = makeOscillator(
+        getWavetable(Waveform::Triangle),
+        tone_frequency,
+        tone_amplitude);
+    toneEnvelope = makeEnvelope(0.01f, 0, 1, 0.05f, sampleRate);
+    mixer = makeMixer();
+
+    SDL_PauseAudioDevice(device, false);
+    return true;
+}
+
+void destroyAudio()
+{
+    SDL_CloseAudioDevice(device);
+    device = 0;
+
+    for (int32_t sound = 0; sound < soundCount; sound++)
+    {
+        delete[] sounds[sound].samples;
+    }
+    soundCount = 0;
+}
+
+SoundId loadSound(const char* path)
+{
+    ASSERT(device != 0);
+    ASSERT(path != nullptr);
+
+    SDL_AudioSpec spec;
+    Uint8* buffer;
+    Uint32 length;
+    if (SDL_LoadWAV(path, &spec, &buffer, &length) == nullptr) {
+        // TODO: Logging.
+        fprintf(stderr, "Loading sound %s failed: %s\n", path, SDL_GetError());
+        return -1;
+    }
+
+    SDL_AudioCVT conversion;
+    if (SDL_BuildAudioCVT(&conversion,
+                          spec.format,
+                          spec.channels,
+                          spec.freq,
+                          AUDIO_S16,
+                          1,
+                          sampleRate) < 0) {
+        // TODO: Logging.
+        fprintf(stderr, "Converting sound %s failed: %s\n", path, SDL_GetError());
+        SDL_FreeWAV(buffer);
+        return -1;
+    }
+
+    conversion.len = length;
+    conversion.buf = new Uint8[length * conversion.len_mult];
+    memcpy(conversion.buf, buffer, length);
+    SDL_FreeWAV(buffer);
+    SDL_ConvertAudio(&conversion);
+
+    const int32_t sampleCount = conversion.len_cvt / sizeof(int16_t);
+    int16_t* samples = new int16_t[sampleCount];
+    memcpy(samples, conversion.buf, sampleCount * sizeof(int16_t));
+    delete[] conversion.buf;
+
+    return addSound(samples, sampleCount);
+}
+
+SoundId createToneSound(Waveform waveform, float frequency, float seconds)
+{
+    ASSERT(device != 0);
+    ASSERT(seconds > 0);
+
+    const int32_t sampleCount = int32_t(seconds * sampleRate);
+    int16_t* samples = new int16_t[sampleCount];
+    Oscillator oscillator =
+        makeOscillator(getWavetable(waveform), frequency, tone_amplitude);
+    Envelope envelope = makeEnvelope(0.005f, seconds, 0, 0, sampleRate);
+    noteOn(envelope);
+    renderTone(oscillator, envelope, samples, sampleCount);
+
+    return addSound(samples, sampleCount);
+}
+
+void postSoundEvent(const SoundEvent& event)
+{
+    ASSERT(event.command == SoundCommand::StartTone ||
+           event.command == SoundCommand::StopTone ||
+           (event.sound >= 0 && event.sound < soundCount));
+
+    const QueuedEvent queued = QueuedEvent{ event, SDL_GetPerformanceCounter() };
+    if (!tryPush(events, queued))
+        droppedEventCount++;
+}
+
+AudioStats getAudioStats()
+{
+    return AudioStats{
+        sampleRate,
+        bufferSampleCount,
+        callbackCount.load(std::memory_order_relaxed),
+        underrunCount.load(std::memory_order_relaxed),
+        droppedEventCount,
+        sampleRate != 0 ? bufferSampleCount * 1000.0f / sampleRate : 0,
+        counterToMs(lastEventLatency.load(std::memory_order_relaxed)),
+        counterToMs(maxEventLatency.load(std::memory_order_relaxed))
+    };
+}
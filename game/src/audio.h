@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+#include <synth/wavetable.h>
+
+// Identifies a sound in the sound cache.
+using SoundId = int32_t;
+
+enum class SoundCommand : uint8_t
+{
+    StartTone,
+    StopTone,
+    PlaySound,
+    StopSound
+};
+
+struct SoundEvent
+{
+    SoundCommand command;
+    SoundId sound;
+    float volume;
+    bool looping;
+};
+
+struct AudioStats
+{
+    uint32_t sampleRate;
+    uint32_t bufferSampleCount;
+    uint64_t callbackCount;
+    // Callbacks that arrived more than two buffer periods after the previous
+    // one, which means the device ran dry in between.
+    uint64_t underrunCount;
+    // Events that could not be posted because the queue was full.
+    uint64_t droppedEventCount;
+    // Time the device buffer adds between synthesis and playback.
+    float bufferLatencyMs;
+    // Time from posting an event until the audio thread picked it up.
+    float lastEventLatencyMs;
+    float maxEventLatencyMs;
+};
+
+// Opens the default audio device with the given buffer size and starts
+// synthesizing on the audio thread. Returns false if no device could be
+// opened.
+bool initAudio(uint32_t sampleRate, uint32_t bufferSampleCount);
+void destroyAudio();
+
+// Loads a WAV file into the sound cache, converting it to the format of the
+// device so that it can be mixed as is. Returns -1 if the file could not be
+// loaded.
+SoundId loadSound(const char* path);
+
+// Renders a short tone with the synthesizer into the sound cache.
+SoundId createToneSound(Waveform waveform, float frequency, float seconds);
+
+// Hands an event to the audio thread without locking or allocating. Must only
+// be called from a single thread.
+void postSoundEvent(const SoundEvent& event);
+
+AudioStats getAudioStats();
@@ -0,0 +1,149 @@
+#include "font.h"
+
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+// Rows from top to bottom, with the leftmost pixel in bit 4.
+constexpr uint8_t glyph_rows[font_glyph_count][glyph_height] = {
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00 }, // ' '
+    { 0x04, 0x04, 0x04, 0x04, 0x04, 0x00, 0x04 }, // '!'
+    {},                                           // '"'
+    {},                                           // '#'
+    {},                                           // '$'
+    {},                                           // '%'
+    {},                                           // '&'
+    {},                                           // '''
+    { 0x02, 0x04, 0x08, 0x08, 0x08, 0x04, 0x02 }, // '('
+    { 0x08, 0x04, 0x02, 0x02, 0x02, 0x04, 0x08 }, // ')'
+    {},                                           // '*'
+    { 0x00, 0x04, 0x04, 0x1F, 0x04, 0x04, 0x00 }, // '+'
+    { 0x00, 0x00, 0x00, 0x00, 0x0C, 0x04, 0x08 }, // ','
+    { 0x00, 0x00, 0x00, 0x1F, 0x00, 0x00, 0x00 }, // '-'
+    { 0x00, 0x00, 0x00, 0x00, 0x00, 0x0C, 0x0C }, // '.'
+    { 0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x00 }, // '/'
+    { 0x0E, 0x11, 0x13, 0x15, 0x19, 0x11, 0x0E }, // '0'
+    { 0x04, 0x0C, 0x04, 0x04, 0x04, 0x04, 0x0E }, // '1'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x08, 0x1F }, // '2'
+    { 0x1F, 0x02, 0x04, 0x02, 0x01, 0x11, 0x0E }, // '3'
+    { 0x02, 0x06, 0x0A, 0x12, 0x1F, 0x02, 0x02 }, // '4'
+    { 0x1F, 0x10, 0x1E, 0x01, 0x01, 0x11, 0x0E }, // '5'
+    { 0x06, 0x08, 0x10, 0x1E, 0x11, 0x11, 0x0E }, // '6'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x08, 0x08 }, // '7'
+    { 0x0E, 0x11, 0x11, 0x0E, 0x11, 0x11, 0x0E }, // '8'
+    { 0x0E, 0x11, 0x11, 0x0F, 0x01, 0x02, 0x0C }, // '9'
+    { 0x00, 0x0C, 0x0C, 0x00, 0x0C, 0x0C, 0x00 }, // ':'
+    {},                                           // ';'
+    {},                                           // '<'
+    {},                                           // '='
+    {},                                           // '>'
+    { 0x0E, 0x11, 0x01, 0x02, 0x04, 0x00, 0x04 }, // '?'
+    {},                                           // '@'
+    { 0x0E, 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11 }, // 'A'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x11, 0x11, 0x1E }, // 'B'
+    { 0x0E, 0x11, 0x10, 0x10, 0x10, 0x11, 0x0E }, // 'C'
+    { 0x1C, 0x12, 0x11, 0x11, 0x11, 0x12, 0x1C }, // 'D'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x1F }, // 'E'
+    { 0x1F, 0x10, 0x10, 0x1E, 0x10, 0x10, 0x10 }, // 'F'
+    { 0x0E, 0x11, 0x10, 0x17, 0x11, 0x11, 0x0F }, // 'G'
+    { 0x11, 0x11, 0x11, 0x1F, 0x11, 0x11, 0x11 }, // 'H'
+    { 0x0E, 0x04, 0x04, 0x04, 0x04, 0x04, 0x0E }, // 'I'
+    { 0x07, 0x02, 0x02, 0x02, 0x02, 0x12, 0x0C }, // 'J'
+    { 0x11, 0x12, 0x14, 0x18, 0x14, 0x12, 0x11 }, // 'K'
+    { 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x1F }, // 'L'
+    { 0x11, 0x1B, 0x15, 0x15, 0x11, 0x11, 0x11 }, // 'M'
+    { 0x11, 0x11, 0x19, 0x15, 0x13, 0x11, 0x11 }, // 'N'
+    { 0x0E, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // 'O'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x10, 0x10, 0x10 }, // 'P'
+    { 0x0E, 0x11, 0x11, 0x11, 0x15, 0x12, 0x0D }, // 'Q'
+    { 0x1E, 0x11, 0x11, 0x1E, 0x14, 0x12, 0x11 }, // 'R'
+    { 0x0F, 0x10, 0x10, 0x0E, 0x01, 0x01, 0x1E }, // 'S'
+    { 0x1F, 0x04, 0x04, 0x04, 0x04, 0x04, 0x04 }, // 'T'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x11, 0x0E }, // 'U'
+    { 0x11, 0x11, 0x11, 0x11, 0x11, 0x0A, 0x04 }, // 'V'
+    { 0x11, 0x11, 0x11, 0x15, 0x15, 0x15, 0x0A }, // 'W'
+    { 0x11, 0x11, 0x0A, 0x04, 0x0A, 0x11, 0x11 }, // 'X'
+    { 0x11, 0x11, 0x11, 0x0A, 0x04, 0x04, 0x04 }, // 'Y'
+    { 0x1F, 0x01, 0x02, 0x04, 0x08, 0x10, 0x1F }  // 'Z'
+};
+
+// Returns the glyph for the character, or -1 if it is drawn as a space.
+int32_t getGlyph(char character)
+{
+    if (character >= 'a' && character <= 'z')
+        character = character - 'a' + 'A';
+    if (character <= font_first_char || character > font_last_char)
+        return -1;
+    return character - font_first_char;
+}
+
+}
+
+void makeFontImages(uint32_t* pixels, Image* images)
+{
+    ASSERT(pixels != nullptr);
+    ASSERT(images != nullptr);
+
+    for (int32_t glyph = 0; glyph < font_glyph_count; glyph++)
+    {
+        uint32_t* glyphPixels = pixels + glyph * glyph_width * glyph_height;
+        for (int32_t row = 0; row < glyph_height; row++)
+        {
+            for (int32_t column = 0; column < glyph_width; column++)
+            {
+                const bool set =
+                    (glyph_rows[glyph][row] >> (glyph_width - 1 - column)) & 1;
+                glyphPixels[row * glyph_width + column] =
+                    set ? 0xFFFFFFFF : 0x00FFFFFF;
+            }
+        }
+        images[glyph] = Image{ glyph_width, glyph_height, glyphPixels };
+    }
+}
+
+Font makeFont(const Sprite* glyphs)
+{
+    ASSERT(glyphs != nullptr);
+
+    Font font;
+    memcpy(font.glyphs, glyphs, sizeof(font.glyphs));
+    return font;
+}
+
+void drawText(const Font& font,
+              const char* text,
+              float x,
+              float y,
+              float scale,
+              const Color& color,
+              const DrawOrder& order)
+{
+    ASSERT(text != nullptr);
+    ASSERT(scale > 0);
+
+    for (; *text != '\0'; text++, x += glyph_advance * scale)
+    {
+        const int32_t glyph = getGlyph(*text);
+        if (glyph == -1)
+            continue;
+
+        drawSprite(x,
+                   y,
+                   glyph_width * scale,
+                   glyph_height * scale,
+                   font.glyphs[glyph],
+                   color,
+                   order);
+    }
+}
+
+float getTextWidth(const char* text, float scale)
+{
+    ASSERT(text != nullptr);
+
+    const size_t length = strlen(text);
+    if (length == 0)
+        return 0;
+    return (length * glyph_advance - 1) * scale;
+}
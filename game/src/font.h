@@ -0,0 +1,44 @@
+#pragma once
+
+#include <cstdint>
+
+#include "atlas.h"
+#include "color.h"
+#include "renderer.h"
+
+constexpr char font_first_char = ' ';
+constexpr char font_last_char = 'Z';
+constexpr int32_t font_glyph_count = font_last_char - font_first_char + 1;
+constexpr int32_t glyph_width = 5;
+constexpr int32_t glyph_height = 7;
+// Glyphs are one pixel apart.
+constexpr int32_t glyph_advance = glyph_width + 1;
+constexpr int32_t font_pixel_count =
+    font_glyph_count * glyph_width * glyph_height;
+
+// A fixed width bitmap font with upper case letters, digits and the most
+// common punctuation built in.
+struct Font
+{
+    Sprite glyphs[font_glyph_count];
+};
+
+// Renders the glyphs into pixels, which must hold font_pixel_count pixels,
+// and writes an image for each to images, for packing into an atlas.
+void makeFontImages(uint32_t* pixels, Image* images);
+
+// Makes a font from the sprites of the images made by makeFontImages.
+Font makeFont(const Sprite* glyphs);
+
+// Draws the text with its top left corner at x, y, scaling each pixel of the
+// glyphs to scale pixels. Lower case letters are drawn as upper case ones
+// and characters without a glyph as spaces.
+void drawText(const Font& font,
+              const char* text,
+              float x,
+              float y,
+              float scale,
+              const Color& color,
+              const DrawOrder& order);
+
+float getTextWidth(const char* text, float scale);
@@ -0,0 +1,58 @@
+#include "frame_graph.h"
+
+#include <simulation/game.h>
+
+namespace {
+
+constexpr float bar_width = 2;
+constexpr float pixels_per_ms = 3;
+constexpr float max_bar_ms = 33.3f;
+
+constexpr Color cpu_color = Color{ 0.2f, 0.8f, 0.2f };
+constexpr Color gpu_color = Color{ 1, 0.5f, 0 };
+constexpr Color marker_color = Color{ 1, 1, 1 };
+
+void drawBar(float x,
+             float y,
+             float ms,
+             float width,
+             const Color& color,
+             const DrawOrder& order)
+{
+    const float clamped = ms < max_bar_ms ? ms : max_bar_ms;
+    const float height = clamped * pixels_per_ms;
+    if (height <= 0)
+        return;
+
+    drawQuad(x, y - height, width, height, color, order);
+}
+
+}
+
+void addFrameGraphSample(FrameGraph& graph, float cpuMs, float gpuMs)
+{
+    graph.cpuMs[graph.next] = cpuMs;
+    graph.gpuMs[graph.next] = gpuMs;
+    graph.next = (graph.next + 1) % frame_graph_sample_count;
+}
+
+void drawFrameGraph(const FrameGraph& graph,
+                    float x,
+                    float y,
+                    const DrawOrder& order)
+{
+    for (int32_t sample = 0; sample < frame_graph_sample_count; sample++)
+    {
+        const int32_t index = (graph.next + sample) % frame_graph_sample_count;
+        const float barX = x + sample * bar_width;
+        drawBar(barX, y, graph.cpuMs[index], bar_width, cpu_color, order);
+        drawBar(barX, y, graph.gpuMs[index], bar_width / 2, gpu_color, order);
+    }
+
+    drawQuad(x,
+             y - (1000.0f / tick_rate) * pixels_per_ms,
+             frame_graph_sample_count * bar_width,
+             1,
+             marker_color,
+             order);
+}
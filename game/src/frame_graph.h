@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstdint>
+
+#include "renderer.h"
+
+constexpr int32_t frame_graph_sample_count = 120;
+
+// The CPU and GPU times of the last frames, drawn as bars.
+struct FrameGraph
+{
+    float cpuMs[frame_graph_sample_count];
+    float gpuMs[frame_graph_sample_count];
+    int32_t next;
+};
+
+void addFrameGraphSample(FrameGraph& graph, float cpuMs, float gpuMs);
+
+// Draws the graph with its bottom left corner at x, y, oldest frame first.
+// The marker line is at the length of a tick.
+void drawFrameGraph(const FrameGraph& graph,
+                    float x,
+                    float y,
+                    const DrawOrder& order);
@@ -0,0 +1,95 @@
+#include "frame_profiler.h"
+
+#if defined(PROFILER_ENABLED)
+
+#include <cstdio>
+#include <profiler/profiler.h>
+
+namespace {
+
+// Enough for a few minutes of play.
+constexpr size_t max_trace_event_count = 1 << 18;
+
+constexpr float graph_left = 10;
+constexpr float graph_bottom = 470;
+constexpr DrawOrder graph_order = DrawOrder{ 255, 0 };
+
+}
+
+void initFrameProfiler(FrameProfiler& profiler, const char* tracePath)
+{
+    profiler = FrameProfiler{};
+    profiler.tracePath = tracePath;
+
+    // Without a trace the events are only drained from the thread buffers.
+    initProfiler(tracePath != nullptr ? max_trace_event_count : 0);
+    PROFILE_THREAD("main");
+}
+
+void initGpuProfile(FrameProfiler& profiler)
+{
+    profiler.gpuTimer = makeGpuTimer();
+}
+
+void destroyFrameProfiler(FrameProfiler& profiler)
+{
+    collectProfileEvents();
+    if (profiler.tracePath != nullptr) {
+        if (writeChromeTrace(profiler.tracePath))
+            printf("Wrote trace to %s\n", profiler.tracePath);
+        if (const uint64_t dropped = getDroppedProfileEventCount(); dropped > 0)
+            printf("Dropped %llu profile events\n", (unsigned long long)dropped);
+    }
+    destroyProfiler();
+    destroyGpuTimer(profiler.gpuTimer);
+}
+
+void beginFrameProfile(FrameProfiler& profiler)
+{
+    profiler.frameBegin = getProfileTime();
+}
+
+void beginGpuProfile(FrameProfiler& profiler)
+{
+    beginGpuTimer(profiler.gpuTimer);
+}
+
+void endGpuProfile(FrameProfiler& profiler)
+{
+    endGpuTimer(profiler.gpuTimer);
+}
+
+void drawFrameProfile(const FrameProfiler& profiler)
+{
+    if (profiler.showGraph)
+        drawFrameGraph(profiler.graph, graph_left, graph_bottom, graph_order);
+}
+
+void endFrameProfile(FrameProfiler& profiler)
+{
+    const uint64_t frameEnd = getProfileTime();
+    recordProfileZone("frame", profiler.frameBegin, frameEnd);
+
+    const RenderStats stats = getRenderStats();
+    PROFILE_COUNTER("quads", stats.quadCount);
+    PROFILE_COUNTER("draw calls", stats.drawCallCount);
+    PROFILE_COUNTER("state changes", stats.stateChangeCount);
+    PROFILE_COUNTER("upload bytes", stats.uploadByteCount);
+
+    const int64_t gpuTime = profiler.gpuTimer.lastTime;
+    if (gpuTime >= 0)
+        PROFILE_COUNTER("gpu us", gpuTime / 1000);
+
+    addFrameGraphSample(
+        profiler.graph,
+        (frameEnd - profiler.frameBegin) / 1e6f,
+        gpuTime >= 0 ? gpuTime / 1e6f : 0);
+    collectProfileEvents();
+}
+
+void toggleFrameGraph(FrameProfiler& profiler)
+{
+    profiler.showGraph = !profiler.showGraph;
+}
+
+#endif
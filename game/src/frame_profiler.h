@@ -0,0 +1,54 @@
+#pragma once
+
+#include <cstdint>
+
+#include "frame_graph.h"
+#include "gpu_timer.h"
+#include "renderer.h"
+
+// Profiles the frames of the main loop. Everything compiles to nothing
+// unless the profiler is enabled with the ENABLE_PROFILER build option.
+struct FrameProfiler
+{
+    GpuTimer gpuTimer;
+    FrameGraph graph;
+    bool showGraph;
+    // Where to write a Chrome trace of the run to, or null.
+    const char* tracePath;
+    uint64_t frameBegin;
+};
+
+#if defined(PROFILER_ENABLED)
+
+// Needs no GL context, so that it can be started before anything else.
+void initFrameProfiler(FrameProfiler& profiler, const char* tracePath);
+// Needs a current GL context.
+void initGpuProfile(FrameProfiler& profiler);
+// Writes the trace if one was requested.
+void destroyFrameProfiler(FrameProfiler& profiler);
+
+void beginFrameProfile(FrameProfiler& profiler);
+// Brackets the GL commands of the frame for the GPU timer.
+void beginGpuProfile(FrameProfiler& profiler);
+void endGpuProfile(FrameProfiler& profiler);
+// Draws the frame time graph when it is shown.
+void drawFrameProfile(const FrameProfiler& profiler);
+// Ends the work of the frame, which is before it is presented, since that
+// waits for the display.
+void endFrameProfile(FrameProfiler& profiler);
+
+void toggleFrameGraph(FrameProfiler& profiler);
+
+#else
+
+inline void initFrameProfiler(FrameProfiler&, const char*) {}
+inline void initGpuProfile(FrameProfiler&) {}
+inline void destroyFrameProfiler(FrameProfiler&) {}
+inline void beginFrameProfile(FrameProfiler&) {}
+inline void beginGpuProfile(FrameProfiler&) {}
+inline void endGpuProfile(FrameProfiler&) {}
+inline void drawFrameProfile(const FrameProfiler&) {}
+inline void endFrameProfile(FrameProfiler&) {}
+inline void toggleFrameGraph(FrameProfiler&) {}
+
+#endif
@@ -0,0 +1,592 @@
+#include <cstdio>
+#include <cstdlib>
+#include <glad/glad.h>
+#include <util/assert.h>
+#include <util/list_view.h>
+
+#include "gl_debug.h"
+#include "matrix.h"
+#include "program_cache.h"
+#include "quad_queue.h"
+#include "render_backend.h"
+#include "stream_buffer.h"
+
+namespace {
+
+constexpr int32_t position_index = 0;
+constexpr int32_t color_index = 1;
+constexpr int32_t size_index = 2;
+constexpr int32_t uv_index = 3;
+
+constexpr const char* indexed_vertex_shader =
+    "#version 400 core\n"
+    "layout(location=0) in vec4 in_position;\n"
+    "layout(location=1) in vec3 in_color;\n"
+    "layout(location=3) in vec2 in_uv;\n"
+    "uniform mat4 u_projection;\n"
+    "out vec4 vert_color;\n"
+    "out vec2 vert_uv;\n"
+    "void main() {\n"
+    "  gl_Position = u_projection * in_position;\n"
+    "  vert_color = vec4(in_color, 1);\n"
+    "  vert_uv = in_uv;\n"
+    "}\n";
+
+// Expands each instance into a triangle strip over the corners (0, 0),
+// (1, 0), (0, 1) and (1, 1).
+constexpr const char* instanced_vertex_shader =
+    "#version 400 core\n"
+    "layout(location=0) in vec2 in_position;\n"
+    "layout(location=1) in vec4 in_color;\n"
+    "layout(location=2) in vec2 in_size;\n"
+    "layout(location=3) in vec4 in_uv;\n"
+    "uniform mat4 u_projection;\n"
+    "out vec4 vert_color;\n"
+    "out vec2 vert_uv;\n"
+    "void main() {\n"
+    "  vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "  gl_Position = u_projection * vec4(in_position + corner * in_size, 0, 1);\n"
+    "  vert_color = in_color;\n"
+    "  vert_uv = mix(in_uv.xy, in_uv.zw, corner);\n"
+    "}\n";
+
+constexpr const char* fragment_shader =
+    "#version 400 core\n"
+    "in vec4 vert_color;\n"
+    "in vec2 vert_uv;\n"
+    "uniform sampler2D u_texture;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "  frag_color = vert_color * texture(u_texture, vert_uv);\n"
+    "}\n";
+
+uint32_t createVertexArray()
+{
+    uint32_t vao;
+    GL_ASSERT(glGenVertexArrays(1, &vao));
+    GL_ASSERT(glBindVertexArray(vao));
+
+    return vao;
+}
+
+// Points the vertex attributes at the quad vertices starting at offset in the
+// bound vertex buffer.
+void setVertexAttributes(size_t offset)
+{
+    GL_ASSERT(glEnableVertexAttribArray(position_index));
+    GL_ASSERT(glVertexAttribPointer(
+        position_index,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(Vertex),
+        (void*)offset));
+
+    GL_ASSERT(glEnableVertexAttribArray(color_index));
+    GL_ASSERT(glVertexAttribPointer(
+        color_index,
+        3,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(Vertex),
+        (void*)(offset + offsetof(Vertex, color))));
+
+    GL_ASSERT(glEnableVertexAttribArray(uv_index));
+    GL_ASSERT(glVertexAttribPointer(
+        uv_index,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(Vertex),
+        (void*)(offset + offsetof(Vertex, uv))));
+}
+
+// Points the vertex attributes at the quad instances starting at offset in the
+// bound vertex buffer.
+void setInstanceAttributes(size_t offset)
+{
+    GL_ASSERT(glEnableVertexAttribArray(position_index));
+    GL_ASSERT(glVertexAttribPointer(
+        position_index,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(QuadInstance),
+        (void*)offset));
+    GL_ASSERT(glVertexAttribDivisor(position_index, 1));
+
+    GL_ASSERT(glEnableVertexAttribArray(size_index));
+    GL_ASSERT(glVertexAttribPointer(
+        size_index,
+        2,
+        GL_FLOAT,
+        GL_FALSE,
+        sizeof(QuadInstance),
+        (void*)(offset + offsetof(QuadInstance, size))));
+    GL_ASSERT(glVertexAttribDivisor(size_index, 1));
+
+    GL_ASSERT(glEnableVertexAttribArray(color_index));
+    GL_ASSERT(glVertexAttribPointer(
+        color_index,
+        4,
+        GL_UNSIGNED_BYTE,
+        GL_TRUE,
+        sizeof(QuadInstance),
+        (void*)(offset + offsetof(QuadInstance, color))));
+    GL_ASSERT(glVertexAttribDivisor(color_index, 1));
+
+    GL_ASSERT(glEnableVertexAttribArray(uv_index));
+    GL_ASSERT(glVertexAttribPointer(
+        uv_index,
+        4,
+        GL_UNSIGNED_SHORT,
+        GL_TRUE,
+        sizeof(QuadInstance),
+        (void*)(offset + offsetof(QuadInstance, uvs))));
+    GL_ASSERT(glVertexAttribDivisor(uv_index, 1));
+}
+
+uint32_t createIndexBuffer(uint32_t maxSpriteCount)
+{
+    uint32_t ibo;
+    GL_ASSERT(glGenBuffers(1, &ibo));
+    GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo));
+
+    // Only needed until it is uploaded.
+    ListView<uint32_t> indices =
+        makeListView<uint32_t>(getFrameArena(), maxSpriteCount * 6);
+    for (uint32_t index = 0; index < maxSpriteCount; index++)
+    {
+        add(indices, (index * 4) + 0);
+        add(indices, (index * 4) + 1);
+        add(indices, (index * 4) + 2);
+        add(indices, (index * 4) + 0);
+        add(indices, (index * 4) + 2);
+        add(indices, (index * 4) + 3);
+    }
+    GL_ASSERT(glBufferData(
+        GL_ELEMENT_ARRAY_BUFFER,
+        indices.count * sizeof(uint32_t),
+        indices.elems,
+        GL_STATIC_DRAW));
+
+    return ibo;
+}
+
+const char* shaderTypeToString(GLenum shaderType)
+{
+    switch (shaderType)
+    {
+        case GL_VERTEX_SHADER: return "vertex shader";
+        case GL_FRAGMENT_SHADER: return "fragment shader";
+        default: UNREACHABLE("Unknown shader type: %d", shaderType);
+    }
+}
+
+constexpr int32_t message_length = 1024;
+
+uint32_t createShader(GLenum type, const char* source)
+{
+    ASSERT(source != nullptr);
+
+    GL_ASSERT(uint32_t shader = glCreateShader(type));
+    GL_ASSERT(glShaderSource(shader, 1, &source, nullptr));
+    GL_ASSERT(glCompileShader(shader));
+
+    GLint compileStatus;
+    GL_ASSERT(glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus));
+    if (compileStatus != GL_TRUE) {
+        GLsizei logLength = 0;
+        char message[message_length];
+        GL_ASSERT(glGetShaderInfoLog(
+            shader,
+            message_length,
+            &logLength,
+            message));
+        fprintf(
+            stderr,
+            "Compilation of %s failed: %s\n",
+            shaderTypeToString(type),
+            message);
+        abort();
+    }
+    
+    return shader;
+}
+
+uint32_t createShaderProgram(const char* vertexShaderSource,
+                             const char* fragmentShaderSource,
+                             bool retrievable)
+{
+    GL_ASSERT(uint32_t program = glCreateProgram());
+    if (retrievable) {
+        GL_ASSERT(glProgramParameteri(
+            program,
+            GL_PROGRAM_BINARY_RETRIEVABLE_HINT,
+            GL_TRUE));
+    }
+
+    uint32_t vertexShader =
+        createShader(GL_VERTEX_SHADER, vertexShaderSource);
+    uint32_t fragmentShader =
+        createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
+    GL_ASSERT(glAttachShader(program, vertexShader));
+    GL_ASSERT(glAttachShader(program, fragmentShader));
+    GL_ASSERT(glLinkProgram(program));
+
+    GLint linkStatus;
+    GL_ASSERT(glGetProgramiv(program, GL_LINK_STATUS, &linkStatus));
+    if (linkStatus != GL_TRUE) {
+        GLsizei logLength = 0;
+        char message[message_length];
+        GL_ASSERT(glGetProgramInfoLog(
+            program,
+            message_length,
+            &logLength,
+            message));
+        fprintf(stderr, "Linking of shader program failed: %s\n", message);
+        abort();
+    }
+    GL_ASSERT(glUseProgram(program));
+
+    GL_ASSERT(glDeleteShader(vertexShader));
+    GL_ASSERT(glDeleteShader(fragmentShader));
+
+    return program;
+}
+
+// Program binaries are core since OpenGL 4.1, the context asks for 4.0 but
+// drivers hand out the newest version they have.
+bool areProgramBinariesSupported()
+{
+    if (!GLAD_GL_VERSION_4_1)
+        return false;
+    GLint formatCount = 0;
+    GL_ASSERT(glGetIntegerv(GL_NUM_PROGRAM_BINARY_FORMATS, &formatCount));
+    return formatCount > 0;
+}
+
+// Returns 0 if the driver rejects the binary, which it may do for any
+// reason, the key only rules out the obvious ones.
+uint32_t loadProgramBinary(const ProgramBinary& binary)
+{
+    GL_ASSERT(uint32_t program = glCreateProgram());
+    GL_ASSERT(glProgramBinary(
+        program,
+        binary.format,
+        binary.bytes,
+        GLsizei(binary.size)));
+    GLint linkStatus;
+    GL_ASSERT(glGetProgramiv(program, GL_LINK_STATUS, &linkStatus));
+    if (linkStatus != GL_TRUE) {
+        GL_ASSERT(glDeleteProgram(program));
+        return 0;
+    }
+    GL_ASSERT(glUseProgram(program));
+    return program;
+}
+
+void saveProgramBinary(uint32_t program, const char* path, uint64_t key)
+{
+    GLint size = 0;
+    GL_ASSERT(glGetProgramiv(program, GL_PROGRAM_BINARY_LENGTH, &size));
+    if (size <= 0)
+        return;
+
+    ProgramBinary binary = { 0, uint32_t(size), new uint8_t[size] };
+    GLenum format;
+    GL_ASSERT(glGetProgramBinary(program, size, nullptr, &format, binary.bytes));
+    binary.format = format;
+    if (!writeProgramCache(path, key, binary)) {
+        // TODO: Logging.
+        fprintf(stderr, "Shader program cache %s could not be written\n", path);
+    }
+    destroyProgramBinary(binary);
+}
+
+// Loads the program from the cache directory if it was linked by the same
+// driver from the same sources before, and links it and caches it otherwise.
+uint32_t loadShaderProgram(const char* name,
+                           const char* vertexShaderSource,
+                           const char* fragmentShaderSource,
+                           const char* cacheDirectory)
+{
+    if (cacheDirectory == nullptr || !areProgramBinariesSupported())
+        return createShaderProgram(vertexShaderSource, fragmentShaderSource, false);
+
+    char path[4096];
+    snprintf(path, sizeof(path), "%s/%s.program", cacheDirectory, name);
+    GL_ASSERT(const GLubyte* vendor = glGetString(GL_VENDOR));
+    GL_ASSERT(const GLubyte* renderer = glGetString(GL_RENDERER));
+    GL_ASSERT(const GLubyte* version = glGetString(GL_VERSION));
+    const char* const keyStrings[] = {
+        reinterpret_cast<const char*>(vendor),
+        reinterpret_cast<const char*>(renderer),
+        reinterpret_cast<const char*>(version),
+        vertexShaderSource,
+        fragmentShaderSource
+    };
+    const uint64_t key = hashProgramKey(keyStrings, 5);
+
+    ProgramBinary binary;
+    if (readProgramCache(path, key, binary)) {
+        const uint32_t program = loadProgramBinary(binary);
+        destroyProgramBinary(binary);
+        if (program != 0)
+            return program;
+    }
+
+    const uint32_t program =
+        createShaderProgram(vertexShaderSource, fragmentShaderSource, true);
+    saveProgramBinary(program, path, key);
+    return program;
+}
+
+QuadMode quadMode;
+
+uint32_t vao;
+StreamBuffer vbo;
+// Where the quads of the frame are in the vertex buffer, if any were written.
+size_t vboOffset;
+bool quadsWritten;
+uint32_t ibo;
+uint32_t programs[shader_count];
+ListView<uint32_t> textures;
+
+struct LayerBuffer
+{
+    uint32_t buffer;
+    uint32_t quadCount;
+    // The quads of the layer as the renderer keeps them.
+    const uint8_t* quads;
+};
+
+ListView<LayerBuffer> layers;
+
+void drawBuffer(uint32_t buffer, size_t offset, uint32_t first, uint32_t count)
+{
+    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, buffer));
+    switch (quadMode)
+    {
+        case QuadMode::Instanced:
+            setInstanceAttributes(offset + first * sizeof(QuadInstance));
+            GL_ASSERT(glDrawArraysInstanced(
+                GL_TRIANGLE_STRIP,
+                0,
+                4,
+                count));
+            break;
+        case QuadMode::Indexed:
+            setVertexAttributes(offset);
+            GL_ASSERT(glDrawElements(
+                GL_TRIANGLES,
+                count * 6,
+                GL_UNSIGNED_INT,
+                (void*)(first * 6 * sizeof(uint32_t))));
+            break;
+    }
+}
+
+void init(uint32_t maxQuadCount,
+          uint32_t windowWidth,
+          uint32_t windowHeight,
+          QuadMode mode,
+          StreamBufferMode streamMode,
+          const char* programCacheDirectory)
+{
+    quadMode = mode;
+    vao = createVertexArray();
+    switch (mode)
+    {
+        case QuadMode::Instanced:
+            vbo = makeStreamBuffer(
+                maxQuadCount * sizeof(QuadInstance),
+                streamMode);
+            programs[color_shader] = loadShaderProgram(
+                "instanced",
+                instanced_vertex_shader,
+                fragment_shader,
+                programCacheDirectory);
+            break;
+        case QuadMode::Indexed:
+            vbo = makeStreamBuffer(maxQuadCount * sizeof(Quad), streamMode);
+            ibo = createIndexBuffer(maxQuadCount);
+            programs[color_shader] = loadShaderProgram(
+                "indexed",
+                indexed_vertex_shader,
+                fragment_shader,
+                programCacheDirectory);
+            break;
+    }
+    layers = makeListView(
+        max_quad_layer_count,
+        new LayerBuffer[max_quad_layer_count]);
+    textures = makeListView(max_texture_count, new uint32_t[max_texture_count]);
+
+    GL_ASSERT(glEnable(GL_BLEND));
+    GL_ASSERT(glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA));
+    GL_ASSERT(glActiveTexture(GL_TEXTURE0));
+
+    const Matrix projection =
+        makeOrthogonalProjectionMatrix(0, windowWidth, 0, windowHeight, -1, 1);
+    for (uint32_t program : programs)
+    {
+        GL_ASSERT(glUseProgram(program));
+        GL_ASSERT(int32_t location =
+            glGetUniformLocation(program, "u_projection"));
+        ASSERT(location != -1);
+        GL_ASSERT(glUniformMatrix4fv(location, 1, GL_FALSE, projection.elems));
+        GL_ASSERT(int32_t textureLocation =
+            glGetUniformLocation(program, "u_texture"));
+        ASSERT(textureLocation != -1);
+        GL_ASSERT(glUniform1i(textureLocation, 0));
+    }
+    GL_CHECK_ERRORS();
+}
+
+void destroy()
+{
+    for (size_t index = 0; index < layers.count; index++)
+    {
+        GL_ASSERT(glDeleteBuffers(1, &layers[index].buffer));
+    }
+    delete[] layers.elems;
+    layers = ListView<LayerBuffer>{};
+
+    GL_ASSERT(glDeleteTextures(textures.count, textures.elems));
+    delete[] textures.elems;
+    textures = ListView<uint32_t>{};
+
+    for (uint32_t& program : programs)
+    {
+        GL_ASSERT(glDeleteProgram(program));
+        program = 0;
+    }
+    GL_ASSERT(glDeleteBuffers(1, &ibo));
+    destroyStreamBuffer(vbo);
+    GL_ASSERT(glDeleteVertexArrays(1, &vao));
+
+    vao = 0;
+    ibo = 0;
+    GL_CHECK_ERRORS();
+}
+
+void createTexture(uint32_t width, uint32_t height, const uint32_t* pixels)
+{
+    uint32_t texture;
+    GL_ASSERT(glGenTextures(1, &texture));
+    GL_ASSERT(glBindTexture(GL_TEXTURE_2D, texture));
+    GL_ASSERT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST));
+    GL_ASSERT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST));
+    GL_ASSERT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE));
+    GL_ASSERT(glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE));
+    GL_ASSERT(glTexImage2D(
+        GL_TEXTURE_2D,
+        0,
+        GL_RGBA8,
+        width,
+        height,
+        0,
+        GL_RGBA,
+        GL_UNSIGNED_BYTE,
+        pixels));
+
+    GL_CHECK_ERRORS();
+
+    add(textures, texture);
+}
+
+void createLayer(const uint8_t* quads, uint32_t quadCount)
+{
+    LayerBuffer layer = LayerBuffer{ 0, quadCount, quads };
+    GL_ASSERT(glGenBuffers(1, &layer.buffer));
+    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, layer.buffer));
+    GL_ASSERT(glBufferData(
+        GL_ARRAY_BUFFER,
+        quadCount * getQuadSize(quadMode),
+        quads,
+        GL_DYNAMIC_DRAW));
+    GL_CHECK_ERRORS();
+
+    add(layers, layer);
+}
+
+void updateLayer(QuadLayer layer, uint32_t first, uint32_t end)
+{
+    const LayerBuffer& layerBuffer = layers[layer];
+    const size_t quadSize = getQuadSize(quadMode);
+    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, layerBuffer.buffer));
+    GL_ASSERT(glBufferSubData(
+        GL_ARRAY_BUFFER,
+        first * quadSize,
+        (end - first) * quadSize,
+        layerBuffer.quads + first * quadSize));
+}
+
+void beginFrame()
+{
+    GL_ASSERT(glClear(GL_COLOR_BUFFER_BIT));
+}
+
+void* beginQuadWrite()
+{
+    return beginStreamWrite(vbo);
+}
+
+void endQuadWrite()
+{
+    vboOffset = endStreamWrite(vbo);
+    quadsWritten = true;
+}
+
+void setShader(uint8_t shader)
+{
+    GL_ASSERT(glUseProgram(programs[shader]));
+}
+
+void setTexture(uint16_t texture)
+{
+    GL_ASSERT(glBindTexture(GL_TEXTURE_2D, textures[texture]));
+}
+
+void drawQuads(uint32_t first, uint32_t count)
+{
+    drawBuffer(vbo.buffer, vboOffset, first, count);
+}
+
+void drawLayer(QuadLayer layer)
+{
+    const LayerBuffer& layerBuffer = layers[layer];
+    drawBuffer(layerBuffer.buffer, 0, 0, layerBuffer.quadCount);
+}
+
+void endFrame()
+{
+    if (quadsWritten) {
+        fenceStreamRegion(vbo);
+        quadsWritten = false;
+    }
+    GL_CHECK_ERRORS();
+}
+
+}
+
+const RenderBackendFunctions& getGlBackend()
+{
+    static const RenderBackendFunctions functions = {
+        init,
+        destroy,
+        createTexture,
+        createLayer,
+        updateLayer,
+        beginFrame,
+        beginQuadWrite,
+        endQuadWrite,
+        setShader,
+        setTexture,
+        drawQuads,
+        drawLayer,
+        endFrame
+    };
+    return functions;
+}
@@ -0,0 +1,210 @@
+#include "gl_debug.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <util/assert.h>
+
+#if defined(GL_DIAGNOSTICS)
+
+namespace {
+
+// The calls listed when errors are found by checkGlErrors.
+constexpr int32_t call_site_count = 16;
+
+struct CallSite
+{
+    const char* file;
+    int32_t line;
+    const char* call;
+};
+
+CallSite callSites[call_site_count];
+uint32_t callSiteCount;
+bool callbackInstalled;
+
+const CallSite& getLastCallSite()
+{
+    return callSites[(callSiteCount - 1) % call_site_count];
+}
+
+GLenum toGlSeverity(GlSeverity severity)
+{
+    switch (severity)
+    {
+        case GlSeverity::Notification: return GL_DEBUG_SEVERITY_NOTIFICATION;
+        case GlSeverity::Low: return GL_DEBUG_SEVERITY_LOW;
+        case GlSeverity::Medium: return GL_DEBUG_SEVERITY_MEDIUM;
+        case GlSeverity::High: return GL_DEBUG_SEVERITY_HIGH;
+        default: UNREACHABLE("Unknown severity: %d", int32_t(severity));
+    }
+}
+
+const char* getSeverityName(GLenum severity)
+{
+    switch (severity)
+    {
+        case GL_DEBUG_SEVERITY_NOTIFICATION: return "notification";
+        case GL_DEBUG_SEVERITY_LOW: return "low";
+        case GL_DEBUG_SEVERITY_MEDIUM: return "medium";
+        case GL_DEBUG_SEVERITY_HIGH: return "high";
+        default: return "unknown";
+    }
+}
+
+const char* getTypeName(GLenum type)
+{
+    switch (type)
+    {
+        case GL_DEBUG_TYPE_ERROR: return "error";
+        case GL_DEBUG_TYPE_DEPRECATED_BEHAVIOR: return "deprecated behavior";
+        case GL_DEBUG_TYPE_UNDEFINED_BEHAVIOR: return "undefined behavior";
+        case GL_DEBUG_TYPE_PORTABILITY: return "portability";
+        case GL_DEBUG_TYPE_PERFORMANCE: return "performance";
+        case GL_DEBUG_TYPE_MARKER: return "marker";
+        default: return "other";
+    }
+}
+
+void APIENTRY handleDebugMessage(GLenum,
+                                 GLenum type,
+                                 GLuint id,
+                                 GLenum severity,
+                                 GLsizei,
+                                 const GLchar* message,
+                                 const void*)
+{
+    // Output is synchronous, so the message belongs to the last call made.
+    if (callSiteCount > 0) {
+        const CallSite& site = getLastCallSite();
+        fprintf(stderr,
+                "[GL %s, %s] %s:%d: \"%s\" (%u: %s)\n",
+                getTypeName(type),
+                getSeverityName(severity),
+                site.file,
+                site.line,
+                site.call,
+                id,
+                message);
+    } else {
+        fprintf(stderr,
+                "[GL %s, %s] (%u: %s)\n",
+                getTypeName(type),
+                getSeverityName(severity),
+                id,
+                message);
+    }
+
+    if (type == GL_DEBUG_TYPE_ERROR)
+        abort();
+}
+
+}
+
+#endif
+
+void initGlDiagnostics(GlSeverity minSeverity)
+{
+#if defined(GL_DIAGNOSTICS)
+    GLint flags = 0;
+    glGetIntegerv(GL_CONTEXT_FLAGS, &flags);
+    if (glDebugMessageCallback == nullptr ||
+        glDebugMessageControl == nullptr ||
+        !(flags & GL_CONTEXT_FLAG_DEBUG_BIT)) {
+        fprintf(stderr, "No GL debug output, checking errors in batches\n");
+        return;
+    }
+
+    glEnable(GL_DEBUG_OUTPUT);
+    glEnable(GL_DEBUG_OUTPUT_SYNCHRONOUS);
+    glDebugMessageCallback(handleDebugMessage, nullptr);
+
+    // Severities are enabled from the highest down to the minimum, so the
+    // driver does not even produce the messages that are filtered out.
+    const GlSeverity severities[] = {
+        GlSeverity::High,
+        GlSeverity::Medium,
+        GlSeverity::Low,
+        GlSeverity::Notification
+    };
+    for (GlSeverity severity : severities)
+    {
+        glDebugMessageControl(
+            GL_DONT_CARE,
+            GL_DONT_CARE,
+            toGlSeverity(severity),
+            0,
+            nullptr,
+            severity >= minSeverity ? GL_TRUE : GL_FALSE);
+    }
+    callbackInstalled = true;
+#else
+    (void)minSeverity;
+#endif
+}
+
+const char* getGlErrorMessage(GLenum error)
+{
+    switch (error)
+    {
+        case GL_NO_ERROR:
+            return "No error";
+        case GL_INVALID_ENUM:
+            return "Invalid enum";
+        case GL_INVALID_VALUE:
+            return "Invalid value";
+        case GL_INVALID_OPERATION:
+            return "Invalid operation";
+        case GL_INVALID_FRAMEBUFFER_OPERATION:
+            return "Invalid framebuffer operation";
+        case GL_OUT_OF_MEMORY:
+            return "Out of memory";
+        case GL_STACK_UNDERFLOW:
+            return "Stack underflow";
+        case GL_STACK_OVERFLOW:
+            return "Stack overflow";
+        default:
+            UNREACHABLE("Unknown OpenGL error: %d", error);
+    }
+}
+
+#if defined(GL_DIAGNOSTICS)
+
+void setGlCallSite(const char* file, int32_t line, const char* call)
+{
+    callSites[callSiteCount % call_site_count] = CallSite{ file, line, call };
+    callSiteCount++;
+}
+
+void checkGlErrors(const char* file, int32_t line)
+{
+    if (callbackInstalled)
+        return;
+
+    GLenum error = glGetError();
+    if (error == GL_NO_ERROR) {
+        callSiteCount = 0;
+        return;
+    }
+
+    for (; error != GL_NO_ERROR; error = glGetError())
+    {
+        fprintf(stderr,
+                "[GL_CHECK_ERRORS] %s:%d: %s\n",
+                file,
+                line,
+                getGlErrorMessage(error));
+    }
+
+    // Any of the calls since the last check may have failed.
+    const uint32_t count =
+        callSiteCount < call_site_count ? callSiteCount : call_site_count;
+    fprintf(stderr, "Last %u GL calls, most recent last:\n", count);
+    for (uint32_t index = callSiteCount - count; index < callSiteCount; index++)
+    {
+        const CallSite& site = callSites[index % call_site_count];
+        fprintf(stderr, "  %s:%d: \"%s\"\n", site.file, site.line, site.call);
+    }
+    abort();
+}
+
+#endif
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <cstdint>
+#include <glad/glad.h>
+
+// GL calls are only checked when GL_DIAGNOSTICS is defined, which the build
+// does for Debug builds. Otherwise GL_ASSERT is just the statement and
+// GL_CHECK_ERRORS nothing, so no calls to the driver are added.
+
+enum class GlSeverity : uint8_t
+{
+    Notification,
+    Low,
+    Medium,
+    High
+};
+
+// Installs a debug message callback if the context supports one, reporting
+// messages of at least minSeverity and aborting on errors. Without one, GL
+// errors are collected with glGetError at every GL_CHECK_ERRORS instead.
+void initGlDiagnostics(GlSeverity minSeverity);
+
+const char* getGlErrorMessage(GLenum error);
+
+#if defined(GL_DIAGNOSTICS)
+
+// Remembers the GL call about to be made, so messages can be traced back to
+// it. This does not call into the driver.
+void setGlCallSite(const char* file, int32_t line, const char* call);
+
+// Aborts if GL reported errors since the last check, listing the calls made
+// in between. Does nothing when the debug message callback is installed,
+// which reports errors as they happen.
+void checkGlErrors(const char* file, int32_t line);
+
+#define GL_ASSERT(stmt) \
+    setGlCallSite(__FILE__, __LINE__, #stmt); \
+    stmt
+
+#define GL_CHECK_ERRORS() checkGlErrors(__FILE__, __LINE__)
+
+#else
+
+#define GL_ASSERT(stmt) stmt
+
+#define GL_CHECK_ERRORS()
+
+#endif
@@ -0,0 +1,73 @@
+#include "gpu_timer.h"
+
+#include <glad/glad.h>
+
+#include "gl_debug.h"
+
+namespace {
+
+// Reads the result of the query if it is available.
+void pollQuery(GpuTimer& timer, int32_t query)
+{
+    if (!timer.pending[query])
+        return;
+
+    GLint available = GL_FALSE;
+    GL_ASSERT(glGetQueryObjectiv(
+        timer.queries[query],
+        GL_QUERY_RESULT_AVAILABLE,
+        &available));
+    if (available != GL_TRUE)
+        return;
+
+    GLuint64 time = 0;
+    GL_ASSERT(glGetQueryObjectui64v(
+        timer.queries[query],
+        GL_QUERY_RESULT,
+        &time));
+    timer.pending[query] = false;
+    timer.lastTime = int64_t(time);
+}
+
+}
+
+GpuTimer makeGpuTimer()
+{
+    GpuTimer timer = {};
+    GL_ASSERT(glGenQueries(gpu_timer_query_count, timer.queries));
+    timer.lastTime = -1;
+    GL_CHECK_ERRORS();
+    return timer;
+}
+
+void destroyGpuTimer(GpuTimer& timer)
+{
+    GL_ASSERT(glDeleteQueries(gpu_timer_query_count, timer.queries));
+    timer = GpuTimer{};
+}
+
+void beginGpuTimer(GpuTimer& timer)
+{
+    for (int32_t query = 0; query < gpu_timer_query_count; query++)
+    {
+        pollQuery(timer, query);
+    }
+
+    const int32_t next = (timer.current + 1) % gpu_timer_query_count;
+    if (timer.pending[next])
+        return;
+
+    timer.current = next;
+    GL_ASSERT(glBeginQuery(GL_TIME_ELAPSED, timer.queries[next]));
+    timer.running = true;
+}
+
+void endGpuTimer(GpuTimer& timer)
+{
+    if (!timer.running)
+        return;
+
+    GL_ASSERT(glEndQuery(GL_TIME_ELAPSED));
+    timer.pending[timer.current] = true;
+    timer.running = false;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr int32_t gpu_timer_query_count = 2;
+
+// Measures how long the GPU takes for the commands of a frame with
+// GL_TIME_ELAPSED queries. The queries are double buffered and results are
+// only read once they are available, so measuring never stalls the CPU.
+struct GpuTimer
+{
+    uint32_t queries[gpu_timer_query_count];
+    bool pending[gpu_timer_query_count];
+    int32_t current;
+    bool running;
+    // Nanoseconds of the most recent frame that finished, or -1 if none did.
+    int64_t lastTime;
+};
+
+GpuTimer makeGpuTimer();
+void destroyGpuTimer(GpuTimer& timer);
+
+// Frames are skipped when the query from two frames ago is not done yet.
+void beginGpuTimer(GpuTimer& timer);
+void endGpuTimer(GpuTimer& timer);
@@ -12,3 +12,23 @@ Matrix makeMatrix(float e11, float e12, float e13, float e14,
         e14, e24, e34, e44
     };
 }
+
+Matrix makeOrthogonalProjectionMatrix(float left,
+                                      float right,
+                                      float top,
+                                      float bottom,
+                                      float near,
+                                      float far)
+{
+    const float scaleX = 2 / (right - left);
+    const float scaleY = 2 / (top - bottom);
+    const float scaleZ = 2 / (near - far);
+    const float translateX = (left + right) / (left - right);
+    const float translateY = (bottom + top) / (bottom - top);
+    const float translateZ = (near + far) / (near - far);
+    return makeMatrix(
+        scaleX, 0,      0,      translateX,
+        0,      scaleY, 0,      translateY,
+        0,      0,      scaleZ, translateZ,
+        0,      0,      0,      1);
+}
@@ -0,0 +1,372 @@
+#include "particles.h"
+
+#include <util/assert.h>
+
+#include "quad_queue.h"
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define PARTICLES_X86 1
+#if defined(__SSE2__)
+#define PARTICLES_SSE2 1
+#endif
+#endif
+
+namespace {
+
+// Arrays are padded to whole AVX registers.
+constexpr uint32_t particle_lane_count = 8;
+
+using KernelFunction = uint32_t (*)(Particles& particles,
+                                    float seconds,
+                                    float gravity);
+
+// For each mask of the lanes that stay alive, the lanes to gather so that
+// they end up packed at the front, in order.
+struct CompactTable
+{
+    int32_t lanes[1 << particle_lane_count][particle_lane_count];
+};
+
+constexpr CompactTable makeCompactTable()
+{
+    CompactTable table = {};
+    for (uint32_t mask = 0; mask < (1u << particle_lane_count); mask++)
+    {
+        int32_t packed = 0;
+        for (int32_t lane = 0; lane < int32_t(particle_lane_count); lane++)
+        {
+            if (mask & (1u << lane))
+                table.lanes[mask][packed++] = lane;
+        }
+    }
+    return table;
+}
+
+alignas(32) constexpr CompactTable compact_table = makeCompactTable();
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Returns a random number from 0 to 1.
+float nextUnit(uint32_t& state)
+{
+    return float(nextRandom(state) >> 8) / float(1u << 24);
+}
+
+// Updates the particles from first up to end and moves the ones that stay
+// alive to live, which is at most first. Every particle is written whether
+// it lives or not, only the count decides, so there is nothing to mispredict.
+uint32_t updateRange(Particles& particles,
+                     uint32_t first,
+                     uint32_t end,
+                     uint32_t live,
+                     float seconds,
+                     float gravity)
+{
+    const float pull = gravity * seconds;
+    for (uint32_t index = first; index < end; index++)
+    {
+        const float velocityY = particles.velocityY[index] + pull;
+        const float life = particles.life[index] - seconds;
+        particles.x[live] = particles.x[index] + particles.velocityX[index] * seconds;
+        particles.y[live] = particles.y[index] + velocityY * seconds;
+        particles.velocityX[live] = particles.velocityX[index];
+        particles.velocityY[live] = velocityY;
+        particles.life[live] = life;
+        particles.sizePerLife[live] = particles.sizePerLife[index];
+        particles.colors[live] = particles.colors[index];
+        live += life > 0;
+    }
+    return live;
+}
+
+uint32_t updateScalar(Particles& particles, float seconds, float gravity)
+{
+    return updateRange(particles, 0, particles.count, 0, seconds, gravity);
+}
+
+#if defined(PARTICLES_SSE2)
+
+// SSE2 has no shuffle by a vector of lanes, so the lanes are only moved
+// into place one at a time.
+uint32_t updateSse2(Particles& particles, float seconds, float gravity)
+{
+    const __m128 times = _mm_set1_ps(seconds);
+    const __m128 pulls = _mm_set1_ps(gravity * seconds);
+
+    uint32_t live = 0;
+    uint32_t index = 0;
+    for (; index + 4 <= particles.count; index += 4)
+    {
+        const __m128 velocityX = _mm_loadu_ps(particles.velocityX + index);
+        const __m128 velocityY = _mm_add_ps(_mm_loadu_ps(particles.velocityY + index), pulls);
+        const __m128 life = _mm_sub_ps(_mm_loadu_ps(particles.life + index), times);
+        alignas(16) float x[4];
+        alignas(16) float y[4];
+        alignas(16) float velocityXs[4];
+        alignas(16) float velocityYs[4];
+        alignas(16) float lives[4];
+        _mm_store_ps(x, _mm_add_ps(_mm_loadu_ps(particles.x + index), _mm_mul_ps(velocityX, times)));
+        _mm_store_ps(y, _mm_add_ps(_mm_loadu_ps(particles.y + index), _mm_mul_ps(velocityY, times)));
+        _mm_store_ps(velocityXs, velocityX);
+        _mm_store_ps(velocityYs, velocityY);
+        _mm_store_ps(lives, life);
+        const int32_t mask = _mm_movemask_ps(_mm_cmpgt_ps(life, _mm_setzero_ps()));
+
+        for (uint32_t lane = 0; lane < 4; lane++)
+        {
+            particles.x[live] = x[lane];
+            particles.y[live] = y[lane];
+            particles.velocityX[live] = velocityXs[lane];
+            particles.velocityY[live] = velocityYs[lane];
+            particles.life[live] = lives[lane];
+            particles.sizePerLife[live] = particles.sizePerLife[index + lane];
+            particles.colors[live] = particles.colors[index + lane];
+            live += (mask >> lane) & 1;
+        }
+    }
+    return updateRange(particles, index, particles.count, live, seconds, gravity);
+}
+
+#endif
+
+#if defined(PARTICLES_X86)
+
+// The live lanes of a register are packed to the front with a single
+// gather across lanes. The whole register is stored, the lanes past the
+// live ones are overwritten by the next one.
+__attribute__((target("avx2")))
+uint32_t updateAvx2(Particles& particles, float seconds, float gravity)
+{
+    const __m256 times = _mm256_set1_ps(seconds);
+    const __m256 pulls = _mm256_set1_ps(gravity * seconds);
+
+    uint32_t live = 0;
+    uint32_t index = 0;
+    for (; index + particle_lane_count <= particles.count; index += particle_lane_count)
+    {
+        const __m256 velocityX = _mm256_loadu_ps(particles.velocityX + index);
+        const __m256 velocityY = _mm256_add_ps(_mm256_loadu_ps(particles.velocityY + index), pulls);
+        const __m256 life = _mm256_sub_ps(_mm256_loadu_ps(particles.life + index), times);
+        const __m256 x = _mm256_add_ps(_mm256_loadu_ps(particles.x + index), _mm256_mul_ps(velocityX, times));
+        const __m256 y = _mm256_add_ps(_mm256_loadu_ps(particles.y + index), _mm256_mul_ps(velocityY, times));
+        const __m256 sizePerLife = _mm256_loadu_ps(particles.sizePerLife + index);
+        const __m256i colors = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(particles.colors + index));
+
+        const int32_t mask = _mm256_movemask_ps(_mm256_cmp_ps(life, _mm256_setzero_ps(), _CMP_GT_OQ));
+        const __m256i lanes = _mm256_load_si256(reinterpret_cast<const __m256i*>(compact_table.lanes[mask]));
+        _mm256_storeu_ps(particles.x + live, _mm256_permutevar8x32_ps(x, lanes));
+        _mm256_storeu_ps(particles.y + live, _mm256_permutevar8x32_ps(y, lanes));
+        _mm256_storeu_ps(particles.velocityX + live, _mm256_permutevar8x32_ps(velocityX, lanes));
+        _mm256_storeu_ps(particles.velocityY + live, _mm256_permutevar8x32_ps(velocityY, lanes));
+        _mm256_storeu_ps(particles.life + live, _mm256_permutevar8x32_ps(life, lanes));
+        _mm256_storeu_ps(particles.sizePerLife + live, _mm256_permutevar8x32_ps(sizePerLife, lanes));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(particles.colors + live),
+                            _mm256_permutevar8x32_epi32(colors, lanes));
+        live += uint32_t(__builtin_popcount(mask));
+    }
+    return updateRange(particles, index, particles.count, live, seconds, gravity);
+}
+
+#endif
+
+KernelFunction getKernelFunction(ParticleKernel kernel)
+{
+    switch (kernel)
+    {
+        case ParticleKernel::Scalar:
+            return updateScalar;
+#if defined(PARTICLES_SSE2)
+        case ParticleKernel::Sse2:
+            return updateSse2;
+#endif
+#if defined(PARTICLES_X86)
+        case ParticleKernel::Avx2:
+            return updateAvx2;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+ParticleKernel detectParticleKernel()
+{
+#if defined(PARTICLES_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        return ParticleKernel::Avx2;
+#endif
+#if defined(PARTICLES_SSE2)
+    return ParticleKernel::Sse2;
+#else
+    return ParticleKernel::Scalar;
+#endif
+}
+
+ParticleKernel activeKernel = detectParticleKernel();
+
+Color unpackColor(uint32_t color)
+{
+    return Color{
+        float(color & 0xFF) / 255,
+        float((color >> 8) & 0xFF) / 255,
+        float((color >> 16) & 0xFF) / 255
+    };
+}
+
+}
+
+bool isParticleKernelSupported(ParticleKernel kernel)
+{
+    switch (kernel)
+    {
+        case ParticleKernel::Scalar:
+            return true;
+        case ParticleKernel::Sse2:
+#if defined(PARTICLES_SSE2)
+            return true;
+#else
+            return false;
+#endif
+        case ParticleKernel::Avx2:
+#if defined(PARTICLES_X86)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* getParticleKernelName(ParticleKernel kernel)
+{
+    switch (kernel)
+    {
+        case ParticleKernel::Scalar: return "scalar";
+        case ParticleKernel::Sse2: return "SSE2";
+        case ParticleKernel::Avx2: return "AVX2";
+    }
+    return "unknown";
+}
+
+ParticleKernel getParticleKernel()
+{
+    return activeKernel;
+}
+
+void setParticleKernel(ParticleKernel kernel)
+{
+    ASSERT(isParticleKernelSupported(kernel));
+    activeKernel = kernel;
+}
+
+void initParticles(Particles& particles, uint32_t capacity)
+{
+    ASSERT(capacity > 0);
+    const uint32_t padded =
+        (capacity + particle_lane_count - 1) / particle_lane_count * particle_lane_count;
+    particles.x = new float[padded];
+    particles.y = new float[padded];
+    particles.velocityX = new float[padded];
+    particles.velocityY = new float[padded];
+    particles.life = new float[padded];
+    particles.sizePerLife = new float[padded];
+    particles.colors = new uint32_t[padded];
+    particles.count = 0;
+    particles.capacity = capacity;
+}
+
+void destroyParticles(Particles& particles)
+{
+    delete[] particles.colors;
+    delete[] particles.sizePerLife;
+    delete[] particles.life;
+    delete[] particles.velocityY;
+    delete[] particles.velocityX;
+    delete[] particles.y;
+    delete[] particles.x;
+    particles = Particles{};
+}
+
+void emitParticles(Particles& particles, const ParticleBurst& burst, uint32_t& random)
+{
+    ASSERT(burst.life > 0);
+    const uint32_t room = particles.capacity - particles.count;
+    const uint32_t count = burst.count < room ? burst.count : room;
+    const uint32_t color = packColor(burst.color);
+    for (uint32_t index = particles.count; index < particles.count + count; index++)
+    {
+        particles.x[index] = burst.x + nextUnit(random) * burst.width;
+        particles.y[index] = burst.y + nextUnit(random) * burst.height;
+        particles.velocityX[index] = (nextUnit(random) * 2 - 1) * burst.speed;
+        particles.velocityY[index] = (nextUnit(random) * 2 - 1) * burst.speed + burst.lift;
+        // Some die early, so the burst thins out instead of vanishing at once.
+        const float life = burst.life * (0.5f + 0.5f * nextUnit(random));
+        particles.life[index] = life;
+        particles.sizePerLife[index] = burst.size / life;
+        particles.colors[index] = color;
+    }
+    particles.count += count;
+}
+
+void updateParticles(Particles& particles, float seconds, float gravity)
+{
+    particles.count = getKernelFunction(activeKernel)(particles, seconds, gravity);
+}
+
+void writeParticleQuads(const Particles& particles,
+                        const Sprite& sprite,
+                        QuadMode mode,
+                        void* quads)
+{
+    switch (mode)
+    {
+        case QuadMode::Instanced:
+        {
+            QuadInstance* instances = static_cast<QuadInstance*>(quads);
+            for (uint32_t index = 0; index < particles.count; index++)
+            {
+                const float size = particles.sizePerLife[index] * particles.life[index];
+                instances[index] = QuadInstance{
+                    Point{ particles.x[index] - size / 2, particles.y[index] - size / 2 },
+                    Vector{ size, size },
+                    { sprite.left, sprite.top, sprite.right, sprite.bottom },
+                    particles.colors[index]
+                };
+            }
+            break;
+        }
+        case QuadMode::Indexed:
+        {
+            Quad* indexed = static_cast<Quad*>(quads);
+            for (uint32_t index = 0; index < particles.count; index++)
+            {
+                const float size = particles.sizePerLife[index] * particles.life[index];
+                indexed[index] = makeQuad(particles.x[index] - size / 2,
+                                          particles.y[index] - size / 2,
+                                          size,
+                                          size,
+                                          sprite,
+                                          unpackColor(particles.colors[index]));
+            }
+            break;
+        }
+    }
+}
+
+void drawParticles(const Particles& particles, const Sprite& sprite, const DrawOrder& order)
+{
+    const uint32_t room = getFreeQuadCount();
+    Particles drawn = particles;
+    drawn.count = particles.count < room ? particles.count : room;
+    if (drawn.count == 0)
+        return;
+
+    writeParticleQuads(drawn, sprite, getQuadMode(), drawQuadRun(drawn.count, sprite.texture, order));
+}
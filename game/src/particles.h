@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdint>
+
+#include "color.h"
+#include "renderer.h"
+
+// The instruction set particles are updated with. Defaults to the widest
+// one supported by the CPU and is only meant to be changed for testing and
+// benchmarking.
+enum class ParticleKernel : uint8_t
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+bool isParticleKernelSupported(ParticleKernel kernel);
+const char* getParticleKernelName(ParticleKernel kernel);
+ParticleKernel getParticleKernel();
+void setParticleKernel(ParticleKernel kernel);
+
+// Short lived quads flying off the board, for effects. Every attribute is an
+// array of its own, so that updating them is straight vector math over
+// whole registers of particles. The particles that are alive are always the
+// first count, in the order they were emitted.
+struct Particles
+{
+    float* x;
+    float* y;
+    float* velocityX;
+    float* velocityY;
+    // The seconds left until the particle is gone.
+    float* life;
+    // The size of the particle is this times its life, so it shrinks away.
+    float* sizePerLife;
+    // RGBA with 8 bits per channel, red in the lowest byte.
+    uint32_t* colors;
+    uint32_t count;
+    uint32_t capacity;
+};
+
+void initParticles(Particles& particles, uint32_t capacity);
+void destroyParticles(Particles& particles);
+
+// Particles emitted at random spots of a rectangle, flying off in random
+// directions.
+struct ParticleBurst
+{
+    float x;
+    float y;
+    float width;
+    float height;
+    float speed;
+    // Added to the random vertical speed, negative is up.
+    float lift;
+    float life;
+    float size;
+    Color color;
+    uint32_t count;
+};
+
+// Particles that do not fit any more are dropped.
+void emitParticles(Particles& particles, const ParticleBurst& burst, uint32_t& random);
+
+// Moves the particles on by the given seconds, pulled down by gravity in
+// pixels per second squared, and removes the ones whose life ran out.
+void updateParticles(Particles& particles, float seconds, float gravity);
+
+// Writes a quad of the sprite for each particle, in the format of the quad
+// mode.
+void writeParticleQuads(const Particles& particles,
+                        const Sprite& sprite,
+                        QuadMode mode,
+                        void* quads);
+
+// Draws as many particles as fit into the frame, as a single run of quads.
+void drawParticles(const Particles& particles, const Sprite& sprite, const DrawOrder& order);
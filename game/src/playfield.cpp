@@ -0,0 +1,61 @@
+#include "playfield.h"
+
+#include <util/assert.h>
+
+Playfield makePlayfield(float left,
+                        float top,
+                        float cellSize,
+                        const Sprite& block,
+                        const Color& color,
+                        const DrawOrder& order)
+{
+    ASSERT(cellSize > 0);
+
+    Playfield playfield = {};
+    playfield.layer = createQuadLayer(
+        board_width * board_visible_height,
+        block.texture,
+        order);
+    playfield.block = block;
+    playfield.color = color;
+    playfield.left = left;
+    playfield.top = top;
+    playfield.cellSize = cellSize;
+    return playfield;
+}
+
+void updatePlayfield(Playfield& playfield, const Board& board)
+{
+    // Quads are laid out row by row from the bottom, so the rows that move
+    // down after a line clear end up as a single range to upload.
+    for (int32_t y = 0; y < board_visible_height; y++)
+    {
+        const uint16_t row = getRow(board, y);
+        const uint16_t changed = row ^ playfield.rows[y];
+        if (changed == 0)
+            continue;
+
+        const float top = playfield.top +
+            (board_visible_height - 1 - y) * playfield.cellSize;
+        for (int32_t x = 0; x < board_width; x++)
+        {
+            if (!((changed >> x) & 1))
+                continue;
+
+            const uint32_t index = y * board_width + x;
+            if ((row >> x) & 1) {
+                setLayerSprite(playfield.layer,
+                               index,
+                               playfield.left + x * playfield.cellSize,
+                               top,
+                               playfield.cellSize,
+                               playfield.cellSize,
+                               playfield.block,
+                               playfield.color);
+            } else {
+                hideLayerQuad(playfield.layer, index);
+            }
+        }
+        playfield.rows[y] = row;
+    }
+}
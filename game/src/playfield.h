@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+#include <board/board.h>
+
+#include "color.h"
+#include "renderer.h"
+
+// The locked cells of a board, kept in a quad layer with one quad per
+// visible cell. Only the cells of rows that changed are touched when it is
+// updated, so a board that did not change costs nothing but the draw.
+struct Playfield
+{
+    QuadLayer layer;
+    Sprite block;
+    Color color;
+    float left;
+    float top;
+    float cellSize;
+    // The rows the layer currently shows.
+    uint16_t rows[board_visible_height];
+};
+
+// Makes an empty playfield with its top left corner at left, top.
+Playfield makePlayfield(float left,
+                        float top,
+                        float cellSize,
+                        const Sprite& block,
+                        const Color& color,
+                        const DrawOrder& order);
+
+void updatePlayfield(Playfield& playfield, const Board& board);
@@ -0,0 +1,169 @@
+#include "program_cache.h"
+
+#include <cstdio>
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+constexpr uint8_t program_cache_magic[4] = { 'T', 'P', 'R', 'G' };
+constexpr uint16_t program_cache_version = 1;
+
+// The magic, the version, the key, the format, the size and a checksum of
+// the bytes that follow.
+constexpr size_t header_size = 32;
+
+constexpr uint64_t fnv_offset_basis = 14695981039346656037ull;
+constexpr uint64_t fnv_prime = 1099511628211ull;
+
+// Drivers hand out binaries of a few hundred kilobytes at most, anything
+// larger is a damaged file.
+constexpr uint32_t max_program_binary_size = 64 << 20;
+
+void putU16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = uint8_t(value);
+    bytes[1] = uint8_t(value >> 8);
+}
+
+void putU32(uint8_t* bytes, uint32_t value)
+{
+    for (int32_t index = 0; index < 4; index++)
+    {
+        bytes[index] = uint8_t(value >> (index * 8));
+    }
+}
+
+void putU64(uint8_t* bytes, uint64_t value)
+{
+    for (int32_t index = 0; index < 8; index++)
+    {
+        bytes[index] = uint8_t(value >> (index * 8));
+    }
+}
+
+uint16_t getU16(const uint8_t* bytes)
+{
+    return uint16_t(bytes[0] | bytes[1] << 8);
+}
+
+uint32_t getU32(const uint8_t* bytes)
+{
+    uint32_t value = 0;
+    for (int32_t index = 0; index < 4; index++)
+    {
+        value |= uint32_t(bytes[index]) << (index * 8);
+    }
+    return value;
+}
+
+uint64_t getU64(const uint8_t* bytes)
+{
+    uint64_t value = 0;
+    for (int32_t index = 0; index < 8; index++)
+    {
+        value |= uint64_t(bytes[index]) << (index * 8);
+    }
+    return value;
+}
+
+uint64_t hashBytes(uint64_t hash, const uint8_t* bytes, size_t size)
+{
+    for (size_t index = 0; index < size; index++)
+    {
+        hash = (hash ^ bytes[index]) * fnv_prime;
+    }
+    return hash;
+}
+
+}
+
+void destroyProgramBinary(ProgramBinary& binary)
+{
+    delete[] binary.bytes;
+    binary = ProgramBinary{};
+}
+
+uint64_t hashProgramKey(const char* const* strings, int32_t count)
+{
+    ASSERT(count >= 0);
+    uint64_t hash = fnv_offset_basis;
+    for (int32_t index = 0; index < count; index++)
+    {
+        ASSERT(strings[index] != nullptr);
+        // The terminator keeps "ab", "c" apart from "a", "bc".
+        hash = hashBytes(hash,
+                         reinterpret_cast<const uint8_t*>(strings[index]),
+                         strlen(strings[index]) + 1);
+    }
+    return hash;
+}
+
+bool readProgramCache(const char* path, uint64_t key, ProgramBinary& binary)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    uint8_t header[header_size];
+    const bool headerValid =
+        fread(header, 1, header_size, file) == header_size &&
+        memcmp(header, program_cache_magic, 4) == 0 &&
+        getU16(header + 4) == program_cache_version &&
+        getU64(header + 8) == key &&
+        getU32(header + 20) > 0 &&
+        getU32(header + 20) <= max_program_binary_size;
+    if (!headerValid) {
+        fclose(file);
+        return false;
+    }
+
+    const uint32_t size = getU32(header + 20);
+    uint8_t* bytes = new uint8_t[size];
+    const bool valid =
+        fread(bytes, 1, size, file) == size &&
+        fgetc(file) == EOF &&
+        hashBytes(fnv_offset_basis, bytes, size) == getU64(header + 24);
+    fclose(file);
+    if (!valid) {
+        delete[] bytes;
+        return false;
+    }
+
+    binary.format = getU32(header + 16);
+    binary.size = size;
+    binary.bytes = bytes;
+    return true;
+}
+
+bool writeProgramCache(const char* path, uint64_t key, const ProgramBinary& binary)
+{
+    ASSERT(binary.size > 0 && binary.bytes != nullptr);
+
+    char temporaryPath[4096];
+    if (snprintf(temporaryPath, sizeof(temporaryPath), "%s.tmp", path) >=
+        int(sizeof(temporaryPath))) {
+        return false;
+    }
+    FILE* file = fopen(temporaryPath, "wb");
+    if (file == nullptr)
+        return false;
+
+    uint8_t header[header_size] = {};
+    memcpy(header, program_cache_magic, 4);
+    putU16(header + 4, program_cache_version);
+    putU64(header + 8, key);
+    putU32(header + 16, binary.format);
+    putU32(header + 20, binary.size);
+    putU64(header + 24, hashBytes(fnv_offset_basis, binary.bytes, binary.size));
+
+    bool written =
+        fwrite(header, 1, header_size, file) == header_size &&
+        fwrite(binary.bytes, 1, binary.size, file) == binary.size;
+    written = fclose(file) == 0 && written;
+    if (!written || rename(temporaryPath, path) != 0) {
+        remove(temporaryPath);
+        return false;
+    }
+    return true;
+}
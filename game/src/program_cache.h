@@ -0,0 +1,30 @@
+#pragma once
+
+#include <cstdint>
+
+// A linked shader program as the driver hands it out. Only the driver that
+// wrote it can load it again, and only as long as nothing about the driver
+// or the shaders changed.
+struct ProgramBinary
+{
+    // The driver specific format of the bytes.
+    uint32_t format;
+    uint32_t size;
+    uint8_t* bytes;
+};
+
+void destroyProgramBinary(ProgramBinary& binary);
+
+// Hashes the strings that a cached program depends on, which are the
+// vendor, renderer and version strings of the driver and the sources of the
+// shaders. A cached program is only loaded again for the same key.
+uint64_t hashProgramKey(const char* const* strings, int32_t count);
+
+// Returns false if the file does not exist, is damaged or was written for
+// another key, in which case the program has to be linked from source.
+bool readProgramCache(const char* path, uint64_t key, ProgramBinary& binary);
+
+// Replaces the file as a whole, so that a run that is cut short never leaves
+// a partly written program behind. Returns false if the file could not be
+// written.
+bool writeProgramCache(const char* path, uint64_t key, const ProgramBinary& binary);
@@ -0,0 +1,308 @@
+#include "quad_queue.h"
+
+#include <cstddef>
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+// Sort key layout, from the most significant bits down: layer, shader,
+// texture and depth. Sorting by it draws layers in order while grouping
+// everything inside a layer that can share a draw call.
+constexpr int32_t layer_shift = 56;
+constexpr int32_t shader_shift = 48;
+constexpr int32_t texture_shift = 32;
+
+// Marks sort items that stand for a whole quad layer or a run of quads
+// instead of a quad.
+constexpr uint32_t layer_command_flag = 0x80000000;
+constexpr uint32_t run_command_flag = 0x40000000;
+constexpr uint32_t command_flags = layer_command_flag | run_command_flag;
+
+uint8_t toColorChannel(float value)
+{
+    return uint8_t(value * 255 + 0.5f);
+}
+
+float toTextureCoordinate(uint16_t value)
+{
+    return value / 65535.0f;
+}
+
+// Adds a batch of the quads from first up to next, if there are any.
+void addQuadBatch(QuadQueue& queue,
+                  uint64_t material,
+                  uint32_t first,
+                  uint32_t next)
+{
+    if (next > first)
+        add(queue.batches, DrawBatch{ material, first, next - first, -1 });
+}
+
+}
+
+uint64_t makeSortKey(uint8_t layer,
+                     uint8_t shader,
+                     uint16_t texture,
+                     uint32_t depth)
+{
+    return uint64_t(layer) << layer_shift |
+           uint64_t(shader) << shader_shift |
+           uint64_t(texture) << texture_shift |
+           depth;
+}
+
+uint8_t getShader(uint64_t key)
+{
+    return uint8_t(key >> shader_shift);
+}
+
+uint16_t getTexture(uint64_t key)
+{
+    return uint16_t(key >> texture_shift);
+}
+
+uint32_t packColor(const Color& color)
+{
+    return uint32_t(toColorChannel(color.r)) |
+           uint32_t(toColorChannel(color.g)) << 8 |
+           uint32_t(toColorChannel(color.b)) << 16 |
+           0xFF000000u;
+}
+
+QuadInstance makeQuadInstance(float x,
+                              float y,
+                              float width,
+                              float height,
+                              const Sprite& sprite,
+                              const Color& color)
+{
+    return QuadInstance{
+        Point{ x, y },
+        Vector{ width, height },
+        { sprite.left, sprite.top, sprite.right, sprite.bottom },
+        packColor(color)
+    };
+}
+
+Quad makeQuad(float x,
+              float y,
+              float width,
+              float height,
+              const Sprite& sprite,
+              const Color& color)
+{
+    const float left = toTextureCoordinate(sprite.left);
+    const float top = toTextureCoordinate(sprite.top);
+    const float right = toTextureCoordinate(sprite.right);
+    const float bottom = toTextureCoordinate(sprite.bottom);
+    return Quad{
+        Vertex{ Point{ x, y }, color, Point{ left, top } },
+        Vertex{ Point{ x, y + height }, color, Point{ left, bottom } },
+        Vertex{ Point{ x + width, y + height }, color, Point{ right, bottom } },
+        Vertex{ Point{ x + width, y }, color, Point{ right, top } }
+    };
+}
+
+size_t getQuadSize(QuadMode mode)
+{
+    return mode == QuadMode::Instanced ? sizeof(QuadInstance) : sizeof(Quad);
+}
+
+size_t getQuadQueueSize(uint32_t maxQuadCount,
+                        uint32_t maxLayerCount,
+                        uint32_t maxRunCount,
+                        QuadMode mode)
+{
+    const size_t maxCommandCount = maxQuadCount + maxLayerCount + maxRunCount;
+    // With room to align each of the lists.
+    return maxQuadCount * getQuadSize(mode) +
+           maxCommandCount * (2 * sizeof(SortItem) + sizeof(DrawBatch)) +
+           maxRunCount * sizeof(QuadRun) +
+           5 * alignof(std::max_align_t);
+}
+
+QuadQueue makeQuadQueue(Arena& arena,
+                        uint32_t maxQuadCount,
+                        uint32_t maxLayerCount,
+                        uint32_t maxRunCount,
+                        QuadMode mode)
+{
+    ASSERT(maxQuadCount > 0);
+
+    QuadQueue queue = {};
+    queue.mode = mode;
+    switch (mode)
+    {
+        case QuadMode::Instanced:
+            queue.instances = makeListView<QuadInstance>(arena, maxQuadCount);
+            break;
+        case QuadMode::Indexed:
+            queue.quads = makeListView<Quad>(arena, maxQuadCount);
+            break;
+    }
+    // Every layer and run takes up a single command.
+    const uint32_t maxCommandCount = maxQuadCount + maxLayerCount + maxRunCount;
+    queue.commands = makeListView<SortItem>(arena, maxCommandCount);
+    queue.sortScratch = allocateArray<SortItem>(arena, maxCommandCount);
+    queue.runs = makeListView<QuadRun>(arena, maxRunCount);
+    queue.batches = makeListView<DrawBatch>(arena, maxCommandCount);
+    return queue;
+}
+
+void clearQuadQueue(QuadQueue& queue)
+{
+    clear(queue.quads);
+    clear(queue.instances);
+    clear(queue.commands);
+    clear(queue.runs);
+    clear(queue.batches);
+}
+
+void pushQuad(QuadQueue& queue,
+              float x,
+              float y,
+              float width,
+              float height,
+              const Sprite& sprite,
+              const Color& color,
+              const DrawOrder& order)
+{
+    const uint64_t key =
+        makeSortKey(order.layer, color_shader, sprite.texture, order.depth);
+    switch (queue.mode)
+    {
+        case QuadMode::Instanced:
+            add(queue.commands, SortItem{ key, uint32_t(queue.instances.count) });
+            add(queue.instances,
+                makeQuadInstance(x, y, width, height, sprite, color));
+            break;
+        case QuadMode::Indexed:
+            add(queue.commands, SortItem{ key, uint32_t(queue.quads.count) });
+            add(queue.quads, makeQuad(x, y, width, height, sprite, color));
+            break;
+    }
+}
+
+void* pushQuadRun(QuadQueue& queue,
+                  uint32_t count,
+                  uint16_t texture,
+                  const DrawOrder& order)
+{
+    ASSERT(count > 0);
+    const uint64_t key = makeSortKey(order.layer, color_shader, texture, order.depth);
+    add(queue.commands, SortItem{ key, uint32_t(queue.runs.count) | run_command_flag });
+    switch (queue.mode)
+    {
+        case QuadMode::Instanced:
+        {
+            ASSERT(count <= queue.instances.capacity - queue.instances.count);
+            add(queue.runs, QuadRun{ uint32_t(queue.instances.count), count });
+            QuadInstance* quads = queue.instances.elems + queue.instances.count;
+            queue.instances.count += count;
+            return quads;
+        }
+        case QuadMode::Indexed:
+        {
+            ASSERT(count <= queue.quads.capacity - queue.quads.count);
+            add(queue.runs, QuadRun{ uint32_t(queue.quads.count), count });
+            Quad* quads = queue.quads.elems + queue.quads.count;
+            queue.quads.count += count;
+            return quads;
+        }
+    }
+    UNREACHABLE("Unknown quad mode: %d", int(queue.mode));
+}
+
+void pushQuadLayer(QuadQueue& queue,
+                   QuadLayer layer,
+                   uint16_t texture,
+                   const DrawOrder& order)
+{
+    ASSERT(layer >= 0);
+    add(queue.commands, SortItem{
+        makeSortKey(order.layer, color_shader, texture, order.depth),
+        uint32_t(layer) | layer_command_flag
+    });
+}
+
+uint32_t flushQuadQueue(QuadQueue& queue, void* output)
+{
+    ListView<SortItem>& commands = queue.commands;
+    clear(queue.batches);
+    if (commands.count == 0)
+        return 0;
+
+    radixSort(commands.elems, queue.sortScratch, commands.count);
+
+    // Layers are drawn from their own buffers, so only the quads are copied.
+    uint32_t quadCount = 0;
+    switch (queue.mode)
+    {
+        case QuadMode::Instanced:
+        {
+            QuadInstance* quads = static_cast<QuadInstance*>(output);
+            for (size_t index = 0; index < commands.count; index++)
+            {
+                const uint32_t value = commands[index].value;
+                if (!(value & command_flags)) {
+                    quads[quadCount++] = queue.instances[value];
+                }
+                else if (value & run_command_flag) {
+                    const QuadRun& run = queue.runs[value & ~run_command_flag];
+                    memcpy(quads + quadCount, queue.instances.elems + run.first, run.count * sizeof(QuadInstance));
+                    quadCount += run.count;
+                }
+            }
+            break;
+        }
+        case QuadMode::Indexed:
+        {
+            Quad* quads = static_cast<Quad*>(output);
+            for (size_t index = 0; index < commands.count; index++)
+            {
+                const uint32_t value = commands[index].value;
+                if (!(value & command_flags)) {
+                    quads[quadCount++] = queue.quads[value];
+                }
+                else if (value & run_command_flag) {
+                    const QuadRun& run = queue.runs[value & ~run_command_flag];
+                    memcpy(quads + quadCount, queue.quads.elems + run.first, run.count * sizeof(Quad));
+                    quadCount += run.count;
+                }
+            }
+            break;
+        }
+    }
+
+    uint64_t material = ~uint64_t(0);
+    uint32_t first = 0;
+    uint32_t next = 0;
+    for (size_t index = 0; index < commands.count; index++)
+    {
+        const SortItem& command = commands[index];
+        const uint64_t commandMaterial = command.key & material_mask;
+        if (command.value & layer_command_flag) {
+            addQuadBatch(queue, material, first, next);
+            first = next;
+            add(queue.batches, DrawBatch{
+                commandMaterial,
+                0,
+                0,
+                QuadLayer(command.value & ~layer_command_flag)
+            });
+            material = commandMaterial;
+            continue;
+        }
+        if (commandMaterial != material) {
+            addQuadBatch(queue, material, first, next);
+            first = next;
+            material = commandMaterial;
+        }
+        next += command.value & run_command_flag ?
+            queue.runs[command.value & ~run_command_flag].count :
+            1;
+    }
+    addQuadBatch(queue, material, first, next);
+    return quadCount;
+}
@@ -0,0 +1,154 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <util/arena.h>
+#include <util/list_view.h>
+#include <util/radix_sort.h>
+
+#include "color.h"
+#include "point.h"
+#include "renderer.h"
+#include "vector.h"
+
+struct Vertex
+{
+    Point position;
+    Color color;
+    Point uv;
+};
+
+struct Quad
+{
+    Vertex bottomLeft;
+    Vertex topLeft;
+    Vertex topRight;
+    Vertex bottomRight;
+};
+
+// A quad in the instanced path, a quarter of the size of a Quad.
+struct QuadInstance
+{
+    Point position;
+    Vector size;
+    // The texture coordinates of the corners at position and at
+    // position + size, in the same format as the ones of a Sprite.
+    uint16_t uvs[4];
+    // RGBA with 8 bits per channel, red in the lowest byte.
+    uint32_t color;
+};
+
+static_assert(sizeof(QuadInstance) * 4 == sizeof(Quad));
+
+// Shaders that quads can be drawn with.
+enum : uint8_t
+{
+    color_shader,
+    shader_count
+};
+
+// The bits of a sort key that decide what a quad is drawn with.
+constexpr uint64_t material_mask = 0x00FFFFFF00000000;
+
+uint64_t makeSortKey(uint8_t layer,
+                     uint8_t shader,
+                     uint16_t texture,
+                     uint32_t depth);
+uint8_t getShader(uint64_t key);
+uint16_t getTexture(uint64_t key);
+
+// Packs the color into RGBA with 8 bits per channel and full alpha, red in
+// the lowest byte.
+uint32_t packColor(const Color& color);
+
+QuadInstance makeQuadInstance(float x,
+                              float y,
+                              float width,
+                              float height,
+                              const Sprite& sprite,
+                              const Color& color);
+Quad makeQuad(float x,
+              float y,
+              float width,
+              float height,
+              const Sprite& sprite,
+              const Color& color);
+
+size_t getQuadSize(QuadMode mode);
+
+// Quads that can share a draw call, or a whole quad layer.
+struct DrawBatch
+{
+    // The sort key of the batch, masked to its material.
+    uint64_t material;
+    // The range of the batch in the sorted quads.
+    uint32_t first;
+    uint32_t count;
+    // The layer to draw, or -1 for a batch of sorted quads.
+    QuadLayer layer;
+};
+
+// Quads that were written by the caller in one go and are sorted as one.
+struct QuadRun
+{
+    // The range of the run in the quads of the queue.
+    uint32_t first;
+    uint32_t count;
+};
+
+// The quads of a frame in the order they were drawn, together with their sort
+// keys. Only one of the quad lists is used depending on the quad mode. It
+// does not touch the GPU, that is left to whoever draws the batches.
+struct QuadQueue
+{
+    QuadMode mode;
+    ListView<Quad> quads;
+    ListView<QuadInstance> instances;
+    // Sort keys, with the index of the quad or layer they belong to.
+    ListView<SortItem> commands;
+    SortItem* sortScratch;
+    ListView<QuadRun> runs;
+    // Sized for the worst case of a batch per command.
+    ListView<DrawBatch> batches;
+};
+
+// Returns how much of an arena a queue takes up.
+size_t getQuadQueueSize(uint32_t maxQuadCount,
+                        uint32_t maxLayerCount,
+                        uint32_t maxRunCount,
+                        QuadMode mode);
+
+// The queue lives until the arena is reset.
+QuadQueue makeQuadQueue(Arena& arena,
+                        uint32_t maxQuadCount,
+                        uint32_t maxLayerCount,
+                        uint32_t maxRunCount,
+                        QuadMode mode);
+
+void clearQuadQueue(QuadQueue& queue);
+
+void pushQuad(QuadQueue& queue,
+              float x,
+              float y,
+              float width,
+              float height,
+              const Sprite& sprite,
+              const Color& color,
+              const DrawOrder& order);
+// Returns room for count quads in the format of the quad mode, which the
+// caller has to fill in before the queue is flushed. They are drawn in the
+// order they are written.
+void* pushQuadRun(QuadQueue& queue,
+                  uint32_t count,
+                  uint16_t texture,
+                  const DrawOrder& order);
+void pushQuadLayer(QuadQueue& queue,
+                   QuadLayer layer,
+                   uint16_t texture,
+                   const DrawOrder& order);
+
+// Sorts the queue, copies its quads to output in the order they are drawn in
+// and fills the batches of the queue. Neighbouring quads that share a
+// material go into the same batch, even across draw order layers. Returns the
+// number of quads written, output must have room for all of them.
+uint32_t flushQuadQueue(QuadQueue& queue, void* output);
@@ -0,0 +1,191 @@
+#include <cstring>
+#include <util/assert.h>
+#include <util/list_view.h>
+
+#include "quad_queue.h"
+#include "render_backend.h"
+#include "renderer.h"
+
+namespace {
+
+constexpr uint64_t fnv_offset_basis = 0xCBF29CE484222325;
+constexpr uint64_t fnv_prime = 0x100000001B3;
+
+size_t quadSize;
+
+// The sorted quads of the frame, before they are recorded.
+uint8_t* stagedQuads;
+
+struct RecordedLayer
+{
+    const uint8_t* quads;
+    uint32_t quadCount;
+};
+
+ListView<RecordedLayer> layers;
+
+uint8_t shader;
+uint16_t texture;
+
+ListView<RecordedDraw> draws;
+ListView<uint8_t> quads;
+
+void recordDraw(const uint8_t* source, uint32_t count)
+{
+    ASSERT(quads.count + count * quadSize <= quads.capacity);
+
+    add(draws, RecordedDraw{
+        shader,
+        texture,
+        uint32_t(quads.count / quadSize),
+        count
+    });
+    memcpy(quads.elems + quads.count, source, count * quadSize);
+    quads.count += count * quadSize;
+}
+
+uint64_t hashBytes(uint64_t hash, const void* data, size_t size)
+{
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    for (size_t index = 0; index < size; index++)
+    {
+        hash = (hash ^ bytes[index]) * fnv_prime;
+    }
+    return hash;
+}
+
+void init(uint32_t maxQuadCount,
+          uint32_t,
+          uint32_t,
+          QuadMode mode,
+          StreamBufferMode,
+          const char*)
+{
+    quadSize = getQuadSize(mode);
+    stagedQuads = new uint8_t[maxQuadCount * quadSize];
+    layers = makeListView(
+        max_quad_layer_count,
+        new RecordedLayer[max_quad_layer_count]);
+
+    // Every batch of the frame is a draw call, and there can be at most one
+    // for every quad and layer. A layer holds up to maxQuadCount quads.
+    const uint32_t maxDrawCount = maxQuadCount + max_quad_layer_count;
+    draws = makeListView(maxDrawCount, new RecordedDraw[maxDrawCount]);
+    const size_t maxQuadBytes =
+        size_t(maxQuadCount) * (max_quad_layer_count + 1) * quadSize;
+    quads = makeListView(maxQuadBytes, new uint8_t[maxQuadBytes]);
+}
+
+void destroy()
+{
+    delete[] quads.elems;
+    delete[] draws.elems;
+    delete[] layers.elems;
+    delete[] stagedQuads;
+    quads = ListView<uint8_t>{};
+    draws = ListView<RecordedDraw>{};
+    layers = ListView<RecordedLayer>{};
+    stagedQuads = nullptr;
+}
+
+void createTexture(uint32_t, uint32_t, const uint32_t*)
+{
+}
+
+void createLayer(const uint8_t* layerQuads, uint32_t quadCount)
+{
+    add(layers, RecordedLayer{ layerQuads, quadCount });
+}
+
+// The layer is recorded as it is when it is drawn.
+void updateLayer(QuadLayer, uint32_t, uint32_t)
+{
+}
+
+void beginFrame()
+{
+    clear(draws);
+    clear(quads);
+}
+
+void* beginQuadWrite()
+{
+    return stagedQuads;
+}
+
+void endQuadWrite()
+{
+}
+
+void setShader(uint8_t value)
+{
+    shader = value;
+}
+
+void setTexture(uint16_t value)
+{
+    texture = value;
+}
+
+void drawQuads(uint32_t first, uint32_t count)
+{
+    recordDraw(stagedQuads + first * quadSize, count);
+}
+
+void drawLayer(QuadLayer layer)
+{
+    const RecordedLayer& recordedLayer = layers[layer];
+    recordDraw(recordedLayer.quads, recordedLayer.quadCount);
+}
+
+void endFrame()
+{
+}
+
+}
+
+const RenderBackendFunctions& getRecordingBackend()
+{
+    static const RenderBackendFunctions functions = {
+        init,
+        destroy,
+        createTexture,
+        createLayer,
+        updateLayer,
+        beginFrame,
+        beginQuadWrite,
+        endQuadWrite,
+        setShader,
+        setTexture,
+        drawQuads,
+        drawLayer,
+        endFrame
+    };
+    return functions;
+}
+
+RecordedFrame getRecordedFrame()
+{
+    return RecordedFrame{
+        draws.elems,
+        uint32_t(draws.count),
+        quads.elems,
+        uint32_t(quads.count / quadSize),
+        quadSize
+    };
+}
+
+uint64_t hashRecordedFrame(const RecordedFrame& frame)
+{
+    uint64_t hash = fnv_offset_basis;
+    for (uint32_t index = 0; index < frame.drawCount; index++)
+    {
+        // Field by field, so the padding of the draws does not end up in it.
+        const RecordedDraw& draw = frame.draws[index];
+        hash = hashBytes(hash, &draw.shader, sizeof(draw.shader));
+        hash = hashBytes(hash, &draw.texture, sizeof(draw.texture));
+        hash = hashBytes(hash, &draw.first, sizeof(draw.first));
+        hash = hashBytes(hash, &draw.count, sizeof(draw.count));
+    }
+    return hashBytes(hash, frame.quads, frame.quadCount * frame.quadSize);
+}
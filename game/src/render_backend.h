@@ -0,0 +1,51 @@
+#pragma once
+
+#include <cstdint>
+
+#include "renderer.h"
+#include "stream_buffer.h"
+
+constexpr int32_t max_texture_count = 16;
+constexpr int32_t max_quad_layer_count = 8;
+
+// What a backend of the renderer does with a frame. The renderer records,
+// sorts and batches the quads itself, so a backend only gets the resulting
+// state changes and draws in the order they are executed. Quads are passed
+// in the format of the quad mode.
+struct RenderBackendFunctions
+{
+    void (*init)(uint32_t maxQuadCount,
+                 uint32_t windowWidth,
+                 uint32_t windowHeight,
+                 QuadMode mode,
+                 StreamBufferMode streamMode,
+                 const char* programCacheDirectory);
+    void (*destroy)();
+
+    // Textures are numbered in the order they are created.
+    void (*createTexture)(uint32_t width,
+                          uint32_t height,
+                          const uint32_t* pixels);
+
+    // Layers are numbered in the order they are created. Their quads stay
+    // where they are until the renderer is destroyed and are only changed
+    // between frames, updateLayer is called for the ones that changed.
+    void (*createLayer)(const uint8_t* quads, uint32_t quadCount);
+    void (*updateLayer)(QuadLayer layer, uint32_t first, uint32_t end);
+
+    void (*beginFrame)();
+    // Returns room for the maximum number of quads, for the sorted quads of
+    // the frame to be written to.
+    void* (*beginQuadWrite)();
+    void (*endQuadWrite)();
+    void (*setShader)(uint8_t shader);
+    void (*setTexture)(uint16_t texture);
+    // Draws quads that were written in this frame.
+    void (*drawQuads)(uint32_t first, uint32_t count);
+    void (*drawLayer)(QuadLayer layer);
+    void (*endFrame)();
+};
+
+const RenderBackendFunctions& getGlBackend();
+const RenderBackendFunctions& getRecordingBackend();
+const RenderBackendFunctions& getSoftwareBackend();
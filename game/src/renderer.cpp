@@ -1,333 +1,336 @@
-#include <cstdio>
-#include <cstdlib>
-#include <glad/glad.h>
+#include <cstring>
+#include <util/arena.h>
+#include <util/assert.h>
+#include <util/dirty_ranges.h>
+#include <util/list_view.h>
 
-#include "util/assert.h"
 #include "color.h"
-#include "list_view.h"
-#include "matrix.h"
-#include "point.h"
+#include "quad_queue.h"
+#include "render_backend.h"
+#include "renderer.h"
 
 namespace {
 
-#define UNREACHABLE(...) \
-    do { \
-        fprintf(stderr, "[UNREACHABLE] %s:%d: ", __FILE__, __LINE__); \
-        fprintf(stderr, __VA_ARGS__); \
-        fprintf(stderr, "\n"); \
-        abort(); \
-    } while(false)
-
-constexpr int32_t position_index = 0;
-constexpr int32_t color_index = 1;
-
-constexpr const char* vertex_shader =
-    "#version 400 core\n"
-    "layout(location=0) in vec4 in_position;\n"
-    "layout(location=1) in vec3 in_color;\n"
-    "uniform mat4 u_projection;\n"
-    "out vec4 vert_color;\n"
-    "void main() {\n"
-    "  gl_Position = u_projection * in_position;\n"
-    "  vert_color = vec4(in_color, 1);\n"
-    "}\n";
-
-constexpr const char* fragment_shader =
-    "#version 400 core\n"
-    "in vec4 vert_color;\n"
-    "out vec4 frag_color;\n"
-    "void main() {\n"
-    "  frag_color = vert_color;\n"
-    "}\n";
-
-struct Vertex
+const RenderBackendFunctions* backend;
+QuadMode quadMode;
+
+uint32_t maxQuadCount;
+uint16_t textureCount;
+// Flat colored quads are drawn with this sprite, which is solid white.
+Sprite blankSprite;
+
+// Room for what the game and the backends need for a frame, besides the
+// queue.
+constexpr size_t frame_scratch_size = 64 * 1024;
+constexpr uint32_t max_quad_run_count = 16;
+
+// Everything that only lives for a frame, reset by beginDrawing.
+Arena frameArena;
+// The quads of the frame, they are handed to the backend in sorted order.
+QuadQueue queue;
+
+struct RetainedLayer
 {
-    Point position;
-    Color color;
+    uint16_t texture;
+    DrawOrder order;
+    uint32_t quadCount;
+    // The quads in the format of the quad mode. The backend has them as they
+    // are, apart from the dirty ones.
+    uint8_t* quads;
+    DirtyRanges dirty;
 };
 
-struct Quad
+ListView<RetainedLayer> layers;
+
+RenderStats stats;
+
+// Copies a quad into a layer and marks it dirty, unless it is already there.
+void writeLayerQuad(RetainedLayer& layer, uint32_t index, const void* quad)
 {
-    Vertex bottomLeft;
-    Vertex topLeft;
-    Vertex topRight;
-    Vertex bottomRight;
-};
+    const size_t quadSize = getQuadSize(quadMode);
+    if (memcmp(layer.quads + index * quadSize, quad, quadSize) == 0)
+        return;
 
-const char* getGlErrorMessage(GLenum error)
+    memcpy(layer.quads + index * quadSize, quad, quadSize);
+    markDirty(layer.dirty, index, index + 1);
+}
+
+void uploadLayer(QuadLayer layer)
 {
-    switch (error)
+    RetainedLayer& retainedLayer = layers[layer];
+    for (int32_t index = 0; index < retainedLayer.dirty.count; index++)
     {
-        case GL_NO_ERROR:
-            return "No error";
-        case GL_INVALID_ENUM:
-            return "Invalid enum";
-        case GL_INVALID_VALUE:
-            return "Invalid value";
-        case GL_INVALID_OPERATION:
-            return "Invalid operation";
-        case GL_INVALID_FRAMEBUFFER_OPERATION:
-            return "Invalid framebuffer operation";
-        case GL_OUT_OF_MEMORY:
-            return "Out of memory";
-        case GL_STACK_UNDERFLOW:
-            return "Stack underflow";
-        case GL_STACK_OVERFLOW:
-            return "Stack overflow";
-        default:
-            UNREACHABLE("Unknown OpenGL error: %d", error);
+        const DirtyRange& range = retainedLayer.dirty.ranges[index];
+        backend->updateLayer(layer, range.first, range.end);
+        stats.uploadByteCount += (range.end - range.first) * getQuadSize(quadMode);
     }
+    clearDirty(retainedLayer.dirty);
 }
 
-#define GL_ASSERT(stmt) \
-    while (glGetError() != GL_NO_ERROR); \
-    stmt; \
-    if (const GLenum error = glGetError(); error != GL_NO_ERROR) { \
-        fprintf(stderr, "[GL_ASSERT] %s:%d: \"%s\" (%s)\n", \
-                __FILE__, \
-                __LINE__, \
-                #stmt, \
-                getGlErrorMessage(error)); \
-        abort(); \
+// Sets the shader and texture of the material that differ from the material
+// that is set, which is ~0 when nothing is set yet.
+void setMaterial(uint64_t material, uint64_t previous)
+{
+    const bool initial = previous == ~uint64_t(0);
+    const uint8_t shader = getShader(material);
+    if (initial || shader != getShader(previous)) {
+        backend->setShader(shader);
+        stats.stateChangeCount++;
     }
+    const uint16_t texture = getTexture(material);
+    if (initial || texture != getTexture(previous)) {
+        backend->setTexture(texture);
+        stats.stateChangeCount++;
+    }
+}
 
-uint32_t createVertexArray()
+const RenderBackendFunctions& getBackendFunctions(RenderBackend backend)
 {
-    uint32_t vao;
-    GL_ASSERT(glGenVertexArrays(1, &vao));
-    GL_ASSERT(glBindVertexArray(vao));
+    switch (backend)
+    {
+        case RenderBackend::OpenGl: return getGlBackend();
+        case RenderBackend::Recording: return getRecordingBackend();
+        case RenderBackend::Software: return getSoftwareBackend();
+        default: UNREACHABLE("Unknown render backend: %d", int(backend));
+    }
+}
 
-    return vao;
 }
 
-uint32_t createVertexBuffer(uint32_t maxSpriteCount)
+void initRenderer(RenderBackend renderBackend,
+                  uint32_t maxSpriteCount,
+                  uint32_t windowWidth,
+                  uint32_t windowHeight,
+                  QuadMode mode,
+                  StreamBufferMode streamMode,
+                  const char* programCacheDirectory)
 {
-    uint32_t vbo;
-    GL_ASSERT(glGenBuffers(1, &vbo));
-    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, vbo));
-
-    GL_ASSERT(glEnableVertexAttribArray(position_index));
-    GL_ASSERT(glVertexAttribPointer(
-        position_index,
-        2,
-        GL_FLOAT,
-        GL_FALSE,
-        sizeof(Vertex),
-        0));
-
-    GL_ASSERT(glEnableVertexAttribArray(color_index));
-    GL_ASSERT(glVertexAttribPointer(
-        color_index,
-        3,
-        GL_FLOAT,
-        GL_FALSE,
-        sizeof(Vertex),
-        (void*)offsetof(Vertex, color)));
-
-    GL_ASSERT(glBufferData(
-        GL_ARRAY_BUFFER,
-        maxSpriteCount * sizeof(Quad),
-        nullptr,
-        GL_DYNAMIC_DRAW));
-
-    return vbo;
+    ASSERT(maxSpriteCount > 0);
+
+    backend = &getBackendFunctions(renderBackend);
+    quadMode = mode;
+    maxQuadCount = maxSpriteCount;
+    textureCount = 0;
+    // The backend may already use the arena for scratch while it sets up.
+    initArena(
+        frameArena,
+        getQuadQueueSize(maxSpriteCount, max_quad_layer_count, max_quad_run_count, mode) + frame_scratch_size);
+    backend->init(maxSpriteCount,
+                  windowWidth,
+                  windowHeight,
+                  mode,
+                  streamMode,
+                  programCacheDirectory);
+
+    resetArena(frameArena);
+    queue = makeQuadQueue(frameArena, maxSpriteCount, max_quad_layer_count, max_quad_run_count, mode);
+    layers = makeListView(
+        max_quad_layer_count,
+        new RetainedLayer[max_quad_layer_count]);
+
+    const uint32_t white = 0xFFFFFFFF;
+    blankSprite = Sprite{ createTexture(1, 1, &white), 0, 0, 65535, 65535 };
 }
 
-uint32_t createIndexBuffer(uint32_t maxSpriteCount)
+void destroyRenderer()
 {
-    uint32_t ibo;
-    GL_ASSERT(glGenBuffers(1, &ibo));
-    GL_ASSERT(glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, ibo));
+    backend->destroy();
+    backend = nullptr;
 
-    ListView<uint32_t> indices =
-        makeListView(maxSpriteCount * 6, new uint32_t[maxSpriteCount * 6]);
-    for (uint32_t index = 0; index < maxSpriteCount; index++)
+    for (size_t index = 0; index < layers.count; index++)
     {
-        add(indices, (index * 4) + 0);
-        add(indices, (index * 4) + 1);
-        add(indices, (index * 4) + 2);
-        add(indices, (index * 4) + 0);
-        add(indices, (index * 4) + 2);
-        add(indices, (index * 4) + 3);
+        delete[] layers[index].quads;
     }
-    GL_ASSERT(glBufferData(
-        GL_ELEMENT_ARRAY_BUFFER,
-        indices.count * sizeof(uint32_t),
-        indices.elems,
-        GL_STATIC_DRAW));
-    delete[] indices.elems;
-
-    return ibo;
+    delete[] layers.elems;
+    layers = ListView<RetainedLayer>{};
+
+    queue = QuadQueue{};
+    destroyArena(frameArena);
+}
+
+void beginDrawing()
+{
+    backend->beginFrame();
+    resetArena(frameArena);
+    queue = makeQuadQueue(frameArena, maxQuadCount, max_quad_layer_count, max_quad_run_count, quadMode);
 }
 
-const char* shaderTypeToString(GLenum shaderType)
+void endDrawing()
 {
-    switch (shaderType)
+    stats = RenderStats{};
+    for (size_t index = 0; index < layers.count; index++)
     {
-        case GL_VERTEX_SHADER: return "vertex shader";
-        case GL_FRAGMENT_SHADER: return "fragment shader";
-        default: UNREACHABLE("Unknown shader type: %d", shaderType);
+        uploadLayer(QuadLayer(index));
     }
-}
 
-constexpr int32_t message_length = 1024;
+    if (queue.commands.count > 0) {
+        const uint32_t quadCount = flushQuadQueue(queue, backend->beginQuadWrite());
+        backend->endQuadWrite();
+        stats.quadCount += quadCount;
+        stats.uploadByteCount += quadCount * getQuadSize(quadMode);
+    }
 
-uint32_t createShader(GLenum type, const char* source)
-{
-    ASSERT(source != nullptr);
-
-    GL_ASSERT(uint32_t shader = glCreateShader(type));
-    GL_ASSERT(glShaderSource(shader, 1, &source, nullptr));
-    GL_ASSERT(glCompileShader(shader));
-
-    GLint compileStatus;
-    GL_ASSERT(glGetShaderiv(shader, GL_COMPILE_STATUS, &compileStatus));
-    if (compileStatus != GL_TRUE) {
-        GLsizei logLength = 0;
-        char message[message_length];
-        GL_ASSERT(glGetShaderInfoLog(
-            shader,
-            message_length,
-            &logLength,
-            message));
-        fprintf(
-            stderr,
-            "Compilation of %s failed: %s\n",
-            shaderTypeToString(type),
-            message);
-        abort();
+    uint64_t material = ~uint64_t(0);
+    for (size_t index = 0; index < queue.batches.count; index++)
+    {
+        const DrawBatch& batch = queue.batches[index];
+        if (batch.material != material) {
+            setMaterial(batch.material, material);
+            material = batch.material;
+        }
+
+        if (batch.layer >= 0) {
+            backend->drawLayer(batch.layer);
+            stats.quadCount += layers[batch.layer].quadCount;
+        } else {
+            backend->drawQuads(batch.first, batch.count);
+        }
+        stats.drawCallCount++;
     }
-    
-    return shader;
+
+    backend->endFrame();
 }
 
-uint32_t createShaderProgram(const char* vertexShaderSource,
-                             const char* fragmentShaderSource)
+uint16_t createTexture(uint32_t width, uint32_t height, const uint32_t* pixels)
 {
-    GL_ASSERT(uint32_t program = glCreateProgram());
-
-    uint32_t vertexShader =
-        createShader(GL_VERTEX_SHADER, vertexShaderSource);
-    uint32_t fragmentShader =
-        createShader(GL_FRAGMENT_SHADER, fragmentShaderSource);
-    GL_ASSERT(glAttachShader(program, vertexShader));
-    GL_ASSERT(glAttachShader(program, fragmentShader));
-    GL_ASSERT(glLinkProgram(program));
-
-    GLint linkStatus;
-    GL_ASSERT(glGetProgramiv(program, GL_LINK_STATUS, &linkStatus));
-    if (linkStatus != GL_TRUE) {
-        GLsizei logLength = 0;
-        char message[message_length];
-        GL_ASSERT(glGetProgramInfoLog(
-            program,
-            message_length,
-            &logLength,
-            message));
-        fprintf(stderr, "Linking of shader program failed: %s\n", message);
-        abort();
-    }
-    GL_ASSERT(glUseProgram(program));
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+    ASSERT(pixels != nullptr);
+    ASSERT(textureCount < max_texture_count);
 
-    GL_ASSERT(glDeleteShader(vertexShader));
-    GL_ASSERT(glDeleteShader(fragmentShader));
+    backend->createTexture(width, height, pixels);
+    return textureCount++;
+}
 
-    return program;
+void setBlankSprite(const Sprite& sprite)
+{
+    ASSERT(sprite.texture < textureCount);
+    blankSprite = sprite;
 }
 
-Matrix makeOrthogonalProjectionMatrix(float left,
-                                      float right,
-                                      float top,
-                                      float bottom,
-                                      float near,
-                                      float far)
+void drawSprite(float x,
+                float y,
+                float width,
+                float height,
+                const Sprite& sprite,
+                const Color& color,
+                const DrawOrder& order)
 {
-    const float scaleX = 2 / (right - left);
-    const float scaleY = 2 / (top - bottom);
-    const float scaleZ = 2 / (near - far);
-    const float translateX = (left + right) / (left - right);
-    const float translateY = (bottom + top) / (bottom - top);
-    const float translateZ = (near + far) / (near - far);
-    return makeMatrix(
-        scaleX, 0,      0,      translateX,
-        0,      scaleY, 0,      translateY,
-        0,      0,      scaleZ, translateZ,
-        0,      0,      0,      1);
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+    ASSERT(sprite.texture < textureCount);
+    ASSERT(color.r >= 0 && color.r <= 1);
+    ASSERT(color.g >= 0 && color.g <= 1);
+    ASSERT(color.b >= 0 && color.b <= 1);
+
+    pushQuad(queue, x, y, width, height, sprite, color, order);
 }
 
-uint32_t vao;
-uint32_t vbo;
-uint32_t ibo;
-uint32_t program;
+void drawQuad(float x,
+              float y,
+              float width,
+              float height,
+              const Color& color,
+              const DrawOrder& order)
+{
+    drawSprite(x, y, width, height, blankSprite, color, order);
+}
 
-ListView<Quad> quads;
+void* drawQuadRun(uint32_t count, uint16_t texture, const DrawOrder& order)
+{
+    ASSERT(count <= getFreeQuadCount());
+    ASSERT(texture < textureCount);
 
+    return pushQuadRun(queue, count, texture, order);
 }
 
-void initRenderer(uint32_t maxSpriteCount, uint32_t windowWidth, uint32_t windowHeight)
+uint32_t getFreeQuadCount()
 {
-    vao = createVertexArray();
-    vbo = createVertexBuffer(maxSpriteCount);
-    ibo = createIndexBuffer(maxSpriteCount);
-    program = createShaderProgram(vertex_shader, fragment_shader);
-
-    const Matrix projection =
-        makeOrthogonalProjectionMatrix(0, windowWidth, 0, windowHeight, -1, 1);
-    GL_ASSERT(int32_t location =
-        glGetUniformLocation(program, "u_projection"));
-    ASSERT(location != -1);
-    GL_ASSERT(glUniformMatrix4fv(location, 1, GL_FALSE, projection.elems));
-
-    quads = makeListView(maxSpriteCount, new Quad[maxSpriteCount]);
+    const size_t used = quadMode == QuadMode::Instanced ?
+        queue.instances.count :
+        queue.quads.count;
+    return maxQuadCount - uint32_t(used);
 }
 
-void destroyRenderer()
+QuadMode getQuadMode()
 {
-    delete[] quads.elems;
-    GL_ASSERT(glDeleteProgram(program));
-    GL_ASSERT(glDeleteBuffers(1, &ibo));
-    GL_ASSERT(glDeleteBuffers(1, &vbo));
-    GL_ASSERT(glDeleteVertexArrays(1, &vao));
-
-    vao = 0;
-    vbo = 0;
-    ibo = 0;
-    program = 0;
+    return quadMode;
 }
 
-void beginDrawing()
+RenderStats getRenderStats()
 {
-    GL_ASSERT(glClear(GL_COLOR_BUFFER_BIT));
-    clear(quads);
+    return stats;
 }
 
-void endDrawing()
+Arena& getFrameArena()
 {
-    GL_ASSERT(glBufferSubData(
-        GL_ARRAY_BUFFER,
-        0,
-        quads.count * sizeof(Quad),
-        quads.elems));
-    GL_ASSERT(glDrawElements(
-        GL_TRIANGLES,
-        quads.count * 6,
-        GL_UNSIGNED_INT,
-        0));
+    return frameArena;
 }
 
-void drawQuad(float x, float y, float width, float height, const Color& color)
+QuadLayer createQuadLayer(uint32_t quadCount,
+                          uint16_t texture,
+                          const DrawOrder& order)
 {
+    ASSERT(quadCount > 0 && quadCount <= maxQuadCount);
+    ASSERT(texture < textureCount);
+
+    // Every quad starts out hidden, which is all zeroes.
+    RetainedLayer layer = {};
+    layer.texture = texture;
+    layer.order = order;
+    layer.quadCount = quadCount;
+    layer.quads = new uint8_t[quadCount * getQuadSize(quadMode)]();
+    backend->createLayer(layer.quads, quadCount);
+
+    add(layers, layer);
+    return QuadLayer(layers.count - 1);
+}
+
+void setLayerSprite(QuadLayer layer,
+                    uint32_t index,
+                    float x,
+                    float y,
+                    float width,
+                    float height,
+                    const Sprite& sprite,
+                    const Color& color)
+{
+    RetainedLayer& retainedLayer = layers[layer];
+    ASSERT(index < retainedLayer.quadCount);
     ASSERT(width > 0);
     ASSERT(height > 0);
-    ASSERT(color.r >= 0 && color.r <= 1);
-    ASSERT(color.g >= 0 && color.g <= 1);
-    ASSERT(color.b >= 0 && color.b <= 1);
+    ASSERT(sprite.texture == retainedLayer.texture);
+
+    switch (quadMode)
+    {
+        case QuadMode::Instanced:
+        {
+            const QuadInstance instance =
+                makeQuadInstance(x, y, width, height, sprite, color);
+            writeLayerQuad(retainedLayer, index, &instance);
+            break;
+        }
+        case QuadMode::Indexed:
+        {
+            const Quad quad = makeQuad(x, y, width, height, sprite, color);
+            writeLayerQuad(retainedLayer, index, &quad);
+            break;
+        }
+    }
+}
+
+void hideLayerQuad(QuadLayer layer, uint32_t index)
+{
+    RetainedLayer& retainedLayer = layers[layer];
+    ASSERT(index < retainedLayer.quadCount);
 
-    const Quad quad = Quad{
-        Vertex{ Point{ x, y }, color },
-        Vertex{ Point{ x, y + height }, color },
-        Vertex{ Point{ x + width, y + height }, color },
-        Vertex{ Point{ x + width, y }, color }
-    };
-    add(quads, quad);
+    // Quads without a size cover no pixels.
+    const Quad hidden = {};
+    writeLayerQuad(retainedLayer, index, &hidden);
+}
+
+void drawQuadLayer(QuadLayer layer)
+{
+    const RetainedLayer& retainedLayer = layers[layer];
+    pushQuadLayer(queue, layer, retainedLayer.texture, retainedLayer.order);
 }
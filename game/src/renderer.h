@@ -1,14 +1,178 @@
 #pragma once
 
+#include <cstddef>
 #include <cstdint>
+#include <util/arena.h>
 
-void initRenderer(uint32_t maxSpriteCount,
+#include "color.h"
+#include "stream_buffer.h"
+
+// How quads are sent to the GPU. Instanced uploads a single compact record per
+// quad and expands the corners in the vertex shader, Indexed uploads all four
+// vertices of each quad and draws them through an index buffer.
+enum class QuadMode
+{
+    Instanced,
+    Indexed
+};
+
+// Where the quads end up. The headless backends need neither a GPU nor a
+// window and draw as fast as they can, for tests and benchmarks.
+enum class RenderBackend
+{
+    OpenGl,
+    // Records the draw calls of every frame and the quads they draw, without
+    // drawing anything.
+    Recording,
+    // Rasterizes the quads on the CPU into a framebuffer, which is split into
+    // tiles that are drawn by a pool of threads.
+    Software
+};
+
+// The OpenGL backend needs a current context, the stream mode and the
+// program cache only matter to it. Linked shader programs are kept in the
+// program cache directory, so that later runs load them instead of compiling
+// them again. No programs are cached when it is null.
+void initRenderer(RenderBackend backend,
+                  uint32_t maxSpriteCount,
                   uint32_t windowWidth,
-                  uint32_t windowHeight);
+                  uint32_t windowHeight,
+                  QuadMode mode,
+                  StreamBufferMode streamMode,
+                  const char* programCacheDirectory);
 
 void destroyRenderer();
 
 void beginDrawing();
 void endDrawing();
 
-void drawQuad(float x, float y, float width, float height, const Color& color);
+// Where a quad ends up in the frame. Quads are drawn by layer, inside a layer
+// they are grouped by what they are drawn with and then ordered by depth.
+// Quads that tie keep the order they were drawn in.
+struct DrawOrder
+{
+    uint8_t layer;
+    uint32_t depth;
+};
+
+// A rectangle of a texture. The texture coordinates are scaled to 0 to
+// 65535, and top is the edge of the first row of pixels of the texture.
+struct Sprite
+{
+    uint16_t texture;
+    uint16_t left;
+    uint16_t top;
+    uint16_t right;
+    uint16_t bottom;
+};
+
+struct RenderStats
+{
+    uint32_t quadCount;
+    uint32_t drawCallCount;
+    // Shader and texture switches between draw calls.
+    uint32_t stateChangeCount;
+    // Bytes of quads written to GPU buffers.
+    uint32_t uploadByteCount;
+};
+
+// Quads that stay in GPU memory across frames, for things that rarely
+// change. Only the quads that changed since the last frame are uploaded
+// again, and all quads of a layer share a texture.
+using QuadLayer = int32_t;
+
+// Creates a texture from RGBA pixels with 8 bits per channel, red in the
+// lowest byte, starting at the top row.
+uint16_t createTexture(uint32_t width, uint32_t height, const uint32_t* pixels);
+
+// Sets the sprite flat colored quads are drawn with, which must be solid
+// white. Pointing it into a texture the sprites are drawn from lets the
+// quads share draw calls with them.
+void setBlankSprite(const Sprite& sprite);
+
+// Draws the sprite with its colors multiplied by color. The top left corner
+// of the sprite ends up at x, y.
+void drawSprite(float x,
+                float y,
+                float width,
+                float height,
+                const Sprite& sprite,
+                const Color& color,
+                const DrawOrder& order);
+
+void drawQuad(float x,
+              float y,
+              float width,
+              float height,
+              const Color& color,
+              const DrawOrder& order);
+
+// Returns room for count quads in the format of getQuadMode, which the
+// caller fills in before endDrawing, for drawing many quads without the
+// checks of drawSprite. They are drawn in the order they are written, and
+// sorted as one by the order given.
+void* drawQuadRun(uint32_t count, uint16_t texture, const DrawOrder& order);
+
+// Returns how many more quads fit into the frame.
+uint32_t getFreeQuadCount();
+
+QuadMode getQuadMode();
+
+// Returns the stats of the last frame that was drawn.
+RenderStats getRenderStats();
+
+// Memory for the frame being drawn, which beginDrawing hands out again from
+// the start.
+Arena& getFrameArena();
+
+// Creates a layer of hidden quads that is drawn in the given order.
+QuadLayer createQuadLayer(uint32_t quadCount,
+                          uint16_t texture,
+                          const DrawOrder& order);
+
+void setLayerSprite(QuadLayer layer,
+                    uint32_t index,
+                    float x,
+                    float y,
+                    float width,
+                    float height,
+                    const Sprite& sprite,
+                    const Color& color);
+
+// Hides the quad until it is set again.
+void hideLayerQuad(QuadLayer layer, uint32_t index);
+
+// Draws all quads of the layer in a single draw call.
+void drawQuadLayer(QuadLayer layer);
+
+// A draw call captured by the recording backend.
+struct RecordedDraw
+{
+    uint8_t shader;
+    uint16_t texture;
+    // The range of the quads of the frame that are drawn.
+    uint32_t first;
+    uint32_t count;
+};
+
+// The last frame drawn by the recording backend, with the quads of every draw
+// call, retained layers included, in the order they are drawn. The quads are
+// in the format of the quad mode, which is quadSize bytes each.
+struct RecordedFrame
+{
+    const RecordedDraw* draws;
+    uint32_t drawCount;
+    const uint8_t* quads;
+    uint32_t quadCount;
+    size_t quadSize;
+};
+
+RecordedFrame getRecordedFrame();
+
+// Hashes the draw calls and quads of the frame, so that frames can be compared
+// without keeping them around.
+uint64_t hashRecordedFrame(const RecordedFrame& frame);
+
+// Returns the pixels of the last frame drawn by the software backend, in the
+// same format as the ones of createTexture and the size of the window.
+const uint32_t* getSoftwareFramebuffer();
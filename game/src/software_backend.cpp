@@ -0,0 +1,443 @@
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+#include <util/assert.h>
+#include <util/list_view.h>
+
+#include "quad_queue.h"
+#include "render_backend.h"
+#include "renderer.h"
+
+namespace {
+
+constexpr int32_t tile_size = 64;
+constexpr int32_t max_worker_count = 7;
+// Opaque black, which is what the game clears to.
+constexpr uint32_t clear_color = 0xFF000000;
+
+struct SoftwareTexture
+{
+    int32_t width;
+    int32_t height;
+    uint32_t* pixels;
+};
+
+struct SoftwareLayer
+{
+    const uint8_t* quads;
+    uint32_t quadCount;
+};
+
+// A quad in the form the rasterizer works with, whatever the quad mode.
+struct RasterQuad
+{
+    float left;
+    float top;
+    float right;
+    float bottom;
+    // The texture coordinates at the top left and bottom right corners.
+    float u0;
+    float v0;
+    float u1;
+    float v1;
+    uint32_t color;
+    uint16_t texture;
+};
+
+QuadMode quadMode;
+size_t quadSize;
+
+int32_t width;
+int32_t height;
+int32_t tileColumnCount;
+int32_t tileCount;
+uint32_t* framebuffer;
+
+ListView<SoftwareTexture> textures;
+ListView<SoftwareLayer> layers;
+uint8_t* stagedQuads;
+uint16_t texture;
+// Everything drawn in the frame, in order. The tiles are only rasterized once
+// the frame ends.
+ListView<RasterQuad> rasterQuads;
+
+// The worker threads wait for the frame counter to change, then take tiles
+// until there are none left.
+std::thread workers[max_worker_count];
+int32_t workerCount;
+std::mutex mutex;
+std::condition_variable frameStarted;
+std::condition_variable workerFinished;
+uint64_t frame;
+int32_t finishedWorkerCount;
+bool quitting;
+std::atomic<int32_t> nextTile;
+
+float toTextureCoordinate(uint16_t value)
+{
+    return value / 65535.0f;
+}
+
+RasterQuad toRasterQuad(const QuadInstance& instance)
+{
+    return RasterQuad{
+        instance.position.x,
+        instance.position.y,
+        instance.position.x + instance.size.x,
+        instance.position.y + instance.size.y,
+        toTextureCoordinate(instance.uvs[0]),
+        toTextureCoordinate(instance.uvs[1]),
+        toTextureCoordinate(instance.uvs[2]),
+        toTextureCoordinate(instance.uvs[3]),
+        instance.color,
+        texture
+    };
+}
+
+RasterQuad toRasterQuad(const Quad& quad)
+{
+    // The first vertex is at the top left corner and the third one at the
+    // bottom right one.
+    return RasterQuad{
+        quad.bottomLeft.position.x,
+        quad.bottomLeft.position.y,
+        quad.topRight.position.x,
+        quad.topRight.position.y,
+        quad.bottomLeft.uv.x,
+        quad.bottomLeft.uv.y,
+        quad.topRight.uv.x,
+        quad.topRight.uv.y,
+        packColor(quad.bottomLeft.color),
+        texture
+    };
+}
+
+void addRasterQuads(const uint8_t* quads, uint32_t count)
+{
+    for (uint32_t index = 0; index < count; index++)
+    {
+        const uint8_t* quad = quads + index * quadSize;
+        switch (quadMode)
+        {
+            case QuadMode::Instanced:
+            {
+                QuadInstance instance;
+                memcpy(&instance, quad, sizeof(instance));
+                add(rasterQuads, toRasterQuad(instance));
+                break;
+            }
+            case QuadMode::Indexed:
+            {
+                Quad indexedQuad;
+                memcpy(&indexedQuad, quad, sizeof(indexedQuad));
+                add(rasterQuads, toRasterQuad(indexedQuad));
+                break;
+            }
+        }
+    }
+}
+
+uint32_t multiplyChannels(uint32_t first, uint32_t second)
+{
+    uint32_t result = 0;
+    for (int32_t shift = 0; shift < 32; shift += 8)
+    {
+        const uint32_t product =
+            ((first >> shift) & 0xFF) * ((second >> shift) & 0xFF);
+        result |= ((product + 127) / 255) << shift;
+    }
+    return result;
+}
+
+// Blends like glBlendFunc(GL_SRC_ALPHA, GL_ONE_MINUS_SRC_ALPHA), which also
+// applies to the alpha channel.
+uint32_t blend(uint32_t source, uint32_t destination)
+{
+    const uint32_t alpha = source >> 24;
+    if (alpha == 0xFF)
+        return source;
+    if (alpha == 0)
+        return destination;
+
+    uint32_t result = 0;
+    for (int32_t shift = 0; shift < 32; shift += 8)
+    {
+        const uint32_t sum = ((source >> shift) & 0xFF) * alpha +
+                             ((destination >> shift) & 0xFF) * (255 - alpha);
+        result |= ((sum + 127) / 255) << shift;
+    }
+    return result;
+}
+
+// Returns the first pixel whose center is at or past the edge.
+int32_t toPixel(float edge)
+{
+    return int32_t(ceilf(edge - 0.5f));
+}
+
+void rasterizeQuad(const RasterQuad& quad,
+                   int32_t tileLeft,
+                   int32_t tileTop,
+                   int32_t tileRight,
+                   int32_t tileBottom)
+{
+    const int32_t left = std::max(toPixel(quad.left), tileLeft);
+    const int32_t top = std::max(toPixel(quad.top), tileTop);
+    const int32_t right = std::min(toPixel(quad.right), tileRight);
+    const int32_t bottom = std::min(toPixel(quad.bottom), tileBottom);
+    if (left >= right || top >= bottom)
+        return;
+
+    const SoftwareTexture& source = textures[quad.texture];
+    const float uStep = (quad.u1 - quad.u0) / (quad.right - quad.left);
+    const float vStep = (quad.v1 - quad.v0) / (quad.bottom - quad.top);
+    for (int32_t y = top; y < bottom; y++)
+    {
+        const float v = quad.v0 + (y + 0.5f - quad.top) * vStep;
+        const int32_t texelY =
+            std::min(std::max(int32_t(v * source.height), 0), source.height - 1);
+        const uint32_t* texels = source.pixels + texelY * source.width;
+        uint32_t* pixels = framebuffer + y * width;
+        for (int32_t x = left; x < right; x++)
+        {
+            const float u = quad.u0 + (x + 0.5f - quad.left) * uStep;
+            const int32_t texelX =
+                std::min(std::max(int32_t(u * source.width), 0), source.width - 1);
+            pixels[x] = blend(multiplyChannels(texels[texelX], quad.color),
+                              pixels[x]);
+        }
+    }
+}
+
+// Draws every quad of the frame over the tile, in the order they were drawn.
+void rasterizeTile(int32_t tile)
+{
+    const int32_t tileLeft = tile % tileColumnCount * tile_size;
+    const int32_t tileTop = tile / tileColumnCount * tile_size;
+    const int32_t tileRight = std::min(tileLeft + tile_size, width);
+    const int32_t tileBottom = std::min(tileTop + tile_size, height);
+
+    for (int32_t y = tileTop; y < tileBottom; y++)
+    {
+        std::fill(framebuffer + y * width + tileLeft,
+                  framebuffer + y * width + tileRight,
+                  clear_color);
+    }
+    for (size_t index = 0; index < rasterQuads.count; index++)
+    {
+        rasterizeQuad(rasterQuads[index], tileLeft, tileTop, tileRight, tileBottom);
+    }
+}
+
+void rasterizeTiles()
+{
+    for (;;)
+    {
+        const int32_t tile = nextTile.fetch_add(1, std::memory_order_relaxed);
+        if (tile >= tileCount)
+            return;
+        rasterizeTile(tile);
+    }
+}
+
+void runWorker()
+{
+    uint64_t lastFrame = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            frameStarted.wait(lock, [&] { return quitting || frame != lastFrame; });
+            if (quitting)
+                return;
+            lastFrame = frame;
+        }
+
+        rasterizeTiles();
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            finishedWorkerCount++;
+        }
+        workerFinished.notify_one();
+    }
+}
+
+void init(uint32_t maxQuadCount,
+          uint32_t windowWidth,
+          uint32_t windowHeight,
+          QuadMode mode,
+          StreamBufferMode,
+          const char*)
+{
+    ASSERT(windowWidth > 0);
+    ASSERT(windowHeight > 0);
+
+    quadMode = mode;
+    quadSize = getQuadSize(mode);
+    width = int32_t(windowWidth);
+    height = int32_t(windowHeight);
+    tileColumnCount = (width + tile_size - 1) / tile_size;
+    tileCount = tileColumnCount * ((height + tile_size - 1) / tile_size);
+    framebuffer = new uint32_t[width * height];
+    std::fill(framebuffer, framebuffer + width * height, clear_color);
+
+    textures = makeListView(
+        max_texture_count,
+        new SoftwareTexture[max_texture_count]);
+    layers = makeListView(
+        max_quad_layer_count,
+        new SoftwareLayer[max_quad_layer_count]);
+    stagedQuads = new uint8_t[maxQuadCount * quadSize];
+    // A layer holds up to maxQuadCount quads.
+    const uint32_t maxRasterQuadCount =
+        maxQuadCount * (max_quad_layer_count + 1);
+    rasterQuads = makeListView(
+        maxRasterQuadCount,
+        new RasterQuad[maxRasterQuadCount]);
+
+    // The thread that ends the frame rasterizes tiles as well.
+    const int32_t threadCount = int32_t(std::thread::hardware_concurrency());
+    workerCount = std::min(std::max(threadCount - 1, 0), max_worker_count);
+    frame = 0;
+    quitting = false;
+    for (int32_t index = 0; index < workerCount; index++)
+    {
+        workers[index] = std::thread(runWorker);
+    }
+}
+
+void destroy()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quitting = true;
+    }
+    frameStarted.notify_all();
+    for (int32_t index = 0; index < workerCount; index++)
+    {
+        workers[index].join();
+    }
+    workerCount = 0;
+
+    for (size_t index = 0; index < textures.count; index++)
+    {
+        delete[] textures[index].pixels;
+    }
+    delete[] textures.elems;
+    delete[] layers.elems;
+    delete[] stagedQuads;
+    delete[] rasterQuads.elems;
+    delete[] framebuffer;
+    textures = ListView<SoftwareTexture>{};
+    layers = ListView<SoftwareLayer>{};
+    stagedQuads = nullptr;
+    rasterQuads = ListView<RasterQuad>{};
+    framebuffer = nullptr;
+}
+
+void createTexture(uint32_t textureWidth,
+                   uint32_t textureHeight,
+                   const uint32_t* pixels)
+{
+    const size_t pixelCount = size_t(textureWidth) * textureHeight;
+    SoftwareTexture source = SoftwareTexture{
+        int32_t(textureWidth),
+        int32_t(textureHeight),
+        new uint32_t[pixelCount]
+    };
+    memcpy(source.pixels, pixels, pixelCount * sizeof(uint32_t));
+    add(textures, source);
+}
+
+void createLayer(const uint8_t* quads, uint32_t quadCount)
+{
+    add(layers, SoftwareLayer{ quads, quadCount });
+}
+
+// The layer is read as it is when it is drawn.
+void updateLayer(QuadLayer, uint32_t, uint32_t)
+{
+}
+
+void beginFrame()
+{
+    clear(rasterQuads);
+}
+
+void* beginQuadWrite()
+{
+    return stagedQuads;
+}
+
+void endQuadWrite()
+{
+}
+
+// There is only the one shader.
+void setShader(uint8_t)
+{
+}
+
+void setTexture(uint16_t value)
+{
+    texture = value;
+}
+
+void drawQuads(uint32_t first, uint32_t count)
+{
+    addRasterQuads(stagedQuads + first * quadSize, count);
+}
+
+void drawLayer(QuadLayer layer)
+{
+    const SoftwareLayer& softwareLayer = layers[layer];
+    addRasterQuads(softwareLayer.quads, softwareLayer.quadCount);
+}
+
+void endFrame()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        nextTile.store(0, std::memory_order_relaxed);
+        finishedWorkerCount = 0;
+        frame++;
+    }
+    frameStarted.notify_all();
+
+    rasterizeTiles();
+
+    std::unique_lock<std::mutex> lock(mutex);
+    workerFinished.wait(lock, [] { return finishedWorkerCount == workerCount; });
+}
+
+}
+
+const RenderBackendFunctions& getSoftwareBackend()
+{
+    static const RenderBackendFunctions functions = {
+        init,
+        destroy,
+        createTexture,
+        createLayer,
+        updateLayer,
+        beginFrame,
+        beginQuadWrite,
+        endQuadWrite,
+        setShader,
+        setTexture,
+        drawQuads,
+        drawLayer,
+        endFrame
+    };
+    return functions;
+}
+
+const uint32_t* getSoftwareFramebuffer()
+{
+    return framebuffer;
+}
@@ -0,0 +1,137 @@
+#include "stream_buffer.h"
+
+#include <util/assert.h>
+
+#include "gl_debug.h"
+
+namespace {
+
+constexpr uint64_t fence_timeout_ns = 1000000000;
+
+void waitForFence(GLsync& fence)
+{
+    if (fence == nullptr)
+        return;
+
+    for (;;)
+    {
+        GL_ASSERT(const GLenum result = glClientWaitSync(
+            fence,
+            GL_SYNC_FLUSH_COMMANDS_BIT,
+            fence_timeout_ns));
+        if (result == GL_ALREADY_SIGNALED || result == GL_CONDITION_SATISFIED)
+            break;
+        if (result == GL_WAIT_FAILED) {
+            fprintf(stderr, "Waiting for stream buffer fence failed\n");
+            abort();
+        }
+    }
+    GL_ASSERT(glDeleteSync(fence));
+    fence = nullptr;
+}
+
+}
+
+StreamBuffer makeStreamBuffer(size_t regionSize, StreamBufferMode mode)
+{
+    ASSERT(regionSize > 0);
+
+    StreamBuffer streamBuffer = {};
+    streamBuffer.mode = mode;
+    streamBuffer.regionSize = regionSize;
+    // Start on the last region so the first write goes to the first one.
+    streamBuffer.region = stream_buffer_region_count - 1;
+
+    const size_t size = mode == StreamBufferMode::Fenced ?
+        regionSize * stream_buffer_region_count :
+        regionSize;
+    GL_ASSERT(glGenBuffers(1, &streamBuffer.buffer));
+    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.buffer));
+    GL_ASSERT(glBufferData(GL_ARRAY_BUFFER, size, nullptr, GL_STREAM_DRAW));
+    GL_CHECK_ERRORS();
+
+    return streamBuffer;
+}
+
+void destroyStreamBuffer(StreamBuffer& streamBuffer)
+{
+    ASSERT(!streamBuffer.mapped);
+
+    for (GLsync& fence : streamBuffer.fences)
+    {
+        if (fence != nullptr) {
+            GL_ASSERT(glDeleteSync(fence));
+            fence = nullptr;
+        }
+    }
+    GL_ASSERT(glDeleteBuffers(1, &streamBuffer.buffer));
+    streamBuffer.buffer = 0;
+}
+
+void* beginStreamWrite(StreamBuffer& streamBuffer)
+{
+    ASSERT(!streamBuffer.mapped);
+
+    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.buffer));
+
+    void* data = nullptr;
+    switch (streamBuffer.mode)
+    {
+        case StreamBufferMode::Fenced:
+            streamBuffer.region =
+                (streamBuffer.region + 1) % stream_buffer_region_count;
+            waitForFence(streamBuffer.fences[streamBuffer.region]);
+            // The fence already ensured the GPU is done with the region, so
+            // the driver does not need to synchronize on its own.
+            GL_ASSERT(data = glMapBufferRange(
+                GL_ARRAY_BUFFER,
+                streamBuffer.region * streamBuffer.regionSize,
+                streamBuffer.regionSize,
+                GL_MAP_WRITE_BIT |
+                GL_MAP_INVALIDATE_RANGE_BIT |
+                GL_MAP_UNSYNCHRONIZED_BIT));
+            break;
+        case StreamBufferMode::Orphaning:
+            streamBuffer.region = 0;
+            GL_ASSERT(glBufferData(
+                GL_ARRAY_BUFFER,
+                streamBuffer.regionSize,
+                nullptr,
+                GL_STREAM_DRAW));
+            GL_ASSERT(data = glMapBufferRange(
+                GL_ARRAY_BUFFER,
+                0,
+                streamBuffer.regionSize,
+                GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT));
+            break;
+    }
+    ASSERT(data != nullptr);
+
+    streamBuffer.mapped = true;
+    return data;
+}
+
+size_t endStreamWrite(StreamBuffer& streamBuffer)
+{
+    ASSERT(streamBuffer.mapped);
+
+    GL_ASSERT(glBindBuffer(GL_ARRAY_BUFFER, streamBuffer.buffer));
+    GL_ASSERT(const GLboolean unmapped = glUnmapBuffer(GL_ARRAY_BUFFER));
+    // The contents are lost if the buffer storage got corrupted, which can
+    // only be fixed by writing them again next frame.
+    if (unmapped != GL_TRUE)
+        fprintf(stderr, "Stream buffer contents were lost while mapped\n");
+
+    streamBuffer.mapped = false;
+    return streamBuffer.region * streamBuffer.regionSize;
+}
+
+void fenceStreamRegion(StreamBuffer& streamBuffer)
+{
+    if (streamBuffer.mode != StreamBufferMode::Fenced)
+        return;
+
+    GLsync& fence = streamBuffer.fences[streamBuffer.region];
+    ASSERT(fence == nullptr);
+    GL_ASSERT(fence = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0));
+}
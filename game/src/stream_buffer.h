@@ -0,0 +1,45 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <glad/glad.h>
+
+constexpr int32_t stream_buffer_region_count = 3;
+
+enum class StreamBufferMode
+{
+    // The buffer is split into regions that are written in turn, each
+    // protected by a fence so that a region is only written again once the
+    // GPU is done drawing from it.
+    Fenced,
+    // The whole buffer is orphaned before every write, leaving it to the
+    // driver to hand out fresh storage while the old one is still in use.
+    Orphaning
+};
+
+// A vertex buffer that is rewritten every frame. Writes go straight into
+// mapped buffer memory and never wait on draws from earlier frames, unless
+// the CPU is more than stream_buffer_region_count frames ahead.
+struct StreamBuffer
+{
+    StreamBufferMode mode;
+    uint32_t buffer;
+    size_t regionSize;
+    int32_t region;
+    GLsync fences[stream_buffer_region_count];
+    bool mapped;
+};
+
+// Creates the buffer and binds it to GL_ARRAY_BUFFER.
+StreamBuffer makeStreamBuffer(size_t regionSize, StreamBufferMode mode);
+void destroyStreamBuffer(StreamBuffer& streamBuffer);
+
+// Maps the next region for writing and returns a pointer to it. Its contents
+// are undefined and must be written before they are drawn.
+void* beginStreamWrite(StreamBuffer& streamBuffer);
+// Unmaps the region and returns its offset into the buffer, to source the
+// vertices from.
+size_t endStreamWrite(StreamBuffer& streamBuffer);
+// Marks the point after the last draw that reads the region, so it is not
+// written to again before the GPU got past it.
+void fenceStreamRegion(StreamBuffer& streamBuffer);
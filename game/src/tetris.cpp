@@ -1,185 +1,1342 @@
+#include <bot/bot_player.h>
+#include <bot/evaluator.h>
+#include <bot/search.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <cstdio>
+#include <cstdlib>
 #include <cstring>
 #include <glad/glad.h>
-#include <cmath>
+#include <net/lossy_link.h>
+#include <net/rollback.h>
+#include <net/spectator_server.h>
+#include <net/spectator_stream.h>
+#include <net/udp_socket.h>
+#include <profiler/profiler.h>
 #include <SDL.h>
+#include <simulation/game.h>
+#include <simulation/game_loop.h>
+#include <simulation/headless.h>
+#include <simulation/input_source.h>
+#include <simulation/replay.h>
+#include <simulation/versus.h>
+#include <thread>
+#include <util/assert.h>
+#include <util/fixed_timestep.h>
+#include <util/list_view.h>
 
+#include "atlas.h"
+#include "audio.h"
 #include "color.h"
-#include "list_view.h"
+#include "font.h"
+#include "frame_profiler.h"
+#include "gl_debug.h"
 #include "matrix.h"
+#include "particles.h"
+#include "playfield.h"
 #include "point.h"
 #include "renderer.h"
 #include "vector.h"
 
-static void generateSineWave(int16_t* buffer, int sampleCount, int soundFreq, int start)
+static constexpr int32_t window_width = 720;
+static constexpr int32_t window_height = 480;
+static constexpr int32_t max_quad_count = 1024;
+// Room for the particles on top of the quads of the games.
+static constexpr uint32_t max_particle_count = 16384;
+// How long the main thread waits for window events before it checks
+// whether it should quit anyway.
+static constexpr int32_t event_wait_timeout_ms = 100;
+static constexpr uint64_t nanoseconds_per_second = 1000000000;
+// From entering main to presenting the first frame, with no cached shader
+// programs. Reported by --startup-times and checked by the startup
+// benchmark.
+static constexpr uint64_t startup_budget = 500 * 1000000;
+static constexpr size_t versus_link_capacity = 256;
+static constexpr int32_t default_max_spectators = 256;
+static constexpr uint32_t audio_sample_rate = 48000;
+static constexpr uint32_t audio_buffer_sample_count = 512;
+static constexpr uint32_t atlas_size = 256;
+static constexpr uint64_t default_headless_game_count = 1000;
+// Ten minutes, after which a game that is still going is cut short.
+static constexpr uint64_t default_headless_tick_count = 10 * 60 * tick_rate;
+
+static constexpr float cell_size = 20;
+static constexpr float board_left = (window_width - board_width * cell_size) / 2;
+static constexpr float board_top =
+    (window_height - board_visible_height * cell_size) / 2;
+
+static constexpr Color piece_colors[piece_type_count] = {
+    Color{ 0, 1, 1 },
+    Color{ 1, 1, 0 },
+    Color{ 0.6f, 0, 0.8f },
+    Color{ 0, 1, 0 },
+    Color{ 1, 0, 0 },
+    Color{ 0, 0, 1 },
+    Color{ 1, 0.5f, 0 }
+};
+
+// Layers the game is drawn in, from back to front.
+static constexpr DrawOrder well_order = DrawOrder{ 0, 0 };
+static constexpr DrawOrder stack_order = DrawOrder{ 1, 0 };
+static constexpr DrawOrder ghost_order = DrawOrder{ 1, 1 };
+static constexpr DrawOrder piece_order = DrawOrder{ 1, 2 };
+static constexpr DrawOrder particle_order = DrawOrder{ 1, 3 };
+static constexpr DrawOrder hud_order = DrawOrder{ 2, 0 };
+
+static constexpr Color well_color = Color{ 0.1f, 0.1f, 0.1f };
+static constexpr Color stack_color = Color{ 0.5f, 0.5f, 0.5f };
+static constexpr Color ghost_color = Color{ 0.25f, 0.25f, 0.25f };
+static constexpr Color text_color = Color{ 1, 1, 1 };
+
+static constexpr float text_scale = 2;
+static constexpr float text_line_height = (glyph_height + 3) * text_scale;
+static constexpr float hud_left = board_left - 6 * cell_size;
+static constexpr float hud_right = board_left + (board_width + 1) * cell_size;
+static constexpr float hud_label_top = board_top - text_line_height;
+static constexpr float hud_stats_top = board_top + 6 * cell_size;
+
+// In pixels per second squared.
+static constexpr float particle_gravity = 900;
+// A frame that took longer moves the particles on as if it took this long,
+// so they do not jump across the window after a stall.
+static constexpr float max_particle_frame_seconds = 0.1f;
+
+struct Graphics
+{
+    Sprite block;
+    Font font;
+};
+
+// Blocks are lit from the top left. They are drawn tinted, so the image
+// itself is gray.
+static void makeBlockImage(uint32_t* pixels, uint32_t size)
+{
+    constexpr uint32_t bevel = 2;
+    for (uint32_t y = 0; y < size; y++)
+    {
+        for (uint32_t x = 0; x < size; x++)
+        {
+            uint32_t shade = 210;
+            if (x < bevel || y < bevel)
+                shade = 255;
+            if (x >= size - bevel || y >= size - bevel)
+                shade = 140;
+            pixels[y * size + x] =
+                0xFF000000 | (shade << 16) | (shade << 8) | shade;
+        }
+    }
+}
+
+// Packs the block and the font into a single atlas, so the whole frame can
+// be drawn from one texture.
+static Graphics loadGraphics()
+{
+    constexpr uint32_t block_size = uint32_t(cell_size);
+    uint32_t blockPixels[block_size * block_size];
+    makeBlockImage(blockPixels, block_size);
+    uint32_t fontPixels[font_pixel_count];
+
+    Image images[1 + font_glyph_count];
+    images[0] = Image{ block_size, block_size, blockPixels };
+    makeFontImages(fontPixels, images + 1);
+
+    Sprite sprites[1 + font_glyph_count];
+    if (!buildAtlas(atlas_size, images, 1 + font_glyph_count, sprites)) {
+        fprintf(stderr, "Sprites do not fit into the atlas\n");
+        abort();
+    }
+
+    return Graphics{ sprites[0], makeFont(sprites + 1) };
+}
+
+struct SoundEffects
+{
+    SoundId rotate;
+    SoundId hold;
+    SoundId hardDrop;
+    SoundId lock;
+    SoundId lineClear;
+    SoundId levelUp;
+    SoundId gameOver;
+};
+
+// Effects are loaded from assets/sounds when a WAV file for them exists and
+// synthesized otherwise.
+static SoundId loadSoundEffect(const char* name,
+                               Waveform waveform,
+                               float frequency,
+                               float seconds)
+{
+    char path[256];
+    snprintf(path, sizeof(path), "assets/sounds/%s.wav", name);
+    if (FILE* file = fopen(path, "rb")) {
+        fclose(file);
+        const SoundId sound = loadSound(path);
+        if (sound != -1)
+            return sound;
+    }
+    return createToneSound(waveform, frequency, seconds);
+}
+
+static SoundEffects loadSoundEffects()
+{
+    return SoundEffects{
+        loadSoundEffect("rotate", Waveform::Square, 880, 0.04f),
+        loadSoundEffect("hold", Waveform::Triangle, 660, 0.08f),
+        loadSoundEffect("hard_drop", Waveform::Saw, 110, 0.1f),
+        loadSoundEffect("lock", Waveform::Triangle, 220, 0.06f),
+        loadSoundEffect("line_clear", Waveform::Square, 1320, 0.25f),
+        loadSoundEffect("level_up", Waveform::Saw, 1760, 0.5f),
+        loadSoundEffect("game_over", Waveform::Saw, 82.5f, 1)
+    };
+}
+
+static void playSoundEffect(SoundId sound, float volume)
+{
+    if (sound != -1)
+        postSoundEvent(SoundEvent{ SoundCommand::PlaySound, sound, volume, false });
+}
+
+static void playSoundEffects(const Game& game, const SoundEffects& effects)
+{
+    if (game.events & game_event_rotated)
+        playSoundEffect(effects.rotate, 0.5f);
+    if (game.events & game_event_held)
+        playSoundEffect(effects.hold, 0.5f);
+    if (game.events & game_event_hard_dropped)
+        playSoundEffect(effects.hardDrop, 0.8f);
+    else if (game.events & game_event_locked)
+        playSoundEffect(effects.lock, 0.5f);
+    if (game.events & game_event_lines_cleared)
+        playSoundEffect(effects.lineClear, 0.25f * game.clearedLines);
+    if (game.events & game_event_level_up)
+        playSoundEffect(effects.levelUp, 1);
+    if (game.events & game_event_over)
+        playSoundEffect(effects.gameOver, 1);
+}
+
+static void drawCell(const Graphics& graphics,
+                     float offset,
+                     int32_t x,
+                     int32_t y,
+                     const Color& color,
+                     const DrawOrder& order)
+{
+    if (y >= board_visible_height)
+        return;
+
+    drawSprite(offset + board_left + x * cell_size,
+               board_top + (board_visible_height - 1 - y) * cell_size,
+               cell_size,
+               cell_size,
+               graphics.block,
+               color,
+               order);
+}
+
+static void drawPiece(const Graphics& graphics,
+                      float offset,
+                      PieceType type,
+                      int32_t rotation,
+                      int32_t x,
+                      int32_t y,
+                      const Color& color,
+                      const DrawOrder& order)
+{
+    const PieceMask mask = getPieceMask(type, rotation);
+    for (int32_t row = 0; row < 4; row++)
+    {
+        for (int32_t column = 0; column < 4; column++)
+        {
+            if ((mask >> (row * 16 + column)) & 1)
+                drawCell(graphics, offset, x + column, y + row, color, order);
+        }
+    }
+}
+
+static void drawStat(const Graphics& graphics,
+                     float offset,
+                     const char* label,
+                     uint32_t value,
+                     float y)
+{
+    char text[16];
+    snprintf(text, sizeof(text), "%u", value);
+    drawText(graphics.font, label, offset + hud_left, y, text_scale, text_color, hud_order);
+    drawText(graphics.font,
+             text,
+             offset + hud_left,
+             y + text_line_height,
+             text_scale,
+             text_color,
+             hud_order);
+}
+
+static void drawHud(const Graphics& graphics, float offset, const Game& game)
+{
+    drawText(graphics.font, "HOLD", offset + hud_left, hud_label_top, text_scale, text_color, hud_order);
+    drawText(graphics.font, "NEXT", offset + hud_right, hud_label_top, text_scale, text_color, hud_order);
+
+    drawStat(graphics, offset, "SCORE", game.score, hud_stats_top);
+    drawStat(graphics, offset, "LEVEL", game.level, hud_stats_top + text_line_height * 3);
+    drawStat(graphics, offset, "LINES", game.lines, hud_stats_top + text_line_height * 6);
+
+    if (game.over) {
+        const char* text = "GAME OVER";
+        drawText(graphics.font,
+                 text,
+                 offset + board_left + (board_width * cell_size - getTextWidth(text, text_scale)) / 2,
+                 board_top + (board_visible_height * cell_size - glyph_height * text_scale) / 2,
+                 text_scale,
+                 text_color,
+                 hud_order);
+    }
+}
+
+// Draws the game with everything shifted right by offset, which leaves room
+// for the games of other players.
+static void drawGame(const Graphics& graphics,
+                     float offset,
+                     Playfield& playfield,
+                     const Game& game)
+{
+    drawQuad(offset + board_left,
+             board_top,
+             board_width * cell_size,
+             board_visible_height * cell_size,
+             well_color,
+             well_order);
+
+    updatePlayfield(playfield, game.board);
+    drawQuadLayer(playfield.layer);
+
+    if (!game.over) {
+        const ActivePiece& piece = game.piece;
+        drawPiece(graphics, offset, piece.type, piece.rotation, piece.x, getGhostRow(game), ghost_color, ghost_order);
+        drawPiece(graphics, offset, piece.type, piece.rotation, piece.x, piece.y, piece_colors[int32_t(piece.type)], piece_order);
+    }
+
+    for (int32_t index = 0; index < preview_count; index++)
+    {
+        const PieceType type = game.previews[index];
+        drawPiece(graphics, offset, type, 0, board_width + 1, board_visible_height - 4 - index * 3, piece_colors[int32_t(type)], hud_order);
+    }
+
+    if (game.hasHold)
+        drawPiece(graphics, offset, game.hold, 0, -5, board_visible_height - 4, piece_colors[int32_t(game.hold)], hud_order);
+
+    drawHud(graphics, offset, game);
+}
+
+struct TickContext
+{
+    const SoundEffects* effects;
+    // The server the game is streamed to, or null.
+    SpectatorServer* spectators;
+};
+
+// Called by the game loop, so the effects are posted and the game is
+// published from the thread that runs the simulation.
+static void handleTick(void* context, const Game& game)
+{
+    const TickContext& tick = *static_cast<const TickContext*>(context);
+    playSoundEffects(game, *tick.effects);
+    if (tick.spectators != nullptr)
+        publishSpectatorGame(*tick.spectators, game);
+}
+
+static void playPauseTone(void*, bool paused)
+{
+    postSoundEvent(SoundEvent{
+        paused ? SoundCommand::StopTone : SoundCommand::StartTone });
+}
+
+struct PlayerInput
+{
+    bool left;
+    bool right;
+    bool down;
+    bool drop;
+    bool swap;
+    bool pause;
+    bool turnLeft;
+    bool turnRight;
+    Point cursorPos;
+    bool leftMouseButton;
+    bool rightMouseButton;
+    bool middleMouseButton;
+    Vector scroll;
+};
+
+static GameInput getGameInput(const PlayerInput& input)
+{
+    return GameInput{
+        input.left,
+        input.right,
+        input.down,
+        input.drop,
+        input.swap,
+        input.turnLeft,
+        input.turnRight
+    };
+}
+
+enum class StartupPhase : uint8_t
+{
+    Video,
+    Window,
+    Context,
+    GlLoader,
+    Renderer,
+    Graphics,
+    Audio,
+    SoundEffects,
+    // From the game being set up until its first frame is presented.
+    FirstFrame
+};
+
+static constexpr int32_t startup_phase_count = 9;
+
+static const char* getStartupPhaseName(StartupPhase phase)
+{
+    switch (phase)
+    {
+        case StartupPhase::Video: return "video";
+        case StartupPhase::Window: return "window";
+        case StartupPhase::Context: return "context";
+        case StartupPhase::GlLoader: return "gl_loader";
+        case StartupPhase::Renderer: return "renderer";
+        case StartupPhase::Graphics: return "graphics";
+        case StartupPhase::Audio: return "audio";
+        case StartupPhase::SoundEffects: return "sound_effects";
+        case StartupPhase::FirstFrame: return "first_frame";
+    }
+    UNREACHABLE("Unknown startup phase: %d", int32_t(phase));
+}
+
+// When each phase of the startup began and ended, in nanoseconds of
+// getSteadyTime. The audio phases run on a thread of their own while the
+// window and the GL context come up, so they overlap the others.
+struct StartupTimes
+{
+    uint64_t start;
+    uint64_t begins[startup_phase_count];
+    uint64_t ends[startup_phase_count];
+};
+
+static void beginStartupPhase(StartupTimes& times, StartupPhase phase)
+{
+    times.begins[int32_t(phase)] = getSteadyTime();
+}
+
+static void endStartupPhase(StartupTimes& times, StartupPhase phase)
+{
+    times.ends[int32_t(phase)] = getSteadyTime();
+}
+
+// Prints every phase relative to the start, one per line, in a format the
+// startup benchmark reads back.
+static void printStartupTimes(const StartupTimes& times)
+{
+    for (int32_t index = 0; index < startup_phase_count; index++)
+    {
+        printf("Startup %-14s %8.2f ms to %8.2f ms\n",
+               getStartupPhaseName(StartupPhase(index)),
+               (times.begins[index] - times.start) / 1e6,
+               (times.ends[index] - times.start) / 1e6);
+    }
+    const uint64_t total =
+        times.ends[int32_t(StartupPhase::FirstFrame)] - times.start;
+    printf("First frame after %.2f ms, %s the budget of %.0f ms\n",
+           total / 1e6,
+           total <= startup_budget ? "within" : "over",
+           startup_budget / 1e6);
+}
+
+// Opens the audio device and loads the sound effects on a thread of their
+// own, since both take a while and need nothing from the window.
+struct AudioStartup
+{
+    StartupTimes* times;
+    SoundEffects effects;
+    std::thread thread;
+};
+
+static void startAudio(AudioStartup* startup)
+{
+    beginStartupPhase(*startup->times, StartupPhase::Audio);
+    bool opened = SDL_InitSubSystem(SDL_INIT_AUDIO) == 0;
+    if (!opened) {
+        // TODO: Logging.
+        fprintf(stderr, "SDL audio initialization failed: %s\n", SDL_GetError());
+    }
+    opened = opened && initAudio(audio_sample_rate, audio_buffer_sample_count);
+    endStartupPhase(*startup->times, StartupPhase::Audio);
+
+    beginStartupPhase(*startup->times, StartupPhase::SoundEffects);
+    if (opened)
+        startup->effects = loadSoundEffects();
+    endStartupPhase(*startup->times, StartupPhase::SoundEffects);
+}
+
+// Draws the newest snapshot of the game loop. The thread that draws owns the
+// GL context, everything else only talks to it through the game loop and the
+// atomics.
+struct RenderThread
+{
+    SDL_Window* window;
+    SDL_GLContext context;
+    GameLoop* loop;
+    const Graphics* graphics;
+    // One for each game drawn side by side.
+    Playfield* playfields;
+    FrameProfiler* profiler;
+    Particles particles;
+    uint32_t particleRandom;
+    // The game of the snapshot drawn last, which new snapshots are compared
+    // to for the effects of what happened in between.
+    Game previousGame;
+    uint64_t previousFrameTime;
+    // Until the first frame is presented, then null.
+    StartupTimes* startup;
+    bool startupTimesPrinted;
+    bool quitAfterStartup;
+    std::atomic<bool> frameGraphToggled;
+    std::atomic<bool> quitting;
+    std::thread thread;
+};
+
+static float getCellTop(int32_t y)
+{
+    return board_top + (board_visible_height - 1 - y) * cell_size;
+}
+
+// Snapshots skip the ticks that ran between two frames, so what happened is
+// read from the counters of the game rather than its events where possible.
+static void emitGameParticles(RenderThread& render, const Game& game)
+{
+    const Game& previous = render.previousGame;
+    if (game.tick <= previous.tick || previous.over)
+        return;
+
+    // The previous piece locked at its ghost row, unless it was moved after
+    // the previous frame, which is close enough for effects.
+    const ActivePiece& piece = previous.piece;
+    const int32_t landedRow = getGhostRow(previous);
+    const Color& pieceColor = piece_colors[int32_t(piece.type)];
+
+    if (game.events & game_event_hard_dropped) {
+        const float top = getCellTop(landedRow + 3);
+        emitParticles(render.particles,
+                      ParticleBurst{ board_left + piece.x * cell_size,
+                                     top,
+                                     4 * cell_size,
+                                     getCellTop(landedRow) + cell_size - top,
+                                     60, -40, 0.4f, 4, pieceColor, 64 },
+                      render.particleRandom);
+    }
+
+    if (const int32_t clearedLines = game.lines - previous.lines; clearedLines > 0) {
+        const float top = getCellTop(landedRow + clearedLines - 1);
+        emitParticles(render.particles,
+                      ParticleBurst{ board_left,
+                                     top,
+                                     board_width * cell_size,
+                                     clearedLines * cell_size,
+                                     180, -120, 0.8f, 6, pieceColor,
+                                     uint32_t(clearedLines) * 400 },
+                      render.particleRandom);
+    }
+
+    if (game.level > previous.level) {
+        emitParticles(render.particles,
+                      ParticleBurst{ board_left,
+                                     board_top,
+                                     board_width * cell_size,
+                                     board_visible_height * cell_size,
+                                     300, -300, 1.5f, 8, text_color, 4000 },
+                      render.particleRandom);
+    }
+}
+
+// Draws the games side by side, each in a window_width wide column.
+static void drawFrame(RenderThread& render, const Game* games, int32_t gameCount)
+{
+    beginFrameProfile(*render.profiler);
+    if (render.frameGraphToggled.exchange(false, std::memory_order_relaxed))
+        toggleFrameGraph(*render.profiler);
+
+    const uint64_t time = getSteadyTime();
+    const float seconds = std::min(
+        float(time - render.previousFrameTime) / nanoseconds_per_second,
+        max_particle_frame_seconds);
+    render.previousFrameTime = time;
+    {
+        PROFILE_SCOPE("particles");
+        updateParticles(render.particles, seconds, particle_gravity);
+    }
+
+    {
+        PROFILE_SCOPE("draw");
+        beginGpuProfile(*render.profiler);
+        beginDrawing();
+        for (int32_t index = 0; index < gameCount; index++)
+        {
+            drawGame(*render.graphics,
+                     float(index * window_width),
+                     render.playfields[index],
+                     games[index]);
+        }
+        drawParticles(render.particles, render.graphics->block, particle_order);
+        drawFrameProfile(*render.profiler);
+        endDrawing();
+        endGpuProfile(*render.profiler);
+    }
+    endFrameProfile(*render.profiler);
+
+    PROFILE_SCOPE("swap");
+    SDL_GL_SwapWindow(render.window);
+
+    if (render.startup != nullptr) {
+        endStartupPhase(*render.startup, StartupPhase::FirstFrame);
+        if (render.startupTimesPrinted)
+            printStartupTimes(*render.startup);
+        render.startup = nullptr;
+        if (render.quitAfterStartup) {
+            SDL_Event event = {};
+            event.type = SDL_QUIT;
+            SDL_PushEvent(&event);
+        }
+    }
+}
+
+static void renderFrame(RenderThread& render)
+{
+    // Without a new snapshot the previous one is drawn again.
+    if (acquireGameSnapshot(*render.loop)) {
+        const Game& game = getGameSnapshot(*render.loop).game;
+        emitGameParticles(render, game);
+        render.previousGame = game;
+    }
+    drawFrame(render, &render.previousGame, 1);
+}
+
+static void runRenderThread(RenderThread* render)
+{
+    PROFILE_THREAD("render");
+    SDL_GL_MakeCurrent(render->window, render->context);
+    while (!render->quitting.load(std::memory_order_relaxed))
+    {
+        renderFrame(*render);
+    }
+    SDL_GL_MakeCurrent(render->window, nullptr);
+}
+
+// SDL stamps events in milliseconds since it was initialized, which is
+// turned into the clock of the game loop to include the time the event
+// waited in the queue.
+static uint64_t getEventTime(uint32_t timestamp)
+{
+    const uint64_t now = getSteadyTime();
+    const uint64_t age = uint64_t(SDL_GetTicks() - timestamp) * 1000000;
+    return age < now ? now - age : now;
+}
+
+// Passes changes of the buttons on to the game loop, if there is one.
+// Returns true when the window is closed.
+static bool handleEvent(const SDL_Event& event,
+                        PlayerInput& input,
+                        GameLoop* loop,
+                        RenderThread& render)
+{
+    const PlayerInput previous = input;
+    switch (event.type)
+    {
+        case SDL_QUIT:
+            return true;
+        case SDL_KEYDOWN:
+            switch (event.key.keysym.sym)
+            {
+                case SDLK_a: input.left = true; break;
+                case SDLK_d: input.right = true; break;
+                case SDLK_s: input.down = true; break;
+                case SDLK_SPACE: input.drop = true; break;
+                case SDLK_w: input.swap = true; break;
+                case SDLK_p: input.pause = true; break;
+                case SDLK_q: input.turnLeft = true; break;
+                case SDLK_e: input.turnRight = true; break;
+                case SDLK_F3:
+                    render.frameGraphToggled.store(true, std::memory_order_relaxed);
+                    break;
+            }
+            break;
+        case SDL_KEYUP:
+            switch (event.key.keysym.sym)
+            {
+                case SDLK_a: input.left = false; break;
+                case SDLK_d: input.right = false; break;
+                case SDLK_s: input.down = false; break;
+                case SDLK_SPACE: input.drop = false; break;
+                case SDLK_w: input.swap = false; break;
+                case SDLK_p: input.pause = false; break;
+                case SDLK_q: input.turnLeft = false; break;
+                case SDLK_e: input.turnRight = false; break;
+            }
+            break;
+        case SDL_MOUSEMOTION:
+            input.cursorPos = Point{ (float)event.motion.x, (float)event.motion.y };
+            break;
+        case SDL_MOUSEBUTTONUP:
+        case SDL_MOUSEBUTTONDOWN:
+            {
+                bool newState = (event.button.state == SDL_PRESSED);
+                switch (event.button.button)
+                {
+                    case SDL_BUTTON_LEFT: input.leftMouseButton = newState; break;
+                    case SDL_BUTTON_RIGHT: input.rightMouseButton = newState; break;
+                    case SDL_BUTTON_MIDDLE: input.middleMouseButton = newState; break;
+                }
+                break;
+            }
+        case SDL_MOUSEWHEEL:
+            input.scroll.x = event.wheel.x;
+            input.scroll.y =
+                event.wheel.y * (event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ?
+                    -1 :
+                    1);
+            break;
+    }
+
+    // Only what the game reacts to is passed on.
+    if (loop == nullptr || (event.type != SDL_KEYDOWN && event.type != SDL_KEYUP))
+        return false;
+    if (memcmp(&input, &previous, offsetof(PlayerInput, cursorPos)) == 0)
+        return false;
+
+    postInputEvent(*loop, InputEvent{
+        getGameInput(input),
+        input.pause,
+        getEventTime(event.key.timestamp)
+    });
+    return false;
+}
+
+struct VersusOptions
+{
+    uint16_t port;
+    NetAddress peer;
+    int32_t localPlayer;
+    LinkConditions conditions;
+};
+
+// Plays against another instance of the game over UDP, with rollback hiding
+// the latency. Everything runs on the main thread, the rollbacks included,
+// which only take a fraction of a frame.
+static int playVersus(RenderThread& render,
+                      const SoundEffects& effects,
+                      uint32_t seed,
+                      const VersusOptions& options)
+{
+    UdpSocket socket;
+    if (!openUdpSocket(socket, options.port)) {
+        // TODO: Logging.
+        fprintf(stderr, "Port %u could not be opened\n", options.port);
+        return 1;
+    }
+    LossyLink link;
+    initLossyLink(link,
+                  socket,
+                  options.conditions,
+                  seed + 1 + uint32_t(options.localPlayer),
+                  versus_link_capacity);
+    // Too large for the stack.
+    static RollbackSession session;
+    initRollbackSession(session, seed, options.localPlayer);
+    // A stall longer than the prediction can cover has to wait for the other
+    // side anyway.
+    FixedTimestep timestep = makeFixedTimestep(
+        tick_rate,
+        max_rollback_ticks,
+        nanoseconds_per_second,
+        getSteadyTime());
+
+    PlayerInput input = {};
+    bool quitting = false;
+    bool desyncReported = false;
+    while (!quitting)
+    {
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            quitting = handleEvent(event, input, nullptr, render) || quitting;
+        }
+
+        NetAddress address;
+        uint8_t bytes[max_udp_packet_size];
+        while (const size_t size = receiveUdpPacket(socket, address, bytes))
+        {
+            if (address == options.peer)
+                readRollbackPacket(session, bytes, size);
+        }
+
+        const uint64_t time = getSteadyTime();
+        const uint32_t ticks = advanceFixedTimestep(timestep, time);
+        for (uint32_t tick = 0; tick < ticks; tick++)
+        {
+            PROFILE_SCOPE("update");
+            if (advanceRollbackSession(session, getGameInput(input)))
+                playSoundEffects(session.game.players[options.localPlayer], effects);
+        }
+        if (ticks > 0) {
+            uint8_t packet[max_rollback_packet_size];
+            const size_t size = writeRollbackPacket(session, packet);
+            sendLinkPacket(link, options.peer, packet, size, time);
+        }
+        flushLossyLink(link, time);
+
+        if (session.desynced && !desyncReported) {
+            // TODO: Logging.
+            fprintf(stderr, "The match desynced after tick %llu\n",
+                    (unsigned long long)session.desyncTick);
+            desyncReported = true;
+        }
+
+        drawFrame(render, session.game.players, versus_player_count);
+    }
+
+    const RollbackStats& stats = session.stats;
+    if (stats.rollbackCount > 0) {
+        printf("Rolled back %llu times, %.2f ticks deep on average and %d at most, "
+               "taking %.3f ms at most\n",
+               (unsigned long long)stats.rollbackCount,
+               stats.resimulatedTickCount / double(stats.rollbackCount),
+               stats.maxRollbackDepth,
+               stats.maxRollbackTime / 1e6);
+    }
+    printf("Waited %llu ticks for the other player, %llu of %llu packets dropped\n",
+           (unsigned long long)(stats.stallCount + stats.syncWaitCount),
+           (unsigned long long)link.droppedCount,
+           (unsigned long long)link.sentCount);
+
+    destroyLossyLink(link);
+    closeUdpSocket(socket);
+    return 0;
+}
+
+// Shows the game another instance streams to its spectators, until the
+// window is closed or the stream ends.
+static int spectate(RenderThread& render, const NetAddress& address)
 {
-    for (int i = 0; i < sampleCount; i++)
+    SpectatorClient client;
+    if (!connectSpectatorClient(client, address)) {
+        // TODO: Logging.
+        fprintf(stderr, "The game to spectate could not be reached\n");
+        return 1;
+    }
+
+    PlayerInput input = {};
+    bool quitting = false;
+    bool connected = true;
+    while (!quitting && connected)
     {
-        buffer[i] = (int16_t)(sinf((((i + start) % soundFreq) / (float)soundFreq) * 3.1415f) * (INT16_MAX / 4));
+        SDL_Event event;
+        while (SDL_PollEvent(&event))
+        {
+            quitting = handleEvent(event, input, nullptr, render) || quitting;
+        }
+        connected = readSpectatorClient(client);
+        drawFrame(render, &client.game, client.synced ? 1 : 0);
     }
+    if (!connected)
+        printf("The game ended the stream after %llu frames\n", (unsigned long long)client.frameCount);
+
+    closeSpectatorClient(client);
+    return 0;
+}
+
+// Plays games without a window, audio or vsync, and reports how fast the
+// simulation ran.
+static int runHeadlessGames(InputSource& source,
+                            uint32_t seed,
+                            uint64_t gameCount,
+                            uint64_t maxTickCount)
+{
+    const HeadlessReport report =
+        runHeadless(source, seed, gameCount, maxTickCount);
+    printf("%llu games, %llu ticks, %llu lines, best score %u\n",
+           (unsigned long long)report.gameCount,
+           (unsigned long long)report.tickCount,
+           (unsigned long long)report.lineCount,
+           report.bestScore);
+    printf("%.3f s, %.0f ticks/s\n", report.seconds, getTicksPerSecond(report));
+    return 0;
 }
 
-int main()
+int main(int argc, char* argv[])
 {
-    if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
+    // The older rendering paths are kept around to compare against.
+    bool singleThreaded = false;
+    QuadMode quadMode = QuadMode::Instanced;
+    StreamBufferMode streamMode = StreamBufferMode::Fenced;
+    GlSeverity glSeverity = GlSeverity::Medium;
+    const char* tracePath = nullptr;
+    bool headless = false;
+    uint64_t headlessGameCount = default_headless_game_count;
+    uint64_t headlessTickCount = default_headless_tick_count;
+    uint32_t seed = 0;
+    bool hasSeed = false;
+    const char* recordPath = nullptr;
+    const char* replayPath = nullptr;
+    uint64_t replayTick = 0;
+    bool botPlaying = false;
+    BotOptions botOptions = getDefaultBotOptions();
+    const char* versusPeer = nullptr;
+    VersusOptions versusOptions = {};
+    versusOptions.localPlayer = 0;
+    const char* spectatorPort = nullptr;
+    int32_t maxSpectators = default_max_spectators;
+    const char* spectated = nullptr;
+    const char* programCachePath = nullptr;
+    bool programCacheUsed = true;
+    bool startupTimesPrinted = false;
+    bool quitAfterStartup = false;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strcmp(argv[index], "--indexed-quads") == 0)
+            quadMode = QuadMode::Indexed;
+        else if (strcmp(argv[index], "--orphan-buffers") == 0)
+            streamMode = StreamBufferMode::Orphaning;
+        else if (strcmp(argv[index], "--gl-severity=notification") == 0)
+            glSeverity = GlSeverity::Notification;
+        else if (strcmp(argv[index], "--gl-severity=low") == 0)
+            glSeverity = GlSeverity::Low;
+        else if (strcmp(argv[index], "--gl-severity=high") == 0)
+            glSeverity = GlSeverity::High;
+        else if (strcmp(argv[index], "--single-thread") == 0)
+            singleThreaded = true;
+        else if (strncmp(argv[index], "--trace=", 8) == 0)
+            tracePath = argv[index] + 8;
+        else if (strcmp(argv[index], "--headless") == 0)
+            headless = true;
+        else if (strncmp(argv[index], "--games=", 8) == 0)
+            headlessGameCount = strtoull(argv[index] + 8, nullptr, 10);
+        else if (strncmp(argv[index], "--ticks=", 8) == 0)
+            headlessTickCount = strtoull(argv[index] + 8, nullptr, 10);
+        else if (strncmp(argv[index], "--seed=", 7) == 0) {
+            seed = uint32_t(strtoul(argv[index] + 7, nullptr, 10));
+            hasSeed = true;
+        }
+        else if (strncmp(argv[index], "--record=", 9) == 0)
+            recordPath = argv[index] + 9;
+        else if (strncmp(argv[index], "--replay=", 9) == 0)
+            replayPath = argv[index] + 9;
+        else if (strncmp(argv[index], "--replay-tick=", 14) == 0)
+            replayTick = strtoull(argv[index] + 14, nullptr, 10);
+        else if (strcmp(argv[index], "--bot") == 0)
+            botPlaying = true;
+        else if (strncmp(argv[index], "--bot-depth=", 12) == 0)
+            botOptions.maxDepth = atoi(argv[index] + 12);
+        else if (strncmp(argv[index], "--bot-budget-ms=", 16) == 0) {
+            botOptions.timeBudget =
+                std::chrono::milliseconds(strtoull(argv[index] + 16, nullptr, 10));
+        }
+        else if (strncmp(argv[index], "--versus-port=", 14) == 0)
+            versusOptions.port = uint16_t(strtoul(argv[index] + 14, nullptr, 10));
+        else if (strncmp(argv[index], "--versus-peer=", 14) == 0)
+            versusPeer = argv[index] + 14;
+        else if (strcmp(argv[index], "--versus-player=2") == 0)
+            versusOptions.localPlayer = 1;
+        else if (strncmp(argv[index], "--net-latency-ms=", 17) == 0)
+            versusOptions.conditions.latency = strtoull(argv[index] + 17, nullptr, 10) * 1000000;
+        else if (strncmp(argv[index], "--net-jitter-ms=", 16) == 0)
+            versusOptions.conditions.jitter = strtoull(argv[index] + 16, nullptr, 10) * 1000000;
+        else if (strncmp(argv[index], "--net-loss=", 11) == 0)
+            versusOptions.conditions.lossRate = float(atof(argv[index] + 11)) / 100;
+        else if (strncmp(argv[index], "--spectator-port=", 17) == 0)
+            spectatorPort = argv[index] + 17;
+        else if (strncmp(argv[index], "--max-spectators=", 17) == 0)
+            maxSpectators = atoi(argv[index] + 17);
+        else if (strncmp(argv[index], "--spectate=", 11) == 0)
+            spectated = argv[index] + 11;
+        else if (strncmp(argv[index], "--program-cache=", 16) == 0)
+            programCachePath = argv[index] + 16;
+        else if (strcmp(argv[index], "--no-program-cache") == 0)
+            programCacheUsed = false;
+        else if (strcmp(argv[index], "--startup-times") == 0)
+            startupTimesPrinted = true;
+        else if (strcmp(argv[index], "--quit-after-startup") == 0)
+            quitAfterStartup = true;
+    }
+
+    if (botOptions.maxDepth < 1 || botOptions.maxDepth > max_search_depth) {
+        fprintf(stderr, "The bot searches 1 to %d pieces deep\n", max_search_depth);
+        return 1;
+    }
+
+    const bool versus = versusPeer != nullptr;
+    if (versus && !parseNetAddress(versusPeer, versusOptions.peer)) {
+        fprintf(stderr, "%s is not an address like 127.0.0.1:7000\n", versusPeer);
+        return 1;
+    }
+    if (versus && (headless || botPlaying || recordPath != nullptr || replayPath != nullptr)) {
+        fprintf(stderr, "Versus is only played by people, without replays\n");
+        return 1;
+    }
+
+    NetAddress spectatedAddress = {};
+    if (spectated != nullptr && !parseNetAddress(spectated, spectatedAddress)) {
+        fprintf(stderr, "%s is not an address like 127.0.0.1:7000\n", spectated);
+        return 1;
+    }
+    if (spectated != nullptr && (headless || versus || botPlaying || recordPath != nullptr || replayPath != nullptr)) {
+        fprintf(stderr, "Spectating only shows the game, it does not play one\n");
+        return 1;
+    }
+    if (spectatorPort != nullptr && (headless || versus || spectated != nullptr)) {
+        fprintf(stderr, "Only a game played in the window can be spectated\n");
+        return 1;
+    }
+    if (maxSpectators < 1) {
+        fprintf(stderr, "At least 1 spectator has to be allowed\n");
+        return 1;
+    }
+
+    Replay replay = {};
+    if (replayPath != nullptr) {
+        if (!openReplay(replay, replayPath)) {
+            // TODO: Logging.
+            fprintf(stderr, "Replay %s could not be opened\n", replayPath);
+            return 1;
+        }
+        if (replayTick > replay.tickCount) {
+            fprintf(stderr, "Replay %s is only %llu ticks long\n",
+                    replayPath,
+                    (unsigned long long)replay.tickCount);
+            return 1;
+        }
+        seed = replay.seed;
+    }
+
+    // Too large for the stack.
+    static Bot bot;
+    const HeuristicWeights botWeights = getDefaultHeuristicWeights();
+    BotPlayer botPlayer = {};
+    InputSource botSource = {};
+    if (botPlaying) {
+        initBot(bot, botOptions, makeHeuristicEvaluator(botWeights));
+        botPlayer = makeBotPlayer(bot);
+        botSource = makeBotInputSource(botPlayer);
+    }
+
+    if (headless) {
+        if (botPlaying) {
+            const int result = runHeadlessGames(
+                botSource,
+                seed,
+                headlessGameCount,
+                headlessTickCount);
+            destroyBot(bot);
+            return result;
+        }
+        if (replayPath != nullptr) {
+            InputSource source = makeReplayInputSource(replay, 0);
+            const int result =
+                runHeadlessGames(source, replay.seed, 1, replay.tickCount);
+            closeReplay(replay);
+            return result;
+        }
+        InputSource source = makeRandomInputSource(seed);
+        return runHeadlessGames(
+            source,
+            seed,
+            headlessGameCount,
+            headlessTickCount);
+    }
+
+    // Timed from here, the flags are read in no time.
+    StartupTimes startupTimes = {};
+    startupTimes.start = getSteadyTime();
+
+    // Started before the audio so that its thread is named in the trace.
+    FrameProfiler profiler;
+    initFrameProfiler(profiler, tracePath);
+
+    beginStartupPhase(startupTimes, StartupPhase::Video);
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
         // TODO: Logging.
         fprintf(stderr, "SDL initialization failed: %s\n", SDL_GetError());
         return 1;
     }
+    endStartupPhase(startupTimes, StartupPhase::Video);
+
+    static AudioStartup audioStartup;
+    audioStartup.times = &startupTimes;
+    audioStartup.effects = SoundEffects{ -1, -1, -1, -1, -1, -1, -1 };
+    audioStartup.thread = std::thread(startAudio, &audioStartup);
 
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 4);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 0);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
+#if defined(GL_DIAGNOSTICS)
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
         SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG | SDL_GL_CONTEXT_DEBUG_FLAG);
+#else
+    SDL_GL_SetAttribute(SDL_GL_CONTEXT_FLAGS,
+        SDL_GL_CONTEXT_FORWARD_COMPATIBLE_FLAG);
+#endif
 
-    SDL_Window* window = SDL_CreateWindow("Tetris", 0, 0, 720, 480, SDL_WINDOW_OPENGL);
+    // Versus shows both games side by side.
+    const int32_t gameCount = versus ? versus_player_count : 1;
+    beginStartupPhase(startupTimes, StartupPhase::Window);
+    SDL_Window* window = SDL_CreateWindow("Tetris", 0, 0, window_width * gameCount, window_height, SDL_WINDOW_OPENGL);
+    endStartupPhase(startupTimes, StartupPhase::Window);
     if (window == nullptr) {
         // TODO: Logging.
         fprintf(stderr, "Window creation failed: %s\n", SDL_GetError());
+        audioStartup.thread.join();
+        destroyAudio();
         SDL_Quit();
         return 1;
     }
 
-    if (SDL_GL_CreateContext(window) == nullptr) {
+    beginStartupPhase(startupTimes, StartupPhase::Context);
+    const SDL_GLContext context = SDL_GL_CreateContext(window);
+    endStartupPhase(startupTimes, StartupPhase::Context);
+    if (context == nullptr) {
         // TODO: Logging.
         fprintf(stderr, "OpenGL context creation failed: %s\n", SDL_GetError());
+        audioStartup.thread.join();
+        destroyAudio();
         SDL_Quit();
         return 1;
     }
 
+    beginStartupPhase(startupTimes, StartupPhase::GlLoader);
     if (!gladLoadGLLoader((GLADloadproc)SDL_GL_GetProcAddress)) {
         // TODO: Logging.
         fprintf(stderr, "GLAD initialization failed: %s\n", SDL_GetError());
+        audioStartup.thread.join();
+        destroyAudio();
         SDL_Quit();
         return 1;
     }
+    endStartupPhase(startupTimes, StartupPhase::GlLoader);
+
+    initGlDiagnostics(glSeverity);
+    initGpuProfile(profiler);
 
-    SDL_AudioSpec inputSpec, outputSpec;
-    inputSpec.freq = 48000;
-    inputSpec.format = AUDIO_S16;
-    inputSpec.channels = 1;
-    inputSpec.samples = 4096;
-    inputSpec.callback = nullptr;
-    inputSpec.userdata = nullptr;
-
-    SDL_AudioDeviceID device = SDL_OpenAudioDevice(nullptr, false, &inputSpec, &outputSpec, 0);
-    
-    int16_t* buffer = new int16_t[outputSpec.freq / 60];
-    int start = 0;
-
-    SDL_PauseAudioDevice(device, false);
-
-    initRenderer(1, 720, 480);
-
-    glClearColor(1, 0, 1, 1);
-
-    struct {
-        bool left;
-        bool right;
-        bool down;
-        bool drop;
-        bool swap;
-        bool pause;
-        bool turnLeft;
-        bool turnRight;
-        Point cursorPos;
-        bool leftMouseButton;
-        bool rightMouseButton;
-        bool middleMouseButton;
-        Vector scroll;
-    } input = {};
-    while (!SDL_QuitRequested())
+    // Rendering is paced by the display, the game itself by the fixed
+    // timestep of the game loop.
+    SDL_GL_SetSwapInterval(1);
+
+    // SDL creates the directory if it does not exist yet.
+    char* prefPath = nullptr;
+    if (programCacheUsed && programCachePath == nullptr) {
+        prefPath = SDL_GetPrefPath("tetris", "tetris");
+        if (prefPath != nullptr) {
+            // Without its trailing separator.
+            const size_t length = strlen(prefPath);
+            if (length > 1 && prefPath[length - 1] == '/')
+                prefPath[length - 1] = '\0';
+            programCachePath = prefPath;
+        }
+    }
+
+    beginStartupPhase(startupTimes, StartupPhase::Renderer);
+    initRenderer(
+        RenderBackend::OpenGl,
+        max_quad_count * gameCount + max_particle_count,
+        window_width * gameCount,
+        window_height,
+        quadMode,
+        streamMode,
+        programCacheUsed ? programCachePath : nullptr);
+    endStartupPhase(startupTimes, StartupPhase::Renderer);
+    SDL_free(prefPath);
+
+    beginStartupPhase(startupTimes, StartupPhase::Graphics);
+    const Graphics graphics = loadGraphics();
+    Playfield playfields[versus_player_count];
+    for (int32_t index = 0; index < gameCount; index++)
     {
-        input.scroll = {};
+        playfields[index] = makePlayfield(
+            float(index * window_width) + board_left,
+            board_top,
+            cell_size,
+            graphics.block,
+            stack_color,
+            stack_order);
+    }
+    endStartupPhase(startupTimes, StartupPhase::Graphics);
 
+    glClearColor(0, 0, 0, 1);
+
+    // The sound effects are needed from the first tick on.
+    audioStartup.thread.join();
+    const SoundEffects& soundEffects = audioStartup.effects;
+    postSoundEvent(SoundEvent{ SoundCommand::StartTone });
+
+    static RenderThread render;
+    render.window = window;
+    render.context = context;
+    render.graphics = &graphics;
+    render.playfields = playfields;
+    render.profiler = &profiler;
+    initParticles(render.particles, max_particle_count);
+    render.particleRandom = 1;
+    render.previousFrameTime = getSteadyTime();
+    render.startup = &startupTimes;
+    render.startupTimesPrinted = startupTimesPrinted;
+    render.quitAfterStartup = quitAfterStartup;
+    beginStartupPhase(startupTimes, StartupPhase::FirstFrame);
+
+    if (versus) {
+        const int result = playVersus(render, soundEffects, seed, versusOptions);
+        destroyFrameProfiler(profiler);
+        destroyParticles(render.particles);
+        destroyRenderer();
+        destroyAudio();
+        SDL_Quit();
+        return result;
+    }
+
+    if (spectated != nullptr) {
+        const int result = spectate(render, spectatedAddress);
+        destroyFrameProfiler(profiler);
+        destroyParticles(render.particles);
+        destroyRenderer();
+        destroyAudio();
+        SDL_Quit();
+        return result;
+    }
+
+    // Too large for the stack.
+    static SpectatorServer spectatorServer;
+    const bool streaming = spectatorPort != nullptr;
+    const uint64_t streamStart = getSteadyTime();
+    if (streaming) {
+        const uint16_t port = uint16_t(strtoul(spectatorPort, nullptr, 10));
+        if (!openSpectatorServer(spectatorServer, port, maxSpectators)) {
+            // TODO: Logging.
+            fprintf(stderr, "Port %s could not be opened for spectators\n", spectatorPort);
+            destroyFrameProfiler(profiler);
+            destroyParticles(render.particles);
+            destroyRenderer();
+            destroyAudio();
+            SDL_Quit();
+            return 1;
+        }
+        startSpectatorServerThread(spectatorServer);
+    }
+
+    if (replayPath == nullptr && !hasSeed)
+        seed = uint32_t(SDL_GetPerformanceCounter());
+    const Game game = replayPath != nullptr ?
+        seekReplay(replay, replayTick) :
+        makeGame(seed);
+    InputSource replaySource = {};
+    if (replayPath != nullptr)
+        replaySource = makeReplayInputSource(replay, replayTick);
+    ReplayWriter replayWriter = {};
+    const bool recording = recordPath != nullptr &&
+        openReplayWriter(
+            replayWriter,
+            recordPath,
+            seed,
+            default_keyframe_interval);
+    if (recordPath != nullptr && !recording) {
+        // TODO: Logging.
+        fprintf(stderr, "Replay %s could not be created\n", recordPath);
+    }
+
+    if (streaming)
+        publishSpectatorGame(spectatorServer, game);
+    TickContext tickContext = { &soundEffects, streaming ? &spectatorServer : nullptr };
+
+    static GameLoop loop;
+    InputSource* source = nullptr;
+    if (botPlaying)
+        source = &botSource;
+    else if (replayPath != nullptr)
+        source = &replaySource;
+    initGameLoop(
+        loop,
+        game,
+        GameLoopCallbacks{ handleTick, playPauseTone, &tickContext },
+        source,
+        recording ? &replayWriter : nullptr,
+        getSteadyTime());
+
+    render.loop = &loop;
+    render.previousGame = game;
+    if (!singleThreaded) {
+        // The render thread takes over the context until it is done.
+        SDL_GL_MakeCurrent(window, nullptr);
+        render.thread = std::thread(runRenderThread, &render);
+        startGameLoopThread(loop);
+    }
+
+    PlayerInput input = {};
+    bool quitting = false;
+    while (!quitting)
+    {
         SDL_Event event;
-        while (SDL_PollEvent(&event))
-        {
-            switch (event.type)
+        if (singleThreaded) {
+            while (SDL_PollEvent(&event))
             {
-                // TODO: Should we handle the quit event instead of using
-                //       SDL_QuitRequested?
-                case SDL_KEYDOWN:
-                    switch (event.key.keysym.sym)
-                    {
-                        case SDLK_a: input.left = true; break;
-                        case SDLK_d: input.right = true; break;
-                        case SDLK_s: input.down = true; break;
-                        case SDLK_SPACE: input.drop = true; break;
-                        case SDLK_w: input.swap = true; break;
-                        case SDLK_p: input.pause = true; break;
-                        case SDLK_q: input.turnLeft = true; break;
-                        case SDLK_e: input.turnRight = true; break;
-                    }
-                    break;
-                case SDL_KEYUP:
-                    switch (event.key.keysym.sym)
-                    {
-                        case SDLK_a: input.left = false; break;
-                        case SDLK_d: input.right = false; break;
-                        case SDLK_s: input.down = false; break;
-                        case SDLK_SPACE: input.drop = false; break;
-                        case SDLK_w: input.swap = false; break;
-                        case SDLK_p: input.pause = false; break;
-                        case SDLK_q: input.turnLeft = false; break;
-                        case SDLK_e: input.turnRight = false; break;
-                    }
-                    break;
-                case SDL_MOUSEMOTION:
-                    input.cursorPos = Point{ (float)event.motion.x, (float)event.motion.y };
-                    break;
-                case SDL_MOUSEBUTTONUP:
-                case SDL_MOUSEBUTTONDOWN:
-                    {
-                        bool newState = (event.button.state == SDL_PRESSED);
-                        switch (event.button.button)
-                        {
-                            case SDL_BUTTON_LEFT: input.leftMouseButton = newState; break;
-                            case SDL_BUTTON_RIGHT: input.rightMouseButton = newState; break;
-                            case SDL_BUTTON_MIDDLE: input.middleMouseButton = newState; break;
-                        }
-                        break;
-                    }
-                case SDL_MOUSEWHEEL:
-                    input.scroll.x = event.wheel.x;
-                    input.scroll.y =
-                        event.wheel.y * (event.wheel.direction == SDL_MOUSEWHEEL_FLIPPED ?
-                            -1 :
-                            1);
-                    break;
+                quitting = handleEvent(event, input, &loop, render) || quitting;
             }
+            updateGameLoop(loop, getSteadyTime());
+            renderFrame(render);
         }
+        // Waiting wakes up as soon as there is an event, so it is passed on
+        // right away no matter what the other threads are doing.
+        else if (SDL_WaitEventTimeout(&event, event_wait_timeout_ms)) {
+            quitting = handleEvent(event, input, &loop, render);
+        }
+    }
 
-        int32_t posX = (input.left || input.scroll.x < 0) ? (input.right || input.scroll.x > 0) ? 180 : 90 : (input.right || input.scroll.x > 0) ? 270 : 180;
-        int32_t posY = (input.swap || input.scroll.y > 0) ? (input.down || input.scroll.y < 0) ? 120 : 60 : (input.down || input.scroll.y < 0) ? 180 : 120;
-        Color color = input.drop ? Color{ 0, 1, 0 } : input.pause ? Color{ 1, 0, 0 } : Color{ 1, 1, 0 };
-        int32_t width = input.turnLeft ? 180 : 360;
-        int32_t height = input.turnRight ? 120 : 240;
-
-        if (!(input.cursorPos.x < posX || input.cursorPos.x > (posX + width) || input.cursorPos.y < posY || input.cursorPos.y > (posY + height)))
-            if (input.leftMouseButton || input.rightMouseButton || input.middleMouseButton)
-                color = Color{ 0, 1, 1 };
+    if (!singleThreaded) {
+        stopGameLoopThread(loop);
+        render.quitting.store(true, std::memory_order_relaxed);
+        render.thread.join();
+        SDL_GL_MakeCurrent(window, context);
+    }
 
-        if (!input.pause) {
-            generateSineWave(buffer, outputSpec.freq / 60, outputSpec.freq / 400, start);
-            start = (start + (outputSpec.freq / 60)) % (outputSpec.freq / 400);
-            SDL_QueueAudio(device, buffer, (outputSpec.freq / 60) * sizeof(int16_t));
-        }
+    if (const uint64_t count = loop.inputLatencyCount; count > 0) {
+        printf("Input latency %.2f ms on average, %.2f ms at most\n",
+               loop.totalInputLatency / double(count) / 1e6,
+               loop.maxInputLatency / 1e6);
+    }
 
-        beginDrawing();
-        drawQuad(posX, posY, width, height, color);
-        endDrawing();
-        SDL_GL_SwapWindow(window);
+    if (streaming) {
+        stopSpectatorServerThread(spectatorServer);
+        const SpectatorStats& stats = spectatorServer.stats;
+        printf("Streamed %llu frames to %llu spectators, resynced %llu times, "
+               "%.1f%% of the time busy\n",
+               (unsigned long long)stats.encodedCount,
+               (unsigned long long)stats.acceptedCount,
+               (unsigned long long)stats.resyncCount,
+               stats.busyTime * 100.0 / (getSteadyTime() - streamStart));
+        closeSpectatorServer(spectatorServer);
     }
 
-    delete[] buffer;
+    if (recording && !closeReplayWriter(replayWriter)) {
+        // TODO: Logging.
+        fprintf(stderr, "Replay %s could not be written\n", recordPath);
+    }
+    closeReplay(replay);
+    if (botPlaying)
+        destroyBot(bot);
 
+    destroyFrameProfiler(profiler);
+    destroyParticles(render.particles);
     destroyRenderer();
 
-    SDL_CloseAudioDevice(device);
+    destroyAudio();
 
     SDL_Quit();
 }
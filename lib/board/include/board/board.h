@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstdint>
+
+#include "board/piece.h"
+
+constexpr int32_t board_width = 10;
+constexpr int32_t board_height = 24;
+constexpr int32_t board_visible_height = 20;
+
+// Every row is a 16 bit mask with the playfield columns in the middle and
+// solid walls on both sides, so wall collisions fall out of the same AND that
+// detects collisions with the stack.
+constexpr int32_t board_left_wall = 3;
+constexpr uint16_t board_full_row = 0xFFFF;
+constexpr uint16_t board_empty_row =
+    uint16_t(~(((1u << board_width) - 1) << board_left_wall));
+
+// Solid rows kept below the floor and above the ceiling so that any four
+// consecutive rows a piece mask can overlap are always readable.
+constexpr int32_t board_padding = 4;
+
+struct Board
+{
+    uint16_t rows[board_padding + board_height + board_padding];
+};
+
+Board makeBoard();
+
+bool isOccupied(const Board& board, int32_t x, int32_t y);
+
+// Returns the playfield cells of a row with column 0 in the lowest bit.
+uint16_t getRow(const Board& board, int32_t y);
+void setRow(Board& board, int32_t y, uint16_t cells);
+
+bool collides(const Board& board, PieceMask mask, int32_t x, int32_t y);
+
+// Like collides, for a mask that is already shifted to its column, as the
+// piece tables hold them.
+bool collidesShifted(const Board& board, PieceMask shiftedMask, int32_t y);
+
+// Returns the lowest row the piece reaches when moved straight down from y.
+int32_t findDropRow(const Board& board, PieceMask mask, int32_t x, int32_t y);
+
+void lockPiece(Board& board, PieceMask mask, int32_t x, int32_t y);
+
+// Removes the full rows among the four rows starting at y, which are the only
+// rows that can have been completed by a piece locked at y, and returns the
+// number of rows removed.
+int32_t clearLines(Board& board, int32_t y);
+
+// Pushes the stack up by count rows and fills the bottom rows with garbage,
+// full except for the cell in the hole column. Returns false if cells were
+// pushed out of the top of the board, which are lost.
+bool addGarbageRows(Board& board, int32_t count, int32_t hole);
+
+// Hard drops a piece from its spawn row, locks it and clears lines. Returns
+// the number of cleared lines, or -1 when the piece cannot be placed in the
+// requested column, which leaves the board untouched.
+int32_t dropPiece(Board& board, PieceType type, int32_t rotation, int32_t x);
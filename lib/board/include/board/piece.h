@@ -0,0 +1,28 @@
+#pragma once
+
+#include <cstdint>
+
+// A piece mask packs the 4x4 bounding box of a piece into four 16 bit lanes,
+// one per row, with the bottom row in the lowest lane and the leftmost column
+// in the lowest bit of each lane. This matches the row layout of the board so
+// a mask can be shifted into place and tested against four rows at once.
+using PieceMask = uint64_t;
+
+enum class PieceType : uint8_t
+{
+    I,
+    O,
+    T,
+    S,
+    Z,
+    J,
+    L
+};
+
+constexpr int32_t piece_type_count = 7;
+constexpr int32_t rotation_count = 4;
+
+constexpr int32_t piece_spawn_x = 3;
+constexpr int32_t piece_spawn_y = 18;
+
+PieceMask getPieceMask(PieceType type, int32_t rotation);
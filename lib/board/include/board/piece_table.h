@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+
+#include "board/piece.h"
+
+// Everything moving and rotating a piece looks up, generated at compile time
+// from the spawn shapes, so that the moves themselves are only table lookups
+// and bit tests.
+//
+// Shapes are written as 4x4 boxes with the top row in the highest nibble and
+// the leftmost column in the lowest bit of each nibble. The other rotation
+// states are found by turning the spawn shape clockwise inside the box it
+// rotates in, which gives the SRS states.
+
+struct PieceBox
+{
+    uint16_t spawnShape;
+    // The box is size x size cells, starting at the top row and at column.
+    int32_t size;
+    int32_t column;
+};
+
+constexpr PieceBox piece_boxes[piece_type_count] = {
+    { 0x0F00, 4, 0 }, // I
+    { 0x6600, 2, 1 }, // O
+    { 0x2700, 3, 0 }, // T
+    { 0x6300, 3, 0 }, // S
+    { 0x3600, 3, 0 }, // Z
+    { 0x1700, 3, 0 }, // J
+    { 0x4700, 3, 0 }  // L
+};
+
+enum class PieceTurn : uint8_t
+{
+    Clockwise,
+    CounterClockwise
+};
+
+constexpr int32_t piece_turn_count = 2;
+
+// Offsets tried in order when a rotation is blocked.
+constexpr int32_t piece_kick_count = 3;
+constexpr int8_t piece_kick_offsets[piece_kick_count] = { 0, -1, 1 };
+
+// The columns the box of a piece can be shifted to within a 16 bit row.
+constexpr int32_t piece_column_count = 16 - 4 + 1;
+
+template <int32_t BoardWidth>
+struct PieceTable
+{
+    static_assert(BoardWidth >= 4 && BoardWidth <= 10,
+                  "Every x a piece can be kicked to has to fit in a 16 bit row");
+
+    // The columns of wall left of the playfield, the rest of the row right
+    // of it is wall as well.
+    static constexpr int32_t left_wall = (16 - BoardWidth) / 2;
+
+    uint16_t shapes[piece_type_count][rotation_count];
+    // The masks of the shapes with the box shifted to column x + left_wall.
+    PieceMask masks[piece_type_count][rotation_count][piece_column_count];
+    // The range of x that keeps every cell of a piece inside the walls.
+    int8_t minX[piece_type_count][rotation_count];
+    int8_t maxX[piece_type_count][rotation_count];
+    // The rotation state each turn leads to.
+    int8_t turns[rotation_count][piece_turn_count];
+    // The offsets to x tried in order for each turn.
+    int8_t kicks[piece_type_count][rotation_count][piece_turn_count][piece_kick_count];
+};
+
+constexpr bool isShapeCell(uint16_t shape, int32_t row, int32_t column)
+{
+    return (shape >> ((3 - row) * 4 + column)) & 1;
+}
+
+constexpr uint16_t getShapeCell(int32_t row, int32_t column)
+{
+    return uint16_t(1u << ((3 - row) * 4 + column));
+}
+
+constexpr int32_t countShapeCells(uint16_t shape)
+{
+    int32_t count = 0;
+    for (int32_t bit = 0; bit < 16; bit++)
+    {
+        count += (shape >> bit) & 1;
+    }
+    return count;
+}
+
+constexpr uint16_t turnShapeClockwise(uint16_t shape, const PieceBox& box)
+{
+    uint16_t turned = 0;
+    for (int32_t row = 0; row < 4; row++)
+    {
+        for (int32_t column = 0; column < 4; column++)
+        {
+            if (!isShapeCell(shape, row, column))
+                continue;
+
+            const int32_t boxColumn = column - box.column;
+            turned |= getShapeCell(boxColumn, box.column + box.size - 1 - row);
+        }
+    }
+    return turned;
+}
+
+// The bottom row of the box goes to the lowest lane.
+constexpr PieceMask getShapeMask(uint16_t shape)
+{
+    PieceMask mask = 0;
+    for (int32_t row = 0; row < 4; row++)
+    {
+        mask |= PieceMask((shape >> (row * 4)) & 0xF) << (row * 16);
+    }
+    return mask;
+}
+
+template <int32_t BoardWidth>
+constexpr PieceTable<BoardWidth> makePieceTable()
+{
+    PieceTable<BoardWidth> table = {};
+    for (int32_t type = 0; type < piece_type_count; type++)
+    {
+        const PieceBox& box = piece_boxes[type];
+        uint16_t shape = box.spawnShape;
+        for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+        {
+            table.shapes[type][rotation] = shape;
+            const PieceMask mask = getShapeMask(shape);
+            for (int32_t column = 0; column < piece_column_count; column++)
+            {
+                table.masks[type][rotation][column] = mask << column;
+            }
+
+            int32_t left = 3;
+            int32_t right = 0;
+            for (int32_t column = 0; column < 4; column++)
+            {
+                for (int32_t row = 0; row < 4; row++)
+                {
+                    if (!isShapeCell(shape, row, column))
+                        continue;
+                    left = column < left ? column : left;
+                    right = column > right ? column : right;
+                }
+            }
+            table.minX[type][rotation] = int8_t(-left);
+            table.maxX[type][rotation] = int8_t(BoardWidth - 1 - right);
+
+            for (int32_t turn = 0; turn < piece_turn_count; turn++)
+            {
+                for (int32_t kick = 0; kick < piece_kick_count; kick++)
+                {
+                    table.kicks[type][rotation][turn][kick] = piece_kick_offsets[kick];
+                }
+            }
+
+            shape = turnShapeClockwise(shape, box);
+        }
+    }
+    for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+    {
+        table.turns[rotation][int32_t(PieceTurn::Clockwise)] =
+            int8_t((rotation + 1) % rotation_count);
+        table.turns[rotation][int32_t(PieceTurn::CounterClockwise)] =
+            int8_t((rotation + rotation_count - 1) % rotation_count);
+    }
+    return table;
+}
+
+// Checks what the tables promise: every state has four cells, four turns
+// lead back to the spawn shape, and every x a piece can be at inside the
+// walls in any rotation, kicked or not, has a mask in every rotation.
+template <int32_t BoardWidth>
+constexpr bool isPieceTableValid(const PieceTable<BoardWidth>& table)
+{
+    constexpr int32_t left_wall = PieceTable<BoardWidth>::left_wall;
+    int32_t minKick = 0;
+    int32_t maxKick = 0;
+    for (int32_t kick = 0; kick < piece_kick_count; kick++)
+    {
+        const int32_t offset = piece_kick_offsets[kick];
+        minKick = offset < minKick ? offset : minKick;
+        maxKick = offset > maxKick ? offset : maxKick;
+    }
+
+    for (int32_t type = 0; type < piece_type_count; type++)
+    {
+        const PieceBox& box = piece_boxes[type];
+        uint16_t shape = box.spawnShape;
+        for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+        {
+            shape = turnShapeClockwise(shape, box);
+            if (countShapeCells(table.shapes[type][rotation]) != 4)
+                return false;
+            for (int32_t other = 0; other < rotation_count; other++)
+            {
+                if (table.minX[type][other] + left_wall + minKick < 0)
+                    return false;
+                if (table.maxX[type][other] + left_wall + maxKick >= piece_column_count)
+                    return false;
+            }
+        }
+        if (shape != box.spawnShape)
+            return false;
+    }
+    for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+    {
+        const int32_t next = table.turns[rotation][int32_t(PieceTurn::Clockwise)];
+        if (table.turns[next][int32_t(PieceTurn::CounterClockwise)] != rotation)
+            return false;
+    }
+    return true;
+}
+
+template <int32_t BoardWidth>
+inline constexpr PieceTable<BoardWidth> piece_table = makePieceTable<BoardWidth>();
+
+// Returns the mask of a piece with its box at x, which has to be within the
+// walls in some rotation of the piece, kicks included.
+template <int32_t BoardWidth>
+constexpr PieceMask getPieceMaskAt(PieceType type, int32_t rotation, int32_t x)
+{
+    return piece_table<BoardWidth>.masks[int32_t(type)][rotation]
+                                        [x + PieceTable<BoardWidth>::left_wall];
+}
+
+static_assert(isPieceTableValid(piece_table<4>));
+static_assert(isPieceTableValid(piece_table<8>));
+static_assert(isPieceTableValid(piece_table<10>));
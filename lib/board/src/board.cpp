@@ -0,0 +1,209 @@
+#include "board/board.h"
+
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+static_assert(__BYTE_ORDER__ == __ORDER_LITTLE_ENDIAN__,
+              "Piece masks assume rows are loaded in little endian order");
+
+constexpr int32_t lane_bits = 16;
+constexpr int32_t lane_count = 4;
+constexpr int32_t max_mask_shift = lane_bits - 4;
+constexpr uint16_t cell_bits = (1u << board_width) - 1;
+
+constexpr uint64_t lane_low_bits = 0x7FFF7FFF7FFF7FFF;
+constexpr uint64_t lane_high_bits = 0x8000800080008000;
+constexpr uint64_t lane_ones = 0x0001000100010001;
+
+uint16_t& rowAt(Board& board, int32_t y)
+{
+    return board.rows[board_padding + y];
+}
+
+uint16_t rowAt(const Board& board, int32_t y)
+{
+    return board.rows[board_padding + y];
+}
+
+uint64_t loadRows(const Board& board, int32_t y)
+{
+    uint64_t rows;
+    memcpy(&rows, &board.rows[board_padding + y], sizeof(rows));
+    return rows;
+}
+
+void storeRows(Board& board, int32_t y, uint64_t rows)
+{
+    memcpy(&board.rows[board_padding + y], &rows, sizeof(rows));
+}
+
+bool isInRange(int32_t x, int32_t y)
+{
+    return x + board_left_wall >= 0 &&
+           x + board_left_wall <= max_mask_shift &&
+           y >= -board_padding &&
+           y <= board_height + board_padding - lane_count;
+}
+
+}
+
+Board makeBoard()
+{
+    Board board;
+    for (int32_t y = -board_padding; y < 0; y++)
+    {
+        rowAt(board, y) = board_full_row;
+    }
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        rowAt(board, y) = board_empty_row;
+    }
+    for (int32_t y = board_height; y < board_height + board_padding; y++)
+    {
+        rowAt(board, y) = board_full_row;
+    }
+    return board;
+}
+
+bool isOccupied(const Board& board, int32_t x, int32_t y)
+{
+    ASSERT(x >= 0 && x < board_width);
+    ASSERT(y >= 0 && y < board_height);
+    return (rowAt(board, y) >> (x + board_left_wall)) & 1;
+}
+
+uint16_t getRow(const Board& board, int32_t y)
+{
+    ASSERT(y >= 0 && y < board_height);
+    return (rowAt(board, y) >> board_left_wall) & cell_bits;
+}
+
+void setRow(Board& board, int32_t y, uint16_t cells)
+{
+    ASSERT(y >= 0 && y < board_height);
+    ASSERT((cells & ~cell_bits) == 0);
+    rowAt(board, y) = board_empty_row | (cells << board_left_wall);
+}
+
+bool collides(const Board& board, PieceMask mask, int32_t x, int32_t y)
+{
+    if (!isInRange(x, y))
+        return true;
+
+    return (loadRows(board, y) & (mask << (x + board_left_wall))) != 0;
+}
+
+bool collidesShifted(const Board& board, PieceMask shiftedMask, int32_t y)
+{
+    if (y < -board_padding || y > board_height + board_padding - lane_count)
+        return true;
+
+    return (loadRows(board, y) & shiftedMask) != 0;
+}
+
+int32_t findDropRow(const Board& board, PieceMask mask, int32_t x, int32_t y)
+{
+    ASSERT(!collides(board, mask, x, y));
+
+    // The padding below the floor is solid, so this always terminates before
+    // leaving the range of readable rows.
+    while (!collides(board, mask, x, y - 1))
+    {
+        y--;
+    }
+    return y;
+}
+
+void lockPiece(Board& board, PieceMask mask, int32_t x, int32_t y)
+{
+    ASSERT(!collides(board, mask, x, y));
+    storeRows(board, y, loadRows(board, y) | (mask << (x + board_left_wall)));
+}
+
+int32_t clearLines(Board& board, int32_t y)
+{
+    ASSERT(y >= -board_padding);
+    ASSERT(y <= board_height + board_padding - lane_count);
+
+    // The top bit of a lane survives only when all of its other bits are set,
+    // and since the low bits of a lane are at most 0x7FFF the add never
+    // carries into the next lane.
+    const uint64_t rows = loadRows(board, y);
+    const uint64_t fullLanes =
+        ((rows & lane_low_bits) + lane_ones) & rows & lane_high_bits;
+    if (fullLanes == 0)
+        return 0;
+
+    // The padding rows are solid as well, so lanes outside of the playfield
+    // have to be ignored.
+    const int32_t bottom = y < 0 ? 0 : y;
+    const int32_t top =
+        y + lane_count > board_height ? board_height : y + lane_count;
+
+    uint32_t fullRows = 0;
+    for (int32_t row = bottom; row < top; row++)
+    {
+        const int32_t lane = row - y;
+        if ((fullLanes >> (lane * lane_bits + lane_bits - 1)) & 1)
+            fullRows |= 1u << lane;
+    }
+    if (fullRows == 0)
+        return 0;
+
+    int32_t cleared = 0;
+    int32_t destination = y + __builtin_ctz(fullRows);
+    for (int32_t source = destination; source < top; source++)
+    {
+        if ((fullRows >> (source - y)) & 1) {
+            cleared++;
+            continue;
+        }
+        rowAt(board, destination++) = rowAt(board, source);
+    }
+
+    memmove(&rowAt(board, destination),
+            &rowAt(board, top),
+            (board_height - top) * sizeof(uint16_t));
+    for (int32_t row = board_height - cleared; row < board_height; row++)
+    {
+        rowAt(board, row) = board_empty_row;
+    }
+
+    return cleared;
+}
+
+bool addGarbageRows(Board& board, int32_t count, int32_t hole)
+{
+    ASSERT(count >= 0 && count <= board_height);
+    ASSERT(hole >= 0 && hole < board_width);
+
+    bool fits = true;
+    for (int32_t y = board_height - count; y < board_height; y++)
+    {
+        fits = fits && rowAt(board, y) == board_empty_row;
+    }
+
+    memmove(&rowAt(board, count),
+            &rowAt(board, 0),
+            (board_height - count) * sizeof(uint16_t));
+    const uint16_t garbage =
+        uint16_t(board_full_row & ~(1u << (board_left_wall + hole)));
+    for (int32_t y = 0; y < count; y++)
+    {
+        rowAt(board, y) = garbage;
+    }
+    return fits;
+}
+
+int32_t dropPiece(Board& board, PieceType type, int32_t rotation, int32_t x)
+{
+    const PieceMask mask = getPieceMask(type, rotation);
+    if (collides(board, mask, x, piece_spawn_y))
+        return -1;
+
+    const int32_t y = findDropRow(board, mask, x, piece_spawn_y);
+    lockPiece(board, mask, x, y);
+    return clearLines(board, y);
+}
@@ -0,0 +1,45 @@
+#include "board/piece.h"
+
+#include <util/assert.h>
+
+#include "board/board.h"
+#include "board/piece_table.h"
+
+namespace {
+
+// The SRS rotation states in clockwise order starting from the spawn
+// orientation, written out to check the generated ones against.
+constexpr uint16_t srs_shapes[piece_type_count][rotation_count] = {
+    { 0x0F00, 0x4444, 0x00F0, 0x2222 }, // I
+    { 0x6600, 0x6600, 0x6600, 0x6600 }, // O
+    { 0x2700, 0x2620, 0x0720, 0x2320 }, // T
+    { 0x6300, 0x2640, 0x0630, 0x1320 }, // S
+    { 0x3600, 0x4620, 0x0360, 0x2310 }, // Z
+    { 0x1700, 0x6220, 0x0740, 0x2230 }, // J
+    { 0x4700, 0x2260, 0x0710, 0x3220 }  // L
+};
+
+constexpr bool haveSrsShapes(const PieceTable<board_width>& table)
+{
+    for (int32_t type = 0; type < piece_type_count; type++)
+    {
+        for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+        {
+            if (table.shapes[type][rotation] != srs_shapes[type][rotation])
+                return false;
+        }
+    }
+    return true;
+}
+
+static_assert(haveSrsShapes(piece_table<board_width>));
+static_assert(PieceTable<board_width>::left_wall == board_left_wall);
+
+}
+
+PieceMask getPieceMask(PieceType type, int32_t rotation)
+{
+    ASSERT(int32_t(type) < piece_type_count);
+    ASSERT(rotation >= 0 && rotation < rotation_count);
+    return piece_table<board_width>.masks[int32_t(type)][rotation][0];
+}
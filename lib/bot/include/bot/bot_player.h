@@ -0,0 +1,36 @@
+#pragma once
+
+#include <cstdint>
+#include <simulation/game.h>
+#include <simulation/input_source.h>
+
+#include "bot/placement.h"
+#include "bot/search.h"
+
+// Plays a game with a bot through the same buttons a player presses. Every
+// new piece is searched once, and the moves to its placement are pressed
+// one per two ticks, releasing the buttons in between so that each press
+// registers. When a move does not end up where it should, for example
+// because gravity pulled the piece down in the meantime, the piece is
+// searched again from where it is.
+struct BotPlayer
+{
+    Bot* bot;
+    bool planned;
+    bool holdPending;
+    PieceMove moves[max_path_length];
+    // Where the piece should be before each move, and after the last one.
+    ActivePiece pieces[max_path_length + 1];
+    int32_t moveCount;
+    int32_t nextMove;
+    bool released;
+    uint64_t searchCount;
+};
+
+BotPlayer makeBotPlayer(Bot& bot);
+
+// Returns false once the game is over.
+bool readBotInput(BotPlayer& player, const Game& game, GameInput& input);
+
+// The player must outlive the source.
+InputSource makeBotInputSource(BotPlayer& player);
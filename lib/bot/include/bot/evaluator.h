@@ -0,0 +1,32 @@
+#pragma once
+
+#include <board/board.h>
+#include <cstdint>
+
+// Scores what the search finds, higher is better. The value of a sequence of
+// placements is the sum of the scores of the lines they clear plus the score
+// of the board they end on, so anything the board alone does not show has to
+// be rewarded through the clears.
+struct Evaluator
+{
+    float (*evaluateBoard)(const Board& board, const void* context);
+    float (*evaluateClear)(int32_t lineCount, const void* context);
+    const void* context;
+};
+
+// The weights of the board features the heuristic evaluator looks at.
+struct HeuristicWeights
+{
+    float aggregateHeight;
+    float holes;
+    float bumpiness;
+    float wells;
+    float lineClears[5];
+    // Added when the stack reaches into the rows pieces spawn in.
+    float danger;
+};
+
+HeuristicWeights getDefaultHeuristicWeights();
+
+// The weights are not copied and must outlive the evaluator.
+Evaluator makeHeuristicEvaluator(const HeuristicWeights& weights);
@@ -0,0 +1,74 @@
+#pragma once
+
+#include <board/board.h>
+#include <cstdint>
+#include <simulation/game.h>
+
+// The moves that take a piece to where it locks, the way the game applies
+// them: shifts and rotations with the same kicks. A soft drop is held until
+// the piece lands, so it only ends up in the rows it can land in, which
+// keeps the states searched to a few hundred.
+enum class PieceMove : uint8_t
+{
+    Left,
+    Right,
+    TurnLeft,
+    TurnRight,
+    Down
+};
+
+constexpr int32_t max_placement_count = 128;
+// Every rotation, x and y a mask can be shifted to on the board.
+constexpr int32_t piece_state_count = rotation_count * 16 * 32;
+// Longer paths than this are not searched. Tucks and spins under an
+// overhang take a handful of moves once the piece is down there.
+constexpr int32_t max_path_length = 64;
+
+// Where a piece can lock. Placements that lock the same cells are only
+// listed once.
+struct Placement
+{
+    int8_t rotation;
+    int8_t x;
+    int8_t y;
+    // The state of the search the placement was found in.
+    int16_t state;
+};
+
+struct PlacementList
+{
+    Placement placements[max_placement_count];
+    int32_t count;
+};
+
+// The states a piece was found in, with the move that first reached each
+// one. Kept around to find the paths to the placements afterwards.
+struct PlacementSearch
+{
+    PieceType type;
+    int16_t parents[piece_state_count];
+    PieceMove moves[piece_state_count];
+    uint8_t distances[piece_state_count];
+};
+
+// Moves the piece like the game would, returns false and leaves it where it
+// is if the move is blocked.
+bool applyPieceMove(const Board& board, ActivePiece& piece, PieceMove move);
+
+// Finds every placement the piece can reach from the given state, by
+// shifting, rotating and soft dropping it in every order. That includes
+// tucks under overhangs and spins into gaps.
+void findPlacements(const Board& board,
+                    const ActivePiece& start,
+                    PlacementSearch& search,
+                    PlacementList& placements);
+
+// Writes the moves that take the piece from the start of the search to the
+// state of the placement, and returns how many there are. A hard drop from
+// there locks it.
+int32_t getPlacementPath(const PlacementSearch& search,
+                         const Placement& placement,
+                         PieceMove* moves);
+
+// Locks the piece at the placement and returns the number of lines cleared.
+int32_t applyPlacement(Board& board, PieceType type, const Placement& placement);
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <simulation/game.h>
+#include <util/task_pool.h>
+
+#include "bot/evaluator.h"
+#include "bot/placement.h"
+#include "bot/transposition_table.h"
+
+struct Bot;
+
+constexpr int32_t max_search_depth = preview_count + 1;
+// Every placement of the current piece and of the one swapped in.
+constexpr int32_t max_root_option_count = 2 * max_placement_count;
+// More tasks than this in one iteration are searched without splitting.
+constexpr size_t max_search_task_count = 16384;
+
+struct BotOptions
+{
+    // The threads searching, including the one that starts the search.
+    int32_t threadCount;
+    // The number of pieces placed ahead, the current one included. The
+    // pieces after the previews are unknown, so the search never goes
+    // deeper than max_search_depth.
+    int32_t maxDepth;
+    // The deeper iterations stop once a search took this long, and the
+    // result of the deepest one that finished is used.
+    std::chrono::microseconds timeBudget;
+    // The transposition table holds 2^tableSizeLog2 entries.
+    uint32_t tableSizeLog2;
+    bool useHold;
+};
+
+BotOptions getDefaultBotOptions();
+
+// A board after some placements, with where the search is in the queue.
+struct SearchNode
+{
+    Board board;
+    // The next piece of the queue, the current piece of the game being 0.
+    int32_t queueIndex;
+    PieceType hold;
+    bool hasHold;
+};
+
+// The first placement of a line of the search.
+struct RootOption
+{
+    bool hold;
+    PieceType type;
+    Placement placement;
+    // What clearing lines with the placement scored.
+    float clearValue;
+    SearchNode node;
+};
+
+// Searches the subtree below a node, or below every placement from it when
+// split, and raises the value of its root option.
+struct SearchTask
+{
+    Bot* bot;
+    int32_t root;
+    SearchNode node;
+    int32_t depthLeft;
+    float pathValue;
+    bool split;
+};
+
+struct BotMove
+{
+    bool hold;
+    PieceType type;
+    Placement placement;
+    float value;
+    // The number of pieces the deepest finished iteration looked ahead.
+    int32_t depth;
+    uint64_t nodeCount;
+};
+
+// Searches placements several pieces deep, using the previews and the hold
+// piece. Each iteration of the search goes one piece deeper than the last,
+// and the lines of play under each placement of the current piece are
+// searched in parallel by a work stealing pool.
+struct Bot
+{
+    BotOptions options;
+    Evaluator evaluator;
+    TaskPool pool;
+    TranspositionTable table;
+
+    // The pieces of the game being searched, the current one first.
+    PieceType queue[max_search_depth];
+    int32_t queueLength;
+    // The searches of the current piece and the one swapped in, kept for
+    // the paths to the placements of the chosen move.
+    PlacementSearch rootSearches[2];
+    RootOption roots[max_root_option_count];
+    int32_t rootCount;
+    std::atomic<float> rootValues[max_root_option_count];
+
+    SearchTask* tasks;
+    std::atomic<size_t> taskCount;
+    std::chrono::steady_clock::time_point deadline;
+    std::atomic<bool> aborted;
+    std::atomic<uint64_t> nodeCount;
+};
+
+// The evaluator is copied, what its context points to must outlive the bot.
+void initBot(Bot& bot, const BotOptions& options, const Evaluator& evaluator);
+void destroyBot(Bot& bot);
+
+// Picks where to place the active piece of the game, which must not be over.
+// The search starts from where the piece is, so it can be called again
+// after the piece moved.
+BotMove searchBotMove(Bot& bot, const Game& game);
+
+// Writes the moves that take the active piece to the placement of the move,
+// after the swap if it holds, and returns how many there are.
+int32_t getBotMovePath(const Bot& bot, const BotMove& move, PieceMove* moves);
@@ -0,0 +1,45 @@
+#pragma once
+
+#include <atomic>
+#include <board/board.h>
+#include <cstdint>
+
+// Zobrist hash of the cells of a board, the XOR of a random key per occupied
+// cell. The keys of every pattern of a half row are combined up front, so
+// hashing takes two lookups per row.
+uint64_t hashBoard(const Board& board);
+
+// Random keys to mix the rest of a search node into the hash of its board.
+uint64_t getZobristKey(uint32_t index);
+
+struct TranspositionEntry
+{
+    // The key XOR the data, so a torn write by another thread reads as a
+    // miss instead of the data of another key.
+    std::atomic<uint64_t> check;
+    // The generation in the high bits and the value in the low ones.
+    std::atomic<uint64_t> data;
+};
+
+// A lock free hash table of search values shared by every search thread.
+// Entries are overwritten freely, and the ones from earlier searches are
+// told apart by their generation.
+struct TranspositionTable
+{
+    TranspositionEntry* entries;
+    uint64_t mask;
+    uint32_t generation;
+};
+
+void initTranspositionTable(TranspositionTable& table, uint32_t sizeLog2);
+void destroyTranspositionTable(TranspositionTable& table);
+
+// Makes every entry stored so far stale.
+void advanceTranspositionTable(TranspositionTable& table);
+
+bool probeTranspositionTable(const TranspositionTable& table,
+                             uint64_t key,
+                             float& value);
+void storeTranspositionTable(TranspositionTable& table,
+                             uint64_t key,
+                             float value);
@@ -0,0 +1,112 @@
+#include "bot/bot_player.h"
+
+#include <util/assert.h>
+
+namespace {
+
+void planMove(BotPlayer& player, const Game& game)
+{
+    const BotMove move = searchBotMove(*player.bot, game);
+    player.planned = true;
+    player.holdPending = move.hold;
+    player.moveCount = getBotMovePath(*player.bot, move, player.moves);
+    player.nextMove = 0;
+    player.searchCount++;
+
+    player.pieces[0] = move.hold ?
+        ActivePiece{ move.type, 0, piece_spawn_x, piece_spawn_y } :
+        game.piece;
+    for (int32_t index = 0; index < player.moveCount; index++)
+    {
+        player.pieces[index + 1] = player.pieces[index];
+        const bool moved = applyPieceMove(
+            game.board,
+            player.pieces[index + 1],
+            player.moves[index]);
+        ASSERT(moved);
+    }
+}
+
+// Gravity can pull the piece down at any time, so only soft drops care how
+// low it is.
+bool isWhereExpected(const BotPlayer& player, const Game& game)
+{
+    const ActivePiece& piece = game.piece;
+    const ActivePiece& expected = player.pieces[player.nextMove];
+    return piece.type == expected.type &&
+           piece.rotation == expected.rotation &&
+           piece.x == expected.x;
+}
+
+bool readBotInputFromSource(void* context, const Game& game, GameInput& input)
+{
+    return readBotInput(*static_cast<BotPlayer*>(context), game, input);
+}
+
+}
+
+BotPlayer makeBotPlayer(Bot& bot)
+{
+    BotPlayer player = {};
+    player.bot = &bot;
+    player.released = true;
+    return player;
+}
+
+bool readBotInput(BotPlayer& player, const Game& game, GameInput& input)
+{
+    input = GameInput{};
+    if (game.over)
+        return false;
+
+    if (!player.planned || (game.events & game_event_locked))
+        planMove(player, game);
+
+    if (!player.released) {
+        player.released = true;
+        return true;
+    }
+
+    if (player.holdPending) {
+        player.holdPending = false;
+        player.released = false;
+        input.swap = true;
+        return true;
+    }
+
+    if (!isWhereExpected(player, game))
+        planMove(player, game);
+
+    // Soft drops are held down until the piece lands, which gravity may
+    // already have taken care of.
+    if (player.nextMove < player.moveCount &&
+        player.moves[player.nextMove] == PieceMove::Down) {
+        if (game.piece.y > player.pieces[player.nextMove + 1].y) {
+            input.down = true;
+            return true;
+        }
+        player.nextMove++;
+    }
+
+    if (player.nextMove == player.moveCount) {
+        input.drop = true;
+        player.released = false;
+        return true;
+    }
+
+    switch (player.moves[player.nextMove++])
+    {
+        case PieceMove::Left: input.left = true; break;
+        case PieceMove::Right: input.right = true; break;
+        case PieceMove::TurnLeft: input.turnLeft = true; break;
+        case PieceMove::TurnRight: input.turnRight = true; break;
+        case PieceMove::Down: break;
+    }
+    player.released = false;
+    return true;
+}
+
+InputSource makeBotInputSource(BotPlayer& player)
+{
+    return makeCallbackInputSource(readBotInputFromSource, &player);
+}
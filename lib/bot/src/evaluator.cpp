@@ -0,0 +1,84 @@
+#include "bot/evaluator.h"
+
+#include <board/piece.h>
+
+namespace {
+
+// Rows at and above this height are where pieces spawn.
+constexpr int32_t danger_row = piece_spawn_y - 2;
+
+float evaluateHeuristicBoard(const Board& board, const void* context)
+{
+    const HeuristicWeights& weights =
+        *static_cast<const HeuristicWeights*>(context);
+
+    int32_t heights[board_width] = {};
+    int32_t holes = 0;
+    // Going down from the top, a column is covered once a cell of it was
+    // seen, and every empty cell in a covered column is a hole.
+    uint16_t covered = 0;
+    for (int32_t y = board_height - 1; y >= 0; y--)
+    {
+        const uint16_t row = getRow(board, y);
+        for (uint32_t uncovered = row & ~covered; uncovered != 0;
+             uncovered &= uncovered - 1)
+        {
+            heights[__builtin_ctz(uncovered)] = y + 1;
+        }
+        holes += __builtin_popcount(covered & ~row);
+        covered |= row;
+    }
+
+    int32_t aggregateHeight = 0;
+    int32_t bumpiness = 0;
+    int32_t wells = 0;
+    int32_t maxHeight = 0;
+    for (int32_t x = 0; x < board_width; x++)
+    {
+        aggregateHeight += heights[x];
+        if (heights[x] > maxHeight)
+            maxHeight = heights[x];
+        if (x > 0) {
+            const int32_t step = heights[x] - heights[x - 1];
+            bumpiness += step < 0 ? -step : step;
+        }
+        // Wells deeper than two rows need an I piece to fill.
+        const int32_t left = x > 0 ? heights[x - 1] : board_height;
+        const int32_t right = x < board_width - 1 ? heights[x + 1] : board_height;
+        const int32_t depth = (left < right ? left : right) - heights[x];
+        if (depth > 2)
+            wells += depth - 2;
+    }
+
+    return weights.aggregateHeight * aggregateHeight +
+           weights.holes * holes +
+           weights.bumpiness * bumpiness +
+           weights.wells * wells +
+           (maxHeight >= danger_row ? weights.danger : 0);
+}
+
+float evaluateHeuristicClear(int32_t lineCount, const void* context)
+{
+    const HeuristicWeights& weights =
+        *static_cast<const HeuristicWeights*>(context);
+    return weights.lineClears[lineCount];
+}
+
+}
+
+HeuristicWeights getDefaultHeuristicWeights()
+{
+    return HeuristicWeights{
+        -0.51f,
+        -3.6f,
+        -0.18f,
+        -0.5f,
+        { 0, -0.5f, -0.2f, 0.5f, 4 },
+        -100
+    };
+}
+
+Evaluator makeHeuristicEvaluator(const HeuristicWeights& weights)
+{
+    return Evaluator{ evaluateHeuristicBoard, evaluateHeuristicClear, &weights };
+}
@@ -0,0 +1,228 @@
+#include "bot/placement.h"
+
+#include <board/piece_table.h>
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+constexpr int32_t column_count = 16;
+constexpr int32_t row_count = 32;
+constexpr uint8_t unvisited = 0xFF;
+
+static_assert(max_path_length < unvisited);
+static_assert(rotation_count * column_count * row_count == piece_state_count);
+
+int32_t getStateIndex(int32_t rotation, int32_t x, int32_t y)
+{
+    return (rotation * column_count + x + board_left_wall) * row_count +
+           y + board_padding;
+}
+
+int32_t getStateRotation(int32_t state)
+{
+    return state / (column_count * row_count);
+}
+
+int32_t getStateX(int32_t state)
+{
+    return state / row_count % column_count - board_left_wall;
+}
+
+int32_t getStateY(int32_t state)
+{
+    return state % row_count - board_padding;
+}
+
+// The cells a piece locks at, moved down to the lowest lane it covers so
+// that rotations which cover the same cells compare equal.
+struct LockedCells
+{
+    uint64_t cells;
+    int32_t y;
+};
+
+LockedCells getLockedCells(PieceMask mask, int32_t x, int32_t y)
+{
+    uint64_t cells = mask << (x + board_left_wall);
+    while ((cells & 0xFFFF) == 0)
+    {
+        cells >>= 16;
+        y++;
+    }
+    return LockedCells{ cells, y };
+}
+
+// Returns the state the move leads to, or -1 if the piece cannot make it.
+int32_t applyMove(const Board& board,
+                  PieceType type,
+                  int32_t state,
+                  PieceMove move)
+{
+    ActivePiece piece = ActivePiece{
+        type,
+        getStateRotation(state),
+        getStateX(state),
+        getStateY(state)
+    };
+    if (!applyPieceMove(board, piece, move))
+        return -1;
+    return getStateIndex(piece.rotation, piece.x, piece.y);
+}
+
+// Adds the placement of a state that cannot move down any further.
+void addPlacement(PieceType type,
+                  int32_t state,
+                  PlacementList& placements,
+                  LockedCells* lockedCells)
+{
+    const int32_t rotation = getStateRotation(state);
+    const int32_t x = getStateX(state);
+    const int32_t y = getStateY(state);
+    const PieceMask mask = getPieceMask(type, rotation);
+    const LockedCells cells = getLockedCells(mask, x, y);
+    for (int32_t index = 0; index < placements.count; index++)
+    {
+        if (lockedCells[index].cells == cells.cells &&
+            lockedCells[index].y == cells.y)
+            return;
+    }
+
+    ASSERT(placements.count < max_placement_count);
+    lockedCells[placements.count] = cells;
+    placements.placements[placements.count++] = Placement{
+        int8_t(rotation),
+        int8_t(x),
+        int8_t(y),
+        int16_t(state)
+    };
+}
+
+}
+
+void findPlacements(const Board& board,
+                    const ActivePiece& start,
+                    PlacementSearch& search,
+                    PlacementList& placements)
+{
+    ASSERT(!collides(board,
+                     getPieceMask(start.type, start.rotation),
+                     start.x,
+                     start.y));
+
+    constexpr PieceMove moves[] = {
+        PieceMove::Left,
+        PieceMove::Right,
+        PieceMove::TurnLeft,
+        PieceMove::TurnRight,
+        PieceMove::Down
+    };
+
+    search.type = start.type;
+    memset(search.distances, unvisited, sizeof(search.distances));
+    placements.count = 0;
+    LockedCells lockedCells[max_placement_count];
+
+    // Breadth first, so every state is reached with the fewest moves.
+    int16_t queue[piece_state_count];
+    int32_t queueFront = 0;
+    int32_t queueBack = 0;
+    const int32_t first = getStateIndex(start.rotation, start.x, start.y);
+    search.parents[first] = -1;
+    search.distances[first] = 0;
+    queue[queueBack++] = int16_t(first);
+    while (queueFront < queueBack)
+    {
+        const int32_t state = queue[queueFront++];
+        const bool atLimit = search.distances[state] == max_path_length;
+        for (PieceMove move : moves)
+        {
+            const int32_t next = applyMove(board, start.type, state, move);
+            if (next < 0 && move == PieceMove::Down)
+                addPlacement(start.type, state, placements, lockedCells);
+            if (next < 0 || atLimit || search.distances[next] != unvisited)
+                continue;
+
+            search.parents[next] = int16_t(state);
+            search.moves[next] = move;
+            search.distances[next] = uint8_t(search.distances[state] + 1);
+            queue[queueBack++] = int16_t(next);
+        }
+    }
+}
+
+bool applyPieceMove(const Board& board, ActivePiece& piece, PieceMove move)
+{
+    switch (move)
+    {
+        case PieceMove::Left:
+        case PieceMove::Right:
+        {
+            const int32_t dx = move == PieceMove::Left ? -1 : 1;
+            const PieceMask mask = getPieceMask(piece.type, piece.rotation);
+            if (collides(board, mask, piece.x + dx, piece.y))
+                return false;
+            piece.x += dx;
+            return true;
+        }
+        case PieceMove::TurnLeft:
+        case PieceMove::TurnRight:
+        {
+            constexpr const PieceTable<board_width>& table =
+                piece_table<board_width>;
+            const PieceTurn turn = move == PieceMove::TurnLeft ?
+                PieceTurn::CounterClockwise :
+                PieceTurn::Clockwise;
+            const int32_t rotation = table.turns[piece.rotation][int32_t(turn)];
+            for (int32_t offset :
+                 table.kicks[int32_t(piece.type)][piece.rotation][int32_t(turn)])
+            {
+                const PieceMask mask =
+                    getPieceMaskAt<board_width>(piece.type, rotation, piece.x + offset);
+                if (!collidesShifted(board, mask, piece.y)) {
+                    piece.rotation = rotation;
+                    piece.x += offset;
+                    return true;
+                }
+            }
+            return false;
+        }
+        case PieceMove::Down:
+        {
+            const PieceMask mask = getPieceMask(piece.type, piece.rotation);
+            if (collides(board, mask, piece.x, piece.y - 1))
+                return false;
+            piece.y = findDropRow(board, mask, piece.x, piece.y - 1);
+            return true;
+        }
+        default: UNREACHABLE("Unknown piece move: %d", int(move));
+    }
+}
+
+int32_t getPlacementPath(const PlacementSearch& search,
+                         const Placement& placement,
+                         PieceMove* moves)
+{
+    int32_t length = search.distances[placement.state];
+    ASSERT(length != unvisited);
+
+    int32_t state = placement.state;
+    for (int32_t index = length - 1; index >= 0; index--)
+    {
+        moves[index] = search.moves[state];
+        state = search.parents[state];
+    }
+    // The hard drop takes care of a soft drop at the end.
+    if (length > 0 && moves[length - 1] == PieceMove::Down)
+        length--;
+    return length;
+}
+
+int32_t applyPlacement(Board& board, PieceType type, const Placement& placement)
+{
+    lockPiece(board,
+              getPieceMask(type, placement.rotation),
+              placement.x,
+              placement.y);
+    return clearLines(board, placement.y);
+}
@@ -0,0 +1,417 @@
+#include "bot/search.h"
+
+#include <util/assert.h>
+
+namespace {
+
+// The value of topping out, far below any board the evaluator can score.
+constexpr float lose_value = -1e9f;
+
+// Offsets of the parts of a search node in the Zobrist keys.
+constexpr uint32_t queue_key = 0;
+constexpr uint32_t hold_key = 16;
+constexpr uint32_t depth_key = 32;
+
+static_assert(max_search_depth < hold_key - queue_key);
+static_assert(piece_type_count + 1 <= depth_key - hold_key);
+
+// A piece that can be placed next from a node, and what the queue and the
+// hold piece look like once it is.
+struct PieceChoice
+{
+    PieceType type;
+    bool hold;
+    int32_t queueIndex;
+    PieceType nextHold;
+    bool nextHasHold;
+};
+
+int32_t getPieceChoices(const Bot& bot,
+                        const SearchNode& node,
+                        bool canHold,
+                        PieceChoice* choices)
+{
+    if (node.queueIndex >= bot.queueLength)
+        return 0;
+
+    const PieceType current = bot.queue[node.queueIndex];
+    int32_t count = 0;
+    choices[count++] = PieceChoice{
+        current,
+        false,
+        node.queueIndex + 1,
+        node.hold,
+        node.hasHold
+    };
+    if (!bot.options.useHold || !canHold)
+        return count;
+
+    if (node.hasHold) {
+        // Swapping for the same piece changes nothing.
+        if (node.hold != current) {
+            choices[count++] = PieceChoice{
+                node.hold,
+                true,
+                node.queueIndex + 1,
+                current,
+                true
+            };
+        }
+    }
+    else if (node.queueIndex + 1 < bot.queueLength) {
+        choices[count++] = PieceChoice{
+            bot.queue[node.queueIndex + 1],
+            true,
+            node.queueIndex + 2,
+            current,
+            true
+        };
+    }
+    return count;
+}
+
+ActivePiece getSpawnedPiece(PieceType type)
+{
+    return ActivePiece{ type, 0, piece_spawn_x, piece_spawn_y };
+}
+
+bool canSpawn(const Board& board, PieceType type)
+{
+    return !collides(board, getPieceMask(type, 0), piece_spawn_x, piece_spawn_y);
+}
+
+SearchNode makeChildNode(const SearchNode& node, const PieceChoice& choice)
+{
+    SearchNode child = node;
+    child.queueIndex = choice.queueIndex;
+    child.hold = choice.nextHold;
+    child.hasHold = choice.nextHasHold;
+    return child;
+}
+
+uint64_t getNodeKey(const SearchNode& node, int32_t depthLeft)
+{
+    return hashBoard(node.board) ^
+           getZobristKey(queue_key + uint32_t(node.queueIndex)) ^
+           getZobristKey(hold_key + (node.hasHold ? 1 + uint32_t(node.hold) : 0)) ^
+           getZobristKey(depth_key + uint32_t(depthLeft));
+}
+
+bool isSearchAborted(Bot& bot)
+{
+    if (bot.aborted.load(std::memory_order_relaxed))
+        return true;
+    if (std::chrono::steady_clock::now() < bot.deadline)
+        return false;
+
+    bot.aborted.store(true, std::memory_order_relaxed);
+    return true;
+}
+
+// Returns the best value of the placements below the node, or of the node
+// itself when the search ends there. Values found after the search was
+// aborted are meaningless and not stored.
+float searchNode(Bot& bot,
+                 const SearchNode& node,
+                 int32_t depthLeft,
+                 uint64_t& nodeCount)
+{
+    const Evaluator& evaluator = bot.evaluator;
+    if (depthLeft == 0 || node.queueIndex >= bot.queueLength)
+        return evaluator.evaluateBoard(node.board, evaluator.context);
+    if (isSearchAborted(bot))
+        return 0;
+
+    const uint64_t key = getNodeKey(node, depthLeft);
+    float best;
+    if (probeTranspositionTable(bot.table, key, best))
+        return best;
+
+    nodeCount++;
+    best = lose_value;
+    PieceChoice choices[2];
+    const int32_t choiceCount = getPieceChoices(bot, node, true, choices);
+    for (int32_t choiceIndex = 0; choiceIndex < choiceCount; choiceIndex++)
+    {
+        const PieceChoice& choice = choices[choiceIndex];
+        if (!canSpawn(node.board, choice.type))
+            continue;
+
+        PlacementSearch search;
+        PlacementList placements;
+        findPlacements(
+            node.board,
+            getSpawnedPiece(choice.type),
+            search,
+            placements);
+        for (int32_t index = 0; index < placements.count; index++)
+        {
+            SearchNode child = makeChildNode(node, choice);
+            const int32_t lines =
+                applyPlacement(child.board, choice.type, placements.placements[index]);
+            const float value =
+                evaluator.evaluateClear(lines, evaluator.context) +
+                searchNode(bot, child, depthLeft - 1, nodeCount);
+            if (value > best)
+                best = value;
+        }
+    }
+
+    if (!bot.aborted.load(std::memory_order_relaxed))
+        storeTranspositionTable(bot.table, key, best);
+    return best;
+}
+
+void raiseRootValue(Bot& bot, int32_t root, float value)
+{
+    std::atomic<float>& rootValue = bot.rootValues[root];
+    float current = rootValue.load(std::memory_order_relaxed);
+    while (value > current &&
+           !rootValue.compare_exchange_weak(current, value, std::memory_order_relaxed))
+    {
+    }
+}
+
+void runSearchTask(void* data, int32_t worker);
+
+// Pushes a task to the pool, or runs it right away when the tasks of the
+// iteration ran out.
+void startSearchTask(Bot& bot, int32_t worker, const SearchTask& task)
+{
+    const size_t slot = bot.taskCount.fetch_add(1, std::memory_order_relaxed);
+    if (slot >= max_search_task_count) {
+        SearchTask inlineTask = task;
+        inlineTask.split = false;
+        runSearchTask(&inlineTask, worker);
+        return;
+    }
+
+    bot.tasks[slot] = task;
+    pushTask(bot.pool, worker, Task{ runSearchTask, &bot.tasks[slot] });
+}
+
+// Splits a node into a task per placement from it, so that the lines under a
+// single root option can be searched by several threads.
+void splitSearchTask(const SearchTask& task, int32_t worker)
+{
+    Bot& bot = *task.bot;
+    const Evaluator& evaluator = bot.evaluator;
+    PieceChoice choices[2];
+    const int32_t choiceCount = getPieceChoices(bot, task.node, true, choices);
+    bool placed = false;
+    for (int32_t choiceIndex = 0; choiceIndex < choiceCount; choiceIndex++)
+    {
+        const PieceChoice& choice = choices[choiceIndex];
+        if (!canSpawn(task.node.board, choice.type))
+            continue;
+
+        PlacementSearch search;
+        PlacementList placements;
+        findPlacements(
+            task.node.board,
+            getSpawnedPiece(choice.type),
+            search,
+            placements);
+        for (int32_t index = 0; index < placements.count; index++)
+        {
+            SearchTask child = task;
+            child.node = makeChildNode(task.node, choice);
+            const int32_t lines =
+                applyPlacement(child.node.board, choice.type, placements.placements[index]);
+            child.depthLeft = task.depthLeft - 1;
+            child.pathValue =
+                task.pathValue + evaluator.evaluateClear(lines, evaluator.context);
+            child.split = false;
+            startSearchTask(bot, worker, child);
+            placed = true;
+        }
+    }
+    if (!placed)
+        raiseRootValue(bot, task.root, task.pathValue + lose_value);
+}
+
+void runSearchTask(void* data, int32_t worker)
+{
+    const SearchTask& task = *static_cast<const SearchTask*>(data);
+    Bot& bot = *task.bot;
+    if (task.split && task.node.queueIndex < bot.queueLength) {
+        bot.nodeCount.fetch_add(1, std::memory_order_relaxed);
+        splitSearchTask(task, worker);
+        return;
+    }
+
+    uint64_t nodeCount = 0;
+    const float value =
+        task.pathValue + searchNode(bot, task.node, task.depthLeft, nodeCount);
+    raiseRootValue(bot, task.root, value);
+    bot.nodeCount.fetch_add(nodeCount, std::memory_order_relaxed);
+}
+
+void addRootOptions(Bot& bot,
+                    const Board& board,
+                    const ActivePiece& start,
+                    const PieceChoice& choice,
+                    const SearchNode& node)
+{
+    const Evaluator& evaluator = bot.evaluator;
+    PlacementSearch& search = bot.rootSearches[choice.hold];
+    PlacementList placements;
+    findPlacements(board, start, search, placements);
+    for (int32_t index = 0; index < placements.count; index++)
+    {
+        RootOption& root = bot.roots[bot.rootCount++];
+        root.hold = choice.hold;
+        root.type = choice.type;
+        root.placement = placements.placements[index];
+        root.node = makeChildNode(node, choice);
+        const int32_t lines =
+            applyPlacement(root.node.board, choice.type, root.placement);
+        root.clearValue = evaluator.evaluateClear(lines, evaluator.context);
+    }
+}
+
+// Lines of play often end on the same board in a different order, ties go
+// to the one that clears the most right away.
+int32_t findBestRoot(const Bot& bot)
+{
+    int32_t best = 0;
+    for (int32_t root = 1; root < bot.rootCount; root++)
+    {
+        const float value = bot.rootValues[root].load(std::memory_order_relaxed);
+        const float bestValue =
+            bot.rootValues[best].load(std::memory_order_relaxed);
+        if (value > bestValue ||
+            (value == bestValue &&
+             bot.roots[root].clearValue > bot.roots[best].clearValue))
+            best = root;
+    }
+    return best;
+}
+
+}
+
+BotOptions getDefaultBotOptions()
+{
+    return BotOptions{
+        getHardwareThreadCount(),
+        3,
+        std::chrono::milliseconds(10),
+        20,
+        true
+    };
+}
+
+void initBot(Bot& bot, const BotOptions& options, const Evaluator& evaluator)
+{
+    ASSERT(options.threadCount > 0);
+    ASSERT(options.maxDepth > 0);
+
+    bot.options = options;
+    bot.evaluator = evaluator;
+    initTaskPool(bot.pool, options.threadCount, max_search_task_count);
+    initTranspositionTable(bot.table, options.tableSizeLog2);
+    bot.tasks = new SearchTask[max_search_task_count];
+}
+
+void destroyBot(Bot& bot)
+{
+    delete[] bot.tasks;
+    bot.tasks = nullptr;
+    destroyTranspositionTable(bot.table);
+    destroyTaskPool(bot.pool);
+}
+
+BotMove searchBotMove(Bot& bot, const Game& game)
+{
+    ASSERT(!game.over);
+
+    bot.deadline = std::chrono::steady_clock::now() + bot.options.timeBudget;
+    bot.aborted.store(false, std::memory_order_relaxed);
+    bot.nodeCount.store(0, std::memory_order_relaxed);
+    advanceTranspositionTable(bot.table);
+
+    bot.queue[0] = game.piece.type;
+    for (int32_t index = 0; index < preview_count; index++)
+    {
+        bot.queue[index + 1] = game.previews[index];
+    }
+    bot.queueLength = max_search_depth;
+
+    // The current piece starts from where it is, a piece swapped in from
+    // the spawn.
+    const SearchNode start = SearchNode{ game.board, 0, game.hold, game.hasHold };
+    PieceChoice choices[2];
+    const int32_t choiceCount =
+        getPieceChoices(bot, start, !game.holdUsed, choices);
+    bot.rootCount = 0;
+    addRootOptions(bot, game.board, game.piece, choices[0], start);
+    if (choiceCount > 1 && canSpawn(game.board, choices[1].type)) {
+        addRootOptions(
+            bot,
+            game.board,
+            getSpawnedPiece(choices[1].type),
+            choices[1],
+            start);
+    }
+    ASSERT(bot.rootCount > 0);
+
+    // Looking at the current piece alone is quick enough to always finish.
+    const Evaluator& evaluator = bot.evaluator;
+    for (int32_t root = 0; root < bot.rootCount; root++)
+    {
+        const RootOption& option = bot.roots[root];
+        bot.rootValues[root].store(
+            option.clearValue +
+                evaluator.evaluateBoard(option.node.board, evaluator.context),
+            std::memory_order_relaxed);
+    }
+    int32_t best = findBestRoot(bot);
+    float bestValue = bot.rootValues[best].load(std::memory_order_relaxed);
+    int32_t depth = 1;
+
+    const int32_t maxDepth = bot.options.maxDepth < bot.queueLength ?
+        bot.options.maxDepth :
+        bot.queueLength;
+    for (int32_t iterationDepth = 2; iterationDepth <= maxDepth; iterationDepth++)
+    {
+        bot.taskCount.store(0, std::memory_order_relaxed);
+        for (int32_t root = 0; root < bot.rootCount; root++)
+        {
+            bot.rootValues[root].store(lose_value * 2, std::memory_order_relaxed);
+            const RootOption& option = bot.roots[root];
+            // Splitting below the root leaves enough tasks to go around for
+            // every thread, but is only worth it when the tasks it makes
+            // still have some depth to search.
+            startSearchTask(bot, 0, SearchTask{
+                &bot,
+                root,
+                option.node,
+                iterationDepth - 1,
+                option.clearValue,
+                iterationDepth - 1 >= 2
+            });
+        }
+        runTasks(bot.pool);
+        if (bot.aborted.load(std::memory_order_relaxed))
+            break;
+
+        best = findBestRoot(bot);
+        bestValue = bot.rootValues[best].load(std::memory_order_relaxed);
+        depth = iterationDepth;
+    }
+
+    const RootOption& option = bot.roots[best];
+    return BotMove{
+        option.hold,
+        option.type,
+        option.placement,
+        bestValue,
+        depth,
+        bot.nodeCount.load(std::memory_order_relaxed)
+    };
+}
+
+int32_t getBotMovePath(const Bot& bot, const BotMove& move, PieceMove* moves)
+{
+    return getPlacementPath(bot.rootSearches[move.hold], move.placement, moves);
+}
@@ -0,0 +1,143 @@
+#include "bot/transposition_table.h"
+
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+constexpr int32_t half_row_width = board_width / 2;
+constexpr int32_t half_row_patterns = 1 << half_row_width;
+constexpr uint32_t half_row_mask = half_row_patterns - 1;
+
+static_assert(board_width % 2 == 0);
+
+struct ZobristKeys
+{
+    uint64_t halfRows[board_height][2][half_row_patterns];
+    uint64_t extra[256];
+};
+
+uint64_t nextRandom(uint64_t& state)
+{
+    // splitmix64, which spreads even a simple counter over all bits.
+    state += 0x9E3779B97F4A7C15;
+    uint64_t value = state;
+    value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9;
+    value = (value ^ (value >> 27)) * 0x94D049BB133111EB;
+    return value ^ (value >> 31);
+}
+
+ZobristKeys makeZobristKeys()
+{
+    ZobristKeys keys = {};
+    uint64_t random = 0;
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        for (int32_t half = 0; half < 2; half++)
+        {
+            uint64_t cellKeys[half_row_width];
+            for (uint64_t& key : cellKeys)
+            {
+                key = nextRandom(random);
+            }
+            for (int32_t pattern = 0; pattern < half_row_patterns; pattern++)
+            {
+                uint64_t key = 0;
+                for (int32_t x = 0; x < half_row_width; x++)
+                {
+                    if ((pattern >> x) & 1)
+                        key ^= cellKeys[x];
+                }
+                keys.halfRows[y][half][pattern] = key;
+            }
+        }
+    }
+    for (uint64_t& key : keys.extra)
+    {
+        key = nextRandom(random);
+    }
+    return keys;
+}
+
+const ZobristKeys zobrist_keys = makeZobristKeys();
+
+uint64_t packEntry(uint32_t generation, float value)
+{
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return uint64_t(generation) << 32 | bits;
+}
+
+}
+
+uint64_t hashBoard(const Board& board)
+{
+    uint64_t hash = 0;
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        const uint16_t row = getRow(board, y);
+        hash ^= zobrist_keys.halfRows[y][0][row & half_row_mask];
+        hash ^= zobrist_keys.halfRows[y][1][row >> half_row_width];
+    }
+    return hash;
+}
+
+uint64_t getZobristKey(uint32_t index)
+{
+    ASSERT(index < 256);
+    return zobrist_keys.extra[index];
+}
+
+void initTranspositionTable(TranspositionTable& table, uint32_t sizeLog2)
+{
+    ASSERT(sizeLog2 > 0 && sizeLog2 < 40);
+
+    const uint64_t size = uint64_t(1) << sizeLog2;
+    table.entries = new TranspositionEntry[size];
+    for (uint64_t index = 0; index < size; index++)
+    {
+        table.entries[index].check.store(0, std::memory_order_relaxed);
+        table.entries[index].data.store(0, std::memory_order_relaxed);
+    }
+    table.mask = size - 1;
+    // Generation 0 is what the empty entries have.
+    table.generation = 1;
+}
+
+void destroyTranspositionTable(TranspositionTable& table)
+{
+    delete[] table.entries;
+    table = TranspositionTable{};
+}
+
+void advanceTranspositionTable(TranspositionTable& table)
+{
+    table.generation++;
+    if (table.generation == 0)
+        table.generation = 1;
+}
+
+bool probeTranspositionTable(const TranspositionTable& table,
+                             uint64_t key,
+                             float& value)
+{
+    const TranspositionEntry& entry = table.entries[key & table.mask];
+    const uint64_t data = entry.data.load(std::memory_order_relaxed);
+    const uint64_t check = entry.check.load(std::memory_order_relaxed);
+    if ((check ^ data) != key || uint32_t(data >> 32) != table.generation)
+        return false;
+
+    const uint32_t bits = uint32_t(data);
+    memcpy(&value, &bits, sizeof(value));
+    return true;
+}
+
+void storeTranspositionTable(TranspositionTable& table,
+                             uint64_t key,
+                             float value)
+{
+    TranspositionEntry& entry = table.entries[key & table.mask];
+    const uint64_t data = packEntry(table.generation, value);
+    entry.data.store(data, std::memory_order_relaxed);
+    entry.check.store(key ^ data, std::memory_order_relaxed);
+}
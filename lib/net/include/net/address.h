@@ -0,0 +1,17 @@
+#pragma once
+
+#include <cstdint>
+
+// An IPv4 address and port, in host byte order.
+struct NetAddress
+{
+    uint32_t host;
+    uint16_t port;
+};
+
+NetAddress makeLoopbackAddress(uint16_t port);
+
+// Parses "a.b.c.d:port". Returns false if the text is not such an address.
+bool parseNetAddress(const char* text, NetAddress& address);
+
+bool operator==(const NetAddress& left, const NetAddress& right);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "net/udp_socket.h"
+
+// How a simulated link treats the packets sent over it.
+struct LinkConditions
+{
+    // One way delay in nanoseconds, plus a random amount of up to jitter.
+    uint64_t latency;
+    uint64_t jitter;
+    // The chance of a packet being dropped, from 0 to 1.
+    float lossRate;
+};
+
+struct DelayedPacket
+{
+    uint64_t sendTime;
+    NetAddress address;
+    size_t size;
+    uint8_t bytes[max_udp_packet_size];
+};
+
+// Sends packets through a socket as if they went over a worse link, to try
+// out how netplay copes with latency and loss on loopback. Packets are held
+// back until they are due and dropped at random. They are always sent in the
+// order they were queued, so jitter delays the packets behind a late one
+// rather than reordering them.
+struct LossyLink
+{
+    UdpSocket* socket;
+    LinkConditions conditions;
+    uint32_t random;
+    DelayedPacket* packets;
+    size_t capacity;
+    size_t first;
+    size_t count;
+    uint64_t sentCount;
+    // Packets dropped at random or because too many were held back.
+    uint64_t droppedCount;
+};
+
+// Holds back at most capacity packets at a time.
+void initLossyLink(LossyLink& link,
+                   UdpSocket& socket,
+                   const LinkConditions& conditions,
+                   uint32_t seed,
+                   size_t capacity);
+void destroyLossyLink(LossyLink& link);
+
+// Queues a packet that was sent at the given time, in nanoseconds.
+void sendLinkPacket(LossyLink& link,
+                    const NetAddress& address,
+                    const uint8_t* bytes,
+                    size_t size,
+                    uint64_t time);
+
+// Sends the packets that are due at the given time.
+void flushLossyLink(LossyLink& link, uint64_t time);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <simulation/game.h>
+#include <simulation/versus.h>
+
+// Versus over the network without waiting for the other player. Every tick
+// runs right away with the local input and a prediction of the remote one,
+// which is simply the last remote input that arrived. When the real remote
+// input turns out to differ, the match is restored from the snapshot before
+// the first wrong tick and simulated up to the present again, all within
+// the tick that found out.
+//
+// The session only deals in packets, how they get to the other side is up
+// to the caller. Packets are sent unreliably and carry every local input the
+// other side has not acknowledged yet, so a lost packet is made up for by the
+// next one.
+//
+// Packet layout, all numbers little endian:
+//   magic "TRBK", version, tick of the sender, ticks the sender is ahead,
+//   remote ticks the sender has, tick and checksum of the newest match the
+//   sender is sure of, first tick and count of the inputs, packed inputs
+//
+// Ticks are sent as 32 bits, which lasts for two years of play.
+
+// How far ahead of the last known remote input the match may run. Beyond
+// that the session waits for the other side instead of predicting further.
+constexpr int32_t max_rollback_ticks = 8;
+// The ticks kept around: snapshots to roll back to, and local inputs the
+// other side has not acknowledged. A power of two.
+constexpr int32_t rollback_window = 32;
+constexpr size_t rollback_header_size = 27;
+constexpr size_t max_rollback_packet_size = rollback_header_size + rollback_window;
+
+struct RollbackStats
+{
+    uint64_t rollbackCount;
+    uint64_t resimulatedTickCount;
+    // The ticks simulated again by a rollback.
+    int32_t lastRollbackDepth;
+    int32_t maxRollbackDepth;
+    // The time spent simulating again by a rollback, in nanoseconds.
+    uint64_t lastRollbackTime;
+    uint64_t maxRollbackTime;
+    uint64_t totalRollbackTime;
+    // Ticks that were not run because the prediction ran too far ahead of
+    // the remote input.
+    uint64_t stallCount;
+    // Ticks that were not run to let the other side catch up.
+    uint64_t syncWaitCount;
+};
+
+struct RollbackSession
+{
+    int32_t localPlayer;
+    // The match at the start of the next tick to run, which is game.tick.
+    VersusGame game;
+    // The match at the start of tick t and the inputs of both players for
+    // it, at t % rollback_window. Remote inputs that did not arrive yet are
+    // the predictions they were run with.
+    VersusGame snapshots[rollback_window];
+    uint8_t inputs[versus_player_count][rollback_window];
+    // The checksum of the match after tick t, at t % rollback_window.
+    uint32_t checksums[rollback_window];
+
+    // The remote inputs of the ticks before remoteTick have arrived.
+    uint64_t remoteTick;
+    // The other side has the local inputs of the ticks before ackedTick.
+    uint64_t ackedTick;
+    // The first tick that ran with a wrong prediction, or game.tick if none
+    // did.
+    uint64_t rollbackTick;
+
+    // The tick the other side was at when it sent its newest packet, and how
+    // far it saw itself ahead.
+    uint64_t peerTick;
+    int32_t peerAdvantage;
+    uint64_t syncWaitTick;
+
+    // The newest checksum the other side is sure of.
+    uint64_t peerChecksumTick;
+    uint32_t peerChecksum;
+    bool hasPeerChecksum;
+    bool desynced;
+    // The first tick after which the matches were found to differ.
+    uint64_t desyncTick;
+
+    RollbackStats stats;
+};
+
+// Both sides must start from the same seed, with different local players.
+void initRollbackSession(RollbackSession& session,
+                         uint32_t seed,
+                         int32_t localPlayer);
+
+// Runs the next tick with the local input, after rolling back whatever
+// arrived since the last call proved wrong. Returns false if the tick was
+// not run because the session is too far ahead of the other side, in which
+// case it has to be run again later.
+bool advanceRollbackSession(RollbackSession& session, const GameInput& input);
+
+// Returns the size of the packet written, which is at most
+// max_rollback_packet_size.
+size_t writeRollbackPacket(const RollbackSession& session, uint8_t* bytes);
+
+// Returns false if the bytes are not a packet of the other side.
+bool readRollbackPacket(RollbackSession& session,
+                        const uint8_t* bytes,
+                        size_t size);
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <simulation/game.h>
+#include <thread>
+#include <util/pool.h>
+#include <util/spsc_queue.h>
+
+#include "net/spectator_stream.h"
+
+// Games waiting for the server thread to send them.
+constexpr size_t spectator_publish_capacity = 16;
+// The frames queued for a spectator beyond what its socket takes. A
+// spectator that falls further behind loses them and is sent a keyframe
+// instead.
+constexpr int32_t spectator_queue_capacity = 64;
+
+// An encoded frame shared by every spectator it is queued for, and put
+// back into the pool once the last of them sent it. Only the server thread
+// touches frames, so the count needs no atomics.
+struct SpectatorFrame
+{
+    int32_t refCount;
+    uint32_t size;
+    uint8_t bytes[max_spectator_frame_size];
+};
+
+struct Spectator
+{
+    // The socket, or -1 while the slot is free.
+    int handle;
+    SpectatorFrame* frames[spectator_queue_capacity];
+    int32_t first;
+    int32_t count;
+    // The bytes of the first frame that were sent already.
+    uint32_t sentSize;
+    // Whether the server waits for the socket to take more.
+    bool blocked;
+};
+
+struct SpectatorStats
+{
+    uint64_t encodedCount;
+    uint64_t sentBytes;
+    uint64_t acceptedCount;
+    uint64_t rejectedCount;
+    uint64_t disconnectedCount;
+    // Keyframes sent to spectators that fell too far behind.
+    uint64_t resyncCount;
+    // The time the server spent working rather than waiting, in
+    // nanoseconds.
+    uint64_t busyTime;
+};
+
+// Streams a game to many spectators over TCP. The thread running the game
+// publishes every tick without blocking, and a single server thread
+// encodes it once as a delta and queues the same buffer for every
+// spectator. An epoll loop then writes out as much of each queue as the
+// sockets take, so a slow spectator only ever holds up itself.
+struct SpectatorServer
+{
+    int listener;
+    int epoll;
+    // Wakes up the server when a game is published or it should stop.
+    int wakeup;
+    uint16_t port;
+    SpscQueue<Game, spectator_publish_capacity> games;
+    // The last game encoded, which the next delta is taken against.
+    Game game;
+    bool hasGame;
+    // The keyframe of game, encoded when a spectator first needs it.
+    SpectatorFrame* keyframe;
+    Pool<SpectatorFrame> frames;
+    Spectator* spectators;
+    int32_t maxSpectators;
+    int32_t spectatorCount;
+    // Only the server thread writes the statistics.
+    SpectatorStats stats;
+    // Games that could not be published because the server fell behind.
+    std::atomic<uint64_t> droppedGameCount;
+
+    std::thread thread;
+    std::atomic<bool> quitting;
+};
+
+// Listens on the port, or a port picked by the system when it is 0, and
+// takes at most maxSpectators at a time. Returns false if the socket
+// cannot be set up.
+bool openSpectatorServer(SpectatorServer& server, uint16_t port, int32_t maxSpectators);
+void closeSpectatorServer(SpectatorServer& server);
+
+// Hands a game to the server without blocking, from a single thread.
+void publishSpectatorGame(SpectatorServer& server, const Game& game);
+
+// Runs the server once, waiting at most timeoutMs for something to do, or
+// forever when it is negative. Returns false if waiting failed.
+bool pollSpectatorServer(SpectatorServer& server, int32_t timeoutMs);
+
+void startSpectatorServerThread(SpectatorServer& server);
+void stopSpectatorServerThread(SpectatorServer& server);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <simulation/game.h>
+
+#include "net/address.h"
+
+// The stream of game state sent to spectators, one frame per tick. Most
+// frames are deltas against the frame before, which only carry the rows of
+// the board that changed and the piece, queue and stats when they changed.
+// A keyframe carries everything, it starts the stream and resynchronizes a
+// spectator that fell behind. Only what is drawn is sent, so a spectator
+// can show the game but not simulate it.
+//
+// Frame layout, all numbers little endian:
+//   size of the whole frame (16 bits), flags (8 bits), tick (32 bits)
+//   if rows:  mask of the changed rows (32 bits), then each of them (16 bits)
+//   if piece: type, rotation, x, y (8 bits each)
+//   if queue: the previews, the held piece and whether there is one
+//   if stats: score, lines and level (32 bits each)
+
+constexpr uint8_t spectator_frame_keyframe = 1u << 0;
+constexpr uint8_t spectator_frame_rows = 1u << 1;
+constexpr uint8_t spectator_frame_piece = 1u << 2;
+constexpr uint8_t spectator_frame_queue = 1u << 3;
+constexpr uint8_t spectator_frame_stats = 1u << 4;
+constexpr uint8_t spectator_frame_over = 1u << 5;
+
+constexpr size_t spectator_frame_header_size = 7;
+constexpr size_t max_spectator_frame_size =
+    spectator_frame_header_size + 4 + 2 * board_height + 4 + preview_count + 2 + 12;
+
+// Both return the size of the frame written to bytes, which hold at least
+// max_spectator_frame_size.
+size_t encodeSpectatorKeyframe(const Game& game, uint8_t* bytes);
+size_t encodeSpectatorDelta(const Game& previous, const Game& game, uint8_t* bytes);
+
+// Applies a complete frame to the game of a spectator. Returns false if the
+// frame is malformed.
+bool applySpectatorFrame(Game& game, const uint8_t* bytes, size_t size);
+
+// Follows a spectator stream over TCP. The game only holds what the frames
+// carry, and it is only valid once synced.
+struct SpectatorClient
+{
+    int handle;
+    Game game;
+    bool synced;
+    uint64_t frameCount;
+    size_t bufferedSize;
+    uint8_t buffer[4096];
+};
+
+// Returns false if the server cannot be reached.
+bool connectSpectatorClient(SpectatorClient& client, const NetAddress& address);
+void closeSpectatorClient(SpectatorClient& client);
+
+// Applies the frames that arrived so far without blocking. Returns false
+// once the server closed the stream or sent a malformed frame.
+bool readSpectatorClient(SpectatorClient& client);
@@ -0,0 +1,37 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "net/address.h"
+
+// The largest packet sent or received, well below the MTU of any link so
+// packets are never fragmented.
+constexpr size_t max_udp_packet_size = 1024;
+
+// A non-blocking socket bound to a port on every interface.
+struct UdpSocket
+{
+    int handle;
+    // The port the socket is bound to, which is picked by the system when
+    // the socket is opened with port 0.
+    uint16_t port;
+};
+
+// Returns false if the socket cannot be created or bound.
+bool openUdpSocket(UdpSocket& socket, uint16_t port);
+void closeUdpSocket(UdpSocket& socket);
+
+// Returns false if the packet could not be handed to the system. Delivery
+// is never guaranteed either way.
+bool sendUdpPacket(UdpSocket& socket,
+                   const NetAddress& address,
+                   const uint8_t* bytes,
+                   size_t size);
+
+// Returns the size of the next packet that arrived and writes it to bytes,
+// or 0 if none is waiting. Packets larger than max_udp_packet_size are
+// dropped.
+size_t receiveUdpPacket(UdpSocket& socket,
+                        NetAddress& address,
+                        uint8_t* bytes);
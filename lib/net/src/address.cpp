@@ -0,0 +1,38 @@
+#include "net/address.h"
+
+#include <arpa/inet.h>
+#include <cstdlib>
+#include <cstring>
+#include <netinet/in.h>
+
+NetAddress makeLoopbackAddress(uint16_t port)
+{
+    return NetAddress{ INADDR_LOOPBACK, port };
+}
+
+bool parseNetAddress(const char* text, NetAddress& address)
+{
+    const char* colon = strrchr(text, ':');
+    if (colon == nullptr || size_t(colon - text) >= INET_ADDRSTRLEN)
+        return false;
+
+    char host[INET_ADDRSTRLEN];
+    memcpy(host, text, colon - text);
+    host[colon - text] = '\0';
+    in_addr hostAddress;
+    if (inet_pton(AF_INET, host, &hostAddress) != 1)
+        return false;
+
+    char* end;
+    const unsigned long port = strtoul(colon + 1, &end, 10);
+    if (end == colon + 1 || *end != '\0' || port == 0 || port > 0xFFFF)
+        return false;
+
+    address = NetAddress{ ntohl(hostAddress.s_addr), uint16_t(port) };
+    return true;
+}
+
+bool operator==(const NetAddress& left, const NetAddress& right)
+{
+    return left.host == right.host && left.port == right.port;
+}
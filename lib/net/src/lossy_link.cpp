@@ -0,0 +1,86 @@
+#include "net/lossy_link.h"
+
+#include <cstring>
+#include <util/assert.h>
+
+namespace {
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Returns a random number from 0 to 1.
+float nextUnit(uint32_t& state)
+{
+    return float(nextRandom(state) >> 8) / float(1u << 24);
+}
+
+}
+
+void initLossyLink(LossyLink& link,
+                   UdpSocket& socket,
+                   const LinkConditions& conditions,
+                   uint32_t seed,
+                   size_t capacity)
+{
+    ASSERT(capacity > 0);
+    link.socket = &socket;
+    link.conditions = conditions;
+    link.random = seed != 0 ? seed : 1;
+    link.packets = new DelayedPacket[capacity];
+    link.capacity = capacity;
+    link.first = 0;
+    link.count = 0;
+    link.sentCount = 0;
+    link.droppedCount = 0;
+}
+
+void destroyLossyLink(LossyLink& link)
+{
+    delete[] link.packets;
+    link.packets = nullptr;
+}
+
+void sendLinkPacket(LossyLink& link,
+                    const NetAddress& address,
+                    const uint8_t* bytes,
+                    size_t size,
+                    uint64_t time)
+{
+    ASSERT(size <= max_udp_packet_size);
+    link.sentCount++;
+    if (nextUnit(link.random) < link.conditions.lossRate ||
+        link.count == link.capacity) {
+        link.droppedCount++;
+        return;
+    }
+
+    uint64_t delay = link.conditions.latency;
+    if (link.conditions.jitter > 0)
+        delay += nextRandom(link.random) % (link.conditions.jitter + 1);
+
+    DelayedPacket& packet = link.packets[(link.first + link.count) % link.capacity];
+    packet.sendTime = time + delay;
+    packet.address = address;
+    packet.size = size;
+    memcpy(packet.bytes, bytes, size);
+    link.count++;
+}
+
+void flushLossyLink(LossyLink& link, uint64_t time)
+{
+    while (link.count > 0)
+    {
+        const DelayedPacket& packet = link.packets[link.first];
+        if (packet.sendTime > time)
+            return;
+
+        sendUdpPacket(*link.socket, packet.address, packet.bytes, packet.size);
+        link.first = (link.first + 1) % link.capacity;
+        link.count--;
+    }
+}
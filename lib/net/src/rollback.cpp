@@ -0,0 +1,260 @@
+#include "net/rollback.h"
+
+#include <cstring>
+#include <profiler/profiler.h>
+#include <simulation/game_loop.h>
+#include <simulation/input_source.h>
+#include <util/assert.h>
+
+namespace {
+
+static_assert((rollback_window & (rollback_window - 1)) == 0,
+              "The window is indexed with a mask");
+static_assert(rollback_window > 2 * max_rollback_ticks,
+              "The window holds the ticks that can be rolled back and the "
+              "ones the other side can be ahead by");
+
+constexpr uint64_t window_mask = rollback_window - 1;
+constexpr uint8_t rollback_magic[4] = { 'T', 'R', 'B', 'K' };
+constexpr uint8_t rollback_version = 1;
+// The session lets the other side catch up by skipping at most one tick
+// this often.
+constexpr uint64_t sync_wait_interval = tick_rate / 10;
+
+void putU32(uint8_t* bytes, uint32_t value)
+{
+    for (int32_t index = 0; index < 4; index++)
+    {
+        bytes[index] = uint8_t(value >> (index * 8));
+    }
+}
+
+uint32_t getU32(const uint8_t* bytes)
+{
+    uint32_t value = 0;
+    for (int32_t index = 0; index < 4; index++)
+    {
+        value |= uint32_t(bytes[index]) << (index * 8);
+    }
+    return value;
+}
+
+int32_t getRemotePlayer(const RollbackSession& session)
+{
+    return 1 - session.localPlayer;
+}
+
+// The newest tick whose match no longer depends on a prediction.
+uint64_t getConfirmedTick(const RollbackSession& session)
+{
+    return session.remoteTick < session.rollbackTick ?
+        session.remoteTick :
+        session.rollbackTick;
+}
+
+// How far this side is ahead of the other one, as far as it can tell.
+int32_t getAdvantage(const RollbackSession& session)
+{
+    return int32_t(int64_t(session.game.tick) - int64_t(session.peerTick));
+}
+
+// Runs the tick the match is at with the inputs recorded for it, predicting
+// the remote input again if it did not arrive yet.
+void simulateTick(RollbackSession& session)
+{
+    const uint64_t tick = session.game.tick;
+    const int32_t remote = getRemotePlayer(session);
+    if (tick >= session.remoteTick) {
+        session.inputs[remote][tick & window_mask] = session.remoteTick > 0 ?
+            session.inputs[remote][(session.remoteTick - 1) & window_mask] :
+            0;
+    }
+
+    session.snapshots[tick & window_mask] = session.game;
+    GameInput inputs[versus_player_count];
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        inputs[player] = unpackGameInput(session.inputs[player][tick & window_mask]);
+    }
+    updateVersusGame(session.game, inputs);
+    // A match that is over stays at its last tick, but the session goes on
+    // counting so that both sides keep agreeing on the ticks.
+    session.game.tick = tick + 1;
+    session.checksums[(tick + 1) & window_mask] = getVersusChecksum(session.game);
+}
+
+void rollBack(RollbackSession& session)
+{
+    const uint64_t tick = session.game.tick;
+    if (session.rollbackTick >= tick)
+        return;
+
+    PROFILE_SCOPE("rollback");
+    const uint64_t start = getSteadyTime();
+    const int32_t depth = int32_t(tick - session.rollbackTick);
+    ASSERT(depth <= max_rollback_ticks);
+
+    session.game = session.snapshots[session.rollbackTick & window_mask];
+    while (session.game.tick < tick)
+    {
+        simulateTick(session);
+    }
+    session.rollbackTick = tick;
+
+    const uint64_t time = getSteadyTime() - start;
+    RollbackStats& stats = session.stats;
+    stats.rollbackCount++;
+    stats.resimulatedTickCount += depth;
+    stats.lastRollbackDepth = depth;
+    stats.maxRollbackDepth = depth > stats.maxRollbackDepth ? depth : stats.maxRollbackDepth;
+    stats.lastRollbackTime = time;
+    stats.maxRollbackTime = time > stats.maxRollbackTime ? time : stats.maxRollbackTime;
+    stats.totalRollbackTime += time;
+    PROFILE_COUNTER("rollback depth", depth);
+    PROFILE_COUNTER("rollback us", int64_t(time / 1000));
+}
+
+// Compares the checksum of the other side with the own one once this side
+// is sure of the same tick. Checksums that fell out of the window are
+// skipped, newer ones will follow.
+void checkPeerChecksum(RollbackSession& session)
+{
+    if (!session.hasPeerChecksum || session.desynced)
+        return;
+    const uint64_t tick = session.peerChecksumTick;
+    if (tick > getConfirmedTick(session))
+        return;
+
+    session.hasPeerChecksum = false;
+    if (session.game.tick - tick >= uint64_t(rollback_window))
+        return;
+    if (session.checksums[tick & window_mask] != session.peerChecksum) {
+        session.desynced = true;
+        session.desyncTick = tick;
+    }
+}
+
+}
+
+void initRollbackSession(RollbackSession& session,
+                         uint32_t seed,
+                         int32_t localPlayer)
+{
+    ASSERT(localPlayer >= 0 && localPlayer < versus_player_count);
+    session = {};
+    session.localPlayer = localPlayer;
+    session.game = makeVersusGame(seed);
+    session.checksums[0] = getVersusChecksum(session.game);
+}
+
+bool advanceRollbackSession(RollbackSession& session, const GameInput& input)
+{
+    rollBack(session);
+    checkPeerChecksum(session);
+
+    const uint64_t tick = session.game.tick;
+    RollbackStats& stats = session.stats;
+    if (tick >= session.remoteTick + max_rollback_ticks ||
+        tick - session.ackedTick >= uint64_t(rollback_window)) {
+        stats.stallCount++;
+        return false;
+    }
+    // Both sides see the other one behind by the latency, so only the
+    // difference between what they see is how far this side is ahead. Until
+    // the other side was heard from, only the stall holds this side back.
+    if (session.remoteTick > 0 &&
+        (getAdvantage(session) - session.peerAdvantage) / 2 >= 1 &&
+        tick >= session.syncWaitTick + sync_wait_interval) {
+        session.syncWaitTick = tick;
+        stats.syncWaitCount++;
+        return false;
+    }
+
+    session.inputs[session.localPlayer][tick & window_mask] = packGameInput(input);
+    simulateTick(session);
+    session.rollbackTick = session.game.tick;
+    return true;
+}
+
+size_t writeRollbackPacket(const RollbackSession& session, uint8_t* bytes)
+{
+    const uint64_t tick = session.game.tick;
+    const uint64_t confirmedTick = getConfirmedTick(session);
+    int32_t advantage = getAdvantage(session);
+    advantage = advantage < INT8_MIN ? INT8_MIN : advantage > INT8_MAX ? INT8_MAX : advantage;
+    const uint64_t firstTick = session.ackedTick;
+    const size_t count = size_t(tick - firstTick);
+    ASSERT(count <= size_t(rollback_window));
+
+    memcpy(bytes, rollback_magic, sizeof(rollback_magic));
+    bytes[4] = rollback_version;
+    putU32(bytes + 5, uint32_t(tick));
+    bytes[9] = uint8_t(int8_t(advantage));
+    putU32(bytes + 10, uint32_t(session.remoteTick));
+    putU32(bytes + 14, uint32_t(confirmedTick));
+    putU32(bytes + 18, session.checksums[confirmedTick & window_mask]);
+    putU32(bytes + 22, uint32_t(firstTick));
+    bytes[26] = uint8_t(count);
+    for (size_t index = 0; index < count; index++)
+    {
+        bytes[rollback_header_size + index] =
+            session.inputs[session.localPlayer][(firstTick + index) & window_mask];
+    }
+    return rollback_header_size + count;
+}
+
+bool readRollbackPacket(RollbackSession& session,
+                        const uint8_t* bytes,
+                        size_t size)
+{
+    if (size < rollback_header_size ||
+        memcmp(bytes, rollback_magic, sizeof(rollback_magic)) != 0 ||
+        bytes[4] != rollback_version)
+        return false;
+    const size_t count = bytes[26];
+    if (count > size_t(rollback_window) || size != rollback_header_size + count)
+        return false;
+
+    const uint64_t tick = session.game.tick;
+    const uint64_t peerTick = getU32(bytes + 5);
+    // Packets can arrive out of order, only the newest tells where the
+    // other side is.
+    if (peerTick >= session.peerTick) {
+        session.peerTick = peerTick;
+        session.peerAdvantage = int8_t(bytes[9]);
+    }
+    const uint64_t ackedTick = getU32(bytes + 10);
+    if (ackedTick > session.ackedTick && ackedTick <= tick)
+        session.ackedTick = ackedTick;
+
+    // Only inputs that follow the ones already there are taken, the others
+    // are sent again until they are acknowledged. The other side cannot be
+    // further ahead than the prediction allows, anything beyond that is not
+    // from it.
+    const int32_t remote = getRemotePlayer(session);
+    const uint64_t firstTick = getU32(bytes + 22);
+    for (uint64_t index = 0; index < count; index++)
+    {
+        const uint64_t inputTick = firstTick + index;
+        if (inputTick != session.remoteTick)
+            continue;
+        if (inputTick >= tick + max_rollback_ticks)
+            break;
+
+        const uint8_t input = bytes[rollback_header_size + index];
+        uint8_t& recorded = session.inputs[remote][inputTick & window_mask];
+        if (inputTick < tick && recorded != input && inputTick < session.rollbackTick)
+            session.rollbackTick = inputTick;
+        recorded = input;
+        session.remoteTick++;
+    }
+
+    const uint64_t checksumTick = getU32(bytes + 14);
+    if (!session.hasPeerChecksum || checksumTick > session.peerChecksumTick) {
+        session.peerChecksumTick = checksumTick;
+        session.peerChecksum = getU32(bytes + 18);
+        session.hasPeerChecksum = true;
+    }
+    checkPeerChecksum(session);
+    return true;
+}
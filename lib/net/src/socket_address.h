@@ -0,0 +1,20 @@
+#pragma once
+
+#include <netinet/in.h>
+
+#include "net/address.h"
+
+inline sockaddr_in makeSocketAddress(const NetAddress& address)
+{
+    sockaddr_in socketAddress = {};
+    socketAddress.sin_family = AF_INET;
+    socketAddress.sin_addr.s_addr = htonl(address.host);
+    socketAddress.sin_port = htons(address.port);
+    return socketAddress;
+}
+
+inline NetAddress getNetAddress(const sockaddr_in& socketAddress)
+{
+    return NetAddress{ ntohl(socketAddress.sin_addr.s_addr),
+                       ntohs(socketAddress.sin_port) };
+}
@@ -0,0 +1,414 @@
+#include "net/spectator_server.h"
+
+#include <cerrno>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <profiler/profiler.h>
+#include <simulation/game_loop.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <util/assert.h>
+
+#include "socket_address.h"
+
+namespace {
+
+// The keys of the listener and the wakeup in the epoll set, spectators use
+// their slot index.
+constexpr uint64_t listener_key = ~uint64_t(0);
+constexpr uint64_t wakeup_key = ~uint64_t(0) - 1;
+constexpr int32_t max_events = 64;
+constexpr int listen_backlog = 128;
+// Kept small so a spectator that stops reading is noticed within a second
+// or so instead of the kernel buffering minutes of frames for it.
+constexpr int spectator_send_buffer_size = 16 * 1024;
+
+static_assert((spectator_queue_capacity & (spectator_queue_capacity - 1)) == 0,
+              "The spectator queues are indexed with a mask");
+
+constexpr int32_t queue_mask = spectator_queue_capacity - 1;
+
+// Every frame queued after the first one of a spectator belongs to one of
+// the last spectator_queue_capacity ticks, as each tick either adds to the
+// queue or replaces it. That leaves the first frames, a delta and a
+// keyframe for each of those ticks, and the cached keyframe.
+int32_t getFramePoolSize(int32_t maxSpectators)
+{
+    return maxSpectators + 2 * spectator_queue_capacity + 2;
+}
+
+SpectatorFrame* takeFrame(SpectatorServer& server)
+{
+    SpectatorFrame* frame = takeFromPool(server.frames);
+    ASSERT(frame != nullptr);
+    frame->refCount = 1;
+    return frame;
+}
+
+void releaseFrame(SpectatorServer& server, SpectatorFrame* frame)
+{
+    ASSERT(frame->refCount > 0);
+    if (--frame->refCount == 0)
+        putBackIntoPool(server.frames, frame);
+}
+
+SpectatorFrame* getKeyframe(SpectatorServer& server)
+{
+    ASSERT(server.hasGame);
+    if (server.keyframe == nullptr) {
+        server.keyframe = takeFrame(server);
+        server.keyframe->size = uint32_t(encodeSpectatorKeyframe(server.game, server.keyframe->bytes));
+        server.stats.encodedCount++;
+    }
+    return server.keyframe;
+}
+
+void pushFrame(Spectator& spectator, SpectatorFrame* frame)
+{
+    ASSERT(spectator.count < spectator_queue_capacity);
+    frame->refCount++;
+    spectator.frames[(spectator.first + spectator.count) & queue_mask] = frame;
+    spectator.count++;
+}
+
+// Drops what the spectator did not get yet and starts it over from the
+// current keyframe. A frame that was partly sent stays, so the stream does
+// not break in the middle of it.
+void resyncSpectator(SpectatorServer& server, Spectator& spectator)
+{
+    const int32_t kept = spectator.sentSize > 0 ? 1 : 0;
+    for (int32_t index = kept; index < spectator.count; index++)
+    {
+        releaseFrame(server, spectator.frames[(spectator.first + index) & queue_mask]);
+    }
+    spectator.count = kept;
+    pushFrame(spectator, getKeyframe(server));
+    server.stats.resyncCount++;
+}
+
+void disconnectSpectator(SpectatorServer& server, int32_t slot)
+{
+    Spectator& spectator = server.spectators[slot];
+    for (int32_t index = 0; index < spectator.count; index++)
+    {
+        releaseFrame(server, spectator.frames[(spectator.first + index) & queue_mask]);
+    }
+    close(spectator.handle);
+    spectator.handle = -1;
+    spectator.count = 0;
+    server.spectatorCount--;
+    server.stats.disconnectedCount++;
+}
+
+bool setWriteInterest(SpectatorServer& server, int32_t slot, bool blocked)
+{
+    Spectator& spectator = server.spectators[slot];
+    epoll_event event = {};
+    event.events = EPOLLIN | EPOLLRDHUP | (blocked ? EPOLLOUT : 0);
+    event.data.u64 = uint64_t(slot);
+    spectator.blocked = blocked;
+    return epoll_ctl(server.epoll, EPOLL_CTL_MOD, spectator.handle, &event) == 0;
+}
+
+// Writes as much of the queue as the socket takes in one call. Returns
+// false if the spectator went away.
+bool flushSpectator(SpectatorServer& server, int32_t slot)
+{
+    Spectator& spectator = server.spectators[slot];
+    if (spectator.blocked || spectator.count == 0)
+        return true;
+
+    iovec buffers[spectator_queue_capacity];
+    for (int32_t index = 0; index < spectator.count; index++)
+    {
+        SpectatorFrame* frame = spectator.frames[(spectator.first + index) & queue_mask];
+        const uint32_t offset = index == 0 ? spectator.sentSize : 0;
+        buffers[index].iov_base = frame->bytes + offset;
+        buffers[index].iov_len = frame->size - offset;
+    }
+    msghdr message = {};
+    message.msg_iov = buffers;
+    message.msg_iovlen = size_t(spectator.count);
+
+    const ssize_t sent = sendmsg(spectator.handle, &message, MSG_NOSIGNAL | MSG_DONTWAIT);
+    if (sent == -1) {
+        if (errno == EAGAIN || errno == EWOULDBLOCK)
+            return setWriteInterest(server, slot, true);
+        return errno == EINTR;
+    }
+    server.stats.sentBytes += uint64_t(sent);
+
+    size_t remaining = size_t(sent);
+    while (spectator.count > 0)
+    {
+        SpectatorFrame* frame = spectator.frames[spectator.first];
+        const size_t left = frame->size - spectator.sentSize;
+        if (remaining < left) {
+            spectator.sentSize += uint32_t(remaining);
+            break;
+        }
+        remaining -= left;
+        releaseFrame(server, frame);
+        spectator.first = (spectator.first + 1) & queue_mask;
+        spectator.count--;
+        spectator.sentSize = 0;
+    }
+    // The socket took less than it was given, so it is full.
+    if (spectator.count > 0)
+        return setWriteInterest(server, slot, true);
+    return true;
+}
+
+void acceptSpectators(SpectatorServer& server)
+{
+    while (true)
+    {
+        const int handle = accept4(server.listener, nullptr, nullptr, SOCK_NONBLOCK);
+        if (handle == -1)
+            return;
+
+        int32_t slot = 0;
+        while (slot < server.maxSpectators && server.spectators[slot].handle != -1)
+        {
+            slot++;
+        }
+        const int noDelay = 1;
+        const int sendBufferSize = spectator_send_buffer_size;
+        epoll_event event = {};
+        event.events = EPOLLIN | EPOLLRDHUP;
+        event.data.u64 = uint64_t(slot);
+        if (slot == server.maxSpectators ||
+            setsockopt(handle, IPPROTO_TCP, TCP_NODELAY, &noDelay, sizeof(noDelay)) == -1 ||
+            setsockopt(handle, SOL_SOCKET, SO_SNDBUF, &sendBufferSize, sizeof(sendBufferSize)) == -1 ||
+            epoll_ctl(server.epoll, EPOLL_CTL_ADD, handle, &event) == -1) {
+            close(handle);
+            server.stats.rejectedCount++;
+            continue;
+        }
+
+        Spectator& spectator = server.spectators[slot];
+        spectator.handle = handle;
+        spectator.first = 0;
+        spectator.count = 0;
+        spectator.sentSize = 0;
+        spectator.blocked = false;
+        server.spectatorCount++;
+        server.stats.acceptedCount++;
+        // Spectators that join before the first game get its keyframe with
+        // the first tick.
+        if (server.hasGame)
+            pushFrame(spectator, getKeyframe(server));
+    }
+}
+
+// Encodes the game once and queues it for every spectator.
+void broadcastGame(SpectatorServer& server, const Game& game)
+{
+    PROFILE_SCOPE("broadcast");
+    if (!server.hasGame) {
+        server.game = game;
+        server.hasGame = true;
+        for (int32_t slot = 0; slot < server.maxSpectators; slot++)
+        {
+            if (server.spectators[slot].handle != -1)
+                pushFrame(server.spectators[slot], getKeyframe(server));
+        }
+        return;
+    }
+
+    SpectatorFrame* delta = takeFrame(server);
+    delta->size = uint32_t(encodeSpectatorDelta(server.game, game, delta->bytes));
+    server.stats.encodedCount++;
+    if (server.keyframe != nullptr) {
+        releaseFrame(server, server.keyframe);
+        server.keyframe = nullptr;
+    }
+    server.game = game;
+
+    for (int32_t slot = 0; slot < server.maxSpectators; slot++)
+    {
+        Spectator& spectator = server.spectators[slot];
+        if (spectator.handle == -1)
+            continue;
+        if (spectator.count == spectator_queue_capacity)
+            resyncSpectator(server, spectator);
+        else
+            pushFrame(spectator, delta);
+    }
+    releaseFrame(server, delta);
+}
+
+void runSpectatorServer(SpectatorServer* server)
+{
+    PROFILE_THREAD("spectators");
+    while (!server->quitting.load(std::memory_order_relaxed))
+    {
+        if (!pollSpectatorServer(*server, -1))
+            return;
+    }
+}
+
+}
+
+bool openSpectatorServer(SpectatorServer& server, uint16_t port, int32_t maxSpectators)
+{
+    ASSERT(maxSpectators > 0);
+    const int listener = socket(AF_INET, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (listener == -1)
+        return false;
+
+    const int reuse = 1;
+    const sockaddr_in address = makeSocketAddress(NetAddress{ INADDR_ANY, port });
+    sockaddr_in bound;
+    socklen_t boundSize = sizeof(bound);
+    if (setsockopt(listener, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse)) == -1 ||
+        bind(listener, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 ||
+        listen(listener, listen_backlog) == -1 ||
+        getsockname(listener, reinterpret_cast<sockaddr*>(&bound), &boundSize) == -1) {
+        close(listener);
+        return false;
+    }
+
+    const int epoll = epoll_create1(0);
+    const int wakeup = eventfd(0, EFD_NONBLOCK);
+    epoll_event listenerEvent = {};
+    listenerEvent.events = EPOLLIN;
+    listenerEvent.data.u64 = listener_key;
+    epoll_event wakeupEvent = {};
+    wakeupEvent.events = EPOLLIN;
+    wakeupEvent.data.u64 = wakeup_key;
+    if (epoll == -1 || wakeup == -1 ||
+        epoll_ctl(epoll, EPOLL_CTL_ADD, listener, &listenerEvent) == -1 ||
+        epoll_ctl(epoll, EPOLL_CTL_ADD, wakeup, &wakeupEvent) == -1) {
+        if (epoll != -1)
+            close(epoll);
+        if (wakeup != -1)
+            close(wakeup);
+        close(listener);
+        return false;
+    }
+
+    server.listener = listener;
+    server.epoll = epoll;
+    server.wakeup = wakeup;
+    server.port = ntohs(bound.sin_port);
+    server.games.head.store(0, std::memory_order_relaxed);
+    server.games.tail.store(0, std::memory_order_relaxed);
+    server.hasGame = false;
+    server.keyframe = nullptr;
+
+    initPool(server.frames, getFramePoolSize(maxSpectators));
+
+    server.spectators = new Spectator[maxSpectators];
+    for (int32_t slot = 0; slot < maxSpectators; slot++)
+    {
+        server.spectators[slot].handle = -1;
+        server.spectators[slot].count = 0;
+    }
+    server.maxSpectators = maxSpectators;
+    server.spectatorCount = 0;
+    server.stats = SpectatorStats{};
+    server.droppedGameCount.store(0, std::memory_order_relaxed);
+    server.quitting.store(false, std::memory_order_relaxed);
+    return true;
+}
+
+void closeSpectatorServer(SpectatorServer& server)
+{
+    for (int32_t slot = 0; slot < server.maxSpectators; slot++)
+    {
+        if (server.spectators[slot].handle != -1)
+            disconnectSpectator(server, slot);
+    }
+    close(server.wakeup);
+    close(server.epoll);
+    close(server.listener);
+    delete[] server.spectators;
+    server.spectators = nullptr;
+    destroyPool(server.frames);
+}
+
+void publishSpectatorGame(SpectatorServer& server, const Game& game)
+{
+    if (!tryPush(server.games, game)) {
+        server.droppedGameCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(server.wakeup, &one, sizeof(one));
+}
+
+bool pollSpectatorServer(SpectatorServer& server, int32_t timeoutMs)
+{
+    epoll_event events[max_events];
+    const int eventCount = epoll_wait(server.epoll, events, max_events, timeoutMs);
+    if (eventCount == -1)
+        return errno == EINTR;
+
+    const uint64_t start = getSteadyTime();
+    for (int index = 0; index < eventCount; index++)
+    {
+        const uint64_t key = events[index].data.u64;
+        if (key == listener_key) {
+            acceptSpectators(server);
+        }
+        else if (key == wakeup_key) {
+            uint64_t count;
+            [[maybe_unused]] const ssize_t drained = read(server.wakeup, &count, sizeof(count));
+        }
+        else {
+            const int32_t slot = int32_t(key);
+            Spectator& spectator = server.spectators[slot];
+            if (spectator.handle == -1)
+                continue;
+            if (events[index].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) {
+                disconnectSpectator(server, slot);
+                continue;
+            }
+            // Spectators have nothing to say, whatever they send is
+            // thrown away.
+            if (events[index].events & EPOLLIN) {
+                uint8_t discarded[256];
+                while (recv(spectator.handle, discarded, sizeof(discarded), MSG_DONTWAIT) > 0)
+                {
+                }
+            }
+            if ((events[index].events & EPOLLOUT) && !setWriteInterest(server, slot, false))
+                disconnectSpectator(server, slot);
+        }
+    }
+
+    // Any games published in the meantime go out together, one write per
+    // spectator.
+    Game game;
+    while (tryPop(server.games, game))
+    {
+        broadcastGame(server, game);
+    }
+    for (int32_t slot = 0; slot < server.maxSpectators; slot++)
+    {
+        if (server.spectators[slot].handle != -1 && !flushSpectator(server, slot))
+            disconnectSpectator(server, slot);
+    }
+
+    server.stats.busyTime += getSteadyTime() - start;
+    return true;
+}
+
+void startSpectatorServerThread(SpectatorServer& server)
+{
+    ASSERT(!server.thread.joinable());
+    server.quitting.store(false, std::memory_order_relaxed);
+    server.thread = std::thread(runSpectatorServer, &server);
+}
+
+void stopSpectatorServerThread(SpectatorServer& server)
+{
+    server.quitting.store(true, std::memory_order_relaxed);
+    const uint64_t one = 1;
+    [[maybe_unused]] const ssize_t written = write(server.wakeup, &one, sizeof(one));
+    server.thread.join();
+}
@@ -0,0 +1,301 @@
+#include "net/spectator_stream.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <util/assert.h>
+
+#include "socket_address.h"
+
+namespace {
+
+static_assert(board_height <= 32, "The changed rows are sent as a 32 bit mask");
+
+void putU16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = uint8_t(value);
+    bytes[1] = uint8_t(value >> 8);
+}
+
+uint16_t getU16(const uint8_t* bytes)
+{
+    return uint16_t(bytes[0] | bytes[1] << 8);
+}
+
+void putU32(uint8_t* bytes, uint32_t value)
+{
+    for (int32_t index = 0; index < 4; index++)
+    {
+        bytes[index] = uint8_t(value >> (index * 8));
+    }
+}
+
+uint32_t getU32(const uint8_t* bytes)
+{
+    uint32_t value = 0;
+    for (int32_t index = 0; index < 4; index++)
+    {
+        value |= uint32_t(bytes[index]) << (index * 8);
+    }
+    return value;
+}
+
+bool isSamePiece(const ActivePiece& left, const ActivePiece& right)
+{
+    return left.type == right.type &&
+           left.rotation == right.rotation &&
+           left.x == right.x &&
+           left.y == right.y;
+}
+
+bool isSameQueue(const Game& left, const Game& right)
+{
+    return memcmp(left.previews, right.previews, sizeof(left.previews)) == 0 &&
+           left.hasHold == right.hasHold &&
+           (!left.hasHold || left.hold == right.hold);
+}
+
+bool isSameStats(const Game& left, const Game& right)
+{
+    return left.score == right.score &&
+           left.lines == right.lines &&
+           left.level == right.level;
+}
+
+// Writes the sections of the frame that the flags ask for. The rows are
+// the ones set in rowMask.
+size_t encodeFrame(const Game& game, uint8_t flags, uint32_t rowMask, uint8_t* bytes)
+{
+    if (game.over)
+        flags |= spectator_frame_over;
+    if (rowMask != 0)
+        flags |= spectator_frame_rows;
+
+    size_t size = spectator_frame_header_size;
+    if (flags & spectator_frame_rows) {
+        putU32(bytes + size, rowMask);
+        size += 4;
+        for (int32_t y = 0; y < board_height; y++)
+        {
+            if (rowMask & (1u << y)) {
+                putU16(bytes + size, getRow(game.board, y));
+                size += 2;
+            }
+        }
+    }
+    if (flags & spectator_frame_piece) {
+        bytes[size++] = uint8_t(game.piece.type);
+        bytes[size++] = uint8_t(game.piece.rotation);
+        bytes[size++] = uint8_t(int8_t(game.piece.x));
+        bytes[size++] = uint8_t(int8_t(game.piece.y));
+    }
+    if (flags & spectator_frame_queue) {
+        for (int32_t index = 0; index < preview_count; index++)
+        {
+            bytes[size++] = uint8_t(game.previews[index]);
+        }
+        bytes[size++] = uint8_t(game.hold);
+        bytes[size++] = game.hasHold;
+    }
+    if (flags & spectator_frame_stats) {
+        putU32(bytes + size, game.score);
+        putU32(bytes + size + 4, uint32_t(game.lines));
+        putU32(bytes + size + 8, uint32_t(game.level));
+        size += 12;
+    }
+
+    ASSERT(size <= max_spectator_frame_size);
+    putU16(bytes, uint16_t(size));
+    bytes[2] = flags;
+    putU32(bytes + 3, uint32_t(game.tick));
+    return size;
+}
+
+bool isPieceType(uint8_t value)
+{
+    return value < piece_type_count;
+}
+
+}
+
+size_t encodeSpectatorKeyframe(const Game& game, uint8_t* bytes)
+{
+    const uint32_t allRows = (1u << board_height) - 1;
+    return encodeFrame(game,
+                       spectator_frame_keyframe |
+                       spectator_frame_rows |
+                       spectator_frame_piece |
+                       spectator_frame_queue |
+                       spectator_frame_stats,
+                       allRows,
+                       bytes);
+}
+
+size_t encodeSpectatorDelta(const Game& previous, const Game& game, uint8_t* bytes)
+{
+    uint32_t rowMask = 0;
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        if (getRow(previous.board, y) != getRow(game.board, y))
+            rowMask |= 1u << y;
+    }
+
+    uint8_t flags = 0;
+    if (!isSamePiece(previous.piece, game.piece))
+        flags |= spectator_frame_piece;
+    if (!isSameQueue(previous, game))
+        flags |= spectator_frame_queue;
+    if (!isSameStats(previous, game))
+        flags |= spectator_frame_stats;
+    return encodeFrame(game, flags, rowMask, bytes);
+}
+
+bool applySpectatorFrame(Game& game, const uint8_t* bytes, size_t size)
+{
+    if (size < spectator_frame_header_size || getU16(bytes) != size)
+        return false;
+
+    const uint8_t flags = bytes[2];
+    size_t offset = spectator_frame_header_size;
+    // Everything is checked before the game is touched, so a malformed
+    // frame leaves it as it was.
+    uint32_t rowMask = 0;
+    size_t expected = offset;
+    if (flags & spectator_frame_rows) {
+        if (size < offset + 4)
+            return false;
+        rowMask = getU32(bytes + offset);
+        if (rowMask >> board_height != 0)
+            return false;
+        expected += 4 + 2 * __builtin_popcount(rowMask);
+    }
+    const size_t pieceOffset = expected;
+    if (flags & spectator_frame_piece)
+        expected += 4;
+    const size_t queueOffset = expected;
+    if (flags & spectator_frame_queue)
+        expected += preview_count + 2;
+    if (flags & spectator_frame_stats)
+        expected += 12;
+    if (expected != size)
+        return false;
+
+    if (flags & spectator_frame_piece) {
+        if (!isPieceType(bytes[pieceOffset]) || bytes[pieceOffset + 1] >= rotation_count)
+            return false;
+    }
+    if (flags & spectator_frame_queue) {
+        for (int32_t index = 0; index < preview_count + 1; index++)
+        {
+            if (!isPieceType(bytes[queueOffset + index]))
+                return false;
+        }
+    }
+
+    if (flags & spectator_frame_rows) {
+        offset += 4;
+        for (int32_t y = 0; y < board_height; y++)
+        {
+            if (rowMask & (1u << y)) {
+                setRow(game.board, y, getU16(bytes + offset) & ((1u << board_width) - 1));
+                offset += 2;
+            }
+        }
+    }
+    if (flags & spectator_frame_piece) {
+        game.piece.type = PieceType(bytes[offset]);
+        game.piece.rotation = bytes[offset + 1];
+        game.piece.x = int8_t(bytes[offset + 2]);
+        game.piece.y = int8_t(bytes[offset + 3]);
+        offset += 4;
+    }
+    if (flags & spectator_frame_queue) {
+        for (int32_t index = 0; index < preview_count; index++)
+        {
+            game.previews[index] = PieceType(bytes[offset++]);
+        }
+        game.hold = PieceType(bytes[offset++]);
+        game.hasHold = bytes[offset++] != 0;
+    }
+    if (flags & spectator_frame_stats) {
+        game.score = getU32(bytes + offset);
+        game.lines = int32_t(getU32(bytes + offset + 4));
+        game.level = int32_t(getU32(bytes + offset + 8));
+    }
+    game.tick = getU32(bytes + 3);
+    game.over = (flags & spectator_frame_over) != 0;
+    return true;
+}
+
+bool connectSpectatorClient(SpectatorClient& client, const NetAddress& address)
+{
+    const int handle = socket(AF_INET, SOCK_STREAM, 0);
+    if (handle == -1)
+        return false;
+
+    const sockaddr_in socketAddress = makeSocketAddress(address);
+    if (connect(handle, reinterpret_cast<const sockaddr*>(&socketAddress), sizeof(socketAddress)) == -1 ||
+        fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK) == -1) {
+        close(handle);
+        return false;
+    }
+
+    client.handle = handle;
+    client.game = makeGame(0);
+    client.synced = false;
+    client.frameCount = 0;
+    client.bufferedSize = 0;
+    return true;
+}
+
+void closeSpectatorClient(SpectatorClient& client)
+{
+    close(client.handle);
+    client.handle = -1;
+}
+
+bool readSpectatorClient(SpectatorClient& client)
+{
+    static_assert(sizeof(client.buffer) >= max_spectator_frame_size,
+                  "The buffer holds at least one frame");
+
+    while (true)
+    {
+        const ssize_t received = recv(client.handle,
+                                      client.buffer + client.bufferedSize,
+                                      sizeof(client.buffer) - client.bufferedSize,
+                                      0);
+        if (received == 0)
+            return false;
+        if (received == -1)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        client.bufferedSize += size_t(received);
+
+        size_t offset = 0;
+        while (true)
+        {
+            const uint8_t* frame = client.buffer + offset;
+            if (client.bufferedSize - offset < 2)
+                break;
+            const size_t frameSize = getU16(frame);
+            if (frameSize < spectator_frame_header_size || frameSize > max_spectator_frame_size)
+                return false;
+            if (frameSize > client.bufferedSize - offset)
+                break;
+
+            // Deltas only make sense on top of the keyframe that starts the
+            // stream.
+            if (frame[2] & spectator_frame_keyframe)
+                client.synced = true;
+            if (client.synced && !applySpectatorFrame(client.game, frame, frameSize))
+                return false;
+            client.frameCount++;
+            offset += frameSize;
+        }
+        memmove(client.buffer, client.buffer + offset, client.bufferedSize - offset);
+        client.bufferedSize -= offset;
+    }
+}
@@ -0,0 +1,86 @@
+#include "net/udp_socket.h"
+
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include <util/assert.h>
+
+#include "socket_address.h"
+
+bool openUdpSocket(UdpSocket& udpSocket, uint16_t port)
+{
+    const int handle = socket(AF_INET, SOCK_DGRAM, 0);
+    if (handle == -1)
+        return false;
+
+    const sockaddr_in address = makeSocketAddress(NetAddress{ INADDR_ANY, port });
+    sockaddr_in bound;
+    socklen_t boundSize = sizeof(bound);
+    if (fcntl(handle, F_SETFL, fcntl(handle, F_GETFL) | O_NONBLOCK) == -1 ||
+        bind(handle, reinterpret_cast<const sockaddr*>(&address), sizeof(address)) == -1 ||
+        getsockname(handle, reinterpret_cast<sockaddr*>(&bound), &boundSize) == -1) {
+        close(handle);
+        return false;
+    }
+
+    udpSocket.handle = handle;
+    udpSocket.port = ntohs(bound.sin_port);
+    return true;
+}
+
+void closeUdpSocket(UdpSocket& socket)
+{
+    if (socket.handle != -1)
+        close(socket.handle);
+    socket.handle = -1;
+}
+
+bool sendUdpPacket(UdpSocket& socket,
+                   const NetAddress& address,
+                   const uint8_t* bytes,
+                   size_t size)
+{
+    ASSERT(size <= max_udp_packet_size);
+    const sockaddr_in socketAddress = makeSocketAddress(address);
+    return sendto(socket.handle,
+                  bytes,
+                  size,
+                  0,
+                  reinterpret_cast<const sockaddr*>(&socketAddress),
+                  sizeof(socketAddress)) == ssize_t(size);
+}
+
+size_t receiveUdpPacket(UdpSocket& socket,
+                        NetAddress& address,
+                        uint8_t* bytes)
+{
+    for (;;)
+    {
+        sockaddr_in socketAddress;
+        socklen_t addressSize = sizeof(socketAddress);
+        // One byte more than the largest packet tells the ones that were cut
+        // short apart.
+        uint8_t buffer[max_udp_packet_size + 1];
+        const ssize_t size = recvfrom(socket.handle,
+                                      buffer,
+                                      sizeof(buffer),
+                                      0,
+                                      reinterpret_cast<sockaddr*>(&socketAddress),
+                                      &addressSize);
+        // Errors of earlier sends, like a peer that is not listening yet,
+        // show up here as well and are skipped over.
+        if (size < 0 && errno == ECONNREFUSED)
+            continue;
+        if (size < 0)
+            return 0;
+        if (size == 0 || size_t(size) > max_udp_packet_size)
+            continue;
+
+        memcpy(bytes, buffer, size);
+        address = getNetAddress(socketAddress);
+        return size_t(size);
+    }
+}
@@ -0,0 +1,85 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <util/list_view.h>
+
+// Up to this many threads can record events, each into its own buffer.
+constexpr int32_t profiler_max_thread_count = 8;
+// Events a thread can record before they are collected. Events recorded
+// into a full buffer are dropped.
+constexpr size_t profiler_thread_buffer_size = 4096;
+
+enum class ProfileEventKind : uint8_t
+{
+    Zone,
+    Counter
+};
+
+struct ProfileEvent
+{
+    // Must be a string that outlives the profiler, usually a literal.
+    const char* name;
+    ProfileEventKind kind;
+    int32_t thread;
+    // Nanoseconds since the profiler was initialized.
+    uint64_t time;
+    // The duration of a zone in nanoseconds, or the value of a counter.
+    int64_t value;
+};
+
+// Keeps up to maxEventCount collected events for export. Must not be called
+// while other threads record events.
+void initProfiler(size_t maxEventCount);
+void destroyProfiler();
+
+uint64_t getProfileTime();
+
+// Names the calling thread in exported traces.
+void setProfileThreadName(const char* name);
+
+// Records into the buffer of the calling thread, without locking or
+// allocating. Does nothing when the profiler is not initialized.
+void recordProfileZone(const char* name, uint64_t begin, uint64_t end);
+void recordProfileCounter(const char* name, int64_t value);
+
+// Moves the events recorded by all threads into the collected events. Must
+// only be called from a single thread.
+void collectProfileEvents();
+
+ListView<ProfileEvent> getProfileEvents();
+// Events that were lost because a buffer or the collected events were full.
+uint64_t getDroppedProfileEventCount();
+
+// Writes the collected events in the Chrome trace event format, which can be
+// opened with chrome://tracing or Perfetto.
+bool writeChromeTrace(const char* path);
+
+struct ProfileScope
+{
+    const char* name;
+    uint64_t begin;
+
+    explicit ProfileScope(const char* name);
+    ~ProfileScope();
+};
+
+// The macros compile to nothing unless the profiler is enabled with the
+// ENABLE_PROFILER build option.
+#if defined(PROFILER_ENABLED)
+
+#define PROFILE_CONCAT_INNER(first, second) first##second
+#define PROFILE_CONCAT(first, second) PROFILE_CONCAT_INNER(first, second)
+
+#define PROFILE_SCOPE(name) \
+    const ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+#define PROFILE_COUNTER(name, value) recordProfileCounter(name, value)
+#define PROFILE_THREAD(name) setProfileThreadName(name)
+
+#else
+
+#define PROFILE_SCOPE(name)
+#define PROFILE_COUNTER(name, value)
+#define PROFILE_THREAD(name)
+
+#endif
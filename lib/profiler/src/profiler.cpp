@@ -0,0 +1,235 @@
+#include "profiler/profiler.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <util/assert.h>
+#include <util/spsc_queue.h>
+
+namespace {
+
+struct ThreadBuffer
+{
+    SpscQueue<ProfileEvent, profiler_thread_buffer_size> events;
+    std::atomic<const char*> name;
+};
+
+// Which buffer a thread records into. Threads pick a new one when the
+// profiler was initialized again since they last recorded.
+struct ThreadSlot
+{
+    uint32_t generation;
+    int32_t index;
+};
+
+thread_local ThreadSlot threadSlot;
+
+ThreadBuffer* threadBuffers;
+std::atomic<int32_t> threadCount;
+uint32_t generation;
+std::chrono::steady_clock::time_point startTime;
+
+ListView<ProfileEvent> collectedEvents;
+std::atomic<uint64_t> droppedEventCount;
+
+ThreadBuffer* getThreadBuffer()
+{
+    if (threadBuffers == nullptr)
+        return nullptr;
+
+    if (threadSlot.generation != generation) {
+        threadSlot.generation = generation;
+        threadSlot.index = threadCount.fetch_add(1, std::memory_order_relaxed);
+    }
+    if (threadSlot.index >= profiler_max_thread_count)
+        return nullptr;
+    return &threadBuffers[threadSlot.index];
+}
+
+void recordEvent(ProfileEvent event)
+{
+    ThreadBuffer* buffer = getThreadBuffer();
+    if (buffer == nullptr)
+        return;
+
+    event.thread = threadSlot.index;
+    if (!tryPush(buffer->events, event))
+        droppedEventCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+void writeString(FILE* file, const char* string)
+{
+    fputc('"', file);
+    for (; *string != '\0'; string++)
+    {
+        if (*string == '"' || *string == '\\')
+            fputc('\\', file);
+        fputc(*string, file);
+    }
+    fputc('"', file);
+}
+
+}
+
+void initProfiler(size_t maxEventCount)
+{
+    ASSERT(threadBuffers == nullptr);
+
+    // Value initialized, so every queue starts out empty.
+    threadBuffers = new ThreadBuffer[profiler_max_thread_count]();
+    threadCount.store(0, std::memory_order_relaxed);
+    generation++;
+    startTime = std::chrono::steady_clock::now();
+    if (maxEventCount > 0)
+        collectedEvents =
+            makeListView(maxEventCount, new ProfileEvent[maxEventCount]);
+    droppedEventCount.store(0, std::memory_order_relaxed);
+}
+
+void destroyProfiler()
+{
+    delete[] threadBuffers;
+    threadBuffers = nullptr;
+    delete[] collectedEvents.elems;
+    collectedEvents = ListView<ProfileEvent>{};
+}
+
+uint64_t getProfileTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - startTime).count();
+}
+
+void setProfileThreadName(const char* name)
+{
+    ASSERT(name != nullptr);
+
+    ThreadBuffer* buffer = getThreadBuffer();
+    if (buffer != nullptr)
+        buffer->name.store(name, std::memory_order_relaxed);
+}
+
+void recordProfileZone(const char* name, uint64_t begin, uint64_t end)
+{
+    recordEvent(ProfileEvent{
+        name,
+        ProfileEventKind::Zone,
+        0,
+        begin,
+        int64_t(end - begin)
+    });
+}
+
+void recordProfileCounter(const char* name, int64_t value)
+{
+    recordEvent(ProfileEvent{
+        name,
+        ProfileEventKind::Counter,
+        0,
+        getProfileTime(),
+        value
+    });
+}
+
+void collectProfileEvents()
+{
+    if (threadBuffers == nullptr)
+        return;
+
+    int32_t count = threadCount.load(std::memory_order_relaxed);
+    if (count > profiler_max_thread_count)
+        count = profiler_max_thread_count;
+    for (int32_t thread = 0; thread < count; thread++)
+    {
+        ProfileEvent event;
+        while (tryPop(threadBuffers[thread].events, event))
+        {
+            if (collectedEvents.count < collectedEvents.capacity)
+                add(collectedEvents, event);
+            else if (collectedEvents.elems != nullptr)
+                droppedEventCount.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+}
+
+ListView<ProfileEvent> getProfileEvents()
+{
+    return collectedEvents;
+}
+
+uint64_t getDroppedProfileEventCount()
+{
+    return droppedEventCount.load(std::memory_order_relaxed);
+}
+
+bool writeChromeTrace(const char* path)
+{
+    ASSERT(path != nullptr);
+
+    FILE* file = fopen(path, "w");
+    if (file == nullptr) {
+        fprintf(stderr, "Opening trace file %s failed\n", path);
+        return false;
+    }
+
+    fprintf(file, "{\"traceEvents\":[\n");
+    bool first = true;
+    int32_t count = threadCount.load(std::memory_order_relaxed);
+    if (count > profiler_max_thread_count)
+        count = profiler_max_thread_count;
+    for (int32_t thread = 0; thread < count && threadBuffers != nullptr; thread++)
+    {
+        const char* name = threadBuffers[thread].name.load(std::memory_order_relaxed);
+        if (name == nullptr)
+            continue;
+
+        fprintf(file,
+                "%s{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%d,\"args\":{\"name\":",
+                first ? "" : ",\n",
+                thread);
+        writeString(file, name);
+        fprintf(file, "}}");
+        first = false;
+    }
+
+    // Timestamps and durations are in microseconds.
+    for (size_t index = 0; index < collectedEvents.count; index++)
+    {
+        const ProfileEvent& event = collectedEvents[index];
+        fprintf(file, "%s{\"name\":", first ? "" : ",\n");
+        writeString(file, event.name);
+        switch (event.kind)
+        {
+            case ProfileEventKind::Zone:
+                fprintf(file,
+                        ",\"ph\":\"X\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"dur\":%.3f}",
+                        event.thread,
+                        event.time / 1000.0,
+                        event.value / 1000.0);
+                break;
+            case ProfileEventKind::Counter:
+                fprintf(file,
+                        ",\"ph\":\"C\",\"pid\":1,\"tid\":%d,\"ts\":%.3f,\"args\":{\"value\":%lld}}",
+                        event.thread,
+                        event.time / 1000.0,
+                        (long long)event.value);
+                break;
+        }
+        first = false;
+    }
+    fprintf(file, "\n]}\n");
+
+    const bool written = ferror(file) == 0;
+    fclose(file);
+    return written;
+}
+
+ProfileScope::ProfileScope(const char* name)
+    : name(name), begin(getProfileTime())
+{
+}
+
+ProfileScope::~ProfileScope()
+{
+    recordProfileZone(name, begin, getProfileTime());
+}
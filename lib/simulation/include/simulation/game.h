@@ -0,0 +1,74 @@
+#pragma once
+
+#include <cstdint>
+#include <board/board.h>
+
+constexpr int32_t tick_rate = 60;
+constexpr int32_t preview_count = 5;
+
+// Flags for what happened during the last tick, for sound and effects to
+// react to.
+constexpr uint32_t game_event_rotated = 1u << 0;
+constexpr uint32_t game_event_held = 1u << 1;
+constexpr uint32_t game_event_hard_dropped = 1u << 2;
+constexpr uint32_t game_event_locked = 1u << 3;
+constexpr uint32_t game_event_lines_cleared = 1u << 4;
+constexpr uint32_t game_event_level_up = 1u << 5;
+constexpr uint32_t game_event_over = 1u << 6;
+
+// The buttons the simulation reacts to, sampled once per tick.
+struct GameInput
+{
+    bool left;
+    bool right;
+    bool down;
+    bool drop;
+    bool swap;
+    bool turnLeft;
+    bool turnRight;
+};
+
+struct ActivePiece
+{
+    PieceType type;
+    int32_t rotation;
+    int32_t x;
+    int32_t y;
+};
+
+// The complete state of a single player game. It holds no pointers, so it can
+// be copied around freely and two games built from the same seed and fed the
+// same inputs always end up identical.
+struct Game
+{
+    Board board;
+    ActivePiece piece;
+    PieceType previews[preview_count];
+    PieceType bag[piece_type_count];
+    int32_t bagIndex;
+    PieceType hold;
+    bool hasHold;
+    bool holdUsed;
+    uint32_t random;
+    GameInput previousInput;
+    int32_t shiftDirection;
+    int32_t shiftTicks;
+    int32_t gravityTicks;
+    int32_t lockTicks;
+    int32_t lines;
+    int32_t level;
+    uint32_t score;
+    uint64_t tick;
+    uint32_t events;
+    // The number of lines cleared by the last locked piece.
+    int32_t clearedLines;
+    bool over;
+};
+
+Game makeGame(uint32_t seed);
+
+// Advances the game by one tick.
+void updateGame(Game& game, const GameInput& input);
+
+// Returns the row the active piece would lock at if it was hard dropped.
+int32_t getGhostRow(const Game& game);
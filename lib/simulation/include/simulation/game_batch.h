@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstdint>
+#include <board/board.h>
+#include <util/task_pool.h>
+
+#include "simulation/game.h"
+
+// Games stepped in lock step, many at a time, one placement per game and
+// step. This is for training and tuning players, which need far more games
+// than a tick by tick simulation can play. Pieces spawn, fall and clear lines
+// the way dropPiece places them, without gravity, lock delay or hold.
+//
+// The games are stored as structures of arrays, so the same row of every
+// game is contiguous and the drops and line clears of neighbouring games are
+// tested with SIMD. The batch is split into chunks of games that the threads
+// of a pool step in parallel.
+//
+// Everything a player observes lives in flat arrays owned by the batch,
+// which stay where they are for the lifetime of the batch and can be read
+// in place after every step.
+
+// An action places the current piece with a rotation and the column its
+// mask is shifted to, x + board_left_wall, so every in range mask position
+// is an action.
+constexpr int32_t batch_column_count = 13;
+constexpr int32_t batch_action_count = rotation_count * batch_column_count;
+// The number of games tested at once, and what the games are padded to.
+constexpr int32_t batch_lane_count = 8;
+constexpr int32_t batch_row_count = board_padding + board_height + board_padding;
+
+struct GameBatch;
+
+// The games a thread steps at once.
+struct GameBatchChunk
+{
+    GameBatch* batch;
+    int32_t first;
+    int32_t count;
+};
+
+struct GameBatch
+{
+    int32_t gameCount;
+    // The distance between the same row or preview of neighbouring games,
+    // gameCount rounded up to batch_lane_count.
+    int32_t stride;
+
+    // The rows of every board laid out like Board::rows, walls and padding
+    // included, with row y of game i at (board_padding + y) * stride + i.
+    uint16_t* rows;
+    // The piece to be placed next by each game.
+    PieceType* pieces;
+    // Preview j of game i at j * stride + i.
+    PieceType* previews;
+    // The lines each game cleared with the last step.
+    float* rewards;
+    // Set for the games that topped out with the last step, either because
+    // the action could not be placed or because the next piece could not
+    // spawn. Those games are restarted right away, and what is observed of
+    // them is the new game.
+    uint8_t* dones;
+
+    // The pieces each game draws from, like Game::bag, with the bag of
+    // game i at i * piece_type_count as only that game reads it.
+    PieceType* bags;
+    uint8_t* bagIndices;
+    uint32_t* randoms;
+    // The seed each game was last started from. Game i starts from
+    // seed + i, and every restart adds gameCount to it.
+    uint32_t* seeds;
+
+    TaskPool pool;
+    GameBatchChunk* chunks;
+    int32_t chunkCount;
+    // The actions of the step being run.
+    const uint8_t* actions;
+};
+
+void initGameBatch(GameBatch& batch,
+                   int32_t gameCount,
+                   uint32_t seed,
+                   int32_t threadCount);
+void destroyGameBatch(GameBatch& batch);
+
+uint8_t makeBatchAction(int32_t rotation, int32_t x);
+
+// Places the current piece of every game with the action at the same index,
+// clears lines and spawns the next pieces.
+void stepGameBatch(GameBatch& batch, const uint8_t* actions);
+
+// Returns the playfield cells of a row of one of the games, like getRow.
+uint16_t getBatchRow(const GameBatch& batch, int32_t game, int32_t y);
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <thread>
+#include <util/fixed_timestep.h>
+#include <util/spsc_queue.h>
+#include <util/triple_buffer.h>
+
+#include "simulation/game.h"
+#include "simulation/input_source.h"
+#include "simulation/replay.h"
+
+constexpr size_t game_loop_input_capacity = 256;
+
+// The buttons held after a window event. Only the thread handling window
+// events posts them.
+struct InputEvent
+{
+    GameInput buttons;
+    bool pause;
+    // When the event happened, in nanoseconds of getSteadyTime.
+    uint64_t time;
+};
+
+// The state of the game after a tick, published for the renderer. It is a
+// copy, so the renderer can take its time drawing it while the game goes on.
+struct GameSnapshot
+{
+    Game game;
+    bool paused;
+    // When the snapshot was published, in nanoseconds of getSteadyTime.
+    uint64_t time;
+};
+
+// Lets the game react to the simulation, on the thread that runs it.
+struct GameLoopCallbacks
+{
+    // Called after every tick, with the events of the tick.
+    void (*ticked)(void* context, const Game& game);
+    void (*pauseChanged)(void* context, bool paused);
+    void* context;
+};
+
+// Runs the simulation at the tick rate, on its own thread or driven by the
+// main loop, and decouples it from the window and the renderer. Input comes
+// in over a wait free queue and snapshots go out through a triple buffer,
+// so a stalled swap or driver never holds up the ticks, and the ticks never
+// hold up a frame.
+struct GameLoop
+{
+    Game game;
+    FixedTimestep timestep;
+    GameLoopCallbacks callbacks;
+    // Overrides the buttons of the player while it has input, or null.
+    InputSource* source;
+    // Records the input of every tick, or null.
+    ReplayWriter* recorder;
+
+    GameInput buttons;
+    bool paused;
+    bool pauseHeld;
+    // When the oldest input that did not make it into a tick yet happened,
+    // or 0 if there is none.
+    uint64_t pendingInputTime;
+
+    SpscQueue<InputEvent, game_loop_input_capacity> inputs;
+    TripleBuffer<GameSnapshot> snapshots;
+
+    // The time from an input event until the game state with it was
+    // published, in nanoseconds.
+    std::atomic<uint64_t> lastInputLatency;
+    std::atomic<uint64_t> maxInputLatency;
+    std::atomic<uint64_t> totalInputLatency;
+    std::atomic<uint64_t> inputLatencyCount;
+    // Events that could not be posted because the queue was full.
+    std::atomic<uint64_t> droppedInputCount;
+
+    std::thread thread;
+    std::atomic<bool> quitting;
+};
+
+uint64_t getSteadyTime();
+
+// Publishes the game as the first snapshot.
+void initGameLoop(GameLoop& loop,
+                  const Game& game,
+                  const GameLoopCallbacks& callbacks,
+                  InputSource* source,
+                  ReplayWriter* recorder,
+                  uint64_t time);
+
+// Applies the posted input, runs the ticks that are due at the given time
+// and publishes a snapshot if anything changed. Must only be called by one
+// thread, and not while the loop runs on its own thread.
+void updateGameLoop(GameLoop& loop, uint64_t time);
+
+// Updates the loop on a thread of its own, sleeping in between ticks.
+void startGameLoopThread(GameLoop& loop);
+void stopGameLoopThread(GameLoop& loop);
+
+// Must only be called from a single thread.
+void postInputEvent(GameLoop& loop, const InputEvent& event);
+
+// Takes the newest snapshot if one was published since the last call.
+// Returns false if there is none, the previous one is still valid then. Must
+// only be called from a single thread.
+bool acquireGameSnapshot(GameLoop& loop);
+const GameSnapshot& getGameSnapshot(const GameLoop& loop);
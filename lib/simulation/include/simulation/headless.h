@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+#include "simulation/input_source.h"
+
+struct HeadlessReport
+{
+    uint64_t gameCount;
+    // The games that ended by topping out, rather than being cut short.
+    uint64_t finishedGameCount;
+    uint64_t tickCount;
+    uint64_t lineCount;
+    uint32_t bestScore;
+    double seconds;
+};
+
+double getTicksPerSecond(const HeadlessReport& report);
+
+// Plays games back to back with input from the source, as fast as they can
+// be simulated. Game i is built from seed + i. A game that is not over after
+// maxTickCount ticks is cut short, and running stops early once the source
+// runs out.
+HeadlessReport runHeadless(InputSource& source,
+                           uint32_t seed,
+                           uint64_t gameCount,
+                           uint64_t maxTickCount);
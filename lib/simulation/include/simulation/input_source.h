@@ -0,0 +1,52 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "simulation/game.h"
+#include "simulation/replay.h"
+
+// GameInput with one bit per button, in the order of its fields.
+uint8_t packGameInput(const GameInput& input);
+GameInput unpackGameInput(uint8_t buttons);
+
+enum class InputSourceType : uint8_t
+{
+    // Mashes buttons at random, holding each combination for a few ticks.
+    // Hard drops come often enough that games end in a few hundred ticks.
+    Random,
+    // Plays back packed inputs, one per tick.
+    Recording,
+    // Plays back a replay file.
+    Replay,
+    // Asks a function, which gets to look at the game first.
+    Callback
+};
+
+// Where the input of a game comes from when nobody is playing it.
+struct InputSource
+{
+    InputSourceType type;
+    uint32_t random;
+    GameInput held;
+    int32_t heldTicks;
+    const uint8_t* inputs;
+    size_t inputCount;
+    size_t position;
+    ReplayCursor cursor;
+    bool (*read)(void* context, const Game& game, GameInput& input);
+    void* context;
+};
+
+InputSource makeRandomInputSource(uint32_t seed);
+// The inputs are not copied and must outlive the source.
+InputSource makeRecordedInputSource(const uint8_t* inputs, size_t inputCount);
+// Starts at the tick of the replay, which must stay open.
+InputSource makeReplayInputSource(const Replay& replay, uint64_t tick);
+InputSource makeCallbackInputSource(
+    bool (*read)(void* context, const Game& game, GameInput& input),
+    void* context);
+
+// Writes the input for the next tick of the game, returns false if the
+// source ran out.
+bool readInput(InputSource& source, const Game& game, GameInput& input);
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+
+#include "simulation/game.h"
+
+// Replay files hold the inputs of a single game, one per tick, split into
+// chunks that each start with a keyframe of the whole game state. The inputs
+// of a chunk are stored as runs of ticks with the same buttons held, each run
+// holding the buttons that changed since the previous one. An index of the
+// keyframes at the end of the file allows seeking to any tick by replaying
+// the inputs from the keyframe before it.
+//
+// Keyframes are the Game struct as it is laid out in memory, so replays can
+// only be read by builds with the same layout. The format version has to be
+// bumped whenever Game changes.
+//
+// Layout, all numbers little endian:
+//   header: magic "TRPL", version, size of Game, seed, keyframe interval
+//   chunk:  first tick, tick count, input byte count, buttons held before
+//           the first tick, keyframe, input bytes
+//   ...
+//   index:  first tick and file offset of every chunk
+//   footer: index offset, chunk count, tick count, magic "TRPL"
+
+constexpr uint32_t default_keyframe_interval = 10 * tick_rate;
+
+struct ReplayIndexEntry
+{
+    uint64_t tick;
+    uint64_t offset;
+};
+
+// Writes a replay while the game is being played. Only the current chunk and
+// the index are kept in memory, the rest goes to the file as it is done.
+struct ReplayWriter
+{
+    FILE* file;
+    uint32_t keyframeInterval;
+    uint64_t tick;
+    uint64_t offset;
+    // The current chunk.
+    uint64_t chunkTick;
+    uint8_t chunkButtons;
+    Game keyframe;
+    uint8_t* bytes;
+    size_t byteCount;
+    // The current run of ticks with the same buttons held.
+    uint8_t previousButtons;
+    uint8_t buttons;
+    uint32_t runLength;
+    ReplayIndexEntry* index;
+    size_t indexCount;
+    size_t indexCapacity;
+    bool failed;
+};
+
+// Returns false if the file cannot be created.
+bool openReplayWriter(ReplayWriter& writer,
+                      const char* path,
+                      uint32_t seed,
+                      uint32_t keyframeInterval);
+// Records the input for the next tick of the game, before it is applied.
+void writeReplayInput(ReplayWriter& writer,
+                      const Game& game,
+                      const GameInput& input);
+// Writes the last chunk and the index. Returns false if anything failed to
+// be written.
+bool closeReplayWriter(ReplayWriter& writer);
+
+// A replay file mapped into memory. Nothing is read up front besides the
+// header and footer, so opening is just as fast for archives of any size.
+struct Replay
+{
+    const uint8_t* data;
+    size_t size;
+    uint32_t seed;
+    uint32_t keyframeInterval;
+    uint64_t tickCount;
+    uint64_t chunkCount;
+    size_t indexOffset;
+};
+
+// Returns false if the file cannot be mapped or is not a valid replay.
+bool openReplay(Replay& replay, const char* path);
+void closeReplay(Replay& replay);
+
+// Reads the inputs of a replay in order, starting from any tick.
+struct ReplayCursor
+{
+    const Replay* replay;
+    uint64_t chunk;
+    uint64_t tick;
+    // The end of the current chunk.
+    uint64_t chunkEnd;
+    const uint8_t* bytes;
+    const uint8_t* bytesEnd;
+    uint8_t buttons;
+    uint32_t runLeft;
+};
+
+// Positions the cursor at the tick, which can be one past the last tick.
+// Finding the chunk takes O(log n), the inputs before the tick inside the
+// chunk are skipped.
+ReplayCursor makeReplayCursor(const Replay& replay, uint64_t tick);
+// Returns false once the cursor is past the last tick.
+bool readReplayInput(ReplayCursor& cursor, GameInput& input);
+
+// Returns the game as it was before the input of the tick was applied, by
+// replaying from the keyframe before it.
+Game seekReplay(const Replay& replay, uint64_t tick);
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <cstdint>
+
+#include "simulation/game.h"
+
+constexpr int32_t versus_player_count = 2;
+
+// Two games played against each other. Clearing lines sends garbage to the
+// other player, which first cancels the garbage waiting for the sender and
+// then waits until the next piece of the receiver locks without clearing
+// lines. Both players are dealt the same pieces.
+//
+// Like Game it holds no pointers, so a copy is a complete snapshot that can
+// be restored to roll the match back.
+struct VersusGame
+{
+    Game players[versus_player_count];
+    // The rows of garbage waiting to be added to the board of each player.
+    int32_t pendingGarbage[versus_player_count];
+    uint32_t random;
+    uint64_t tick;
+    bool over;
+    // The player who is still standing once the match is over, or -1 if
+    // both topped out on the same tick.
+    int32_t winner;
+};
+
+VersusGame makeVersusGame(uint32_t seed);
+
+// Advances both games by one tick, with the input of each player at its
+// index.
+void updateVersusGame(VersusGame& game, const GameInput* inputs);
+
+// Hashes everything the match depends on, so that two machines can compare
+// their matches without sending them. The padding is left out, so equal
+// matches hash the same no matter how they were copied.
+uint32_t getVersusChecksum(const VersusGame& game);
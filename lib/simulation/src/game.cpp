@@ -0,0 +1,239 @@
+#include "simulation/game.h"
+
+#include <board/piece_table.h>
+#include <util/assert.h>
+
+namespace {
+
+constexpr int32_t shift_delay_ticks = 10;
+constexpr int32_t shift_repeat_ticks = 2;
+constexpr int32_t soft_drop_ticks = 1;
+constexpr int32_t lock_delay_ticks = 30;
+constexpr int32_t lines_per_level = 10;
+
+constexpr int32_t gravity_ticks[] = {
+    48, 43, 38, 33, 28, 23, 18, 13, 8, 6,
+    5, 5, 5, 4, 4, 4, 3, 3, 3, 2
+};
+constexpr int32_t gravity_level_count =
+    sizeof(gravity_ticks) / sizeof(gravity_ticks[0]);
+
+constexpr uint32_t line_scores[] = { 0, 100, 300, 500, 800 };
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void refillBag(Game& game)
+{
+    for (int32_t index = 0; index < piece_type_count; index++)
+    {
+        game.bag[index] = PieceType(index);
+    }
+    for (int32_t index = piece_type_count - 1; index > 0; index--)
+    {
+        const int32_t other = nextRandom(game.random) % (index + 1);
+        const PieceType type = game.bag[index];
+        game.bag[index] = game.bag[other];
+        game.bag[other] = type;
+    }
+    game.bagIndex = 0;
+}
+
+PieceType drawFromBag(Game& game)
+{
+    if (game.bagIndex == piece_type_count)
+        refillBag(game);
+    return game.bag[game.bagIndex++];
+}
+
+PieceType takePreview(Game& game)
+{
+    const PieceType type = game.previews[0];
+    for (int32_t index = 1; index < preview_count; index++)
+    {
+        game.previews[index - 1] = game.previews[index];
+    }
+    game.previews[preview_count - 1] = drawFromBag(game);
+    return type;
+}
+
+PieceMask getActiveMask(const Game& game)
+{
+    return getPieceMask(game.piece.type, game.piece.rotation);
+}
+
+void spawnPiece(Game& game, PieceType type)
+{
+    game.piece = ActivePiece{ type, 0, piece_spawn_x, piece_spawn_y };
+    game.gravityTicks = 0;
+    game.lockTicks = 0;
+    if (collides(game.board, getActiveMask(game), game.piece.x, game.piece.y)) {
+        game.over = true;
+        game.events |= game_event_over;
+    }
+}
+
+bool tryMove(Game& game, int32_t dx, int32_t dy)
+{
+    const ActivePiece& piece = game.piece;
+    if (collides(game.board, getActiveMask(game), piece.x + dx, piece.y + dy))
+        return false;
+
+    game.piece.x += dx;
+    game.piece.y += dy;
+    return true;
+}
+
+void tryRotate(Game& game, PieceTurn turn)
+{
+    constexpr const PieceTable<board_width>& table = piece_table<board_width>;
+    const ActivePiece& piece = game.piece;
+    const int32_t rotation = table.turns[piece.rotation][int32_t(turn)];
+    for (int32_t offset : table.kicks[int32_t(piece.type)][piece.rotation][int32_t(turn)])
+    {
+        const PieceMask mask =
+            getPieceMaskAt<board_width>(piece.type, rotation, piece.x + offset);
+        if (!collidesShifted(game.board, mask, piece.y)) {
+            game.piece.rotation = rotation;
+            game.piece.x += offset;
+            game.events |= game_event_rotated;
+            return;
+        }
+    }
+}
+
+void lockActivePiece(Game& game)
+{
+    lockPiece(game.board, getActiveMask(game), game.piece.x, game.piece.y);
+
+    game.events |= game_event_locked;
+
+    const int32_t cleared = clearLines(game.board, game.piece.y);
+    game.clearedLines = cleared;
+    if (cleared > 0)
+        game.events |= game_event_lines_cleared;
+
+    const int32_t level = game.level;
+    game.score += line_scores[cleared] * (game.level + 1);
+    game.lines += cleared;
+    game.level = game.lines / lines_per_level;
+    if (game.level != level)
+        game.events |= game_event_level_up;
+
+    game.holdUsed = false;
+    spawnPiece(game, takePreview(game));
+}
+
+void holdActivePiece(Game& game)
+{
+    const PieceType type = game.piece.type;
+    spawnPiece(game, game.hasHold ? game.hold : takePreview(game));
+    game.hold = type;
+    game.hasHold = true;
+    game.holdUsed = true;
+    game.events |= game_event_held;
+}
+
+void updateShift(Game& game, const GameInput& input)
+{
+    const int32_t direction =
+        input.left == input.right ? 0 : input.left ? -1 : 1;
+    if (direction != game.shiftDirection) {
+        game.shiftDirection = direction;
+        game.shiftTicks = 0;
+        if (direction != 0)
+            tryMove(game, direction, 0);
+        return;
+    }
+    if (direction == 0)
+        return;
+
+    game.shiftTicks++;
+    if (game.shiftTicks >= shift_delay_ticks &&
+        (game.shiftTicks - shift_delay_ticks) % shift_repeat_ticks == 0)
+        tryMove(game, direction, 0);
+}
+
+int32_t getGravityTicks(const Game& game)
+{
+    return game.level < gravity_level_count ?
+        gravity_ticks[game.level] :
+        gravity_ticks[gravity_level_count - 1];
+}
+
+}
+
+Game makeGame(uint32_t seed)
+{
+    Game game = {};
+    game.board = makeBoard();
+    game.random = seed != 0 ? seed : 1;
+    game.bagIndex = piece_type_count;
+    for (int32_t index = 0; index < preview_count; index++)
+    {
+        game.previews[index] = drawFromBag(game);
+    }
+    spawnPiece(game, takePreview(game));
+    return game;
+}
+
+void updateGame(Game& game, const GameInput& input)
+{
+    game.events = 0;
+    if (game.over)
+        return;
+
+    game.tick++;
+    const GameInput& previous = game.previousInput;
+    const bool swapPressed = input.swap && !previous.swap;
+    const bool turnLeftPressed = input.turnLeft && !previous.turnLeft;
+    const bool turnRightPressed = input.turnRight && !previous.turnRight;
+    const bool dropPressed = input.drop && !previous.drop;
+    game.previousInput = input;
+
+    if (swapPressed && !game.holdUsed) {
+        holdActivePiece(game);
+        if (game.over)
+            return;
+    }
+
+    if (turnLeftPressed)
+        tryRotate(game, PieceTurn::CounterClockwise);
+    if (turnRightPressed)
+        tryRotate(game, PieceTurn::Clockwise);
+
+    updateShift(game, input);
+
+    if (dropPressed) {
+        game.events |= game_event_hard_dropped;
+        game.piece.y = getGhostRow(game);
+        lockActivePiece(game);
+        return;
+    }
+
+    const int32_t gravity = input.down ? soft_drop_ticks : getGravityTicks(game);
+    if (++game.gravityTicks >= gravity) {
+        game.gravityTicks = 0;
+        tryMove(game, 0, -1);
+    }
+
+    const ActivePiece& piece = game.piece;
+    if (collides(game.board, getActiveMask(game), piece.x, piece.y - 1)) {
+        if (++game.lockTicks >= lock_delay_ticks)
+            lockActivePiece(game);
+    } else {
+        game.lockTicks = 0;
+    }
+}
+
+int32_t getGhostRow(const Game& game)
+{
+    ASSERT(!game.over);
+    const ActivePiece& piece = game.piece;
+    return findDropRow(game.board, getActiveMask(game), piece.x, piece.y);
+}
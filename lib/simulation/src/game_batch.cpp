@@ -0,0 +1,460 @@
+#include "simulation/game_batch.h"
+
+#include <cstring>
+#include <util/assert.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#define BATCH_SSE2 1
+#endif
+
+namespace {
+
+// Enough chunks per thread for the threads that finish early to steal some.
+constexpr int32_t chunks_per_thread = 4;
+
+// The masks of the pieces of a group of neighbouring games, one lane per
+// game, shifted to their columns. Lanes without a game hold no cells.
+struct LaneMasks
+{
+    uint16_t rows[4][batch_lane_count];
+};
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Draws pieces the same way as the game does, so a batch game deals the
+// same pieces as a Game built from the same seed.
+void refillBag(GameBatch& batch, int32_t game)
+{
+    PieceType* bag = &batch.bags[game * piece_type_count];
+    for (int32_t index = 0; index < piece_type_count; index++)
+    {
+        bag[index] = PieceType(index);
+    }
+    for (int32_t index = piece_type_count - 1; index > 0; index--)
+    {
+        const int32_t other = nextRandom(batch.randoms[game]) % (index + 1);
+        const PieceType type = bag[index];
+        bag[index] = bag[other];
+        bag[other] = type;
+    }
+    batch.bagIndices[game] = 0;
+}
+
+PieceType drawFromBag(GameBatch& batch, int32_t game)
+{
+    if (batch.bagIndices[game] == piece_type_count)
+        refillBag(batch, game);
+    return batch.bags[game * piece_type_count + batch.bagIndices[game]++];
+}
+
+PieceType takePreview(GameBatch& batch, int32_t game)
+{
+    const int32_t stride = batch.stride;
+    const PieceType type = batch.previews[game];
+    for (int32_t index = 1; index < preview_count; index++)
+    {
+        batch.previews[(index - 1) * stride + game] =
+            batch.previews[index * stride + game];
+    }
+    batch.previews[(preview_count - 1) * stride + game] = drawFromBag(batch, game);
+    return type;
+}
+
+uint16_t& rowAt(GameBatch& batch, int32_t game, int32_t y)
+{
+    return batch.rows[(board_padding + y) * batch.stride + game];
+}
+
+uint16_t rowAt(const GameBatch& batch, int32_t game, int32_t y)
+{
+    return batch.rows[(board_padding + y) * batch.stride + game];
+}
+
+void startGame(GameBatch& batch, int32_t game, uint32_t seed)
+{
+    for (int32_t y = -board_padding; y < 0; y++)
+    {
+        rowAt(batch, game, y) = board_full_row;
+    }
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        rowAt(batch, game, y) = board_empty_row;
+    }
+    for (int32_t y = board_height; y < board_height + board_padding; y++)
+    {
+        rowAt(batch, game, y) = board_full_row;
+    }
+
+    batch.seeds[game] = seed;
+    batch.randoms[game] = seed != 0 ? seed : 1;
+    batch.bagIndices[game] = piece_type_count;
+    for (int32_t index = 0; index < preview_count; index++)
+    {
+        batch.previews[index * batch.stride + game] = drawFromBag(batch, game);
+    }
+    batch.pieces[game] = takePreview(batch, game);
+}
+
+void setLaneMask(LaneMasks& masks, int32_t lane, PieceMask mask)
+{
+    for (int32_t row = 0; row < 4; row++)
+    {
+        masks.rows[row][lane] = uint16_t(mask >> (row * 16));
+    }
+}
+
+#if defined(BATCH_SSE2)
+
+// Returns a lane of all ones for every game whose piece fits at row y.
+__m128i findFreeLanes(const uint16_t* rows,
+                      int32_t stride,
+                      const __m128i* masks,
+                      int32_t y)
+{
+    const uint16_t* row = rows + (board_padding + y) * stride;
+    __m128i hits = _mm_setzero_si128();
+    for (int32_t maskRow = 0; maskRow < 4; maskRow++)
+    {
+        const __m128i cells = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(row + maskRow * stride));
+        hits = _mm_or_si128(hits, _mm_and_si128(cells, masks[maskRow]));
+    }
+    return _mm_cmpeq_epi16(hits, _mm_setzero_si128());
+}
+
+// Drops the pieces of the lanes straight down from the spawn row, all
+// lanes one row at a time, and writes the rows they land at. Returns a bit
+// per lane whose piece does not fit at the spawn row.
+uint32_t dropLanes(const uint16_t* rows,
+                   int32_t stride,
+                   const LaneMasks& laneMasks,
+                   int16_t* landings)
+{
+    __m128i masks[4];
+    for (int32_t maskRow = 0; maskRow < 4; maskRow++)
+    {
+        masks[maskRow] = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(laneMasks.rows[maskRow]));
+    }
+
+    // Lanes without a piece fit anywhere and are left where they are.
+    const __m128i cells = _mm_or_si128(
+        _mm_or_si128(masks[0], masks[1]),
+        _mm_or_si128(masks[2], masks[3]));
+    const __m128i empty = _mm_cmpeq_epi16(cells, _mm_setzero_si128());
+    __m128i falling = findFreeLanes(rows, stride, masks, piece_spawn_y);
+    const uint32_t blocked = ~uint32_t(_mm_movemask_epi8(falling)) & 0xFFFF;
+    falling = _mm_andnot_si128(empty, falling);
+    __m128i landing = _mm_set1_epi16(piece_spawn_y);
+    // The padding below the floor is solid, so every lane stops before the
+    // rows run out.
+    for (int32_t y = piece_spawn_y - 1; _mm_movemask_epi8(falling) != 0; y--)
+    {
+        falling = _mm_and_si128(falling, findFreeLanes(rows, stride, masks, y));
+        landing = _mm_or_si128(
+            _mm_andnot_si128(falling, landing),
+            _mm_and_si128(falling, _mm_set1_epi16(int16_t(y))));
+    }
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(landings), landing);
+
+    uint32_t blockedLanes = 0;
+    for (int32_t lane = 0; lane < batch_lane_count; lane++)
+    {
+        blockedLanes |= ((blocked >> (lane * 2)) & 1) << lane;
+    }
+    return blockedLanes;
+}
+
+// Returns a bit per lane that has a full row among the rows from bottom up
+// to top.
+uint32_t findFullLanes(const uint16_t* rows,
+                       int32_t stride,
+                       int32_t bottom,
+                       int32_t top)
+{
+    const __m128i full = _mm_set1_epi16(int16_t(board_full_row));
+    __m128i fullLanes = _mm_setzero_si128();
+    for (int32_t y = bottom; y < top; y++)
+    {
+        const __m128i cells = _mm_loadu_si128(
+            reinterpret_cast<const __m128i*>(rows + (board_padding + y) * stride));
+        fullLanes = _mm_or_si128(fullLanes, _mm_cmpeq_epi16(cells, full));
+    }
+
+    const uint32_t bits = uint32_t(_mm_movemask_epi8(fullLanes));
+    uint32_t lanes = 0;
+    for (int32_t lane = 0; lane < batch_lane_count; lane++)
+    {
+        lanes |= ((bits >> (lane * 2)) & 1) << lane;
+    }
+    return lanes;
+}
+
+#else
+
+bool fitsLane(const uint16_t* rows,
+              int32_t stride,
+              const LaneMasks& masks,
+              int32_t lane,
+              int32_t y)
+{
+    const uint16_t* row = rows + (board_padding + y) * stride + lane;
+    uint16_t hits = 0;
+    for (int32_t maskRow = 0; maskRow < 4; maskRow++)
+    {
+        hits |= row[maskRow * stride] & masks.rows[maskRow][lane];
+    }
+    return hits == 0;
+}
+
+uint32_t dropLanes(const uint16_t* rows,
+                   int32_t stride,
+                   const LaneMasks& masks,
+                   int16_t* landings)
+{
+    uint32_t blockedLanes = 0;
+    for (int32_t lane = 0; lane < batch_lane_count; lane++)
+    {
+        const bool empty = (masks.rows[0][lane] | masks.rows[1][lane] |
+                            masks.rows[2][lane] | masks.rows[3][lane]) == 0;
+        int32_t y = piece_spawn_y;
+        if (fitsLane(rows, stride, masks, lane, y)) {
+            // Lanes without a piece fit anywhere and are left where they are.
+            while (!empty && fitsLane(rows, stride, masks, lane, y - 1))
+            {
+                y--;
+            }
+        } else {
+            blockedLanes |= 1u << lane;
+        }
+        landings[lane] = int16_t(y);
+    }
+    return blockedLanes;
+}
+
+uint32_t findFullLanes(const uint16_t* rows,
+                       int32_t stride,
+                       int32_t bottom,
+                       int32_t top)
+{
+    uint32_t lanes = 0;
+    for (int32_t y = bottom; y < top; y++)
+    {
+        const uint16_t* row = rows + (board_padding + y) * stride;
+        for (int32_t lane = 0; lane < batch_lane_count; lane++)
+        {
+            lanes |= uint32_t(row[lane] == board_full_row) << lane;
+        }
+    }
+    return lanes;
+}
+
+#endif
+
+// Clears the full rows of a game the way the board does, on a copy of its
+// rows. Only the few games that completed a row take this path.
+int32_t clearBatchLines(GameBatch& batch, int32_t game, int32_t y)
+{
+    Board board;
+    for (int32_t row = 0; row < batch_row_count; row++)
+    {
+        board.rows[row] = batch.rows[row * batch.stride + game];
+    }
+    const int32_t cleared = clearLines(board, y);
+    for (int32_t row = 0; row < batch_row_count; row++)
+    {
+        batch.rows[row * batch.stride + game] = board.rows[row];
+    }
+    return cleared;
+}
+
+// Steps up to batch_lane_count neighbouring games starting at first.
+void stepLanes(GameBatch& batch, int32_t first, int32_t count)
+{
+    const uint16_t* rows = batch.rows + first;
+    LaneMasks masks = {};
+    for (int32_t lane = 0; lane < count; lane++)
+    {
+        const int32_t game = first + lane;
+        const uint8_t action = batch.actions[game];
+        ASSERT(action < batch_action_count);
+
+        const int32_t rotation = action / batch_column_count;
+        const int32_t column = action % batch_column_count;
+        setLaneMask(
+            masks,
+            lane,
+            getPieceMask(batch.pieces[game], rotation) << column);
+    }
+
+    int16_t landings[batch_lane_count];
+    uint32_t doneLanes = dropLanes(rows, batch.stride, masks, landings);
+    int32_t bottom = board_height;
+    int32_t top = 0;
+    for (int32_t lane = 0; lane < count; lane++)
+    {
+        const int32_t game = first + lane;
+        batch.rewards[game] = 0;
+        if ((doneLanes >> lane) & 1)
+            continue;
+
+        const int32_t y = landings[lane];
+        for (int32_t row = 0; row < 4; row++)
+        {
+            rowAt(batch, game, y + row) |= masks.rows[row][lane];
+        }
+        if (y < bottom)
+            bottom = y;
+        if (y + 4 > top)
+            top = y + 4;
+    }
+
+    // Only the rows the pieces landed in can have been completed.
+    bottom = bottom < 0 ? 0 : bottom;
+    top = top > board_height ? board_height : top;
+    const uint32_t fullLanes =
+        bottom < top ? findFullLanes(rows, batch.stride, bottom, top) : 0;
+    for (int32_t lane = 0; lane < count; lane++)
+    {
+        if (((fullLanes & ~doneLanes) >> lane) & 1) {
+            const int32_t game = first + lane;
+            batch.rewards[game] = float(clearBatchLines(batch, game, landings[lane]));
+        }
+    }
+
+    LaneMasks spawnMasks = {};
+    for (int32_t lane = 0; lane < count; lane++)
+    {
+        const int32_t game = first + lane;
+        if ((doneLanes >> lane) & 1)
+            continue;
+
+        batch.pieces[game] = takePreview(batch, game);
+        setLaneMask(
+            spawnMasks,
+            lane,
+            getPieceMask(batch.pieces[game], 0) << (piece_spawn_x + board_left_wall));
+    }
+    // Only whether the pieces fit at the spawn row matters here.
+    doneLanes |= dropLanes(rows, batch.stride, spawnMasks, landings);
+
+    for (int32_t lane = 0; lane < count; lane++)
+    {
+        const int32_t game = first + lane;
+        batch.dones[game] = (doneLanes >> lane) & 1;
+        if (batch.dones[game])
+            startGame(batch, game, batch.seeds[game] + uint32_t(batch.gameCount));
+    }
+}
+
+void stepChunk(void* data, int32_t)
+{
+    const GameBatchChunk& chunk = *static_cast<const GameBatchChunk*>(data);
+    const int32_t end = chunk.first + chunk.count;
+    for (int32_t first = chunk.first; first < end; first += batch_lane_count)
+    {
+        const int32_t count = end - first;
+        stepLanes(
+            *chunk.batch,
+            first,
+            count < batch_lane_count ? count : batch_lane_count);
+    }
+}
+
+}
+
+void initGameBatch(GameBatch& batch,
+                   int32_t gameCount,
+                   uint32_t seed,
+                   int32_t threadCount)
+{
+    ASSERT(gameCount > 0);
+    ASSERT(threadCount > 0);
+
+    const int32_t stride =
+        (gameCount + batch_lane_count - 1) / batch_lane_count * batch_lane_count;
+    batch.gameCount = gameCount;
+    batch.stride = stride;
+    // Zeroed, so that the lanes past the last game are empty and never
+    // collide with anything.
+    batch.rows = new uint16_t[batch_row_count * stride]();
+    batch.pieces = new PieceType[stride];
+    batch.previews = new PieceType[preview_count * stride];
+    batch.rewards = new float[stride]();
+    batch.dones = new uint8_t[stride]();
+    batch.bags = new PieceType[piece_type_count * stride];
+    batch.bagIndices = new uint8_t[stride];
+    batch.randoms = new uint32_t[stride];
+    batch.seeds = new uint32_t[stride];
+    for (int32_t game = 0; game < gameCount; game++)
+    {
+        startGame(batch, game, seed + uint32_t(game));
+    }
+
+    // Chunks are whole groups of lanes, so no two threads share a group.
+    const int32_t laneGroupCount = stride / batch_lane_count;
+    int32_t chunkCount = threadCount * chunks_per_thread;
+    chunkCount = chunkCount < laneGroupCount ? chunkCount : laneGroupCount;
+    const int32_t groupsPerChunk = (laneGroupCount + chunkCount - 1) / chunkCount;
+    batch.chunks = new GameBatchChunk[chunkCount];
+    batch.chunkCount = 0;
+    for (int32_t group = 0; group < laneGroupCount; group += groupsPerChunk)
+    {
+        const int32_t first = group * batch_lane_count;
+        const int32_t last = first + groupsPerChunk * batch_lane_count;
+        batch.chunks[batch.chunkCount++] = GameBatchChunk{
+            &batch,
+            first,
+            (last < gameCount ? last : gameCount) - first
+        };
+    }
+    initTaskPool(batch.pool, threadCount, size_t(batch.chunkCount));
+    batch.actions = nullptr;
+}
+
+void destroyGameBatch(GameBatch& batch)
+{
+    destroyTaskPool(batch.pool);
+    delete[] batch.chunks;
+    delete[] batch.seeds;
+    delete[] batch.randoms;
+    delete[] batch.bagIndices;
+    delete[] batch.bags;
+    delete[] batch.dones;
+    delete[] batch.rewards;
+    delete[] batch.previews;
+    delete[] batch.pieces;
+    delete[] batch.rows;
+}
+
+uint8_t makeBatchAction(int32_t rotation, int32_t x)
+{
+    ASSERT(rotation >= 0 && rotation < rotation_count);
+    ASSERT(x + board_left_wall >= 0 && x + board_left_wall < batch_column_count);
+    return uint8_t(rotation * batch_column_count + x + board_left_wall);
+}
+
+void stepGameBatch(GameBatch& batch, const uint8_t* actions)
+{
+    batch.actions = actions;
+    for (int32_t chunk = 0; chunk < batch.chunkCount; chunk++)
+    {
+        pushTask(batch.pool, 0, Task{ stepChunk, &batch.chunks[chunk] });
+    }
+    runTasks(batch.pool);
+    batch.actions = nullptr;
+}
+
+uint16_t getBatchRow(const GameBatch& batch, int32_t game, int32_t y)
+{
+    ASSERT(game >= 0 && game < batch.gameCount);
+    ASSERT(y >= 0 && y < board_height);
+    return (rowAt(batch, game, y) >> board_left_wall) & ((1u << board_width) - 1);
+}
@@ -0,0 +1,163 @@
+#include "simulation/game_loop.h"
+
+#include <chrono>
+#include <profiler/profiler.h>
+#include <util/assert.h>
+
+namespace {
+
+constexpr uint64_t nanoseconds_per_second = 1000000000;
+// After a stall, for example while the window is dragged, the game skips
+// ahead rather than running a burst of ticks.
+constexpr uint32_t max_catch_up_ticks = tick_rate / 4;
+
+void publishSnapshot(GameLoop& loop, uint64_t time)
+{
+    GameSnapshot& snapshot = getBackBuffer(loop.snapshots);
+    snapshot.game = loop.game;
+    snapshot.paused = loop.paused;
+    snapshot.time = time;
+    publishBackBuffer(loop.snapshots);
+}
+
+// Only the thread updating the loop writes the statistics.
+void recordInputLatency(GameLoop& loop, uint64_t latency)
+{
+    loop.lastInputLatency.store(latency, std::memory_order_relaxed);
+    if (latency > loop.maxInputLatency.load(std::memory_order_relaxed))
+        loop.maxInputLatency.store(latency, std::memory_order_relaxed);
+    loop.totalInputLatency.fetch_add(latency, std::memory_order_relaxed);
+    loop.inputLatencyCount.fetch_add(1, std::memory_order_relaxed);
+    PROFILE_COUNTER("input latency us", int64_t(latency / 1000));
+}
+
+void runGameLoop(GameLoop* loop)
+{
+    PROFILE_THREAD("simulation");
+    while (!loop->quitting.load(std::memory_order_relaxed))
+    {
+        updateGameLoop(*loop, getSteadyTime());
+        // Input only makes it into the game with a tick, so there is
+        // nothing to do in between.
+        std::this_thread::sleep_for(
+            std::chrono::nanoseconds(getCounterUntilNextTick(loop->timestep)));
+    }
+}
+
+}
+
+uint64_t getSteadyTime()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+void initGameLoop(GameLoop& loop,
+                  const Game& game,
+                  const GameLoopCallbacks& callbacks,
+                  InputSource* source,
+                  ReplayWriter* recorder,
+                  uint64_t time)
+{
+    loop.game = game;
+    loop.timestep = makeFixedTimestep(
+        tick_rate,
+        max_catch_up_ticks,
+        nanoseconds_per_second,
+        time);
+    loop.callbacks = callbacks;
+    loop.source = source;
+    loop.recorder = recorder;
+    loop.buttons = GameInput{};
+    loop.paused = false;
+    loop.pauseHeld = false;
+    loop.pendingInputTime = 0;
+    loop.inputs.head.store(0, std::memory_order_relaxed);
+    loop.inputs.tail.store(0, std::memory_order_relaxed);
+    loop.lastInputLatency.store(0, std::memory_order_relaxed);
+    loop.maxInputLatency.store(0, std::memory_order_relaxed);
+    loop.totalInputLatency.store(0, std::memory_order_relaxed);
+    loop.inputLatencyCount.store(0, std::memory_order_relaxed);
+    loop.droppedInputCount.store(0, std::memory_order_relaxed);
+    loop.quitting.store(false, std::memory_order_relaxed);
+    publishSnapshot(loop, time);
+}
+
+void updateGameLoop(GameLoop& loop, uint64_t time)
+{
+    PROFILE_SCOPE("update");
+    bool changed = false;
+    InputEvent event;
+    while (tryPop(loop.inputs, event))
+    {
+        loop.buttons = event.buttons;
+        if (event.pause && !loop.pauseHeld) {
+            loop.paused = !loop.paused;
+            if (!loop.paused)
+                resetFixedTimestep(loop.timestep, time);
+            if (loop.callbacks.pauseChanged != nullptr)
+                loop.callbacks.pauseChanged(loop.callbacks.context, loop.paused);
+            changed = true;
+        }
+        loop.pauseHeld = event.pause;
+        if (loop.pendingInputTime == 0)
+            loop.pendingInputTime = event.time;
+    }
+    // What is pressed while paused never makes it into the game.
+    if (loop.paused)
+        loop.pendingInputTime = 0;
+
+    const uint32_t ticks = advanceFixedTimestep(loop.timestep, time);
+    for (uint32_t tick = 0; tick < ticks && !loop.paused; tick++)
+    {
+        // The player takes over once the source runs out.
+        GameInput input = loop.buttons;
+        if (loop.source != nullptr)
+            readInput(*loop.source, loop.game, input);
+        if (loop.recorder != nullptr && !loop.game.over)
+            writeReplayInput(*loop.recorder, loop.game, input);
+        updateGame(loop.game, input);
+        if (loop.callbacks.ticked != nullptr)
+            loop.callbacks.ticked(loop.callbacks.context, loop.game);
+        changed = true;
+    }
+    if (!changed)
+        return;
+
+    publishSnapshot(loop, time);
+    if (loop.pendingInputTime != 0) {
+        recordInputLatency(
+            loop,
+            time > loop.pendingInputTime ? time - loop.pendingInputTime : 0);
+        loop.pendingInputTime = 0;
+    }
+}
+
+void startGameLoopThread(GameLoop& loop)
+{
+    ASSERT(!loop.thread.joinable());
+    loop.quitting.store(false, std::memory_order_relaxed);
+    loop.thread = std::thread(runGameLoop, &loop);
+}
+
+void stopGameLoopThread(GameLoop& loop)
+{
+    loop.quitting.store(true, std::memory_order_relaxed);
+    loop.thread.join();
+}
+
+void postInputEvent(GameLoop& loop, const InputEvent& event)
+{
+    if (!tryPush(loop.inputs, event))
+        loop.droppedInputCount.fetch_add(1, std::memory_order_relaxed);
+}
+
+bool acquireGameSnapshot(GameLoop& loop)
+{
+    return acquireFrontBuffer(loop.snapshots);
+}
+
+const GameSnapshot& getGameSnapshot(const GameLoop& loop)
+{
+    return getFrontBuffer(loop.snapshots);
+}
@@ -0,0 +1,43 @@
+#include "simulation/headless.h"
+
+#include <chrono>
+
+double getTicksPerSecond(const HeadlessReport& report)
+{
+    return report.seconds > 0 ? report.tickCount / report.seconds : 0;
+}
+
+HeadlessReport runHeadless(InputSource& source,
+                           uint32_t seed,
+                           uint64_t gameCount,
+                           uint64_t maxTickCount)
+{
+    const auto start = std::chrono::steady_clock::now();
+
+    HeadlessReport report = {};
+    bool sourceEnded = false;
+    while (report.gameCount < gameCount && !sourceEnded)
+    {
+        Game game = makeGame(seed + uint32_t(report.gameCount));
+        GameInput input;
+        while (!game.over && game.tick < maxTickCount)
+        {
+            if (!readInput(source, game, input)) {
+                sourceEnded = true;
+                break;
+            }
+            updateGame(game, input);
+        }
+
+        report.gameCount++;
+        report.finishedGameCount += game.over;
+        report.tickCount += game.tick;
+        report.lineCount += uint64_t(game.lines);
+        if (game.score > report.bestScore)
+            report.bestScore = game.score;
+    }
+
+    report.seconds = std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count();
+    return report;
+}
@@ -0,0 +1,122 @@
+#include "simulation/input_source.h"
+
+#include <util/assert.h>
+
+namespace {
+
+constexpr int32_t max_held_ticks = 8;
+
+// Chances out of 256 that a button is held, per button in the order of the
+// fields of GameInput.
+constexpr uint32_t press_chances[] = { 64, 64, 40, 24, 8, 40, 40 };
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+GameInput makeRandomInput(uint32_t& random)
+{
+    uint8_t buttons = 0;
+    for (int32_t button = 0; button < 7; button++)
+    {
+        if ((nextRandom(random) & 0xFF) < press_chances[button])
+            buttons |= uint8_t(1u << button);
+    }
+    return unpackGameInput(buttons);
+}
+
+}
+
+uint8_t packGameInput(const GameInput& input)
+{
+    return uint8_t(input.left) |
+           uint8_t(input.right) << 1 |
+           uint8_t(input.down) << 2 |
+           uint8_t(input.drop) << 3 |
+           uint8_t(input.swap) << 4 |
+           uint8_t(input.turnLeft) << 5 |
+           uint8_t(input.turnRight) << 6;
+}
+
+GameInput unpackGameInput(uint8_t buttons)
+{
+    return GameInput{
+        (buttons & 1) != 0,
+        (buttons & 2) != 0,
+        (buttons & 4) != 0,
+        (buttons & 8) != 0,
+        (buttons & 16) != 0,
+        (buttons & 32) != 0,
+        (buttons & 64) != 0
+    };
+}
+
+InputSource makeRandomInputSource(uint32_t seed)
+{
+    InputSource source = {};
+    source.type = InputSourceType::Random;
+    source.random = seed != 0 ? seed : 1;
+    return source;
+}
+
+InputSource makeRecordedInputSource(const uint8_t* inputs, size_t inputCount)
+{
+    ASSERT(inputs != nullptr || inputCount == 0);
+
+    InputSource source = {};
+    source.type = InputSourceType::Recording;
+    source.inputs = inputs;
+    source.inputCount = inputCount;
+    return source;
+}
+
+InputSource makeReplayInputSource(const Replay& replay, uint64_t tick)
+{
+    InputSource source = {};
+    source.type = InputSourceType::Replay;
+    source.cursor = makeReplayCursor(replay, tick);
+    return source;
+}
+
+InputSource makeCallbackInputSource(
+    bool (*read)(void* context, const Game& game, GameInput& input),
+    void* context)
+{
+    ASSERT(read != nullptr);
+
+    InputSource source = {};
+    source.type = InputSourceType::Callback;
+    source.read = read;
+    source.context = context;
+    return source;
+}
+
+bool readInput(InputSource& source, const Game& game, GameInput& input)
+{
+    switch (source.type)
+    {
+        case InputSourceType::Random:
+            if (source.heldTicks == 0) {
+                source.held = makeRandomInput(source.random);
+                source.heldTicks =
+                    1 + int32_t(nextRandom(source.random) % max_held_ticks);
+            }
+            source.heldTicks--;
+            input = source.held;
+            return true;
+        case InputSourceType::Recording:
+            if (source.position == source.inputCount)
+                return false;
+            input = unpackGameInput(source.inputs[source.position++]);
+            return true;
+        case InputSourceType::Replay:
+            return readReplayInput(source.cursor, input);
+        case InputSourceType::Callback:
+            return source.read(source.context, game, input);
+        default: UNREACHABLE("Unknown input source type: %d", int(source.type));
+    }
+}
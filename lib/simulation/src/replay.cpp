@@ -0,0 +1,400 @@
+#include "simulation/replay.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <util/assert.h>
+
+#include "simulation/input_source.h"
+
+namespace {
+
+constexpr uint8_t replay_magic[4] = { 'T', 'R', 'P', 'L' };
+constexpr uint16_t replay_version = 1;
+
+constexpr size_t header_size = 16;
+constexpr size_t chunk_header_size = 17;
+constexpr size_t index_entry_size = 16;
+constexpr size_t footer_size = 28;
+
+// The low bits of a run hold the buttons that changed since the previous
+// run. Runs longer than a tick set the high bit and are followed by their
+// length minus two as a varint.
+constexpr uint8_t run_buttons_mask = 0x7F;
+constexpr uint8_t long_run_flag = 0x80;
+// A run of up to keyframeInterval ticks takes at most this many bytes.
+constexpr size_t max_run_size = 1 + 5;
+
+void putU16(uint8_t* bytes, uint16_t value)
+{
+    bytes[0] = uint8_t(value);
+    bytes[1] = uint8_t(value >> 8);
+}
+
+void putU32(uint8_t* bytes, uint32_t value)
+{
+    for (int32_t index = 0; index < 4; index++)
+    {
+        bytes[index] = uint8_t(value >> (index * 8));
+    }
+}
+
+void putU64(uint8_t* bytes, uint64_t value)
+{
+    for (int32_t index = 0; index < 8; index++)
+    {
+        bytes[index] = uint8_t(value >> (index * 8));
+    }
+}
+
+uint16_t getU16(const uint8_t* bytes)
+{
+    return uint16_t(bytes[0] | bytes[1] << 8);
+}
+
+uint32_t getU32(const uint8_t* bytes)
+{
+    uint32_t value = 0;
+    for (int32_t index = 0; index < 4; index++)
+    {
+        value |= uint32_t(bytes[index]) << (index * 8);
+    }
+    return value;
+}
+
+uint64_t getU64(const uint8_t* bytes)
+{
+    uint64_t value = 0;
+    for (int32_t index = 0; index < 8; index++)
+    {
+        value |= uint64_t(bytes[index]) << (index * 8);
+    }
+    return value;
+}
+
+void writeBytes(ReplayWriter& writer, const void* bytes, size_t size)
+{
+    if (fwrite(bytes, 1, size, writer.file) != size)
+        writer.failed = true;
+    writer.offset += size;
+}
+
+void writeRun(ReplayWriter& writer)
+{
+    uint8_t* bytes = writer.bytes + writer.byteCount;
+    *bytes = (writer.buttons ^ writer.previousButtons) & run_buttons_mask;
+    if (writer.runLength > 1) {
+        *bytes++ |= long_run_flag;
+        uint32_t length = writer.runLength - 2;
+        while (length >= 0x80)
+        {
+            *bytes++ = uint8_t(length) | 0x80;
+            length >>= 7;
+        }
+        *bytes = uint8_t(length);
+    }
+    writer.byteCount = bytes + 1 - writer.bytes;
+    writer.previousButtons = writer.buttons;
+    writer.runLength = 0;
+}
+
+void startChunk(ReplayWriter& writer, const Game& game)
+{
+    writer.chunkTick = writer.tick;
+    writer.chunkButtons = writer.previousButtons;
+    writer.keyframe = game;
+    writer.byteCount = 0;
+}
+
+void finishChunk(ReplayWriter& writer)
+{
+    if (writer.runLength > 0)
+        writeRun(writer);
+
+    if (writer.indexCount == writer.indexCapacity) {
+        ReplayIndexEntry* index = new ReplayIndexEntry[writer.indexCapacity * 2];
+        memcpy(index, writer.index, writer.indexCount * sizeof(ReplayIndexEntry));
+        delete[] writer.index;
+        writer.index = index;
+        writer.indexCapacity *= 2;
+    }
+    writer.index[writer.indexCount++] =
+        ReplayIndexEntry{ writer.chunkTick, writer.offset };
+
+    uint8_t header[chunk_header_size];
+    putU64(header, writer.chunkTick);
+    putU32(header + 8, uint32_t(writer.tick - writer.chunkTick));
+    putU32(header + 12, uint32_t(writer.byteCount));
+    header[16] = writer.chunkButtons;
+    writeBytes(writer, header, chunk_header_size);
+    writeBytes(writer, &writer.keyframe, sizeof(Game));
+    writeBytes(writer, writer.bytes, writer.byteCount);
+}
+
+uint64_t getChunkTick(const Replay& replay, uint64_t chunk)
+{
+    return getU64(replay.data + replay.indexOffset + chunk * index_entry_size);
+}
+
+const uint8_t* getChunk(const Replay& replay, uint64_t chunk)
+{
+    const uint64_t offset = getU64(
+        replay.data + replay.indexOffset + chunk * index_entry_size + 8);
+    ASSERT(offset + chunk_header_size + sizeof(Game) <= replay.indexOffset);
+    return replay.data + offset;
+}
+
+// Returns the last chunk that starts at or before the tick.
+uint64_t findChunk(const Replay& replay, uint64_t tick)
+{
+    ASSERT(replay.chunkCount > 0);
+
+    uint64_t first = 0;
+    uint64_t count = replay.chunkCount;
+    while (count > 1)
+    {
+        const uint64_t half = count / 2;
+        if (getChunkTick(replay, first + half) <= tick) {
+            first += half;
+            count -= half;
+        }
+        else {
+            count = half;
+        }
+    }
+    return first;
+}
+
+void loadChunk(ReplayCursor& cursor, uint64_t chunk)
+{
+    const uint8_t* header = getChunk(*cursor.replay, chunk);
+    const uint32_t byteCount = getU32(header + 12);
+    cursor.chunk = chunk;
+    cursor.tick = getU64(header);
+    cursor.chunkEnd = cursor.tick + getU32(header + 8);
+    cursor.bytes = header + chunk_header_size + sizeof(Game);
+    cursor.bytesEnd = cursor.bytes + byteCount;
+    ASSERT(cursor.bytesEnd <= cursor.replay->data + cursor.replay->indexOffset);
+    cursor.buttons = header[16];
+    cursor.runLeft = 0;
+}
+
+void readRun(ReplayCursor& cursor)
+{
+    ASSERT(cursor.bytes < cursor.bytesEnd);
+    const uint8_t run = *cursor.bytes++;
+    cursor.buttons ^= run & run_buttons_mask;
+    cursor.runLeft = 1;
+    if (run & long_run_flag) {
+        uint32_t length = 0;
+        for (int32_t shift = 0;; shift += 7)
+        {
+            ASSERT(cursor.bytes < cursor.bytesEnd);
+            const uint8_t byte = *cursor.bytes++;
+            length |= uint32_t(byte & 0x7F) << shift;
+            if (!(byte & 0x80))
+                break;
+        }
+        cursor.runLeft = length + 2;
+    }
+}
+
+}
+
+bool openReplayWriter(ReplayWriter& writer,
+                      const char* path,
+                      uint32_t seed,
+                      uint32_t keyframeInterval)
+{
+    ASSERT(keyframeInterval > 0);
+
+    writer = ReplayWriter{};
+    writer.file = fopen(path, "wb");
+    if (writer.file == nullptr)
+        return false;
+
+    writer.keyframeInterval = keyframeInterval;
+    writer.bytes = new uint8_t[keyframeInterval * max_run_size];
+    writer.indexCapacity = 64;
+    writer.index = new ReplayIndexEntry[writer.indexCapacity];
+
+    uint8_t header[header_size];
+    memcpy(header, replay_magic, 4);
+    putU16(header + 4, replay_version);
+    putU16(header + 6, uint16_t(sizeof(Game)));
+    putU32(header + 8, seed);
+    putU32(header + 12, keyframeInterval);
+    writeBytes(writer, header, header_size);
+    return true;
+}
+
+void writeReplayInput(ReplayWriter& writer,
+                      const Game& game,
+                      const GameInput& input)
+{
+    ASSERT(writer.file != nullptr);
+
+    if (writer.tick % writer.keyframeInterval == 0) {
+        if (writer.tick > 0)
+            finishChunk(writer);
+        startChunk(writer, game);
+    }
+
+    const uint8_t buttons = packGameInput(input);
+    if (writer.runLength > 0 && buttons != writer.buttons)
+        writeRun(writer);
+    writer.buttons = buttons;
+    writer.runLength++;
+    writer.tick++;
+}
+
+bool closeReplayWriter(ReplayWriter& writer)
+{
+    ASSERT(writer.file != nullptr);
+
+    if (writer.tick > 0)
+        finishChunk(writer);
+
+    const uint64_t indexOffset = writer.offset;
+    for (size_t index = 0; index < writer.indexCount; index++)
+    {
+        uint8_t entry[index_entry_size];
+        putU64(entry, writer.index[index].tick);
+        putU64(entry + 8, writer.index[index].offset);
+        writeBytes(writer, entry, index_entry_size);
+    }
+
+    uint8_t footer[footer_size];
+    putU64(footer, indexOffset);
+    putU64(footer + 8, writer.indexCount);
+    putU64(footer + 16, writer.tick);
+    memcpy(footer + 24, replay_magic, 4);
+    writeBytes(writer, footer, footer_size);
+
+    const bool written = fclose(writer.file) == 0 && !writer.failed;
+    delete[] writer.index;
+    delete[] writer.bytes;
+    writer = ReplayWriter{};
+    return written;
+}
+
+bool openReplay(Replay& replay, const char* path)
+{
+    replay = Replay{};
+    const int file = open(path, O_RDONLY);
+    if (file < 0)
+        return false;
+
+    struct stat status;
+    if (fstat(file, &status) != 0 ||
+        size_t(status.st_size) < header_size + footer_size) {
+        close(file);
+        return false;
+    }
+    const size_t size = size_t(status.st_size);
+    void* data = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+    // The mapping stays valid after the file is closed.
+    close(file);
+    if (data == MAP_FAILED)
+        return false;
+
+    const uint8_t* bytes = static_cast<const uint8_t*>(data);
+    const uint8_t* footer = bytes + size - footer_size;
+    const uint64_t indexOffset = getU64(footer);
+    const uint64_t chunkCount = getU64(footer + 8);
+    const bool valid =
+        memcmp(bytes, replay_magic, 4) == 0 &&
+        getU16(bytes + 4) == replay_version &&
+        getU16(bytes + 6) == sizeof(Game) &&
+        getU32(bytes + 12) > 0 &&
+        memcmp(footer + 24, replay_magic, 4) == 0 &&
+        indexOffset >= header_size &&
+        indexOffset <= size - footer_size &&
+        chunkCount == (size - footer_size - indexOffset) / index_entry_size &&
+        (chunkCount > 0 || getU64(footer + 16) == 0);
+    if (!valid) {
+        munmap(data, size);
+        return false;
+    }
+
+    replay.data = bytes;
+    replay.size = size;
+    replay.seed = getU32(bytes + 8);
+    replay.keyframeInterval = getU32(bytes + 12);
+    replay.tickCount = getU64(footer + 16);
+    replay.chunkCount = chunkCount;
+    replay.indexOffset = size_t(indexOffset);
+    return true;
+}
+
+void closeReplay(Replay& replay)
+{
+    if (replay.data != nullptr)
+        munmap(const_cast<uint8_t*>(replay.data), replay.size);
+    replay = Replay{};
+}
+
+ReplayCursor makeReplayCursor(const Replay& replay, uint64_t tick)
+{
+    ASSERT(replay.data != nullptr);
+    ASSERT(tick <= replay.tickCount);
+
+    ReplayCursor cursor = {};
+    cursor.replay = &replay;
+    if (replay.chunkCount == 0)
+        return cursor;
+
+    loadChunk(cursor, findChunk(replay, tick));
+    while (cursor.tick < tick)
+    {
+        if (cursor.runLeft == 0)
+            readRun(cursor);
+        const uint64_t skipped =
+            std::min(uint64_t(cursor.runLeft), tick - cursor.tick);
+        cursor.runLeft -= uint32_t(skipped);
+        cursor.tick += skipped;
+    }
+    return cursor;
+}
+
+bool readReplayInput(ReplayCursor& cursor, GameInput& input)
+{
+    if (cursor.tick == cursor.replay->tickCount)
+        return false;
+    if (cursor.tick == cursor.chunkEnd)
+        loadChunk(cursor, cursor.chunk + 1);
+    if (cursor.runLeft == 0)
+        readRun(cursor);
+
+    cursor.runLeft--;
+    cursor.tick++;
+    input = unpackGameInput(cursor.buttons);
+    return true;
+}
+
+Game seekReplay(const Replay& replay, uint64_t tick)
+{
+    ASSERT(replay.data != nullptr);
+    ASSERT(tick <= replay.tickCount);
+
+    if (replay.chunkCount == 0)
+        return makeGame(replay.seed);
+
+    const uint64_t chunk = findChunk(replay, tick);
+    Game game;
+    memcpy(&game, getChunk(replay, chunk) + chunk_header_size, sizeof(Game));
+
+    ReplayCursor cursor = {};
+    cursor.replay = &replay;
+    loadChunk(cursor, chunk);
+    GameInput input;
+    while (cursor.tick < tick)
+    {
+        readReplayInput(cursor, input);
+        updateGame(game, input);
+    }
+    return game;
+}
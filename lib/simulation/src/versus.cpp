@@ -0,0 +1,170 @@
+#include "simulation/versus.h"
+
+#include <type_traits>
+
+#include "simulation/input_source.h"
+
+namespace {
+
+static_assert(std::is_trivially_copyable_v<VersusGame>,
+              "Snapshots of a match are plain copies");
+
+// The rows sent for clearing 0 to 4 lines at once.
+constexpr int32_t garbage_rows[] = { 0, 0, 1, 2, 4 };
+
+constexpr uint32_t fnv_offset_basis = 0x811C9DC5;
+constexpr uint32_t fnv_prime = 0x01000193;
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+uint32_t hashValue(uint32_t hash, uint64_t value, int32_t size)
+{
+    for (int32_t index = 0; index < size; index++)
+    {
+        hash = (hash ^ uint8_t(value >> (index * 8))) * fnv_prime;
+    }
+    return hash;
+}
+
+uint32_t hashGame(uint32_t hash, const Game& game)
+{
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        hash = hashValue(hash, getRow(game.board, y), 2);
+    }
+    hash = hashValue(hash, uint8_t(game.piece.type), 1);
+    hash = hashValue(hash, uint32_t(game.piece.rotation), 4);
+    hash = hashValue(hash, uint32_t(game.piece.x), 4);
+    hash = hashValue(hash, uint32_t(game.piece.y), 4);
+    for (int32_t index = 0; index < preview_count; index++)
+    {
+        hash = hashValue(hash, uint8_t(game.previews[index]), 1);
+    }
+    hash = hashValue(hash, uint32_t(game.bagIndex), 4);
+    hash = hashValue(hash, uint8_t(game.hold), 1);
+    hash = hashValue(hash, game.hasHold, 1);
+    hash = hashValue(hash, game.holdUsed, 1);
+    hash = hashValue(hash, game.random, 4);
+    hash = hashValue(hash, packGameInput(game.previousInput), 1);
+    hash = hashValue(hash, uint32_t(game.shiftDirection), 4);
+    hash = hashValue(hash, uint32_t(game.shiftTicks), 4);
+    hash = hashValue(hash, uint32_t(game.gravityTicks), 4);
+    hash = hashValue(hash, uint32_t(game.lockTicks), 4);
+    hash = hashValue(hash, uint32_t(game.lines), 4);
+    hash = hashValue(hash, game.score, 4);
+    hash = hashValue(hash, game.tick, 8);
+    return hashValue(hash, game.over, 1);
+}
+
+void topOut(Game& game)
+{
+    game.over = true;
+    game.events |= game_event_over;
+}
+
+// Garbage only lands on a board after a piece of its own locked without
+// clearing lines, before the next piece has had the chance to move.
+void receiveGarbage(VersusGame& game, int32_t player)
+{
+    Game& receiver = game.players[player];
+    int32_t& pending = game.pendingGarbage[player];
+    if (pending == 0 || receiver.over)
+        return;
+    if (!(receiver.events & game_event_locked) ||
+        (receiver.events & game_event_lines_cleared))
+        return;
+
+    const int32_t count = pending < board_height ? pending : board_height;
+    const int32_t hole = int32_t(nextRandom(game.random) % board_width);
+    pending = 0;
+    const bool fits = addGarbageRows(receiver.board, count, hole);
+    const ActivePiece& piece = receiver.piece;
+    if (!fits ||
+        collides(receiver.board,
+                 getPieceMask(piece.type, piece.rotation),
+                 piece.x,
+                 piece.y))
+        topOut(receiver);
+}
+
+// Returns the rows the player sends with the lines cleared on the last
+// tick, after cancelling what was waiting for it.
+int32_t cancelGarbage(VersusGame& game, int32_t player)
+{
+    const Game& sender = game.players[player];
+    if (!(sender.events & game_event_lines_cleared))
+        return 0;
+
+    const int32_t rows = garbage_rows[sender.clearedLines];
+    int32_t& own = game.pendingGarbage[player];
+    const int32_t cancelled = rows < own ? rows : own;
+    own -= cancelled;
+    return rows - cancelled;
+}
+
+}
+
+VersusGame makeVersusGame(uint32_t seed)
+{
+    VersusGame game = {};
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        game.players[player] = makeGame(seed);
+    }
+    game.random = seed != 0 ? seed : 1;
+    game.winner = -1;
+    return game;
+}
+
+void updateVersusGame(VersusGame& game, const GameInput* inputs)
+{
+    if (game.over)
+        return;
+
+    game.tick++;
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        updateGame(game.players[player], inputs[player]);
+    }
+    // Both players cancel before either sends and receives, so the order of
+    // the players does not matter.
+    int32_t sent[versus_player_count];
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        sent[player] = cancelGarbage(game, player);
+    }
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        game.pendingGarbage[1 - player] += sent[player];
+    }
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        receiveGarbage(game, player);
+    }
+
+    const bool firstOver = game.players[0].over;
+    const bool secondOver = game.players[1].over;
+    if (firstOver || secondOver) {
+        game.over = true;
+        game.winner = firstOver == secondOver ? -1 : firstOver ? 1 : 0;
+    }
+}
+
+uint32_t getVersusChecksum(const VersusGame& game)
+{
+    uint32_t hash = fnv_offset_basis;
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        hash = hashGame(hash, game.players[player]);
+        hash = hashValue(hash, uint32_t(game.pendingGarbage[player]), 4);
+    }
+    hash = hashValue(hash, game.random, 4);
+    hash = hashValue(hash, game.tick, 8);
+    return hashValue(hash, uint32_t(game.winner), 4);
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+enum class EnvelopeStage : uint8_t
+{
+    Idle,
+    Attack,
+    Decay,
+    Sustain,
+    Release
+};
+
+// A linear attack, decay, sustain, release envelope. The steps are the level
+// change per sample in each stage.
+struct Envelope
+{
+    float attackStep;
+    float decayStep;
+    float sustainLevel;
+    float releaseStep;
+    EnvelopeStage stage;
+    float level;
+};
+
+Envelope makeEnvelope(float attackSeconds,
+                      float decaySeconds,
+                      float sustainLevel,
+                      float releaseSeconds,
+                      uint32_t sampleRate);
+
+void noteOn(Envelope& envelope);
+void noteOff(Envelope& envelope);
+
+bool isActive(const Envelope& envelope);
+
+// Returns how many of the next sampleCount samples lie on the current linear
+// ramp, along with the step of that ramp. Block renderers can apply the ramp
+// to a whole segment at once and then advance the envelope past it.
+int32_t getEnvelopeSegment(const Envelope& envelope,
+                           int32_t sampleCount,
+                           float& step);
+void advanceEnvelope(Envelope& envelope, int32_t sampleCount);
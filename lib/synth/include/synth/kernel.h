@@ -0,0 +1,19 @@
+#pragma once
+
+#include <cstdint>
+
+enum class SynthKernel : uint8_t
+{
+    Scalar,
+    Sse2,
+    Avx2
+};
+
+bool isSynthKernelSupported(SynthKernel kernel);
+const char* getSynthKernelName(SynthKernel kernel);
+
+// The instruction set used for rendering and mixing blocks of samples.
+// Defaults to the widest one supported by the CPU and is only meant to be
+// changed for testing and benchmarking.
+SynthKernel getSynthKernel();
+void setSynthKernel(SynthKernel kernel);
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr int32_t mixer_voice_count = 32;
+
+// Mono samples that were already converted to the output format and rate
+// when they were loaded, so playing them needs no further conversion.
+struct Sound
+{
+    const int16_t* samples;
+    int32_t sampleCount;
+};
+
+struct Voice
+{
+    const Sound* sound;
+    int32_t position;
+    // Q15 fixed point, 0x7FFF is full volume.
+    int16_t gain;
+    bool looping;
+};
+
+struct Mixer
+{
+    Voice voices[mixer_voice_count];
+};
+
+Mixer makeMixer();
+
+// Starts playing the sound on a free voice and returns its index. When every
+// voice is busy the one-shot voice closest to finishing is taken over, and if
+// only looping voices remain the sound is not played and -1 is returned.
+int32_t playSound(Mixer& mixer, const Sound& sound, float volume, bool looping);
+void stopVoice(Mixer& mixer, int32_t voice);
+// Stops all voices playing the sound.
+void stopSound(Mixer& mixer, const Sound& sound);
+
+int32_t getActiveVoiceCount(const Mixer& mixer);
+
+// Adds all active voices to the samples with saturation, so the mix can be
+// layered on top of samples that were rendered before.
+void mixVoices(Mixer& mixer, int16_t* samples, int32_t sampleCount);
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <cstdint>
+
+#include "synth/envelope.h"
+#include "synth/wavetable.h"
+
+// Plays a wavetable with a fractional phase accumulator, so any frequency can
+// be played exactly instead of being rounded to a whole number of samples per
+// period.
+struct Oscillator
+{
+    const float* table;
+    float phase;
+    float increment;
+    float amplitude;
+};
+
+Oscillator makeOscillator(const Wavetable& wavetable,
+                          float frequency,
+                          float amplitude);
+
+void setFrequency(Oscillator& oscillator,
+                  const Wavetable& wavetable,
+                  float frequency);
+
+// Renders sampleCount samples of the oscillator shaped by the envelope,
+// overwriting the contents of samples.
+void renderTone(Oscillator& oscillator,
+                Envelope& envelope,
+                int16_t* samples,
+                int32_t sampleCount);
@@ -0,0 +1,33 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr int32_t wavetable_size = 2048;
+
+// Every level holds one octave. Level n is band limited for fundamentals up
+// to wavetable_base_frequency * 2^n, so playing a note from the matching
+// level never produces harmonics above the Nyquist frequency.
+constexpr int32_t wavetable_level_count = 10;
+constexpr float wavetable_base_frequency = 40;
+
+enum class Waveform : uint8_t
+{
+    Sine,
+    Triangle,
+    Square,
+    Saw
+};
+
+struct Wavetable
+{
+    uint32_t sampleRate;
+    // Each level has a copy of its first sample at the end so interpolation
+    // never has to wrap around.
+    float levels[wavetable_level_count][wavetable_size + 1];
+};
+
+// Builds the table by additive synthesis, which is slow enough that it should
+// happen once at startup.
+void initWavetable(Wavetable& wavetable, Waveform waveform, uint32_t sampleRate);
+
+const float* getWavetableLevel(const Wavetable& wavetable, float frequency);
@@ -0,0 +1,128 @@
+#include "synth/envelope.h"
+
+#include <cmath>
+#include <util/assert.h>
+
+namespace {
+
+float secondsToStep(float seconds, uint32_t sampleRate)
+{
+    const float samples = seconds * sampleRate;
+    return samples > 1 ? 1 / samples : 1;
+}
+
+// Returns the number of steps it takes to get from level to target.
+int32_t getStepsTo(float level, float target, float step)
+{
+    const float distance = fabsf(target - level);
+    if (distance == 0)
+        return 0;
+    return int32_t(ceilf(distance / step));
+}
+
+}
+
+Envelope makeEnvelope(float attackSeconds,
+                      float decaySeconds,
+                      float sustainLevel,
+                      float releaseSeconds,
+                      uint32_t sampleRate)
+{
+    ASSERT(attackSeconds >= 0);
+    ASSERT(decaySeconds >= 0);
+    ASSERT(sustainLevel >= 0 && sustainLevel <= 1);
+    ASSERT(releaseSeconds >= 0);
+    ASSERT(sampleRate > 0);
+    return Envelope{
+        secondsToStep(attackSeconds, sampleRate),
+        secondsToStep(decaySeconds, sampleRate),
+        sustainLevel,
+        secondsToStep(releaseSeconds, sampleRate),
+        EnvelopeStage::Idle,
+        0
+    };
+}
+
+void noteOn(Envelope& envelope)
+{
+    envelope.stage = EnvelopeStage::Attack;
+}
+
+void noteOff(Envelope& envelope)
+{
+    if (envelope.stage != EnvelopeStage::Idle)
+        envelope.stage = EnvelopeStage::Release;
+}
+
+bool isActive(const Envelope& envelope)
+{
+    return envelope.stage != EnvelopeStage::Idle;
+}
+
+int32_t getEnvelopeSegment(const Envelope& envelope,
+                           int32_t sampleCount,
+                           float& step)
+{
+    ASSERT(sampleCount > 0);
+
+    int32_t stageLength = sampleCount;
+    switch (envelope.stage)
+    {
+        case EnvelopeStage::Idle:
+        case EnvelopeStage::Sustain:
+            step = 0;
+            break;
+        case EnvelopeStage::Attack:
+            step = envelope.attackStep;
+            stageLength = getStepsTo(envelope.level, 1, step);
+            break;
+        case EnvelopeStage::Decay:
+            step = -envelope.decayStep;
+            stageLength =
+                getStepsTo(envelope.level, envelope.sustainLevel, -step);
+            break;
+        case EnvelopeStage::Release:
+            step = -envelope.releaseStep;
+            stageLength = getStepsTo(envelope.level, 0, -step);
+            break;
+    }
+
+    // A stage that already reached its target still takes one sample to move
+    // on to the next stage.
+    if (stageLength < 1)
+        stageLength = 1;
+    return stageLength < sampleCount ? stageLength : sampleCount;
+}
+
+void advanceEnvelope(Envelope& envelope, int32_t sampleCount)
+{
+    float step;
+    const int32_t segment = getEnvelopeSegment(envelope, sampleCount, step);
+    ASSERT(segment == sampleCount);
+
+    envelope.level += step * sampleCount;
+    switch (envelope.stage)
+    {
+        case EnvelopeStage::Idle:
+        case EnvelopeStage::Sustain:
+            break;
+        case EnvelopeStage::Attack:
+            if (envelope.level >= 1) {
+                envelope.level = 1;
+                envelope.stage = EnvelopeStage::Decay;
+            }
+            break;
+        case EnvelopeStage::Decay:
+            if (envelope.level <= envelope.sustainLevel) {
+                envelope.level = envelope.sustainLevel;
+                envelope.stage = EnvelopeStage::Sustain;
+            }
+            break;
+        case EnvelopeStage::Release:
+            if (envelope.level <= 0) {
+                envelope.level = 0;
+                envelope.stage = EnvelopeStage::Idle;
+            }
+            break;
+    }
+}
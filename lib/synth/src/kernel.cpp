@@ -0,0 +1,70 @@
+#include "synth/kernel.h"
+
+#include <util/assert.h>
+
+#include "simd.h"
+
+namespace {
+
+SynthKernel detectSynthKernel()
+{
+#if defined(SYNTH_X86)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma"))
+        return SynthKernel::Avx2;
+#endif
+#if defined(SYNTH_SSE2)
+    return SynthKernel::Sse2;
+#else
+    return SynthKernel::Scalar;
+#endif
+}
+
+SynthKernel activeKernel = detectSynthKernel();
+
+}
+
+bool isSynthKernelSupported(SynthKernel kernel)
+{
+    switch (kernel)
+    {
+        case SynthKernel::Scalar:
+            return true;
+        case SynthKernel::Sse2:
+#if defined(SYNTH_SSE2)
+            return true;
+#else
+            return false;
+#endif
+        case SynthKernel::Avx2:
+#if defined(SYNTH_X86)
+            return __builtin_cpu_supports("avx2") &&
+                   __builtin_cpu_supports("fma");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+const char* getSynthKernelName(SynthKernel kernel)
+{
+    switch (kernel)
+    {
+        case SynthKernel::Scalar: return "scalar";
+        case SynthKernel::Sse2: return "SSE2";
+        case SynthKernel::Avx2: return "AVX2";
+    }
+    return "unknown";
+}
+
+SynthKernel getSynthKernel()
+{
+    return activeKernel;
+}
+
+void setSynthKernel(SynthKernel kernel)
+{
+    ASSERT(isSynthKernelSupported(kernel));
+    activeKernel = kernel;
+}
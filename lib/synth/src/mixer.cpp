@@ -0,0 +1,218 @@
+#include "synth/mixer.h"
+
+#include <util/assert.h>
+
+#include "synth/kernel.h"
+#include "simd.h"
+
+namespace {
+
+using KernelFunction = void (*)(int16_t* samples,
+                                const int16_t* source,
+                                int16_t gain,
+                                int32_t sampleCount);
+
+int16_t scale(int16_t sample, int16_t gain)
+{
+    return int16_t((int32_t(sample) * gain + 0x4000) >> 15);
+}
+
+int16_t addSaturated(int16_t first, int16_t second)
+{
+    const int32_t sum = int32_t(first) + second;
+    if (sum > INT16_MAX)
+        return INT16_MAX;
+    if (sum < INT16_MIN)
+        return INT16_MIN;
+    return int16_t(sum);
+}
+
+void mixScalar(int16_t* samples,
+               const int16_t* source,
+               int16_t gain,
+               int32_t sampleCount)
+{
+    for (int32_t index = 0; index < sampleCount; index++)
+    {
+        samples[index] = addSaturated(samples[index], scale(source[index], gain));
+    }
+}
+
+#if defined(SYNTH_SSE2)
+
+void mixSse2(int16_t* samples,
+             const int16_t* source,
+             int16_t gain,
+             int32_t sampleCount)
+{
+    const __m128i gains = _mm_set1_epi16(gain);
+    const __m128i rounding = _mm_set1_epi32(0x4000);
+
+    int32_t index = 0;
+    for (; index + 8 <= sampleCount; index += 8)
+    {
+        const __m128i input =
+            _mm_loadu_si128(reinterpret_cast<const __m128i*>(source + index));
+
+        // SSE2 has no rounding high multiply, so the full 32 bit products are
+        // put back together from their halves.
+        const __m128i low = _mm_mullo_epi16(input, gains);
+        const __m128i high = _mm_mulhi_epi16(input, gains);
+        const __m128i first = _mm_srai_epi32(
+            _mm_add_epi32(_mm_unpacklo_epi16(low, high), rounding),
+            15);
+        const __m128i second = _mm_srai_epi32(
+            _mm_add_epi32(_mm_unpackhi_epi16(low, high), rounding),
+            15);
+
+        __m128i* output = reinterpret_cast<__m128i*>(samples + index);
+        _mm_storeu_si128(
+            output,
+            _mm_adds_epi16(_mm_loadu_si128(output),
+                           _mm_packs_epi32(first, second)));
+    }
+
+    mixScalar(samples + index, source + index, gain, sampleCount - index);
+}
+
+#endif
+
+#if defined(SYNTH_X86)
+
+__attribute__((target("avx2")))
+void mixAvx2(int16_t* samples,
+             const int16_t* source,
+             int16_t gain,
+             int32_t sampleCount)
+{
+    const __m256i gains = _mm256_set1_epi16(gain);
+
+    int32_t index = 0;
+    for (; index + 16 <= sampleCount; index += 16)
+    {
+        const __m256i input = _mm256_loadu_si256(
+            reinterpret_cast<const __m256i*>(source + index));
+        __m256i* output = reinterpret_cast<__m256i*>(samples + index);
+        _mm256_storeu_si256(
+            output,
+            _mm256_adds_epi16(_mm256_loadu_si256(output),
+                              _mm256_mulhrs_epi16(input, gains)));
+    }
+
+    mixScalar(samples + index, source + index, gain, sampleCount - index);
+}
+
+#endif
+
+KernelFunction getKernelFunction(SynthKernel kernel)
+{
+    switch (kernel)
+    {
+        case SynthKernel::Scalar:
+            return mixScalar;
+#if defined(SYNTH_SSE2)
+        case SynthKernel::Sse2:
+            return mixSse2;
+#endif
+#if defined(SYNTH_X86)
+        case SynthKernel::Avx2:
+            return mixAvx2;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+int32_t getRemaining(const Voice& voice)
+{
+    return voice.sound->sampleCount - voice.position;
+}
+
+}
+
+Mixer makeMixer()
+{
+    return Mixer{};
+}
+
+int32_t playSound(Mixer& mixer, const Sound& sound, float volume, bool looping)
+{
+    ASSERT(sound.samples != nullptr);
+    ASSERT(sound.sampleCount > 0);
+    ASSERT(volume >= 0 && volume <= 1);
+
+    int32_t chosen = -1;
+    for (int32_t index = 0; index < mixer_voice_count; index++)
+    {
+        const Voice& voice = mixer.voices[index];
+        if (voice.sound == nullptr) {
+            chosen = index;
+            break;
+        }
+        if (voice.looping)
+            continue;
+        if (chosen == -1 || getRemaining(voice) < getRemaining(mixer.voices[chosen]))
+            chosen = index;
+    }
+    if (chosen == -1)
+        return -1;
+
+    mixer.voices[chosen] =
+        Voice{ &sound, 0, int16_t(volume * INT16_MAX), looping };
+    return chosen;
+}
+
+void stopVoice(Mixer& mixer, int32_t voice)
+{
+    ASSERT(voice >= 0 && voice < mixer_voice_count);
+    mixer.voices[voice].sound = nullptr;
+}
+
+void stopSound(Mixer& mixer, const Sound& sound)
+{
+    for (Voice& voice : mixer.voices)
+    {
+        if (voice.sound == &sound)
+            voice.sound = nullptr;
+    }
+}
+
+int32_t getActiveVoiceCount(const Mixer& mixer)
+{
+    int32_t count = 0;
+    for (const Voice& voice : mixer.voices)
+    {
+        count += voice.sound != nullptr;
+    }
+    return count;
+}
+
+void mixVoices(Mixer& mixer, int16_t* samples, int32_t sampleCount)
+{
+    ASSERT(samples != nullptr);
+
+    const KernelFunction kernel = getKernelFunction(getSynthKernel());
+    for (Voice& voice : mixer.voices)
+    {
+        int32_t mixed = 0;
+        while (voice.sound != nullptr && mixed < sampleCount)
+        {
+            const int32_t remaining = getRemaining(voice);
+            const int32_t count =
+                remaining < sampleCount - mixed ? remaining : sampleCount - mixed;
+            kernel(samples + mixed,
+                   voice.sound->samples + voice.position,
+                   voice.gain,
+                   count);
+            mixed += count;
+            voice.position += count;
+
+            if (voice.position == voice.sound->sampleCount) {
+                if (voice.looping)
+                    voice.position = 0;
+                else
+                    voice.sound = nullptr;
+            }
+        }
+    }
+}
@@ -0,0 +1,260 @@
+#include "synth/oscillator.h"
+
+#include <cmath>
+#include <util/assert.h>
+
+#include "synth/kernel.h"
+#include "simd.h"
+
+namespace {
+
+// Gains are applied in the int16_t range, so a level of 1 maps to full scale.
+constexpr float full_scale = 32767;
+
+using KernelFunction = void (*)(const float* table,
+                                float& phase,
+                                float increment,
+                                float gain,
+                                float gainStep,
+                                int16_t* samples,
+                                int32_t sampleCount);
+
+int16_t saturate(float value)
+{
+    if (value > INT16_MAX)
+        return INT16_MAX;
+    if (value < INT16_MIN)
+        return INT16_MIN;
+    return int16_t(lrintf(value));
+}
+
+float lookup(const float* table, float phase)
+{
+    const float position = phase * wavetable_size;
+    const int32_t index = int32_t(position);
+    const float fraction = position - index;
+    return table[index] + fraction * (table[index + 1] - table[index]);
+}
+
+float wrapPhase(float phase)
+{
+    return phase - floorf(phase);
+}
+
+void renderScalar(const float* table,
+                  float& phase,
+                  float increment,
+                  float gain,
+                  float gainStep,
+                  int16_t* samples,
+                  int32_t sampleCount)
+{
+    float current = phase;
+    for (int32_t index = 0; index < sampleCount; index++)
+    {
+        samples[index] =
+            saturate(lookup(table, current) * (gain + index * gainStep));
+        current += increment;
+        if (current >= 1)
+            current -= 1;
+    }
+    phase = current;
+}
+
+#if defined(SYNTH_SSE2)
+
+void renderSse2(const float* table,
+                float& phase,
+                float increment,
+                float gain,
+                float gainStep,
+                int16_t* samples,
+                int32_t sampleCount)
+{
+    const __m128 lanes = _mm_set_ps(3, 2, 1, 0);
+    const __m128 laneIncrements = _mm_mul_ps(lanes, _mm_set1_ps(increment));
+    const __m128 size = _mm_set1_ps(float(wavetable_size));
+    const __m128 gainSteps = _mm_set1_ps(gainStep);
+    const __m128 gains = _mm_set1_ps(gain);
+
+    float base = phase;
+    int32_t index = 0;
+    for (; index + 4 <= sampleCount; index += 4)
+    {
+        // Phases are never negative, so truncation is the same as floor.
+        __m128 phases = _mm_add_ps(_mm_set1_ps(base), laneIncrements);
+        phases = _mm_sub_ps(phases, _mm_cvtepi32_ps(_mm_cvttps_epi32(phases)));
+
+        const __m128 positions = _mm_mul_ps(phases, size);
+        const __m128i indices = _mm_cvttps_epi32(positions);
+        const __m128 fractions =
+            _mm_sub_ps(positions, _mm_cvtepi32_ps(indices));
+
+        alignas(16) int32_t offsets[4];
+        _mm_store_si128(reinterpret_cast<__m128i*>(offsets), indices);
+        const __m128 first = _mm_set_ps(
+            table[offsets[3]], table[offsets[2]],
+            table[offsets[1]], table[offsets[0]]);
+        const __m128 second = _mm_set_ps(
+            table[offsets[3] + 1], table[offsets[2] + 1],
+            table[offsets[1] + 1], table[offsets[0] + 1]);
+        const __m128 values = _mm_add_ps(
+            first,
+            _mm_mul_ps(fractions, _mm_sub_ps(second, first)));
+
+        const __m128 sampleGains = _mm_add_ps(
+            gains,
+            _mm_mul_ps(_mm_add_ps(_mm_set1_ps(float(index)), lanes), gainSteps));
+        const __m128i scaled = _mm_cvtps_epi32(_mm_mul_ps(values, sampleGains));
+        _mm_storel_epi64(reinterpret_cast<__m128i*>(samples + index),
+                         _mm_packs_epi32(scaled, scaled));
+
+        base = wrapPhase(base + 4 * increment);
+    }
+
+    phase = base;
+    renderScalar(table,
+                 phase,
+                 increment,
+                 gain + index * gainStep,
+                 gainStep,
+                 samples + index,
+                 sampleCount - index);
+}
+
+#endif
+
+#if defined(SYNTH_X86)
+
+__attribute__((target("avx2,fma")))
+void renderAvx2(const float* table,
+                float& phase,
+                float increment,
+                float gain,
+                float gainStep,
+                int16_t* samples,
+                int32_t sampleCount)
+{
+    const __m256 lanes = _mm256_set_ps(7, 6, 5, 4, 3, 2, 1, 0);
+    const __m256 laneIncrements =
+        _mm256_mul_ps(lanes, _mm256_set1_ps(increment));
+    const __m256 size = _mm256_set1_ps(float(wavetable_size));
+    const __m256 gainSteps = _mm256_set1_ps(gainStep);
+    const __m256 gains = _mm256_set1_ps(gain);
+
+    float base = phase;
+    int32_t index = 0;
+    for (; index + 8 <= sampleCount; index += 8)
+    {
+        __m256 phases = _mm256_add_ps(_mm256_set1_ps(base), laneIncrements);
+        phases = _mm256_sub_ps(phases, _mm256_floor_ps(phases));
+
+        const __m256 positions = _mm256_mul_ps(phases, size);
+        const __m256i indices = _mm256_cvttps_epi32(positions);
+        const __m256 fractions =
+            _mm256_sub_ps(positions, _mm256_cvtepi32_ps(indices));
+
+        const __m256 first = _mm256_i32gather_ps(table, indices, 4);
+        const __m256 second = _mm256_i32gather_ps(table + 1, indices, 4);
+        const __m256 values = _mm256_fmadd_ps(
+            fractions,
+            _mm256_sub_ps(second, first),
+            first);
+
+        const __m256 sampleGains = _mm256_fmadd_ps(
+            _mm256_add_ps(_mm256_set1_ps(float(index)), lanes),
+            gainSteps,
+            gains);
+        const __m256i scaled =
+            _mm256_cvtps_epi32(_mm256_mul_ps(values, sampleGains));
+
+        // The pack works within each 128 bit half, so the two halves have to
+        // be brought back together before storing.
+        const __m256i packed = _mm256_permute4x64_epi64(
+            _mm256_packs_epi32(scaled, scaled),
+            0x08);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(samples + index),
+                         _mm256_castsi256_si128(packed));
+
+        base = wrapPhase(base + 8 * increment);
+    }
+
+    phase = base;
+    renderScalar(table,
+                 phase,
+                 increment,
+                 gain + index * gainStep,
+                 gainStep,
+                 samples + index,
+                 sampleCount - index);
+}
+
+#endif
+
+KernelFunction getKernelFunction(SynthKernel kernel)
+{
+    switch (kernel)
+    {
+        case SynthKernel::Scalar:
+            return renderScalar;
+#if defined(SYNTH_SSE2)
+        case SynthKernel::Sse2:
+            return renderSse2;
+#endif
+#if defined(SYNTH_X86)
+        case SynthKernel::Avx2:
+            return renderAvx2;
+#endif
+        default:
+            return nullptr;
+    }
+}
+
+}
+
+Oscillator makeOscillator(const Wavetable& wavetable,
+                          float frequency,
+                          float amplitude)
+{
+    ASSERT(amplitude >= 0 && amplitude <= 1);
+    Oscillator oscillator = Oscillator{ nullptr, 0, 0, amplitude };
+    setFrequency(oscillator, wavetable, frequency);
+    return oscillator;
+}
+
+void setFrequency(Oscillator& oscillator,
+                  const Wavetable& wavetable,
+                  float frequency)
+{
+    ASSERT(frequency > 0 && frequency < wavetable.sampleRate / 2.0f);
+    oscillator.table = getWavetableLevel(wavetable, frequency);
+    oscillator.increment = frequency / wavetable.sampleRate;
+}
+
+void renderTone(Oscillator& oscillator,
+                Envelope& envelope,
+                int16_t* samples,
+                int32_t sampleCount)
+{
+    ASSERT(oscillator.table != nullptr);
+    ASSERT(samples != nullptr);
+
+    const KernelFunction kernel = getKernelFunction(getSynthKernel());
+    const float scale = oscillator.amplitude * full_scale;
+    while (sampleCount > 0)
+    {
+        float step;
+        const int32_t segment =
+            getEnvelopeSegment(envelope, sampleCount, step);
+        kernel(oscillator.table,
+               oscillator.phase,
+               oscillator.increment,
+               envelope.level * scale,
+               step * scale,
+               samples,
+               segment);
+        advanceEnvelope(envelope, segment);
+        samples += segment;
+        sampleCount -= segment;
+    }
+}
@@ -0,0 +1,9 @@
+#pragma once
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define SYNTH_X86 1
+#if defined(__SSE2__)
+#define SYNTH_SSE2 1
+#endif
+#endif
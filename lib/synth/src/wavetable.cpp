@@ -0,0 +1,87 @@
+#include "synth/wavetable.h"
+
+#include <cmath>
+#include <util/assert.h>
+
+namespace {
+
+constexpr double two_pi = 6.283185307179586;
+
+// Returns the amplitude of the given harmonic relative to the fundamental.
+double getHarmonicAmplitude(Waveform waveform, int32_t harmonic)
+{
+    switch (waveform)
+    {
+        case Waveform::Sine:
+            return harmonic == 1 ? 1 : 0;
+        case Waveform::Triangle:
+            if (harmonic % 2 == 0)
+                return 0;
+            return ((harmonic / 2) % 2 == 0 ? 1.0 : -1.0) /
+                   (double(harmonic) * harmonic);
+        case Waveform::Square:
+            return harmonic % 2 == 0 ? 0 : 1.0 / harmonic;
+        case Waveform::Saw:
+            return (harmonic % 2 == 0 ? -1.0 : 1.0) / harmonic;
+    }
+    return 0;
+}
+
+void buildLevel(float* level, Waveform waveform, int32_t harmonicCount)
+{
+    double samples[wavetable_size] = {};
+    for (int32_t harmonic = 1; harmonic <= harmonicCount; harmonic++)
+    {
+        const double amplitude = getHarmonicAmplitude(waveform, harmonic);
+        if (amplitude == 0)
+            continue;
+
+        for (int32_t index = 0; index < wavetable_size; index++)
+        {
+            const double phase = double(index) * harmonic / wavetable_size;
+            samples[index] += amplitude * sin(two_pi * phase);
+        }
+    }
+
+    double peak = 0;
+    for (int32_t index = 0; index < wavetable_size; index++)
+    {
+        peak = fabs(samples[index]) > peak ? fabs(samples[index]) : peak;
+    }
+    for (int32_t index = 0; index < wavetable_size; index++)
+    {
+        level[index] = float(samples[index] / peak);
+    }
+    level[wavetable_size] = level[0];
+}
+
+}
+
+void initWavetable(Wavetable& wavetable, Waveform waveform, uint32_t sampleRate)
+{
+    ASSERT(sampleRate > 0);
+
+    wavetable.sampleRate = sampleRate;
+    const float nyquist = sampleRate / 2.0f;
+    for (int32_t level = 0; level < wavetable_level_count; level++)
+    {
+        const float maxFrequency = wavetable_base_frequency * (1 << level);
+        int32_t harmonicCount = int32_t(nyquist / maxFrequency);
+        if (harmonicCount > wavetable_size / 2)
+            harmonicCount = wavetable_size / 2;
+        if (harmonicCount < 1)
+            harmonicCount = 1;
+        buildLevel(wavetable.levels[level], waveform, harmonicCount);
+    }
+}
+
+const float* getWavetableLevel(const Wavetable& wavetable, float frequency)
+{
+    int32_t level = 0;
+    while (level < wavetable_level_count - 1 &&
+           frequency > wavetable_base_frequency * (1 << level))
+    {
+        level++;
+    }
+    return wavetable.levels[level];
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include <cstdint>
+
+// Debug builds replace the global operator new to count the heap
+// allocations of every thread, so tests can check that code which runs
+// every frame or tick never allocates. Release builds leave operator new
+// alone, and the count stays 0.
+#if defined(ALLOCATION_TRACKING)
+constexpr bool allocation_tracking_enabled = true;
+#else
+constexpr bool allocation_tracking_enabled = false;
+#endif
+
+// Returns the number of allocations the calling thread made so far.
+uint64_t getThreadAllocationCount();
+
+// While forbidden, an allocation by the calling thread fails the run, which
+// points at the allocation in a debugger or core dump.
+void setThreadAllocationsForbidden(bool forbidden);
@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/assert.h"
+#include "util/list_view.h"
+
+// A linear allocator over a block that is allocated once. Allocating only
+// moves an offset, and everything is freed at once by resetting it, which
+// suits memory that lives for a frame. Elements are not constructed, so
+// only types that need no constructor or destructor belong in an arena.
+struct Arena
+{
+    uint8_t* memory;
+    size_t capacity;
+    size_t used;
+    // The most that was used since the arena was created, to size it by.
+    size_t peak;
+};
+
+void initArena(Arena& arena, size_t capacity);
+void destroyArena(Arena& arena);
+
+// Fails when the arena is out of memory.
+void* allocate(Arena& arena, size_t size, size_t alignment);
+void resetArena(Arena& arena);
+
+template<typename Elem>
+Elem* allocateArray(Arena& arena, size_t count)
+{
+    return static_cast<Elem*>(allocate(arena, sizeof(Elem) * count, alignof(Elem)));
+}
+
+// The list lives until the arena is reset.
+template<typename Elem>
+ListView<Elem> makeListView(Arena& arena, size_t capacity)
+{
+    return makeListView(capacity, allocateArray<Elem>(arena, capacity));
+}
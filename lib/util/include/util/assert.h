@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdio>
+#include <cstdlib>
+
+#define ASSERT(x) \
+    if (!(x)) { \
+        fprintf(stderr, "[ASSERT] %s:%d: \"%s\"\n", __FILE__, __LINE__, #x); \
+        abort(); \
+    }
+
+#define UNREACHABLE(...) \
+    do { \
+        fprintf(stderr, "[UNREACHABLE] %s:%d: ", __FILE__, __LINE__); \
+        fprintf(stderr, __VA_ARGS__); \
+        fprintf(stderr, "\n"); \
+        abort(); \
+    } while(false)
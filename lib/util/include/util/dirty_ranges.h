@@ -0,0 +1,27 @@
+#pragma once
+
+#include <cstdint>
+
+constexpr int32_t max_dirty_range_count = 8;
+
+// A half open range of changed elements.
+struct DirtyRange
+{
+    uint32_t first;
+    uint32_t end;
+};
+
+// The parts of an array that changed since it was last synchronized, as
+// sorted ranges that neither overlap nor touch. When there are more ranges
+// than fit, the two closest are merged, which marks the elements between them
+// dirty as well.
+struct DirtyRanges
+{
+    // With room for one more, which a new range is inserted into before the
+    // closest ranges are merged.
+    DirtyRange ranges[max_dirty_range_count + 1];
+    int32_t count;
+};
+
+void markDirty(DirtyRanges& dirty, uint32_t first, uint32_t end);
+void clearDirty(DirtyRanges& dirty);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include <cstdint>
+
+// Turns readings of a real time counter into a number of fixed length ticks,
+// so logic advances at the same rate no matter how often it is polled.
+// Time is accumulated in units of counter ticks times the tick rate, which
+// keeps the schedule exact for any counter frequency.
+struct FixedTimestep
+{
+    uint64_t counterFrequency;
+    uint32_t tickRate;
+    uint32_t maxTicksPerAdvance;
+    uint64_t lastCounter;
+    uint64_t accumulated;
+    uint64_t tickCount;
+};
+
+FixedTimestep makeFixedTimestep(uint32_t tickRate,
+                                uint32_t maxTicksPerAdvance,
+                                uint64_t counterFrequency,
+                                uint64_t counter);
+
+// Returns the number of ticks that are due at the given counter value. When
+// more than maxTicksPerAdvance ticks are due, for example after the process
+// was suspended, the excess time is dropped instead of being caught up.
+uint32_t advanceFixedTimestep(FixedTimestep& timestep, uint64_t counter);
+
+// Returns how far the counter has to advance from its last reading until the
+// next tick is due, for a thread that sleeps in between ticks.
+uint64_t getCounterUntilNextTick(const FixedTimestep& timestep);
+
+// Discards the time accumulated so far, used when resuming after a pause.
+void resetFixedTimestep(FixedTimestep& timestep, uint64_t counter);
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstddef>
+
+#include "util/assert.h"
+
+// A fixed number of elements allocated up front, for objects that come and
+// go at run time. Taking and putting back an element is a push or pop on a
+// free list, so neither touches the heap. Elements are not constructed
+// again when they are taken, they keep whatever they held before.
+template<typename Elem>
+struct Pool
+{
+    Elem* elems;
+    Elem** free;
+    size_t capacity;
+    size_t freeCount;
+};
+
+template<typename Elem>
+void initPool(Pool<Elem>& pool, size_t capacity)
+{
+    ASSERT(capacity > 0);
+    pool.elems = new Elem[capacity];
+    pool.free = new Elem*[capacity];
+    pool.capacity = capacity;
+    // Handed out from the first element on.
+    for (size_t index = 0; index < capacity; index++)
+    {
+        pool.free[index] = &pool.elems[capacity - 1 - index];
+    }
+    pool.freeCount = capacity;
+}
+
+template<typename Elem>
+void destroyPool(Pool<Elem>& pool)
+{
+    delete[] pool.free;
+    delete[] pool.elems;
+    pool = Pool<Elem>{};
+}
+
+// Returns null when every element is taken.
+template<typename Elem>
+Elem* takeFromPool(Pool<Elem>& pool)
+{
+    if (pool.freeCount == 0)
+        return nullptr;
+    return pool.free[--pool.freeCount];
+}
+
+template<typename Elem>
+void putBackIntoPool(Pool<Elem>& pool, Elem* elem)
+{
+    ASSERT(elem >= pool.elems && elem < pool.elems + pool.capacity);
+    ASSERT(pool.freeCount < pool.capacity);
+    pool.free[pool.freeCount++] = elem;
+}
@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+struct SortItem
+{
+    uint64_t key;
+    uint32_t value;
+};
+
+// Sorts the items by key in ascending order, keeping items with equal keys in
+// the order they were in. The scratch space must hold count items. Bytes
+// that are the same across all keys are skipped, so keys that only use a few
+// of their bits sort in fewer passes.
+void radixSort(SortItem* items, SortItem* scratch, size_t count);
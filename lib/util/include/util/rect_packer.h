@@ -0,0 +1,39 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "util/list_view.h"
+
+// A horizontal segment of the top edge of the packed area.
+struct SkylineNode
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+};
+
+// Packs rectangles into a fixed area by placing each as low as possible on
+// the skyline formed by the ones placed before it, and then as far left as
+// possible.
+struct RectPacker
+{
+    uint32_t width;
+    uint32_t height;
+    ListView<SkylineNode> skyline;
+};
+
+// The skyline never has more nodes than the area is wide, so width nodes are
+// always enough.
+RectPacker makeRectPacker(uint32_t width,
+                          uint32_t height,
+                          SkylineNode* nodes,
+                          size_t nodeCapacity);
+
+// Reserves space for a rectangle and returns where its bottom left corner
+// was placed. Returns false if it does not fit anywhere.
+bool packRect(RectPacker& packer,
+              uint32_t width,
+              uint32_t height,
+              uint32_t& x,
+              uint32_t& y);
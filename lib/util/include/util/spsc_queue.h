@@ -0,0 +1,47 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+// A fixed capacity queue for exactly one producer thread and one consumer
+// thread. Both sides finish in a bounded number of steps without locks or
+// allocations, which makes it safe to use from real time threads such as the
+// audio callback.
+template<typename Elem, size_t Capacity>
+struct SpscQueue
+{
+    static_assert(Capacity > 0 && (Capacity & (Capacity - 1)) == 0,
+                  "SpscQueue capacity must be a power of two");
+
+    // The indices only ever grow and wrap around through the mask. They live
+    // on separate cache lines so the two threads do not contend.
+    alignas(64) std::atomic<size_t> head;
+    alignas(64) std::atomic<size_t> tail;
+    Elem elems[Capacity];
+};
+
+// Returns false without blocking when the queue is full.
+template<typename Elem, size_t Capacity>
+bool tryPush(SpscQueue<Elem, Capacity>& queue, const Elem& elem)
+{
+    const size_t tail = queue.tail.load(std::memory_order_relaxed);
+    if (tail - queue.head.load(std::memory_order_acquire) == Capacity)
+        return false;
+
+    queue.elems[tail & (Capacity - 1)] = elem;
+    queue.tail.store(tail + 1, std::memory_order_release);
+    return true;
+}
+
+// Returns false without blocking when the queue is empty.
+template<typename Elem, size_t Capacity>
+bool tryPop(SpscQueue<Elem, Capacity>& queue, Elem& elem)
+{
+    const size_t head = queue.head.load(std::memory_order_relaxed);
+    if (head == queue.tail.load(std::memory_order_acquire))
+        return false;
+
+    elem = queue.elems[head & (Capacity - 1)];
+    queue.head.store(head + 1, std::memory_order_release);
+    return true;
+}
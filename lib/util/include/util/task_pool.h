@@ -0,0 +1,60 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// A unit of work. Tasks may push more tasks to the pool while they run, the
+// worker is the index of the thread running the task.
+struct Task
+{
+    void (*run)(void* data, int32_t worker);
+    void* data;
+};
+
+// The tasks of one thread. The owner pushes and pops at the back, other
+// threads steal from the front, so the owner works depth first on what it
+// pushed last while thieves take the oldest and usually largest tasks. The
+// lock is only ever contended by a steal.
+struct TaskDeque
+{
+    std::mutex mutex;
+    Task* tasks;
+    size_t capacity;
+    size_t front;
+    size_t back;
+};
+
+// A work stealing pool of threads. The thread that runs the tasks is worker
+// 0 and takes part in running them, the pool threads are workers 1 and up.
+struct TaskPool
+{
+    int32_t workerCount;
+    std::thread* threads;
+    TaskDeque* deques;
+    // The tasks that were pushed and did not finish yet.
+    std::atomic<int64_t> pendingCount;
+    std::mutex mutex;
+    std::condition_variable workStarted;
+    uint64_t generation;
+    bool quitting;
+};
+
+// Starts threadCount - 1 threads. Every worker can hold up to maxTaskCount
+// tasks that did not start yet.
+void initTaskPool(TaskPool& pool, int32_t threadCount, size_t maxTaskCount);
+void destroyTaskPool(TaskPool& pool);
+
+// Returns the number of threads the machine can run at once, at least 1.
+int32_t getHardwareThreadCount();
+
+// Can be called before runTasks from the thread that calls it, with worker
+// 0, or by a running task with its own worker.
+void pushTask(TaskPool& pool, int32_t worker, const Task& task);
+
+// Runs the pushed tasks and every task they push, and returns once all of
+// them finished.
+void runTasks(TaskPool& pool);
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+
+// Hands the newest of a stream of values from exactly one producer thread to
+// exactly one consumer thread. Each side owns one of the three buffers and
+// the third is swapped between them, so neither side ever waits for the
+// other and the consumer always gets the newest complete value. Values the
+// consumer did not get to in time are skipped.
+template<typename Elem>
+struct TripleBuffer
+{
+    Elem elems[3];
+    // The buffer between the two threads, with triple_buffer_fresh_bit set
+    // while it holds a value the consumer did not take yet.
+    alignas(64) std::atomic<uint8_t> middle{ 1 };
+    // Only ever touched by the producer and the consumer respectively.
+    alignas(64) uint8_t back = 0;
+    alignas(64) uint8_t front = 2;
+};
+
+constexpr uint8_t triple_buffer_index_bits = 3;
+constexpr uint8_t triple_buffer_fresh_bit = 4;
+
+// The buffer the producer writes the next value into. It holds an old value,
+// so it has to be written in full.
+template<typename Elem>
+Elem& getBackBuffer(TripleBuffer<Elem>& buffer)
+{
+    return buffer.elems[buffer.back];
+}
+
+// Hands the back buffer to the consumer.
+template<typename Elem>
+void publishBackBuffer(TripleBuffer<Elem>& buffer)
+{
+    const uint8_t middle = buffer.middle.exchange(
+        buffer.back | triple_buffer_fresh_bit,
+        std::memory_order_acq_rel);
+    buffer.back = middle & triple_buffer_index_bits;
+}
+
+// Takes the newest published value into the front buffer. Returns false
+// and leaves the front buffer as it is when nothing was published since.
+template<typename Elem>
+bool acquireFrontBuffer(TripleBuffer<Elem>& buffer)
+{
+    if (!(buffer.middle.load(std::memory_order_relaxed) & triple_buffer_fresh_bit))
+        return false;
+
+    const uint8_t middle =
+        buffer.middle.exchange(buffer.front, std::memory_order_acq_rel);
+    buffer.front = middle & triple_buffer_index_bits;
+    return true;
+}
+
+// The value the consumer acquired last.
+template<typename Elem>
+const Elem& getFrontBuffer(const TripleBuffer<Elem>& buffer)
+{
+    return buffer.elems[buffer.front];
+}
@@ -0,0 +1,130 @@
+#include "util/allocation_hook.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+thread_local uint64_t allocationCount = 0;
+thread_local bool allocationsForbidden = false;
+
+}
+
+uint64_t getThreadAllocationCount()
+{
+    return allocationCount;
+}
+
+void setThreadAllocationsForbidden(bool forbidden)
+{
+    allocationsForbidden = forbidden;
+}
+
+#if defined(ALLOCATION_TRACKING)
+
+namespace {
+
+void countAllocation(size_t size)
+{
+    allocationCount++;
+    if (allocationsForbidden) {
+        fprintf(stderr, "[ALLOCATION] %zu bytes allocated where allocations are forbidden\n", size);
+        abort();
+    }
+}
+
+void* allocateOrAbort(size_t size)
+{
+    countAllocation(size);
+    void* memory = malloc(size != 0 ? size : 1);
+    if (memory == nullptr)
+        abort();
+    return memory;
+}
+
+void* allocateAlignedOrAbort(size_t size, std::align_val_t alignment)
+{
+    countAllocation(size);
+    // aligned_alloc wants the size to be a multiple of the alignment.
+    const size_t align = size_t(alignment);
+    void* memory = aligned_alloc(align, (size + align - 1) / align * align);
+    if (memory == nullptr)
+        abort();
+    return memory;
+}
+
+}
+
+// Every other form of new and delete ends up in these.
+void* operator new(size_t size)
+{
+    return allocateOrAbort(size);
+}
+
+void* operator new[](size_t size)
+{
+    return allocateOrAbort(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateOrAbort(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocateOrAbort(size);
+}
+
+void* operator new(size_t size, std::align_val_t alignment)
+{
+    return allocateAlignedOrAbort(size, alignment);
+}
+
+void* operator new[](size_t size, std::align_val_t alignment)
+{
+    return allocateAlignedOrAbort(size, alignment);
+}
+
+void operator delete(void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete(void* memory, size_t, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+void operator delete[](void* memory, size_t, std::align_val_t) noexcept
+{
+    free(memory);
+}
+
+#endif
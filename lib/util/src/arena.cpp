@@ -0,0 +1,36 @@
+#include "util/arena.h"
+
+void initArena(Arena& arena, size_t capacity)
+{
+    ASSERT(capacity > 0);
+    arena.memory = new uint8_t[capacity];
+    arena.capacity = capacity;
+    arena.used = 0;
+    arena.peak = 0;
+}
+
+void destroyArena(Arena& arena)
+{
+    delete[] arena.memory;
+    arena = Arena{};
+}
+
+void* allocate(Arena& arena, size_t size, size_t alignment)
+{
+    ASSERT(alignment > 0 && (alignment & (alignment - 1)) == 0);
+
+    const uintptr_t address = reinterpret_cast<uintptr_t>(arena.memory) + arena.used;
+    const size_t padding = (alignment - address % alignment) % alignment;
+    ASSERT(size <= arena.capacity - arena.used - padding);
+
+    void* memory = arena.memory + arena.used + padding;
+    arena.used += padding + size;
+    if (arena.used > arena.peak)
+        arena.peak = arena.used;
+    return memory;
+}
+
+void resetArena(Arena& arena)
+{
+    arena.used = 0;
+}
@@ -0,0 +1,61 @@
+#include "util/dirty_ranges.h"
+
+#include "util/assert.h"
+
+namespace {
+
+void removeRange(DirtyRanges& dirty, int32_t index)
+{
+    for (int32_t next = index + 1; next < dirty.count; next++)
+    {
+        dirty.ranges[next - 1] = dirty.ranges[next];
+    }
+    dirty.count--;
+}
+
+}
+
+void markDirty(DirtyRanges& dirty, uint32_t first, uint32_t end)
+{
+    ASSERT(first < end);
+
+    // Every range the new one overlaps or touches is merged into it.
+    int32_t index = 0;
+    while (index < dirty.count && dirty.ranges[index].end < first)
+    {
+        index++;
+    }
+    while (index < dirty.count && dirty.ranges[index].first <= end)
+    {
+        if (dirty.ranges[index].first < first)
+            first = dirty.ranges[index].first;
+        if (dirty.ranges[index].end > end)
+            end = dirty.ranges[index].end;
+        removeRange(dirty, index);
+    }
+
+    for (int32_t next = dirty.count; next > index; next--)
+    {
+        dirty.ranges[next] = dirty.ranges[next - 1];
+    }
+    dirty.ranges[index] = DirtyRange{ first, end };
+    dirty.count++;
+
+    if (dirty.count > max_dirty_range_count) {
+        int32_t closest = 0;
+        for (int32_t other = 1; other + 1 < dirty.count; other++)
+        {
+            const uint32_t gap =
+                dirty.ranges[other + 1].first - dirty.ranges[other].end;
+            if (gap < dirty.ranges[closest + 1].first - dirty.ranges[closest].end)
+                closest = other;
+        }
+        dirty.ranges[closest].end = dirty.ranges[closest + 1].end;
+        removeRange(dirty, closest + 1);
+    }
+}
+
+void clearDirty(DirtyRanges& dirty)
+{
+    dirty.count = 0;
+}
@@ -0,0 +1,50 @@
+#include "util/fixed_timestep.h"
+
+#include "util/assert.h"
+
+FixedTimestep makeFixedTimestep(uint32_t tickRate,
+                                uint32_t maxTicksPerAdvance,
+                                uint64_t counterFrequency,
+                                uint64_t counter)
+{
+    ASSERT(tickRate > 0);
+    ASSERT(maxTicksPerAdvance > 0);
+    ASSERT(counterFrequency > 0);
+    return FixedTimestep{
+        counterFrequency,
+        tickRate,
+        maxTicksPerAdvance,
+        counter,
+        0,
+        0
+    };
+}
+
+uint32_t advanceFixedTimestep(FixedTimestep& timestep, uint64_t counter)
+{
+    ASSERT(counter >= timestep.lastCounter);
+
+    timestep.accumulated +=
+        (counter - timestep.lastCounter) * timestep.tickRate;
+    timestep.lastCounter = counter;
+
+    uint64_t ticks = timestep.accumulated / timestep.counterFrequency;
+    timestep.accumulated -= ticks * timestep.counterFrequency;
+    if (ticks > timestep.maxTicksPerAdvance)
+        ticks = timestep.maxTicksPerAdvance;
+
+    timestep.tickCount += ticks;
+    return uint32_t(ticks);
+}
+
+uint64_t getCounterUntilNextTick(const FixedTimestep& timestep)
+{
+    const uint64_t missing = timestep.counterFrequency - timestep.accumulated;
+    return (missing + timestep.tickRate - 1) / timestep.tickRate;
+}
+
+void resetFixedTimestep(FixedTimestep& timestep, uint64_t counter)
+{
+    timestep.lastCounter = counter;
+    timestep.accumulated = 0;
+}
@@ -0,0 +1,66 @@
+#include "util/radix_sort.h"
+
+#include <cstring>
+
+#include "util/assert.h"
+
+namespace {
+
+constexpr int32_t digit_bits = 8;
+constexpr int32_t digit_count = 1 << digit_bits;
+constexpr int32_t pass_count = 64 / digit_bits;
+
+uint32_t getDigit(uint64_t key, int32_t pass)
+{
+    return (key >> (pass * digit_bits)) & (digit_count - 1);
+}
+
+}
+
+void radixSort(SortItem* items, SortItem* scratch, size_t count)
+{
+    ASSERT(count == 0 || (items != nullptr && scratch != nullptr));
+
+    if (count < 2)
+        return;
+
+    // All histograms are built in a single read over the items.
+    uint32_t histograms[pass_count][digit_count] = {};
+    for (size_t index = 0; index < count; index++)
+    {
+        for (int32_t pass = 0; pass < pass_count; pass++)
+        {
+            histograms[pass][getDigit(items[index].key, pass)]++;
+        }
+    }
+
+    SortItem* source = items;
+    SortItem* destination = scratch;
+    for (int32_t pass = 0; pass < pass_count; pass++)
+    {
+        uint32_t* histogram = histograms[pass];
+        if (histogram[getDigit(items[0].key, pass)] == count)
+            continue;
+
+        uint32_t offset = 0;
+        for (int32_t digit = 0; digit < digit_count; digit++)
+        {
+            const uint32_t digitCount = histogram[digit];
+            histogram[digit] = offset;
+            offset += digitCount;
+        }
+
+        for (size_t index = 0; index < count; index++)
+        {
+            const SortItem& item = source[index];
+            destination[histogram[getDigit(item.key, pass)]++] = item;
+        }
+
+        SortItem* sorted = destination;
+        destination = source;
+        source = sorted;
+    }
+
+    if (source != items)
+        memcpy(items, source, count * sizeof(SortItem));
+}
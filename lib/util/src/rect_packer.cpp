@@ -0,0 +1,124 @@
+#include "util/rect_packer.h"
+
+#include <cstring>
+
+namespace {
+
+// Returns the height a rectangle starting at the node would rest at, or
+// UINT32_MAX if it does not fit there.
+uint32_t getRestingHeight(const RectPacker& packer,
+                          size_t node,
+                          uint32_t width,
+                          uint32_t height)
+{
+    const ListView<SkylineNode>& skyline = packer.skyline;
+    const uint32_t x = skyline[node].x;
+    if (x + width > packer.width)
+        return UINT32_MAX;
+
+    uint32_t y = 0;
+    for (size_t index = node; index < skyline.count && skyline[index].x < x + width; index++)
+    {
+        if (skyline[index].y > y)
+            y = skyline[index].y;
+    }
+    if (y + height > packer.height)
+        return UINT32_MAX;
+    return y;
+}
+
+void insertNode(ListView<SkylineNode>& skyline,
+                size_t index,
+                const SkylineNode& node)
+{
+    ASSERT(skyline.count < skyline.capacity);
+    memmove(skyline.elems + index + 1,
+            skyline.elems + index,
+            (skyline.count - index) * sizeof(SkylineNode));
+    skyline.elems[index] = node;
+    skyline.count++;
+}
+
+void removeNode(ListView<SkylineNode>& skyline, size_t index)
+{
+    memmove(skyline.elems + index,
+            skyline.elems + index + 1,
+            (skyline.count - index - 1) * sizeof(SkylineNode));
+    skyline.count--;
+}
+
+}
+
+RectPacker makeRectPacker(uint32_t width,
+                          uint32_t height,
+                          SkylineNode* nodes,
+                          size_t nodeCapacity)
+{
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+
+    RectPacker packer = RectPacker{
+        width,
+        height,
+        makeListView(nodeCapacity, nodes)
+    };
+    add(packer.skyline, SkylineNode{ 0, 0, width });
+    return packer;
+}
+
+bool packRect(RectPacker& packer,
+              uint32_t width,
+              uint32_t height,
+              uint32_t& x,
+              uint32_t& y)
+{
+    ASSERT(width > 0);
+    ASSERT(height > 0);
+
+    ListView<SkylineNode>& skyline = packer.skyline;
+    size_t best = skyline.count;
+    uint32_t bestY = UINT32_MAX;
+    for (size_t index = 0; index < skyline.count; index++)
+    {
+        const uint32_t restingY = getRestingHeight(packer, index, width, height);
+        if (restingY < bestY) {
+            best = index;
+            bestY = restingY;
+        }
+    }
+    if (best == skyline.count)
+        return false;
+
+    x = skyline[best].x;
+    y = bestY;
+
+    // The new node covers the nodes under the rectangle, which get cut back
+    // or removed.
+    insertNode(skyline, best, SkylineNode{ x, y + height, width });
+    const uint32_t right = x + width;
+    while (best + 1 < skyline.count && skyline[best + 1].x < right)
+    {
+        SkylineNode& node = skyline[best + 1];
+        const uint32_t nodeRight = node.x + node.width;
+        if (nodeRight <= right) {
+            removeNode(skyline, best + 1);
+            continue;
+        }
+        node.width = nodeRight - right;
+        node.x = right;
+        break;
+    }
+
+    // Neighbours at the same height become one node.
+    for (size_t index = 0; index + 1 < skyline.count;)
+    {
+        if (skyline[index].y == skyline[index + 1].y) {
+            skyline[index].width += skyline[index + 1].width;
+            removeNode(skyline, index + 1);
+        } else {
+            index++;
+        }
+    }
+
+    return true;
+}
@@ -0,0 +1,152 @@
+#include "util/task_pool.h"
+
+#include "util/assert.h"
+
+namespace {
+
+bool popTask(TaskDeque& deque, Task& task)
+{
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (deque.back == deque.front)
+        return false;
+
+    task = deque.tasks[--deque.back % deque.capacity];
+    return true;
+}
+
+bool stealTask(TaskDeque& deque, Task& task)
+{
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    if (deque.back == deque.front)
+        return false;
+
+    task = deque.tasks[deque.front++ % deque.capacity];
+    return true;
+}
+
+bool findTask(TaskPool& pool, int32_t worker, Task& task)
+{
+    if (popTask(pool.deques[worker], task))
+        return true;
+
+    for (int32_t offset = 1; offset < pool.workerCount; offset++)
+    {
+        const int32_t victim = (worker + offset) % pool.workerCount;
+        if (stealTask(pool.deques[victim], task))
+            return true;
+    }
+    return false;
+}
+
+// Runs tasks until every pending task finished. Other threads can still be
+// running theirs while there is nothing left to take, so it spins until the
+// last one is done, as they may push more.
+void runPendingTasks(TaskPool& pool, int32_t worker)
+{
+    Task task;
+    while (pool.pendingCount.load(std::memory_order_acquire) > 0)
+    {
+        if (!findTask(pool, worker, task)) {
+            std::this_thread::yield();
+            continue;
+        }
+        task.run(task.data, worker);
+        pool.pendingCount.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+void runWorker(TaskPool* pool, int32_t worker)
+{
+    uint64_t lastGeneration = 0;
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(pool->mutex);
+            pool->workStarted.wait(lock, [&] {
+                return pool->quitting || pool->generation != lastGeneration;
+            });
+            if (pool->quitting)
+                return;
+            lastGeneration = pool->generation;
+        }
+
+        runPendingTasks(*pool, worker);
+    }
+}
+
+}
+
+void initTaskPool(TaskPool& pool, int32_t threadCount, size_t maxTaskCount)
+{
+    ASSERT(threadCount > 0);
+    ASSERT(maxTaskCount > 0);
+
+    pool.workerCount = threadCount;
+    pool.deques = new TaskDeque[threadCount];
+    for (int32_t worker = 0; worker < threadCount; worker++)
+    {
+        TaskDeque& deque = pool.deques[worker];
+        deque.tasks = new Task[maxTaskCount];
+        deque.capacity = maxTaskCount;
+        deque.front = 0;
+        deque.back = 0;
+    }
+    pool.pendingCount.store(0, std::memory_order_relaxed);
+    pool.generation = 0;
+    pool.quitting = false;
+    pool.threads = new std::thread[threadCount - 1];
+    for (int32_t worker = 1; worker < threadCount; worker++)
+    {
+        pool.threads[worker - 1] = std::thread(runWorker, &pool, worker);
+    }
+}
+
+void destroyTaskPool(TaskPool& pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.quitting = true;
+    }
+    pool.workStarted.notify_all();
+    for (int32_t worker = 1; worker < pool.workerCount; worker++)
+    {
+        pool.threads[worker - 1].join();
+    }
+    delete[] pool.threads;
+    for (int32_t worker = 0; worker < pool.workerCount; worker++)
+    {
+        delete[] pool.deques[worker].tasks;
+    }
+    delete[] pool.deques;
+    pool.threads = nullptr;
+    pool.deques = nullptr;
+    pool.workerCount = 0;
+}
+
+int32_t getHardwareThreadCount()
+{
+    const int32_t threadCount = int32_t(std::thread::hardware_concurrency());
+    return threadCount > 0 ? threadCount : 1;
+}
+
+void pushTask(TaskPool& pool, int32_t worker, const Task& task)
+{
+    ASSERT(worker >= 0 && worker < pool.workerCount);
+
+    pool.pendingCount.fetch_add(1, std::memory_order_relaxed);
+    TaskDeque& deque = pool.deques[worker];
+    std::lock_guard<std::mutex> lock(deque.mutex);
+    ASSERT(deque.back - deque.front < deque.capacity);
+    deque.tasks[deque.back++ % deque.capacity] = task;
+}
+
+void runTasks(TaskPool& pool)
+{
+    {
+        std::lock_guard<std::mutex> lock(pool.mutex);
+        pool.generation++;
+    }
+    pool.workStarted.notify_all();
+
+    runPendingTasks(pool, 0);
+}
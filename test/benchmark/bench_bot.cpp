@@ -0,0 +1,77 @@
+#include <catch.hpp>
+
+#include <board/board.h>
+#include <bot/evaluator.h>
+#include <bot/placement.h>
+#include <bot/search.h>
+#include <simulation/game.h>
+
+namespace {
+
+// A stack with holes and overhangs, for tucks and spins to be found in.
+Board makeStackedBoard()
+{
+    Board board = makeBoard();
+    setRow(board, 0, 0x3DF);
+    setRow(board, 1, 0x1FB);
+    setRow(board, 2, 0x0F3);
+    setRow(board, 3, 0x061);
+    setRow(board, 4, 0x041);
+    return board;
+}
+
+BotOptions getBenchmarkBotOptions(int32_t threadCount)
+{
+    BotOptions options = getDefaultBotOptions();
+    options.threadCount = threadCount;
+    options.maxDepth = 3;
+    // Every search goes the whole depth, so the thread counts compare.
+    options.timeBudget = std::chrono::seconds(60);
+    return options;
+}
+
+}
+
+TEST_CASE("Searching placements")
+{
+    const Board board = makeStackedBoard();
+
+    BENCHMARK("findPlacements [7 pieces]")
+    {
+        static PlacementSearch search;
+        PlacementList placements;
+        int32_t count = 0;
+        for (int32_t type = 0; type < piece_type_count; type++)
+        {
+            findPlacements(
+                board,
+                ActivePiece{ PieceType(type), 0, piece_spawn_x, piece_spawn_y },
+                search,
+                placements);
+            count += placements.count;
+        }
+        return count;
+    };
+
+    Game game = makeGame(1);
+    game.board = board;
+    const HeuristicWeights weights = getDefaultHeuristicWeights();
+    static Bot bot;
+
+    initBot(bot, getBenchmarkBotOptions(1), makeHeuristicEvaluator(weights));
+    BENCHMARK("searchBotMove depth 3, 1 thread [1 search]")
+    {
+        return searchBotMove(bot, game).nodeCount;
+    };
+    destroyBot(bot);
+
+    initBot(
+        bot,
+        getBenchmarkBotOptions(getHardwareThreadCount()),
+        makeHeuristicEvaluator(weights));
+    BENCHMARK("searchBotMove depth 3, all threads [1 search]")
+    {
+        return searchBotMove(bot, game).nodeCount;
+    };
+    destroyBot(bot);
+}
@@ -0,0 +1,284 @@
+#include <catch.hpp>
+
+#include <board/board.h>
+#include <board/piece_table.h>
+#include <cstdio>
+#include <simulation/game.h>
+#include <simulation/game_batch.h>
+#include <simulation/replay.h>
+#include <simulation/versus.h>
+#include <string>
+
+namespace {
+
+constexpr int32_t tick_count = 6000;
+constexpr int32_t piece_count = 1000;
+// An hour of play.
+constexpr uint64_t replay_tick_count = 60 * 60 * tick_rate;
+constexpr int32_t seek_count = 1000;
+constexpr int32_t batch_game_count = 4096;
+constexpr int32_t turn_count = 4096;
+constexpr int32_t rollback_tick_count = 8;
+
+// A fixed pattern of button presses that keeps pieces moving, rotating and
+// dropping, so the game goes through all of its paths.
+GameInput getScriptedInput(int32_t tick)
+{
+    GameInput input = {};
+    input.left = tick % 90 < 20;
+    input.right = tick % 90 >= 50 && tick % 90 < 70;
+    input.down = tick % 37 < 10;
+    input.turnRight = tick % 23 == 0;
+    input.turnLeft = tick % 41 == 0;
+    input.swap = tick % 301 == 0;
+    input.drop = tick % 53 == 0;
+    return input;
+}
+
+// Placements spread over the columns and rotations, most of which fit, so
+// the games go on for a while between restarts.
+void fillBatchActions(uint8_t* actions, int32_t step)
+{
+    for (int32_t game = 0; game < batch_game_count; game++)
+    {
+        const int32_t rotation = (game + step) % rotation_count;
+        const int32_t x = (game * 7 + step * 3) % (board_width - 1);
+        actions[game] = makeBatchAction(rotation, x);
+    }
+}
+
+// Turns the piece the way the game did before the tables, finding the
+// rotation state, the shape and the mask as it goes.
+bool turnComputed(const Board& board, ActivePiece& piece, int32_t turns)
+{
+    const int32_t rotation = (piece.rotation + turns) % rotation_count;
+    const PieceBox& box = piece_boxes[int32_t(piece.type)];
+    uint16_t shape = box.spawnShape;
+    for (int32_t turn = 0; turn < rotation; turn++)
+    {
+        shape = turnShapeClockwise(shape, box);
+    }
+    const PieceMask mask = getShapeMask(shape);
+    for (int32_t offset : piece_kick_offsets)
+    {
+        if (!collides(board, mask, piece.x + offset, piece.y)) {
+            piece.rotation = rotation;
+            piece.x += offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool turnWithTable(const Board& board, ActivePiece& piece, PieceTurn turn)
+{
+    constexpr const PieceTable<board_width>& table = piece_table<board_width>;
+    const int32_t rotation = table.turns[piece.rotation][int32_t(turn)];
+    for (int32_t offset : table.kicks[int32_t(piece.type)][piece.rotation][int32_t(turn)])
+    {
+        const PieceMask mask =
+            getPieceMaskAt<board_width>(piece.type, rotation, piece.x + offset);
+        if (!collidesShifted(board, mask, piece.y)) {
+            piece.rotation = rotation;
+            piece.x += offset;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Pieces spread over the board, low enough to bump into the stack.
+void fillTurnPieces(ActivePiece* pieces)
+{
+    for (int32_t index = 0; index < turn_count; index++)
+    {
+        const PieceType type = PieceType(index % piece_type_count);
+        const int32_t rotation = index / piece_type_count % rotation_count;
+        const int32_t x = piece_table<board_width>.minX[int32_t(type)][rotation] +
+                          index * 5 % 7;
+        pieces[index] = ActivePiece{ type, rotation, x, index % 3 + 1 };
+    }
+}
+
+std::string writeScriptedReplay()
+{
+    const std::string path = std::string(BENCHMARK_OUTPUT_DIR) + "/bench.trpl";
+    ReplayWriter writer;
+    REQUIRE(openReplayWriter(
+        writer,
+        path.c_str(),
+        1,
+        default_keyframe_interval));
+    Game game = makeGame(1);
+    for (uint64_t tick = 0; tick < replay_tick_count; tick++)
+    {
+        const GameInput input = getScriptedInput(int32_t(tick));
+        writeReplayInput(writer, game, input);
+        updateGame(game, input);
+        if (game.over)
+            game = makeGame(uint32_t(tick));
+    }
+    REQUIRE(closeReplayWriter(writer));
+    return path;
+}
+
+}
+
+TEST_CASE("Simulating games")
+{
+    BENCHMARK("updateGame scripted [6000 ticks]")
+    {
+        Game game = makeGame(1);
+        for (int32_t tick = 0; tick < tick_count; tick++)
+        {
+            if (game.over)
+                game = makeGame(uint32_t(tick));
+            updateGame(game, getScriptedInput(tick));
+        }
+        return game.score;
+    };
+
+    BENCHMARK("dropPiece [1000 pieces]")
+    {
+        Board board = makeBoard();
+        int32_t lines = 0;
+        for (int32_t piece = 0; piece < piece_count; piece++)
+        {
+            const PieceType type = PieceType(piece % piece_type_count);
+            const int32_t cleared =
+                dropPiece(board, type, piece % rotation_count, piece % 8 - 1);
+            if (cleared < 0)
+                board = makeBoard();
+            else
+                lines += cleared;
+        }
+        return lines;
+    };
+}
+
+// A rollback restores a snapshot and runs the ticks since then again, taking
+// a checksum after each of them.
+TEST_CASE("Rolling back versus matches")
+{
+    VersusGame snapshot = makeVersusGame(1);
+    for (int32_t tick = 0; tick < 300; tick++)
+    {
+        const GameInput inputs[versus_player_count] = {
+            getScriptedInput(tick),
+            getScriptedInput(tick + 45)
+        };
+        updateVersusGame(snapshot, inputs);
+    }
+    REQUIRE(!snapshot.over);
+
+    BENCHMARK("restore and re-simulate [8 ticks]")
+    {
+        VersusGame game = snapshot;
+        uint32_t checksum = 0;
+        for (int32_t tick = 0; tick < rollback_tick_count; tick++)
+        {
+            const GameInput inputs[versus_player_count] = {
+                getScriptedInput(tick),
+                getScriptedInput(tick + 45)
+            };
+            updateVersusGame(game, inputs);
+            checksum ^= getVersusChecksum(game);
+        }
+        return checksum;
+    };
+}
+
+TEST_CASE("Turning pieces")
+{
+    Board board = makeBoard();
+    setRow(board, 0, 0x3EF);
+    setRow(board, 1, 0x1C7);
+    setRow(board, 2, 0x083);
+    static ActivePiece pieces[turn_count];
+    fillTurnPieces(pieces);
+
+    BENCHMARK("turn computed at run time [4096 turns]")
+    {
+        int32_t turned = 0;
+        for (int32_t index = 0; index < turn_count; index++)
+        {
+            ActivePiece piece = pieces[index];
+            turned += turnComputed(board, piece, index % 2 == 0 ? 1 : rotation_count - 1);
+        }
+        return turned;
+    };
+
+    BENCHMARK("turn with the piece table [4096 turns]")
+    {
+        int32_t turned = 0;
+        for (int32_t index = 0; index < turn_count; index++)
+        {
+            ActivePiece piece = pieces[index];
+            turned += turnWithTable(
+                board,
+                piece,
+                index % 2 == 0 ? PieceTurn::Clockwise : PieceTurn::CounterClockwise);
+        }
+        return turned;
+    };
+}
+
+TEST_CASE("Reading replays")
+{
+    const std::string path = writeScriptedReplay();
+    Replay replay;
+    REQUIRE(openReplay(replay, path.c_str()));
+
+    BENCHMARK("readReplayInput [216000 ticks]")
+    {
+        ReplayCursor cursor = makeReplayCursor(replay, 0);
+        GameInput input;
+        uint32_t dropCount = 0;
+        while (readReplayInput(cursor, input))
+        {
+            dropCount += input.drop;
+        }
+        return dropCount;
+    };
+
+    BENCHMARK("seekReplay [1000 seeks]")
+    {
+        uint32_t score = 0;
+        for (int32_t seek = 0; seek < seek_count; seek++)
+        {
+            const uint64_t tick = uint64_t(seek) * 7919 % replay_tick_count;
+            score += seekReplay(replay, tick).score;
+        }
+        return score;
+    };
+
+    closeReplay(replay);
+    remove(path.c_str());
+}
+
+TEST_CASE("Stepping game batches")
+{
+    static uint8_t actions[8][batch_game_count];
+    for (int32_t step = 0; step < 8; step++)
+    {
+        fillBatchActions(actions[step], step);
+    }
+
+    GameBatch batch;
+    initGameBatch(batch, batch_game_count, 1, 1);
+    int32_t step = 0;
+    BENCHMARK("stepGameBatch 1 thread [4096 steps]")
+    {
+        stepGameBatch(batch, actions[step++ % 8]);
+        return batch.rewards[0];
+    };
+    destroyGameBatch(batch);
+
+    initGameBatch(batch, batch_game_count, 1, getHardwareThreadCount());
+    BENCHMARK("stepGameBatch all threads [4096 steps]")
+    {
+        stepGameBatch(batch, actions[step++ % 8]);
+        return batch.rewards[0];
+    };
+    destroyGameBatch(batch);
+}
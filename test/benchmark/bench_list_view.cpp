@@ -0,0 +1,25 @@
+#include <catch.hpp>
+
+#include <util/list_view.h>
+
+namespace {
+
+constexpr int32_t list_capacity = 4096;
+
+}
+
+TEST_CASE("Filling and clearing a ListView")
+{
+    static int32_t elems[list_capacity];
+    ListView<int32_t> listView = makeListView(list_capacity, elems);
+
+    BENCHMARK("ListView add and clear [4096 elements]")
+    {
+        clear(listView);
+        for (int32_t index = 0; index < list_capacity; index++)
+        {
+            add(listView, index);
+        }
+        return listView.count;
+    };
+}
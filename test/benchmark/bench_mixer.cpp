@@ -0,0 +1,52 @@
+#include <catch.hpp>
+
+#include <string>
+#include <synth/kernel.h>
+#include <synth/mixer.h>
+
+namespace {
+
+constexpr int32_t block_size = 512;
+constexpr int32_t sound_length = 48000;
+
+int16_t soundData[mixer_voice_count][sound_length];
+
+}
+
+TEST_CASE("Mixing a full set of voices into an audio block")
+{
+    static Sound sounds[mixer_voice_count];
+    for (int32_t voice = 0; voice < mixer_voice_count; voice++)
+    {
+        for (int32_t index = 0; index < sound_length; index++)
+        {
+            soundData[voice][index] = int16_t((index * (voice + 1) * 31) % 2000 - 1000);
+        }
+        sounds[voice] = Sound{ soundData[voice], sound_length };
+    }
+
+    const SynthKernel original = getSynthKernel();
+    for (SynthKernel kernel :
+         { SynthKernel::Scalar, SynthKernel::Sse2, SynthKernel::Avx2 })
+    {
+        if (!isSynthKernelSupported(kernel))
+            continue;
+
+        setSynthKernel(kernel);
+        Mixer mixer = makeMixer();
+        for (int32_t voice = 0; voice < mixer_voice_count; voice++)
+        {
+            playSound(mixer, sounds[voice], 0.5f, true);
+        }
+
+        static int16_t samples[block_size];
+        const std::string name = std::string("mixVoices 32 voices ") +
+                                 getSynthKernelName(kernel) + " [512 samples]";
+        BENCHMARK(name.c_str())
+        {
+            mixVoices(mixer, samples, block_size);
+            return samples[block_size - 1];
+        };
+    }
+    setSynthKernel(original);
+}
@@ -0,0 +1,83 @@
+#include <catch.hpp>
+
+#include <particles.h>
+#include <quad_queue.h>
+#include <string>
+
+namespace {
+
+constexpr uint32_t particle_counts[] = { 10000, 100000, 1000000 };
+// A frame at 60 frames per second.
+constexpr float frame_seconds = 1.0f / 60;
+constexpr float gravity = 600;
+
+// Particles that outlive the benchmark, so every frame updates the same
+// number of them, while a few die each frame and get compacted away
+// without changing the count by much.
+void emitBenchmarkParticles(Particles& particles, uint32_t count)
+{
+    uint32_t random = 7;
+    emitParticles(particles,
+                  ParticleBurst{ 0, 0, 720, 480, 200, -100, 1e6f, 4, Color{ 1, 1, 0 }, count },
+                  random);
+    for (uint32_t index = 0; index < count; index += 97)
+    {
+        particles.life[index] = frame_seconds / 2;
+    }
+}
+
+}
+
+TEST_CASE("Updating particles for a frame")
+{
+    const ParticleKernel original = getParticleKernel();
+    for (uint32_t count : particle_counts)
+    {
+        for (ParticleKernel kernel :
+             { ParticleKernel::Scalar, ParticleKernel::Sse2, ParticleKernel::Avx2 })
+        {
+            if (!isParticleKernelSupported(kernel))
+                continue;
+
+            setParticleKernel(kernel);
+            Particles particles;
+            initParticles(particles, count);
+            const std::string name = std::string("updateParticles ") +
+                getParticleKernelName(kernel) + " [" + std::to_string(count) + " particles]";
+            BENCHMARK_ADVANCED(name.c_str())(Catch::Benchmark::Chronometer meter)
+            {
+                particles.count = 0;
+                emitBenchmarkParticles(particles, count);
+                meter.measure([&] {
+                    updateParticles(particles, frame_seconds, gravity);
+                    return particles.count;
+                });
+            };
+            destroyParticles(particles);
+        }
+    }
+    setParticleKernel(original);
+}
+
+TEST_CASE("Writing particle quads for a frame")
+{
+    const Sprite sprite = Sprite{ 0, 0, 0, 65535, 65535 };
+    for (uint32_t count : particle_counts)
+    {
+        Particles particles;
+        initParticles(particles, count);
+        emitBenchmarkParticles(particles, count);
+        QuadInstance* quads = new QuadInstance[count];
+
+        const std::string name =
+            "writeParticleQuads instanced [" + std::to_string(count) + " particles]";
+        BENCHMARK(name.c_str())
+        {
+            writeParticleQuads(particles, sprite, QuadMode::Instanced, quads);
+            return quads[count - 1].color;
+        };
+
+        delete[] quads;
+        destroyParticles(particles);
+    }
+}
@@ -0,0 +1,128 @@
+#include <catch.hpp>
+
+#include <matrix.h>
+#include <quad_queue.h>
+#include <renderer.h>
+
+namespace {
+
+constexpr uint32_t quad_count = 1024;
+constexpr uint32_t layer_count = 4;
+constexpr uint16_t texture_count = 2;
+constexpr uint32_t window_width = 720;
+constexpr uint32_t window_height = 480;
+// About what the game draws in a frame with a full board.
+constexpr uint32_t frame_quad_count = 300;
+
+// Roughly what a frame of the game draws: runs of quads on a few layers that
+// alternate between textures, with a retained layer in between.
+void pushFrame(QuadQueue& queue)
+{
+    clearQuadQueue(queue);
+    for (uint32_t index = 0; index < quad_count; index++)
+    {
+        const Sprite sprite = Sprite{
+            uint16_t(index / 64 % texture_count),
+            0,
+            0,
+            65535,
+            65535
+        };
+        const Color color = Color{ (index % 7) / 7.0f, 0.5f, 1 };
+        const DrawOrder order = DrawOrder{
+            uint8_t(index % layer_count),
+            quad_count - index
+        };
+        pushQuad(queue,
+                 float(index % 32) * 20,
+                 float(index / 32) * 20,
+                 20,
+                 20,
+                 sprite,
+                 color,
+                 order);
+    }
+    pushQuadLayer(queue, 0, 0, DrawOrder{ 1, 0 });
+}
+
+}
+
+TEST_CASE("Building quad batches")
+{
+    for (QuadMode mode : { QuadMode::Instanced, QuadMode::Indexed })
+    {
+        Arena arena;
+        initArena(arena, getQuadQueueSize(quad_count, 1, 1, mode));
+        QuadQueue queue = makeQuadQueue(arena, quad_count, 1, 1, mode);
+        static Quad output[quad_count];
+
+        BENCHMARK(mode == QuadMode::Instanced ?
+                  "pushQuad and flush instanced [1024 quads]" :
+                  "pushQuad and flush indexed [1024 quads]")
+        {
+            pushFrame(queue);
+            return flushQuadQueue(queue, output);
+        };
+
+        destroyArena(arena);
+    }
+}
+
+TEST_CASE("Drawing frames with the headless backends")
+{
+    for (RenderBackend backend : { RenderBackend::Recording, RenderBackend::Software })
+    {
+        initRenderer(
+            backend,
+            quad_count,
+            window_width,
+            window_height,
+            QuadMode::Instanced,
+            StreamBufferMode::Fenced,
+            nullptr);
+
+        BENCHMARK(backend == RenderBackend::Recording ?
+                  "Recording backend frame [300 quads]" :
+                  "Software backend frame [300 quads]")
+        {
+            beginDrawing();
+            for (uint32_t index = 0; index < frame_quad_count; index++)
+            {
+                drawQuad(float(index % 20) * 36,
+                         float(index / 20) * 32,
+                         30,
+                         30,
+                         Color{ (index % 7) / 7.0f, 0.5f, 1 },
+                         DrawOrder{ uint8_t(index % layer_count), index });
+            }
+            endDrawing();
+            return getRenderStats().quadCount;
+        };
+
+        destroyRenderer();
+    }
+}
+
+TEST_CASE("Building matrices")
+{
+    BENCHMARK_ADVANCED("makeOrthogonalProjectionMatrix")(
+        Catch::Benchmark::Chronometer meter)
+    {
+        meter.measure([](int run) {
+            const float width = float(720 + run % 64);
+            return makeOrthogonalProjectionMatrix(0, width, 0, 480, -1, 1);
+        });
+    };
+
+    BENCHMARK_ADVANCED("makeMatrix")(Catch::Benchmark::Chronometer meter)
+    {
+        meter.measure([](int run) {
+            const float value = float(run % 64);
+            return makeMatrix(
+                value, 0,     0,     1,
+                0,     value, 0,     2,
+                0,     0,     value, 3,
+                0,     0,     0,     1);
+        });
+    };
+}
@@ -0,0 +1,155 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <net/spectator_server.h>
+#include <net/spectator_stream.h>
+#include <simulation/input_source.h>
+#include <sys/resource.h>
+
+namespace {
+
+constexpr int32_t max_swarm_size = 512;
+constexpr int32_t measured_tick_count = 600;
+// The share of one core the server may take at the tick rate, which is what
+// the spectator count is reported for.
+constexpr double cpu_budget = 0.05;
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+void advanceGame(Game& game, uint32_t& random)
+{
+    if (game.over) {
+        game = makeGame(nextRandom(random));
+        return;
+    }
+    GameInput input = unpackGameInput(uint8_t(nextRandom(random)));
+    input.drop = nextRandom(random) % 16 == 0;
+    updateGame(game, input);
+}
+
+// Every spectator takes two descriptors on this machine, one for each end.
+int32_t getSwarmLimit()
+{
+    rlimit limit;
+    if (getrlimit(RLIMIT_NOFILE, &limit) == -1)
+        return 16;
+    const int64_t available = (int64_t(limit.rlim_cur) - 64) / 2;
+    return available < max_swarm_size ? int32_t(available) : max_swarm_size;
+}
+
+// Spectators on loopback, served by a server driven from this thread so
+// the time it takes can be told apart from the time the clients take.
+struct Swarm
+{
+    SpectatorServer server;
+    SpectatorClient* clients;
+    int32_t clientCount;
+    Game game;
+    uint32_t random;
+};
+
+bool openSwarm(Swarm& swarm, int32_t clientCount)
+{
+    if (!openSpectatorServer(swarm.server, 0, clientCount))
+        return false;
+    swarm.clients = new SpectatorClient[clientCount];
+    swarm.clientCount = 0;
+    for (int32_t index = 0; index < clientCount; index++)
+    {
+        if (!connectSpectatorClient(swarm.clients[index], makeLoopbackAddress(swarm.server.port)))
+            return false;
+        swarm.clientCount++;
+        pollSpectatorServer(swarm.server, 0);
+    }
+    for (int32_t attempt = 0; attempt < 1000 && swarm.server.spectatorCount < clientCount; attempt++)
+    {
+        pollSpectatorServer(swarm.server, 1);
+    }
+    swarm.game = makeGame(1);
+    swarm.random = 3;
+    return swarm.server.spectatorCount == clientCount;
+}
+
+void closeSwarm(Swarm& swarm)
+{
+    for (int32_t index = 0; index < swarm.clientCount; index++)
+    {
+        closeSpectatorClient(swarm.clients[index]);
+    }
+    delete[] swarm.clients;
+    closeSpectatorServer(swarm.server);
+}
+
+uint64_t runSwarmTick(Swarm& swarm)
+{
+    advanceGame(swarm.game, swarm.random);
+    publishSpectatorGame(swarm.server, swarm.game);
+    pollSpectatorServer(swarm.server, 0);
+    uint64_t frameCount = 0;
+    for (int32_t index = 0; index < swarm.clientCount; index++)
+    {
+        readSpectatorClient(swarm.clients[index]);
+        frameCount += swarm.clients[index].frameCount;
+    }
+    return frameCount;
+}
+
+}
+
+TEST_CASE("Broadcasting to spectators")
+{
+    const int32_t clientCount = getSwarmLimit() < 256 ? getSwarmLimit() : 256;
+    Swarm swarm;
+    REQUIRE(openSwarm(swarm, clientCount));
+
+    BENCHMARK("publish, fan out and receive a tick [256 spectators]")
+    {
+        return runSwarmTick(swarm);
+    };
+    CHECK(swarm.server.stats.resyncCount == 0);
+    closeSwarm(swarm);
+}
+
+// Only the server thread is measured, through the time it reports being
+// busy, and the count it could serve within the budget is extrapolated from
+// the largest swarm.
+TEST_CASE("Spectators served within a CPU budget")
+{
+    const double budgetPerTick = cpu_budget * 1e9 / tick_rate;
+    const int32_t swarmLimit = getSwarmLimit();
+    printf("\n%-12s %16s %16s\n", "Spectators", "Server us/tick", "us/spectator");
+
+    double costPerSpectator = 0;
+    for (int32_t clientCount = 16; clientCount <= swarmLimit; clientCount *= 2)
+    {
+        Swarm swarm;
+        REQUIRE(openSwarm(swarm, clientCount));
+        // Warms up the queues and sends every spectator its keyframe.
+        for (int32_t tick = 0; tick < 60; tick++)
+        {
+            runSwarmTick(swarm);
+        }
+
+        const uint64_t busyTime = swarm.server.stats.busyTime;
+        for (int32_t tick = 0; tick < measured_tick_count; tick++)
+        {
+            runSwarmTick(swarm);
+        }
+        const double perTick = double(swarm.server.stats.busyTime - busyTime) / measured_tick_count;
+        costPerSpectator = perTick / clientCount;
+        printf("%-12d %16.1f %16.3f\n", clientCount, perTick / 1e3, costPerSpectator / 1e3);
+        CHECK(swarm.server.stats.resyncCount == 0);
+        closeSwarm(swarm);
+    }
+
+    REQUIRE(costPerSpectator > 0);
+    printf("At %.0f%% of a core the server keeps up with about %.0f spectators\n\n",
+           cpu_budget * 100,
+           budgetPerTick / costPerSpectator);
+}
@@ -0,0 +1,58 @@
+#include <catch.hpp>
+
+#include <cmath>
+#include <string>
+#include <synth/kernel.h>
+#include <synth/oscillator.h>
+
+namespace {
+
+constexpr uint32_t sample_rate = 48000;
+constexpr int32_t block_size = 4096;
+
+// The per sample sinf generator the synth replaced, kept as a baseline.
+void generateSineWave(int16_t* buffer, int sampleCount, int soundFreq, int start)
+{
+    for (int i = 0; i < sampleCount; i++)
+    {
+        buffer[i] = (int16_t)(sinf((((i + start) % soundFreq) / (float)soundFreq) * 3.1415f) * (INT16_MAX / 4));
+    }
+}
+
+Wavetable wavetable;
+
+}
+
+TEST_CASE("Synthesizing a block of samples")
+{
+    static int16_t samples[block_size];
+
+    BENCHMARK("generateSineWave [4096 samples]")
+    {
+        generateSineWave(samples, block_size, sample_rate / 400, 0);
+        return samples[block_size - 1];
+    };
+
+    initWavetable(wavetable, Waveform::Square, sample_rate);
+    const SynthKernel original = getSynthKernel();
+    for (SynthKernel kernel :
+         { SynthKernel::Scalar, SynthKernel::Sse2, SynthKernel::Avx2 })
+    {
+        if (!isSynthKernelSupported(kernel))
+            continue;
+
+        setSynthKernel(kernel);
+        Oscillator oscillator = makeOscillator(wavetable, 440, 0.25f);
+        Envelope envelope = makeEnvelope(0.01f, 0.1f, 0.5f, 0.1f, sample_rate);
+        noteOn(envelope);
+
+        const std::string name =
+            std::string("renderTone ") + getSynthKernelName(kernel) + " [4096 samples]";
+        BENCHMARK(name.c_str())
+        {
+            renderTone(oscillator, envelope, samples, block_size);
+            return samples[block_size - 1];
+        };
+    }
+    setSynthKernel(original);
+}
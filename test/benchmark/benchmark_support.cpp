@@ -0,0 +1,72 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+namespace {
+
+// Benchmarks whose name ends in "[<count> <unit>]" process that many items
+// per run. For those the mean run time is also reported as a throughput once
+// all benchmarks have finished, so it does not interleave with the table of
+// the console reporter.
+struct ThroughputListener : Catch::TestEventListenerBase
+{
+    using TestEventListenerBase::TestEventListenerBase;
+
+    std::vector<std::string> lines;
+
+    void benchmarkEnded(const Catch::BenchmarkStats<>& stats) override
+    {
+        const std::string& name = stats.info.name;
+        const size_t open = name.rfind('[');
+        if (open == std::string::npos || name.back() != ']')
+            return;
+
+        char* unit = nullptr;
+        const double count = strtod(name.c_str() + open + 1, &unit);
+        if (unit == name.c_str() + open + 1 || count <= 0)
+            return;
+        while (*unit == ' ')
+        {
+            unit++;
+        }
+
+        const double seconds = stats.mean.point.count() * 1e-9;
+        char line[256];
+        snprintf(line,
+                 sizeof(line),
+                 "%-48s %12.4g %.*s/s",
+                 name.substr(0, open).c_str(),
+                 count / seconds,
+                 int(name.c_str() + name.size() - 1 - unit),
+                 unit);
+        lines.push_back(line);
+    }
+
+    void testRunEnded(const Catch::TestRunStats&) override
+    {
+        if (lines.empty())
+            return;
+
+        stream << "\nThroughput\n";
+        for (const std::string& line : lines)
+        {
+            stream << line << "\n";
+        }
+        stream << "\n";
+    }
+};
+
+}
+
+CATCH_REGISTER_LISTENER(ThroughputListener)
+
+// The benchmarking code still raises errors through exceptions. With those
+// disabled Catch hands them to this function instead.
+void Catch::throw_exception(const std::exception& exception)
+{
+    fprintf(stderr, "[BENCHMARK] %s\n", exception.what());
+    abort();
+}
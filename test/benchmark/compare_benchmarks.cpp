@@ -0,0 +1,223 @@
+// Compares two result files written by the xml reporter of benchmark_test and
+// reports the benchmarks whose mean got slower by more than a threshold.
+//
+//     compare_benchmarks <baseline.xml> <current.xml> [--threshold=<percent>]
+//
+// Exits with 1 when there is a regression, so it can gate a build.
+
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr double default_threshold = 5;
+
+struct BenchmarkResult
+{
+    std::string name;
+    // Nanoseconds per run.
+    double mean;
+};
+
+bool readFile(const char* path, std::string& contents)
+{
+    FILE* file = fopen(path, "rb");
+    if (file == nullptr)
+        return false;
+
+    char buffer[4096];
+    size_t size;
+    while ((size = fread(buffer, 1, sizeof(buffer), file)) > 0)
+    {
+        contents.append(buffer, size);
+    }
+    fclose(file);
+    return true;
+}
+
+std::string unescape(const std::string& text)
+{
+    static const struct { const char* entity; char character; } entities[] = {
+        { "&quot;", '"' },
+        { "&apos;", '\'' },
+        { "&lt;", '<' },
+        { "&gt;", '>' },
+        { "&amp;", '&' }
+    };
+
+    std::string result;
+    for (size_t index = 0; index < text.size(); index++)
+    {
+        bool replaced = false;
+        for (const auto& entity : entities)
+        {
+            const size_t length = strlen(entity.entity);
+            if (text.compare(index, length, entity.entity) == 0) {
+                result += entity.character;
+                index += length - 1;
+                replaced = true;
+                break;
+            }
+        }
+        if (!replaced)
+            result += text[index];
+    }
+    return result;
+}
+
+// Returns the value of the attribute of the element starting at position.
+bool readAttribute(const std::string& xml,
+                   size_t position,
+                   const char* attribute,
+                   std::string& value)
+{
+    const size_t end = xml.find('>', position);
+    const std::string prefix = std::string(" ") + attribute + "=\"";
+    const size_t start = xml.find(prefix, position);
+    if (start == std::string::npos || start > end)
+        return false;
+
+    const size_t first = start + prefix.size();
+    const size_t last = xml.find('"', first);
+    if (last == std::string::npos)
+        return false;
+
+    value = unescape(xml.substr(first, last - first));
+    return true;
+}
+
+bool readResults(const char* path, std::vector<BenchmarkResult>& results)
+{
+    std::string xml;
+    if (!readFile(path, xml)) {
+        fprintf(stderr, "Could not read %s\n", path);
+        return false;
+    }
+
+    size_t position = 0;
+    while ((position = xml.find("<BenchmarkResults", position)) != std::string::npos)
+    {
+        BenchmarkResult result;
+        std::string mean;
+        const size_t meanPosition = xml.find("<mean", position);
+        if (!readAttribute(xml, position, "name", result.name) ||
+            meanPosition == std::string::npos ||
+            !readAttribute(xml, meanPosition, "value", mean)) {
+            fprintf(stderr, "Malformed benchmark results in %s\n", path);
+            return false;
+        }
+        result.mean = strtod(mean.c_str(), nullptr);
+        results.push_back(result);
+        position = meanPosition;
+    }
+
+    if (results.empty()) {
+        fprintf(stderr, "No benchmark results in %s\n", path);
+        return false;
+    }
+    return true;
+}
+
+const BenchmarkResult* findResult(const std::vector<BenchmarkResult>& results,
+                                  const std::string& name)
+{
+    for (const BenchmarkResult& result : results)
+    {
+        if (result.name == name)
+            return &result;
+    }
+    return nullptr;
+}
+
+void formatTime(double nanoseconds, char* text, size_t size)
+{
+    if (nanoseconds >= 1e6)
+        snprintf(text, size, "%.3f ms", nanoseconds / 1e6);
+    else if (nanoseconds >= 1e3)
+        snprintf(text, size, "%.3f us", nanoseconds / 1e3);
+    else
+        snprintf(text, size, "%.3f ns", nanoseconds);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const char* paths[2] = {};
+    int32_t pathCount = 0;
+    double threshold = default_threshold;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strncmp(argv[index], "--threshold=", 12) == 0)
+            threshold = strtod(argv[index] + 12, nullptr);
+        else if (pathCount < 2)
+            paths[pathCount++] = argv[index];
+    }
+    if (pathCount != 2 || threshold <= 0) {
+        fprintf(stderr,
+                "Usage: %s <baseline.xml> <current.xml> [--threshold=<percent>]\n",
+                argv[0]);
+        return 2;
+    }
+
+    std::vector<BenchmarkResult> baseline;
+    std::vector<BenchmarkResult> current;
+    if (!readResults(paths[0], baseline) || !readResults(paths[1], current))
+        return 2;
+
+    int32_t regressionCount = 0;
+    printf("%-48s %12s %12s %9s\n", "Benchmark", "Baseline", "Current", "Change");
+    for (const BenchmarkResult& result : current)
+    {
+        char currentTime[32];
+        formatTime(result.mean, currentTime, sizeof(currentTime));
+
+        const BenchmarkResult* previous = findResult(baseline, result.name);
+        if (previous == nullptr) {
+            printf("%-48s %12s %12s %9s\n",
+                   result.name.c_str(),
+                   "-",
+                   currentTime,
+                   "new");
+            continue;
+        }
+
+        char baselineTime[32];
+        formatTime(previous->mean, baselineTime, sizeof(baselineTime));
+        const double change = (result.mean / previous->mean - 1) * 100;
+        const bool regressed = change > threshold;
+        regressionCount += regressed;
+        printf("%-48s %12s %12s %+8.1f%%%s\n",
+               result.name.c_str(),
+               baselineTime,
+               currentTime,
+               change,
+               regressed ? "  REGRESSION" : "");
+    }
+    for (const BenchmarkResult& result : baseline)
+    {
+        if (findResult(current, result.name) != nullptr)
+            continue;
+
+        char baselineTime[32];
+        formatTime(result.mean, baselineTime, sizeof(baselineTime));
+        printf("%-48s %12s %12s %9s\n",
+               result.name.c_str(),
+               baselineTime,
+               "-",
+               "removed");
+    }
+
+    if (regressionCount > 0) {
+        printf("\n%d benchmark(s) got more than %.1f%% slower\n",
+               regressionCount,
+               threshold);
+        return 1;
+    }
+    printf("\nNo benchmark got more than %.1f%% slower\n", threshold);
+    return 0;
+}
@@ -0,0 +1,168 @@
+// Starts the game over and over until it presents its first frame and
+// reports the median time of every startup phase. The cold runs start with
+// an empty shader program cache, the warm runs with the programs the cold
+// runs left behind.
+//
+//     startup_benchmark <tetris> [--runs=<count>] [--budget-ms=<milliseconds>]
+//
+// The game opens a window, so this needs a display. Exits with 1 when the
+// median cold start takes longer than the budget.
+
+#include <algorithm>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <string>
+#include <unistd.h>
+#include <vector>
+
+namespace {
+
+constexpr int32_t default_run_count = 5;
+// The same budget the game reports against.
+constexpr double default_budget_ms = 500;
+
+struct PhaseTime
+{
+    std::string name;
+    // Milliseconds since the game entered main.
+    double begin;
+    double end;
+};
+
+using StartupRun = std::vector<PhaseTime>;
+
+void clearDirectory(const std::string& directory)
+{
+    DIR* entries = opendir(directory.c_str());
+    if (entries == nullptr)
+        return;
+    while (const dirent* entry = readdir(entries))
+    {
+        if (strcmp(entry->d_name, ".") != 0 && strcmp(entry->d_name, "..") != 0)
+            unlink((directory + "/" + entry->d_name).c_str());
+    }
+    closedir(entries);
+}
+
+// Runs the game once and reads back the times it prints.
+bool runGame(const char* game, const std::string& cacheDirectory, StartupRun& run)
+{
+    const std::string command = std::string("'") + game +
+        "' --startup-times --quit-after-startup --program-cache='" +
+        cacheDirectory + "'";
+    FILE* output = popen(command.c_str(), "r");
+    if (output == nullptr)
+        return false;
+
+    char line[256];
+    while (fgets(line, sizeof(line), output) != nullptr)
+    {
+        char name[32];
+        PhaseTime phase;
+        if (sscanf(line, "Startup %31s %lf ms to %lf ms", name, &phase.begin, &phase.end) == 3) {
+            phase.name = name;
+            run.push_back(phase);
+        }
+    }
+    return pclose(output) == 0 && !run.empty();
+}
+
+double getMedian(std::vector<double> values)
+{
+    std::sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+    return values.size() % 2 == 1 ?
+        values[middle] :
+        (values[middle - 1] + values[middle]) / 2;
+}
+
+// The median time the phase took in the runs, or when it ended if ended is
+// set.
+double getMedianPhaseTime(const std::vector<StartupRun>& runs, size_t phase, bool ended)
+{
+    std::vector<double> times;
+    for (const StartupRun& run : runs)
+    {
+        times.push_back(ended ? run[phase].end : run[phase].end - run[phase].begin);
+    }
+    return getMedian(times);
+}
+
+}
+
+int main(int argc, char* argv[])
+{
+    const char* game = nullptr;
+    int32_t runCount = default_run_count;
+    double budget = default_budget_ms;
+    for (int index = 1; index < argc; index++)
+    {
+        if (strncmp(argv[index], "--runs=", 7) == 0)
+            runCount = atoi(argv[index] + 7);
+        else if (strncmp(argv[index], "--budget-ms=", 12) == 0)
+            budget = strtod(argv[index] + 12, nullptr);
+        else if (game == nullptr)
+            game = argv[index];
+    }
+    if (game == nullptr || runCount < 1 || budget <= 0) {
+        fprintf(stderr,
+                "Usage: %s <tetris> [--runs=<count>] [--budget-ms=<milliseconds>]\n",
+                argv[0]);
+        return 2;
+    }
+
+    char cacheDirectory[] = "/tmp/tetris_programs_XXXXXX";
+    if (mkdtemp(cacheDirectory) == nullptr) {
+        fprintf(stderr, "Could not create a directory for the program cache\n");
+        return 2;
+    }
+
+    // Alternating keeps slow drifts of the machine from favoring either.
+    std::vector<StartupRun> coldRuns;
+    std::vector<StartupRun> warmRuns;
+    bool failed = false;
+    for (int32_t index = 0; index < runCount && !failed; index++)
+    {
+        StartupRun cold;
+        StartupRun warm;
+        clearDirectory(cacheDirectory);
+        failed = !runGame(game, cacheDirectory, cold) ||
+                 !runGame(game, cacheDirectory, warm) ||
+                 warm.size() != cold.size() ||
+                 (!coldRuns.empty() && cold.size() != coldRuns[0].size());
+        coldRuns.push_back(cold);
+        warmRuns.push_back(warm);
+    }
+    clearDirectory(cacheDirectory);
+    rmdir(cacheDirectory);
+    if (failed) {
+        fprintf(stderr, "%s did not start up or did not report its startup times\n", game);
+        return 2;
+    }
+
+    printf("Median of %d runs each\n\n", runCount);
+    printf("%-16s %12s %12s\n", "Phase", "Cold", "Warm");
+    for (size_t phase = 0; phase < coldRuns[0].size(); phase++)
+    {
+        printf("%-16s %9.2f ms %9.2f ms\n",
+               coldRuns[0][phase].name.c_str(),
+               getMedianPhaseTime(coldRuns, phase, false),
+               getMedianPhaseTime(warmRuns, phase, false));
+    }
+
+    // The first frame is the last phase.
+    const size_t lastPhase = coldRuns[0].size() - 1;
+    const double coldStart = getMedianPhaseTime(coldRuns, lastPhase, true);
+    const double warmStart = getMedianPhaseTime(warmRuns, lastPhase, true);
+    printf("%-16s %9.2f ms %9.2f ms\n", "first frame at", coldStart, warmStart);
+
+    if (coldStart > budget) {
+        printf("\nA cold start takes longer than the budget of %.0f ms\n", budget);
+        return 1;
+    }
+    printf("\nA cold start takes less than the budget of %.0f ms\n", budget);
+    return 0;
+}
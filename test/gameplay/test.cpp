@@ -1,4 +1,33 @@
-// This is just a placeholder.
+#include <catch.hpp>
 
-int main()
-{}
+#include <board/board.h>
+
+TEST_CASE("Filling four rows with vertical I pieces scores a tetris")
+{
+    Board board = makeBoard();
+
+    // The vertical I occupies the third column of its box.
+    for (int32_t column = 0; column < board_width - 1; column++)
+    {
+        REQUIRE(dropPiece(board, PieceType::I, 1, column - 2) == 0);
+    }
+    CHECK(dropPiece(board, PieceType::I, 1, board_width - 3) == 4);
+
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        CHECK(getRow(board, y) == 0);
+    }
+}
+
+TEST_CASE("Stacking pieces in one column tops out")
+{
+    Board board = makeBoard();
+
+    // The O spawns in rows 20 and 21, so the eleventh one locks right where
+    // it spawned.
+    for (int32_t piece = 0; piece < 11; piece++)
+    {
+        REQUIRE(dropPiece(board, PieceType::O, 0, piece_spawn_x) == 0);
+    }
+    CHECK(dropPiece(board, PieceType::O, 0, piece_spawn_x) == -1);
+}
@@ -0,0 +1,40 @@
+#include <catch.hpp>
+
+#include <bot/bot_player.h>
+#include <bot/evaluator.h>
+#include <bot/search.h>
+#include <simulation/game.h>
+#include <simulation/headless.h>
+#include <simulation/input_source.h>
+
+namespace {
+
+// Ten minutes of play.
+constexpr uint64_t max_tick_count = 10 * 60 * tick_rate;
+
+}
+
+TEST_CASE("The bot plays through ten minutes without topping out")
+{
+    BotOptions options = getDefaultBotOptions();
+    options.threadCount = 1;
+    options.maxDepth = 2;
+    // Long enough to always finish, so the game does not depend on timing.
+    options.timeBudget = std::chrono::seconds(10);
+    options.tableSizeLog2 = 16;
+
+    HeuristicWeights weights = getDefaultHeuristicWeights();
+    static Bot bot;
+    initBot(bot, options, makeHeuristicEvaluator(weights));
+    BotPlayer player = makeBotPlayer(bot);
+    InputSource source = makeBotInputSource(player);
+
+    const HeadlessReport report = runHeadless(source, 1, 1, max_tick_count);
+
+    CHECK(report.finishedGameCount == 0);
+    CHECK(report.tickCount == max_tick_count);
+    CHECK(report.lineCount > 500);
+    CHECK(player.searchCount > 0);
+
+    destroyBot(bot);
+}
@@ -0,0 +1,79 @@
+#include <catch.hpp>
+
+#include <simulation/game.h>
+#include <simulation/headless.h>
+#include <simulation/input_source.h>
+#include <vector>
+
+namespace {
+
+// Ten minutes of play, far longer than random input survives.
+constexpr uint64_t max_tick_count = 10 * 60 * tick_rate;
+
+bool haveSameBoard(const Game& first, const Game& second)
+{
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        if (getRow(first.board, y) != getRow(second.board, y))
+            return false;
+    }
+    return true;
+}
+
+}
+
+TEST_CASE("Random input plays thousands of games to the end")
+{
+    InputSource source = makeRandomInputSource(1);
+    const HeadlessReport report = runHeadless(source, 1, 2000, max_tick_count);
+
+    CHECK(report.gameCount == 2000);
+    CHECK(report.finishedGameCount == 2000);
+    CHECK(report.tickCount > report.gameCount);
+    CHECK(report.lineCount > 0);
+    CHECK(getTicksPerSecond(report) > 0);
+}
+
+TEST_CASE("Replaying the recorded input of a game plays it the same way")
+{
+    for (uint32_t seed = 1; seed <= 100; seed++)
+    {
+        CAPTURE(seed);
+        InputSource random = makeRandomInputSource(seed * 31);
+        Game game = makeGame(seed);
+        std::vector<uint8_t> inputs;
+        GameInput input;
+        while (!game.over)
+        {
+            REQUIRE(readInput(random, game, input));
+            inputs.push_back(packGameInput(input));
+            updateGame(game, input);
+        }
+
+        InputSource recording =
+            makeRecordedInputSource(inputs.data(), inputs.size());
+        Game replayed = makeGame(seed);
+        while (readInput(recording, replayed, input))
+        {
+            REQUIRE(!replayed.over);
+            updateGame(replayed, input);
+        }
+
+        CHECK(replayed.over);
+        CHECK(replayed.tick == game.tick);
+        CHECK(replayed.score == game.score);
+        CHECK(replayed.lines == game.lines);
+        CHECK(haveSameBoard(replayed, game));
+    }
+}
+
+TEST_CASE("Running headless stops once the recorded input runs out")
+{
+    const uint8_t inputs[10] = {};
+    InputSource source = makeRecordedInputSource(inputs, 10);
+    const HeadlessReport report = runHeadless(source, 1, 5, max_tick_count);
+
+    CHECK(report.gameCount == 1);
+    CHECK(report.finishedGameCount == 0);
+    CHECK(report.tickCount == 10);
+}
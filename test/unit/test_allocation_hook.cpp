@@ -0,0 +1,16 @@
+#include <catch.hpp>
+
+#include <util/allocation_hook.h>
+
+TEST_CASE("Heap allocations are counted per thread")
+{
+    const uint64_t before = getThreadAllocationCount();
+    int* value = new int(3);
+    const uint64_t after = getThreadAllocationCount();
+    delete value;
+
+    if (allocation_tracking_enabled)
+        CHECK(after == before + 1);
+    else
+        CHECK(after == 0);
+}
@@ -0,0 +1,53 @@
+#include <catch.hpp>
+
+#include <cstdint>
+#include <util/arena.h>
+
+TEST_CASE("Arenas hand out aligned memory in order")
+{
+    Arena arena;
+    initArena(arena, 256);
+
+    uint8_t* byte = allocateArray<uint8_t>(arena, 1);
+    uint64_t* words = allocateArray<uint64_t>(arena, 4);
+    CHECK(reinterpret_cast<uintptr_t>(words) % alignof(uint64_t) == 0);
+    CHECK(reinterpret_cast<uint8_t*>(words) > byte);
+    CHECK(arena.used <= 1 + alignof(uint64_t) + 4 * sizeof(uint64_t));
+
+    void* aligned = allocate(arena, 16, 64);
+    CHECK(reinterpret_cast<uintptr_t>(aligned) % 64 == 0);
+
+    destroyArena(arena);
+}
+
+TEST_CASE("Resetting an arena hands out the same memory again")
+{
+    Arena arena;
+    initArena(arena, 64);
+
+    uint32_t* first = allocateArray<uint32_t>(arena, 16);
+    CHECK(arena.used == 64);
+    resetArena(arena);
+    CHECK(arena.used == 0);
+    CHECK(allocateArray<uint32_t>(arena, 8) == first);
+    CHECK(arena.peak == 64);
+
+    destroyArena(arena);
+}
+
+TEST_CASE("ListViews can be made from an arena")
+{
+    Arena arena;
+    initArena(arena, 64);
+
+    ListView<int32_t> listView = makeListView<int32_t>(arena, 4);
+    CHECK(listView.capacity == 4);
+    CHECK(listView.count == 0);
+    add(listView, 3);
+    add(listView, 5);
+    CHECK(listView[0] == 3);
+    CHECK(listView[1] == 5);
+    CHECK(arena.used == 4 * sizeof(int32_t));
+
+    destroyArena(arena);
+}
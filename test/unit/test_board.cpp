@@ -0,0 +1,116 @@
+#include <catch.hpp>
+
+#include <board/board.h>
+
+TEST_CASE("Boards start empty")
+{
+    const Board board = makeBoard();
+
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        CHECK(getRow(board, y) == 0);
+    }
+}
+
+TEST_CASE("Board rows can be set")
+{
+    Board board = makeBoard();
+
+    setRow(board, 3, 0b1000000101);
+
+    CHECK(getRow(board, 3) == 0b1000000101);
+    CHECK(isOccupied(board, 0, 3));
+    CHECK(!isOccupied(board, 1, 3));
+    CHECK(isOccupied(board, 2, 3));
+    CHECK(isOccupied(board, 9, 3));
+}
+
+TEST_CASE("Pieces collide with the walls, floor and ceiling")
+{
+    const Board board = makeBoard();
+    const PieceMask mask = getPieceMask(PieceType::I, 1);
+
+    // The vertical I occupies the third column of its box.
+    CHECK(!collides(board, mask, -2, 0));
+    CHECK(collides(board, mask, -3, 0));
+    CHECK(!collides(board, mask, 7, 0));
+    CHECK(collides(board, mask, 8, 0));
+    CHECK(collides(board, mask, 0, -1));
+    CHECK(!collides(board, mask, 0, board_height - 4));
+    CHECK(collides(board, mask, 0, board_height - 3));
+}
+
+TEST_CASE("Pieces collide with the stack")
+{
+    Board board = makeBoard();
+    setRow(board, 0, 0b0000010000);
+    const PieceMask mask = getPieceMask(PieceType::O, 0);
+
+    // The O occupies the middle two columns of the top two rows of its box.
+    CHECK(collides(board, mask, 3, -2));
+    CHECK(collides(board, mask, 2, -2));
+    CHECK(!collides(board, mask, 1, -2));
+    CHECK(!collides(board, mask, 3, -1));
+}
+
+TEST_CASE("Dropped pieces land on the stack")
+{
+    Board board = makeBoard();
+    setRow(board, 0, 0b0000010000);
+    setRow(board, 1, 0b0000010000);
+
+    CHECK(dropPiece(board, PieceType::O, 0, 3) == 0);
+
+    CHECK(getRow(board, 2) == 0b0000110000);
+    CHECK(getRow(board, 3) == 0b0000110000);
+    CHECK(getRow(board, 4) == 0);
+}
+
+TEST_CASE("Full rows are cleared and the stack is compacted")
+{
+    Board board = makeBoard();
+    setRow(board, 0, 0b1111111110);
+    setRow(board, 1, 0b0101010100);
+    setRow(board, 2, 0b1111111110);
+    setRow(board, 3, 0b1111111110);
+    setRow(board, 4, 0b0000000010);
+
+    // A vertical I in the first column fills rows 0 to 3.
+    CHECK(dropPiece(board, PieceType::I, 1, -2) == 3);
+
+    CHECK(getRow(board, 0) == 0b0101010101);
+    CHECK(getRow(board, 1) == 0b0000000010);
+    CHECK(getRow(board, 2) == 0);
+    CHECK(getRow(board, board_height - 1) == 0);
+}
+
+TEST_CASE("Pieces that cannot spawn are rejected")
+{
+    Board board = makeBoard();
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        setRow(board, y, 0b0000010000);
+    }
+
+    CHECK(dropPiece(board, PieceType::O, 0, 3) == -1);
+    CHECK(dropPiece(board, PieceType::O, 0, -2) == -1);
+    CHECK(getRow(board, 0) == 0b0000010000);
+}
+
+TEST_CASE("Garbage pushes the stack up")
+{
+    Board board = makeBoard();
+    setRow(board, 0, 0b0000110000);
+    setRow(board, board_height - 3, 0b0000000001);
+
+    CHECK(addGarbageRows(board, 2, 3));
+
+    CHECK(getRow(board, 0) == 0b1111110111);
+    CHECK(getRow(board, 1) == 0b1111110111);
+    CHECK(getRow(board, 2) == 0b0000110000);
+    CHECK(getRow(board, board_height - 1) == 0b0000000001);
+
+    CHECK(!addGarbageRows(board, 1, 0));
+    CHECK(getRow(board, 0) == 0b1111111110);
+    CHECK(getRow(board, board_height - 1) == 0);
+}
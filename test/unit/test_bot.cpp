@@ -0,0 +1,192 @@
+#include <catch.hpp>
+
+#include <bot/bot_player.h>
+#include <bot/evaluator.h>
+#include <bot/placement.h>
+#include <bot/search.h>
+#include <bot/transposition_table.h>
+#include <board/board.h>
+#include <simulation/game.h>
+
+namespace {
+
+constexpr uint16_t full_cells = (1u << board_width) - 1;
+
+ActivePiece getSpawnedPiece(PieceType type)
+{
+    return ActivePiece{ type, 0, piece_spawn_x, piece_spawn_y };
+}
+
+BotOptions getTestBotOptions(int32_t threadCount, int32_t maxDepth)
+{
+    BotOptions options = getDefaultBotOptions();
+    options.threadCount = threadCount;
+    options.maxDepth = maxDepth;
+    // Long enough to always finish, so the results do not depend on timing.
+    options.timeBudget = std::chrono::seconds(60);
+    options.tableSizeLog2 = 16;
+    return options;
+}
+
+bool containsPlacement(const PlacementList& placements,
+                       int32_t rotation,
+                       int32_t x,
+                       int32_t y)
+{
+    for (int32_t index = 0; index < placements.count; index++)
+    {
+        const Placement& placement = placements.placements[index];
+        if (placement.rotation == rotation && placement.x == x && placement.y == y)
+            return true;
+    }
+    return false;
+}
+
+}
+
+TEST_CASE("Placements on an empty board are listed once per set of cells")
+{
+    const Board board = makeBoard();
+    static PlacementSearch search;
+    PlacementList placements;
+
+    findPlacements(board, getSpawnedPiece(PieceType::O), search, placements);
+    CHECK(placements.count == board_width - 1);
+
+    findPlacements(board, getSpawnedPiece(PieceType::I), search, placements);
+    CHECK(placements.count == board_width - 3 + board_width);
+
+    findPlacements(board, getSpawnedPiece(PieceType::T), search, placements);
+    CHECK(placements.count == 2 * (board_width - 2) + 2 * (board_width - 1));
+}
+
+TEST_CASE("Placements include tucks under overhangs")
+{
+    // A roof over the two leftmost columns, with room for an O under it.
+    Board board = makeBoard();
+    setRow(board, 2, 0x3);
+    static PlacementSearch search;
+    PlacementList placements;
+    findPlacements(board, getSpawnedPiece(PieceType::O), search, placements);
+
+    // The O covers the two middle columns and rows of its box.
+    CHECK(containsPlacement(placements, 0, -1, 1));
+    REQUIRE(containsPlacement(placements, 0, -1, -2));
+
+    for (int32_t index = 0; index < placements.count; index++)
+    {
+        const Placement& placement = placements.placements[index];
+        if (placement.x != -1 || placement.y != -2)
+            continue;
+
+        PieceMove moves[max_path_length];
+        const int32_t length = getPlacementPath(search, placement, moves);
+        ActivePiece piece = getSpawnedPiece(PieceType::O);
+        for (int32_t move = 0; move < length; move++)
+        {
+            REQUIRE(applyPieceMove(board, piece, moves[move]));
+        }
+        // Soft dropped next to the roof, then shifted under it.
+        REQUIRE(length >= 3);
+        CHECK(moves[length - 3] == PieceMove::Down);
+        CHECK(moves[length - 1] == PieceMove::Left);
+        CHECK(piece.x == -1);
+        CHECK(piece.y == -2);
+    }
+}
+
+TEST_CASE("Board hashes tell boards apart")
+{
+    Board board = makeBoard();
+    const uint64_t empty = hashBoard(board);
+    setRow(board, 0, 1);
+    const uint64_t single = hashBoard(board);
+    setRow(board, 0, 2);
+    const uint64_t moved = hashBoard(board);
+    setRow(board, 0, 3);
+
+    CHECK(empty == 0);
+    CHECK(single != moved);
+    CHECK(hashBoard(board) == (single ^ moved));
+}
+
+TEST_CASE("Transposition tables forget values from earlier searches")
+{
+    static TranspositionTable table;
+    initTranspositionTable(table, 8);
+
+    float value = 0;
+    CHECK(!probeTranspositionTable(table, 12345, value));
+    storeTranspositionTable(table, 12345, 2.5f);
+    REQUIRE(probeTranspositionTable(table, 12345, value));
+    CHECK(value == 2.5f);
+    // The same slot, but another key.
+    CHECK(!probeTranspositionTable(table, 12345 + 256, value));
+
+    advanceTranspositionTable(table);
+    CHECK(!probeTranspositionTable(table, 12345, value));
+
+    destroyTranspositionTable(table);
+}
+
+TEST_CASE("The bot takes the tetris it is given")
+{
+    Game game = makeGame(1);
+    // A well in the rightmost column, and an I piece to fill it.
+    for (int32_t y = 0; y < 4; y++)
+    {
+        setRow(game.board, y, full_cells >> 1);
+    }
+    game.piece = getSpawnedPiece(PieceType::I);
+
+    const HeuristicWeights weights = getDefaultHeuristicWeights();
+    static Bot bot;
+    initBot(bot, getTestBotOptions(2, 2), makeHeuristicEvaluator(weights));
+    const BotMove move = searchBotMove(bot, game);
+    destroyBot(bot);
+
+    CHECK(!move.hold);
+    CHECK(move.type == PieceType::I);
+    CHECK(move.depth == 2);
+    Board board = game.board;
+    CHECK(applyPlacement(board, PieceType::I, move.placement) == 4);
+}
+
+TEST_CASE("The bot finds the same move with any number of threads")
+{
+    const HeuristicWeights weights = getDefaultHeuristicWeights();
+    static Bot bot;
+    BotMove moves[2];
+    const int32_t threadCounts[2] = { 1, 4 };
+    for (int32_t index = 0; index < 2; index++)
+    {
+        Game game = makeGame(7);
+        setRow(game.board, 0, 0x1EF);
+        setRow(game.board, 1, 0x0C6);
+        initBot(bot, getTestBotOptions(threadCounts[index], 3), makeHeuristicEvaluator(weights));
+        moves[index] = searchBotMove(bot, game);
+        destroyBot(bot);
+    }
+
+    CHECK(moves[0].depth == 3);
+    CHECK(moves[1].depth == 3);
+    CHECK(moves[0].hold == moves[1].hold);
+    CHECK(moves[0].placement.rotation == moves[1].placement.rotation);
+    CHECK(moves[0].placement.x == moves[1].placement.x);
+    CHECK(moves[0].placement.y == moves[1].placement.y);
+    CHECK(moves[0].value == moves[1].value);
+}
+
+TEST_CASE("The bot stops deepening once the time budget runs out")
+{
+    const HeuristicWeights weights = getDefaultHeuristicWeights();
+    BotOptions options = getTestBotOptions(1, max_search_depth);
+    options.timeBudget = std::chrono::microseconds(0);
+    static Bot bot;
+    initBot(bot, options, makeHeuristicEvaluator(weights));
+    const BotMove move = searchBotMove(bot, makeGame(3));
+    destroyBot(bot);
+
+    // Looking at the current piece alone always finishes.
+    CHECK(move.depth == 1);
+}
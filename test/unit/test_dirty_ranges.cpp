@@ -0,0 +1,63 @@
+#include <catch.hpp>
+
+#include <util/dirty_ranges.h>
+
+TEST_CASE("DirtyRanges merge overlapping and touching ranges")
+{
+    DirtyRanges dirty = {};
+
+    markDirty(dirty, 10, 20);
+    markDirty(dirty, 30, 40);
+    REQUIRE(dirty.count == 2);
+
+    markDirty(dirty, 20, 25);
+    REQUIRE(dirty.count == 2);
+    CHECK(dirty.ranges[0].first == 10);
+    CHECK(dirty.ranges[0].end == 25);
+
+    markDirty(dirty, 24, 31);
+    REQUIRE(dirty.count == 1);
+    CHECK(dirty.ranges[0].first == 10);
+    CHECK(dirty.ranges[0].end == 40);
+}
+
+TEST_CASE("DirtyRanges stay sorted")
+{
+    DirtyRanges dirty = {};
+
+    markDirty(dirty, 50, 60);
+    markDirty(dirty, 10, 20);
+    markDirty(dirty, 30, 40);
+
+    REQUIRE(dirty.count == 3);
+    CHECK(dirty.ranges[0].first == 10);
+    CHECK(dirty.ranges[1].first == 30);
+    CHECK(dirty.ranges[2].first == 50);
+}
+
+TEST_CASE("DirtyRanges merge the closest ranges when full")
+{
+    DirtyRanges dirty = {};
+    for (uint32_t index = 0; index < max_dirty_range_count; index++)
+    {
+        markDirty(dirty, index * 10, index * 10 + 1);
+    }
+    // Leaves a smaller gap to the range before it than any other two have.
+    markDirty(dirty, 100, 110);
+    markDirty(dirty, 112, 113);
+
+    REQUIRE(dirty.count == max_dirty_range_count);
+    uint32_t covered = 0;
+    for (int32_t index = 0; index < dirty.count; index++)
+    {
+        if (index > 0)
+            CHECK(dirty.ranges[index - 1].end < dirty.ranges[index].first);
+        covered += dirty.ranges[index].end - dirty.ranges[index].first;
+    }
+    CHECK(dirty.ranges[dirty.count - 1].first == 100);
+    CHECK(dirty.ranges[dirty.count - 1].end == 113);
+    CHECK(covered >= max_dirty_range_count + 13);
+
+    clearDirty(dirty);
+    CHECK(dirty.count == 0);
+}
@@ -0,0 +1,60 @@
+#include <catch.hpp>
+
+#include <util/fixed_timestep.h>
+
+TEST_CASE("FixedTimesteps produce one tick per tick length")
+{
+    FixedTimestep timestep = makeFixedTimestep(60, 15, 6000, 0);
+
+    CHECK(advanceFixedTimestep(timestep, 99) == 0);
+    CHECK(advanceFixedTimestep(timestep, 100) == 1);
+    CHECK(advanceFixedTimestep(timestep, 150) == 0);
+    CHECK(advanceFixedTimestep(timestep, 400) == 3);
+    CHECK(timestep.tickCount == 4);
+}
+
+TEST_CASE("FixedTimesteps do not drift with uneven counter frequencies")
+{
+    // A 144 Hz display polling a 60 Hz schedule off a counter that does not
+    // divide evenly into ticks.
+    FixedTimestep timestep = makeFixedTimestep(60, 15, 1000003, 0);
+
+    uint64_t counter = 0;
+    uint64_t ticks = 0;
+    for (int32_t frame = 0; frame < 144 * 60; frame++)
+    {
+        counter += 1000003 / 144;
+        ticks += advanceFixedTimestep(timestep, counter);
+    }
+
+    CHECK(ticks == (counter * 60) / 1000003);
+}
+
+TEST_CASE("FixedTimesteps drop time beyond the catch up limit")
+{
+    FixedTimestep timestep = makeFixedTimestep(60, 15, 6000, 0);
+
+    CHECK(advanceFixedTimestep(timestep, 100 * 100 + 50) == 15);
+    CHECK(advanceFixedTimestep(timestep, 100 * 100 + 100) == 1);
+}
+
+TEST_CASE("FixedTimesteps can be reset")
+{
+    FixedTimestep timestep = makeFixedTimestep(60, 15, 6000, 0);
+
+    CHECK(advanceFixedTimestep(timestep, 150) == 1);
+    resetFixedTimestep(timestep, 1000);
+    CHECK(advanceFixedTimestep(timestep, 1099) == 0);
+    CHECK(advanceFixedTimestep(timestep, 1100) == 1);
+}
+
+TEST_CASE("FixedTimesteps tell when the next tick is due")
+{
+    FixedTimestep timestep = makeFixedTimestep(60, 15, 6000, 0);
+
+    CHECK(getCounterUntilNextTick(timestep) == 100);
+    CHECK(advanceFixedTimestep(timestep, 130) == 1);
+    CHECK(getCounterUntilNextTick(timestep) == 70);
+    CHECK(advanceFixedTimestep(timestep, 199) == 0);
+    CHECK(advanceFixedTimestep(timestep, 200) == 1);
+}
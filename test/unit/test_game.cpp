@@ -0,0 +1,146 @@
+#include <catch.hpp>
+
+#include <simulation/game.h>
+
+TEST_CASE("Games spawn the first piece at the top")
+{
+    const Game game = makeGame(1);
+
+    CHECK(!game.over);
+    CHECK(game.piece.x == piece_spawn_x);
+    CHECK(game.piece.y == piece_spawn_y);
+    CHECK(game.piece.rotation == 0);
+}
+
+TEST_CASE("Gravity moves the active piece down")
+{
+    Game game = makeGame(1);
+
+    for (int32_t tick = 0; tick < 47; tick++)
+    {
+        updateGame(game, GameInput{});
+    }
+    CHECK(game.piece.y == piece_spawn_y);
+
+    updateGame(game, GameInput{});
+    CHECK(game.piece.y == piece_spawn_y - 1);
+}
+
+TEST_CASE("Held shift buttons repeat after a delay")
+{
+    Game game = makeGame(1);
+    GameInput input = {};
+    input.right = true;
+
+    updateGame(game, input);
+    CHECK(game.piece.x == piece_spawn_x + 1);
+
+    for (int32_t tick = 0; tick < 9; tick++)
+    {
+        updateGame(game, input);
+    }
+    CHECK(game.piece.x == piece_spawn_x + 1);
+
+    updateGame(game, input);
+    CHECK(game.piece.x == piece_spawn_x + 2);
+}
+
+TEST_CASE("Rotations only trigger when the button is pressed")
+{
+    Game game = makeGame(1);
+    GameInput input = {};
+    input.turnRight = true;
+
+    updateGame(game, input);
+    CHECK(game.piece.rotation == 1);
+
+    updateGame(game, input);
+    CHECK(game.piece.rotation == 1);
+}
+
+TEST_CASE("Hard drops lock the piece and spawn the next one")
+{
+    Game game = makeGame(1);
+    const PieceType next = game.previews[0];
+    GameInput input = {};
+    input.drop = true;
+
+    updateGame(game, input);
+
+    CHECK(game.piece.type == next);
+    CHECK(game.piece.y == piece_spawn_y);
+    CHECK(getRow(game.board, 0) != 0);
+    CHECK(game.events == (game_event_hard_dropped | game_event_locked));
+
+    input.drop = false;
+    updateGame(game, input);
+    CHECK(game.events == 0);
+}
+
+TEST_CASE("Pieces can be held once per drop")
+{
+    Game game = makeGame(1);
+    const PieceType first = game.piece.type;
+    const PieceType next = game.previews[0];
+    GameInput input = {};
+    input.swap = true;
+
+    updateGame(game, input);
+
+    CHECK(game.hasHold);
+    CHECK(game.hold == first);
+    CHECK(game.piece.type == next);
+
+    updateGame(game, GameInput{});
+    updateGame(game, input);
+
+    CHECK(game.hold == first);
+    CHECK(game.piece.type == next);
+}
+
+TEST_CASE("The first seven pieces contain every piece type")
+{
+    for (uint32_t seed = 1; seed <= 20; seed++)
+    {
+        Game game = makeGame(seed);
+        GameInput input = {};
+
+        int32_t counts[piece_type_count] = {};
+        for (int32_t piece = 0; piece < piece_type_count; piece++)
+        {
+            counts[int32_t(game.piece.type)]++;
+            input.drop = true;
+            updateGame(game, input);
+            input.drop = false;
+            updateGame(game, input);
+        }
+        for (int32_t type = 0; type < piece_type_count; type++)
+        {
+            CHECK(counts[type] == 1);
+        }
+    }
+}
+
+TEST_CASE("Games with the same seed and inputs stay identical")
+{
+    Game first = makeGame(42);
+    Game second = makeGame(42);
+    GameInput input = {};
+
+    for (int32_t tick = 0; tick < 2000; tick++)
+    {
+        input.left = (tick / 7) % 3 == 0;
+        input.right = (tick / 11) % 4 == 0;
+        input.turnRight = (tick / 5) % 2 == 0;
+        input.drop = tick % 40 == 0;
+        updateGame(first, input);
+        updateGame(second, input);
+    }
+
+    CHECK(first.score == second.score);
+    CHECK(first.tick == second.tick);
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        CHECK(getRow(first.board, y) == getRow(second.board, y));
+    }
+}
@@ -0,0 +1,187 @@
+#include <catch.hpp>
+
+#include <board/board.h>
+#include <climits>
+#include <cstring>
+#include <simulation/game.h>
+#include <simulation/game_batch.h>
+
+namespace {
+
+constexpr int32_t step_count = 300;
+constexpr int32_t max_sequence_length = step_count + preview_count + 1;
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// The pieces a game built from the seed deals, found by hard dropping each
+// of them on an empty board.
+void getPieceSequence(uint32_t seed, PieceType* pieces)
+{
+    Game game = makeGame(seed);
+    GameInput drop = {};
+    drop.drop = true;
+    for (int32_t index = 0; index < max_sequence_length; index++)
+    {
+        pieces[index] = game.piece.type;
+        game.board = makeBoard();
+        updateGame(game, drop);
+        updateGame(game, GameInput{});
+    }
+}
+
+// A game placed with dropPiece, to compare a batch game against.
+struct ReferenceGame
+{
+    Board board;
+    uint32_t seed;
+    PieceType pieces[max_sequence_length];
+    int32_t pieceIndex;
+};
+
+void startReferenceGame(ReferenceGame& game, uint32_t seed)
+{
+    game.board = makeBoard();
+    game.seed = seed;
+    getPieceSequence(seed, game.pieces);
+    game.pieceIndex = 0;
+}
+
+// Mostly the action that clears the most lines and otherwise lands the
+// lowest, to get line clears, and now and then any action, to top out.
+uint8_t pickAction(const ReferenceGame& game, uint32_t& random)
+{
+    if (nextRandom(random) % 8 == 0)
+        return uint8_t(nextRandom(random) % batch_action_count);
+
+    const PieceType type = game.pieces[game.pieceIndex];
+    uint8_t best = 0;
+    int32_t bestValue = INT32_MIN;
+    for (int32_t action = 0; action < batch_action_count; action++)
+    {
+        const int32_t rotation = action / batch_column_count;
+        const int32_t x = action % batch_column_count - board_left_wall;
+        const PieceMask mask = getPieceMask(type, rotation);
+        Board board = game.board;
+        const int32_t cleared = dropPiece(board, type, rotation, x);
+        if (cleared < 0)
+            continue;
+
+        const int32_t y = findDropRow(game.board, mask, x, piece_spawn_y);
+        const int32_t value = cleared * board_height - y;
+        if (value > bestValue) {
+            best = uint8_t(action);
+            bestValue = value;
+        }
+    }
+    return best;
+}
+
+void fillRandomActions(uint8_t* actions, int32_t count, uint32_t& random)
+{
+    for (int32_t index = 0; index < count; index++)
+    {
+        actions[index] = uint8_t(nextRandom(random) % batch_action_count);
+    }
+}
+
+}
+
+TEST_CASE("Batch games place pieces like dropPiece")
+{
+    constexpr int32_t game_count = 37;
+    GameBatch batch;
+    initGameBatch(batch, game_count, 5, 1);
+    static ReferenceGame games[game_count];
+    for (int32_t game = 0; game < game_count; game++)
+    {
+        startReferenceGame(games[game], 5 + uint32_t(game));
+    }
+
+    uint32_t random = 1;
+    uint8_t actions[game_count];
+    int32_t doneCount = 0;
+    int32_t lineCount = 0;
+    for (int32_t step = 0; step < step_count; step++)
+    {
+        for (int32_t game = 0; game < game_count; game++)
+        {
+            actions[game] = pickAction(games[game], random);
+        }
+        stepGameBatch(batch, actions);
+
+        for (int32_t game = 0; game < game_count; game++)
+        {
+            CAPTURE(step, game);
+            ReferenceGame& reference = games[game];
+            const PieceType type = reference.pieces[reference.pieceIndex++];
+            const int32_t rotation = actions[game] / batch_column_count;
+            const int32_t x = actions[game] % batch_column_count - board_left_wall;
+            const int32_t cleared = dropPiece(reference.board, type, rotation, x);
+            const PieceType next = reference.pieces[reference.pieceIndex];
+            const bool done =
+                cleared < 0 ||
+                collides(reference.board, getPieceMask(next, 0), piece_spawn_x, piece_spawn_y);
+            REQUIRE(batch.dones[game] == done);
+            REQUIRE(batch.rewards[game] == (cleared > 0 ? cleared : 0));
+            if (done) {
+                doneCount++;
+                startReferenceGame(reference, reference.seed + game_count);
+            }
+            lineCount += cleared > 0 ? cleared : 0;
+
+            REQUIRE(batch.pieces[game] == reference.pieces[reference.pieceIndex]);
+            for (int32_t index = 0; index < preview_count; index++)
+            {
+                REQUIRE(batch.previews[index * batch.stride + game] ==
+                        reference.pieces[reference.pieceIndex + 1 + index]);
+            }
+            for (int32_t y = 0; y < board_height; y++)
+            {
+                REQUIRE(getBatchRow(batch, game, y) == getRow(reference.board, y));
+            }
+        }
+    }
+    CHECK(doneCount > 0);
+    CHECK(lineCount > 0);
+
+    destroyGameBatch(batch);
+}
+
+TEST_CASE("Batches step the same on any number of threads")
+{
+    constexpr int32_t game_count = 1000;
+    GameBatch single;
+    GameBatch several;
+    initGameBatch(single, game_count, 1, 1);
+    initGameBatch(several, game_count, 1, 4);
+    CHECK(several.chunkCount > 1);
+
+    // The arrays are read in place, so they must not move between steps.
+    const uint16_t* rows = several.rows;
+    const float* rewards = several.rewards;
+
+    uint32_t random = 7;
+    static uint8_t actions[game_count];
+    for (int32_t step = 0; step < 100; step++)
+    {
+        fillRandomActions(actions, game_count, random);
+        stepGameBatch(single, actions);
+        stepGameBatch(several, actions);
+
+        REQUIRE(memcmp(single.rows, several.rows, batch_row_count * single.stride * sizeof(uint16_t)) == 0);
+        REQUIRE(memcmp(single.rewards, several.rewards, game_count * sizeof(float)) == 0);
+        REQUIRE(memcmp(single.dones, several.dones, game_count) == 0);
+        REQUIRE(memcmp(single.pieces, several.pieces, game_count * sizeof(PieceType)) == 0);
+    }
+    CHECK(several.rows == rows);
+    CHECK(several.rewards == rewards);
+
+    destroyGameBatch(several);
+    destroyGameBatch(single);
+}
@@ -0,0 +1,173 @@
+#include <catch.hpp>
+
+#include <chrono>
+#include <simulation/game.h>
+#include <simulation/game_loop.h>
+#include <thread>
+#include <util/allocation_hook.h>
+
+namespace {
+
+// Rounded up, so that a tick is always due after it.
+constexpr uint64_t tick_time = 1000000000 / tick_rate + 1;
+
+struct LoopEvents
+{
+    int32_t tickCount;
+    int32_t pauseCount;
+    bool paused;
+};
+
+void countTick(void* context, const Game&)
+{
+    static_cast<LoopEvents*>(context)->tickCount++;
+}
+
+void countPause(void* context, bool paused)
+{
+    LoopEvents& events = *static_cast<LoopEvents*>(context);
+    events.pauseCount++;
+    events.paused = paused;
+}
+
+void initTestLoop(GameLoop& loop, LoopEvents& events, uint64_t time)
+{
+    initGameLoop(
+        loop,
+        makeGame(1),
+        GameLoopCallbacks{ countTick, countPause, &events },
+        nullptr,
+        nullptr,
+        time);
+}
+
+}
+
+TEST_CASE("Game loops publish the ticks that are due")
+{
+    static GameLoop loop;
+    LoopEvents events = {};
+    initTestLoop(loop, events, 1000);
+
+    REQUIRE(acquireGameSnapshot(loop));
+    CHECK(getGameSnapshot(loop).game.tick == 0);
+
+    updateGameLoop(loop, 1000 + tick_time / 2);
+    CHECK(!acquireGameSnapshot(loop));
+
+    updateGameLoop(loop, 1000 + 3 * tick_time);
+    REQUIRE(acquireGameSnapshot(loop));
+    CHECK(getGameSnapshot(loop).game.tick == 3);
+    CHECK(getGameSnapshot(loop).time == 1000 + 3 * tick_time);
+    CHECK(events.tickCount == 3);
+}
+
+TEST_CASE("Input posted to a game loop goes into the next tick")
+{
+    static GameLoop loop;
+    LoopEvents events = {};
+    initTestLoop(loop, events, 1000);
+    REQUIRE(acquireGameSnapshot(loop));
+    const PieceType first = getGameSnapshot(loop).game.piece.type;
+
+    GameInput drop = {};
+    drop.drop = true;
+    postInputEvent(loop, InputEvent{ drop, false, 1000 + tick_time / 4 });
+    updateGameLoop(loop, 1000 + tick_time / 2);
+    CHECK(!acquireGameSnapshot(loop));
+
+    updateGameLoop(loop, 1000 + tick_time);
+    REQUIRE(acquireGameSnapshot(loop));
+    const GameSnapshot& snapshot = getGameSnapshot(loop);
+    CHECK(snapshot.game.events & game_event_hard_dropped);
+    CHECK(snapshot.game.previousInput.drop);
+    CHECK(snapshot.game.piece.type != first);
+    CHECK(loop.lastInputLatency == tick_time - tick_time / 4);
+    CHECK(loop.inputLatencyCount == 1);
+}
+
+TEST_CASE("Game loops tick without allocating")
+{
+    static GameLoop loop;
+    LoopEvents events = {};
+    initTestLoop(loop, events, 1000);
+
+    // An allocation fails the run right where it happens.
+    const uint64_t allocationCount = getThreadAllocationCount();
+    setThreadAllocationsForbidden(true);
+    for (uint64_t tick = 1; tick <= 600; tick++)
+    {
+        GameInput input = {};
+        input.drop = tick % 30 == 0;
+        input.left = tick % 7 < 3;
+        postInputEvent(loop, InputEvent{ input, false, 1000 + tick * tick_time });
+        updateGameLoop(loop, 1000 + tick * tick_time);
+        acquireGameSnapshot(loop);
+    }
+    setThreadAllocationsForbidden(false);
+
+    CHECK(getThreadAllocationCount() == allocationCount);
+    CHECK(events.tickCount == 600);
+}
+
+TEST_CASE("Paused game loops do not tick")
+{
+    static GameLoop loop;
+    LoopEvents events = {};
+    initTestLoop(loop, events, 0);
+    REQUIRE(acquireGameSnapshot(loop));
+
+    GameInput none = {};
+    postInputEvent(loop, InputEvent{ none, true, 10 });
+    postInputEvent(loop, InputEvent{ none, false, 20 });
+    updateGameLoop(loop, 100);
+    REQUIRE(acquireGameSnapshot(loop));
+    CHECK(getGameSnapshot(loop).paused);
+    CHECK(events.paused);
+
+    updateGameLoop(loop, 10 * tick_time);
+    CHECK(!acquireGameSnapshot(loop));
+    CHECK(events.tickCount == 0);
+
+    // The time spent paused is not caught up on.
+    postInputEvent(loop, InputEvent{ none, true, 10 * tick_time });
+    updateGameLoop(loop, 10 * tick_time);
+    updateGameLoop(loop, 11 * tick_time);
+    REQUIRE(acquireGameSnapshot(loop));
+    CHECK(!getGameSnapshot(loop).paused);
+    CHECK(getGameSnapshot(loop).game.tick == 1);
+    CHECK(events.pauseCount == 2);
+}
+
+TEST_CASE("Game loops run on a thread of their own")
+{
+    static GameLoop loop;
+    initGameLoop(
+        loop,
+        makeGame(1),
+        GameLoopCallbacks{},
+        nullptr,
+        nullptr,
+        getSteadyTime());
+    startGameLoopThread(loop);
+
+    GameInput drop = {};
+    drop.drop = true;
+    postInputEvent(loop, InputEvent{ drop, false, getSteadyTime() });
+
+    // Generous, so that a busy machine does not fail the test.
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    bool dropped = false;
+    while (!dropped && std::chrono::steady_clock::now() < deadline)
+    {
+        if (acquireGameSnapshot(loop))
+            dropped = getGameSnapshot(loop).game.previousInput.drop;
+        else
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    stopGameLoopThread(loop);
+
+    CHECK(dropped);
+    CHECK(loop.inputLatencyCount == 1);
+    CHECK(loop.droppedInputCount == 0);
+}
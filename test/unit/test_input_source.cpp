@@ -0,0 +1,51 @@
+#include <catch.hpp>
+
+#include <simulation/input_source.h>
+
+TEST_CASE("Packed inputs unpack to the same buttons")
+{
+    for (uint32_t buttons = 0; buttons < 128; buttons++)
+    {
+        CAPTURE(buttons);
+        CHECK(packGameInput(unpackGameInput(uint8_t(buttons))) == buttons);
+    }
+
+    GameInput input = {};
+    input.drop = true;
+    input.turnRight = true;
+    CHECK(packGameInput(input) == (8 | 64));
+}
+
+TEST_CASE("Recorded input sources play back their inputs and run out")
+{
+    const uint8_t inputs[] = { 1, 0, 72 };
+    InputSource source = makeRecordedInputSource(inputs, 3);
+    const Game game = makeGame(1);
+
+    GameInput input;
+    for (uint8_t expected : inputs)
+    {
+        REQUIRE(readInput(source, game, input));
+        CHECK(packGameInput(input) == expected);
+    }
+    CHECK(!readInput(source, game, input));
+}
+
+TEST_CASE("Random input sources repeat for the same seed")
+{
+    InputSource first = makeRandomInputSource(7);
+    InputSource second = makeRandomInputSource(7);
+    const Game game = makeGame(1);
+
+    GameInput firstInput;
+    GameInput secondInput;
+    uint32_t pressedCount = 0;
+    for (int32_t tick = 0; tick < 1000; tick++)
+    {
+        REQUIRE(readInput(first, game, firstInput));
+        REQUIRE(readInput(second, game, secondInput));
+        REQUIRE(packGameInput(firstInput) == packGameInput(secondInput));
+        pressedCount += packGameInput(firstInput) != 0;
+    }
+    CHECK(pressedCount > 0);
+}
@@ -1,6 +1,6 @@
 #include <catch.hpp>
 
-#include <list_view.h>
+#include <util/list_view.h>
 
 TEST_CASE("ListViews can be constructed")
 {
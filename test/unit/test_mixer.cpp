@@ -0,0 +1,129 @@
+#include <catch.hpp>
+
+#include <synth/kernel.h>
+#include <synth/mixer.h>
+
+TEST_CASE("Mixers add voices to the existing samples")
+{
+    const int16_t data[4] = { 1000, -1000, 2000, -2000 };
+    const Sound sound = Sound{ data, 4 };
+    Mixer mixer = makeMixer();
+    int16_t samples[4] = { 10, 10, 10, 10 };
+
+    REQUIRE(playSound(mixer, sound, 0.5f, false) == 0);
+    mixVoices(mixer, samples, 4);
+
+    CHECK(samples[0] == 510);
+    CHECK(samples[1] == -490);
+    CHECK(samples[2] == 1010);
+    CHECK(samples[3] == -990);
+}
+
+TEST_CASE("Mixing saturates instead of wrapping around")
+{
+    const int16_t data[2] = { 30000, -30000 };
+    const Sound sound = Sound{ data, 2 };
+    Mixer mixer = makeMixer();
+    int16_t samples[2] = { 10000, -10000 };
+
+    playSound(mixer, sound, 1, false);
+    mixVoices(mixer, samples, 2);
+
+    CHECK(samples[0] == INT16_MAX);
+    CHECK(samples[1] == INT16_MIN);
+}
+
+TEST_CASE("One-shot voices stop at the end of their sound")
+{
+    const int16_t data[3] = { 100, 100, 100 };
+    const Sound sound = Sound{ data, 3 };
+    Mixer mixer = makeMixer();
+    int16_t samples[5] = {};
+
+    playSound(mixer, sound, 1, false);
+    mixVoices(mixer, samples, 5);
+
+    CHECK(samples[2] == 100);
+    CHECK(samples[3] == 0);
+    CHECK(getActiveVoiceCount(mixer) == 0);
+}
+
+TEST_CASE("Looping voices wrap around")
+{
+    const int16_t data[3] = { 1, 2, 3 };
+    const Sound sound = Sound{ data, 3 };
+    Mixer mixer = makeMixer();
+    int16_t samples[7] = {};
+
+    playSound(mixer, sound, 1, true);
+    mixVoices(mixer, samples, 7);
+
+    CHECK(samples[3] == 1);
+    CHECK(samples[6] == 1);
+    CHECK(getActiveVoiceCount(mixer) == 1);
+}
+
+TEST_CASE("Busy mixers take over the voice closest to finishing")
+{
+    static int16_t data[100] = {};
+    const Sound longSound = Sound{ data, 100 };
+    const Sound shortSound = Sound{ data, 10 };
+    Mixer mixer = makeMixer();
+
+    for (int32_t voice = 0; voice < mixer_voice_count; voice++)
+    {
+        const Sound& sound = voice == 7 ? shortSound : longSound;
+        REQUIRE(playSound(mixer, sound, 1, false) == voice);
+    }
+    CHECK(playSound(mixer, longSound, 1, false) == 7);
+
+    for (int32_t voice = 0; voice < mixer_voice_count; voice++)
+    {
+        stopVoice(mixer, voice);
+        playSound(mixer, longSound, 1, true);
+    }
+    CHECK(playSound(mixer, longSound, 1, false) == -1);
+}
+
+TEST_CASE("All mixing kernels produce the same samples")
+{
+    constexpr int32_t sample_count = 1003;
+    static int16_t data[sample_count];
+    for (int32_t index = 0; index < sample_count; index++)
+    {
+        data[index] = int16_t(index * 977);
+    }
+    const Sound sound = Sound{ data, sample_count };
+
+    const SynthKernel original = getSynthKernel();
+    int16_t reference[sample_count] = {};
+    for (SynthKernel kernel :
+         { SynthKernel::Scalar, SynthKernel::Sse2, SynthKernel::Avx2 })
+    {
+        if (!isSynthKernelSupported(kernel))
+            continue;
+
+        setSynthKernel(kernel);
+        Mixer mixer = makeMixer();
+        playSound(mixer, sound, 0.7f, false);
+        playSound(mixer, sound, 0.9f, false);
+        int16_t samples[sample_count] = {};
+        mixVoices(mixer, samples, sample_count);
+
+        if (kernel == SynthKernel::Scalar) {
+            for (int32_t index = 0; index < sample_count; index++)
+            {
+                reference[index] = samples[index];
+            }
+            continue;
+        }
+
+        bool equal = true;
+        for (int32_t index = 0; index < sample_count; index++)
+        {
+            equal = equal && samples[index] == reference[index];
+        }
+        CHECK(equal);
+    }
+    setSynthKernel(original);
+}
@@ -0,0 +1,99 @@
+#include <catch.hpp>
+
+#include <chrono>
+#include <cstring>
+#include <net/lossy_link.h>
+#include <net/udp_socket.h>
+#include <thread>
+
+namespace {
+
+// Loopback packets arrive right away, but not necessarily by the time the
+// send returns.
+size_t receiveWithin(UdpSocket& socket, NetAddress& address, uint8_t* bytes)
+{
+    for (int32_t attempt = 0; attempt < 100; attempt++)
+    {
+        const size_t size = receiveUdpPacket(socket, address, bytes);
+        if (size > 0)
+            return size;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return 0;
+}
+
+}
+
+TEST_CASE("UDP addresses are parsed from text")
+{
+    NetAddress address;
+    REQUIRE(parseNetAddress("127.0.0.1:7000", address));
+    CHECK(address == makeLoopbackAddress(7000));
+
+    CHECK(!parseNetAddress("127.0.0.1", address));
+    CHECK(!parseNetAddress("127.0.0.1:", address));
+    CHECK(!parseNetAddress("127.0.0.1:70000", address));
+    CHECK(!parseNetAddress("localhost:7000", address));
+}
+
+TEST_CASE("UDP packets go over loopback")
+{
+    UdpSocket sender;
+    UdpSocket receiver;
+    REQUIRE(openUdpSocket(sender, 0));
+    REQUIRE(openUdpSocket(receiver, 0));
+
+    NetAddress address;
+    uint8_t bytes[max_udp_packet_size];
+    CHECK(receiveUdpPacket(receiver, address, bytes) == 0);
+
+    const uint8_t packet[] = { 1, 2, 3 };
+    REQUIRE(sendUdpPacket(sender, makeLoopbackAddress(receiver.port), packet, sizeof(packet)));
+    REQUIRE(receiveWithin(receiver, address, bytes) == sizeof(packet));
+    CHECK(memcmp(bytes, packet, sizeof(packet)) == 0);
+    CHECK(address == makeLoopbackAddress(sender.port));
+
+    closeUdpSocket(receiver);
+    closeUdpSocket(sender);
+}
+
+TEST_CASE("Lossy links hold packets back and drop some")
+{
+    UdpSocket sender;
+    UdpSocket receiver;
+    REQUIRE(openUdpSocket(sender, 0));
+    REQUIRE(openUdpSocket(receiver, 0));
+    LossyLink link;
+    initLossyLink(link, sender, LinkConditions{ 1000, 500, 0.25f }, 3, 64);
+
+    constexpr int32_t packet_count = 40;
+    for (int32_t index = 0; index < packet_count; index++)
+    {
+        const uint8_t packet = uint8_t(index);
+        sendLinkPacket(link, makeLoopbackAddress(receiver.port), &packet, 1, index);
+    }
+    CHECK(link.sentCount == packet_count);
+    CHECK(link.droppedCount > 0);
+    CHECK(link.droppedCount < packet_count / 2);
+
+    NetAddress address;
+    uint8_t bytes[max_udp_packet_size];
+    flushLossyLink(link, 999);
+    CHECK(link.count == packet_count - link.droppedCount);
+
+    flushLossyLink(link, packet_count + 1500);
+    CHECK(link.count == 0);
+    int32_t previous = -1;
+    uint64_t receivedCount = 0;
+    while (receiveWithin(receiver, address, bytes) == 1)
+    {
+        CHECK(int32_t(bytes[0]) > previous);
+        previous = bytes[0];
+        receivedCount++;
+    }
+    CHECK(receivedCount == packet_count - link.droppedCount);
+
+    destroyLossyLink(link);
+    closeUdpSocket(receiver);
+    closeUdpSocket(sender);
+}
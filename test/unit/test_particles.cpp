@@ -0,0 +1,138 @@
+#include <catch.hpp>
+
+#include <cstring>
+#include <particles.h>
+#include <quad_queue.h>
+#include <renderer.h>
+
+namespace {
+
+constexpr uint32_t white_pixel = 0xFFFFFFFF;
+
+// A burst whose particles die over the next few updates, in a count that
+// leaves a tail past the last whole register.
+void emitTestBurst(Particles& particles)
+{
+    uint32_t random = 5;
+    emitParticles(particles,
+                  ParticleBurst{ 10, 20, 100, 20, 80, -40, 0.1f, 6, Color{ 1, 0.5f, 0 }, 1003 },
+                  random);
+}
+
+}
+
+TEST_CASE("Particles move, shrink and run out of life")
+{
+    Particles particles;
+    initParticles(particles, 4);
+    uint32_t random = 1;
+    emitParticles(particles, ParticleBurst{ 0, 0, 0, 0, 0, 0, 1, 4, Color{ 1, 1, 1 }, 6 }, random);
+    REQUIRE(particles.count == 4);
+
+    // The second and fourth particle run out first.
+    particles.velocityX[0] = 10;
+    particles.life[0] = 1;
+    particles.life[1] = 0.25f;
+    particles.life[2] = 0.75f;
+    particles.life[3] = 0.25f;
+    updateParticles(particles, 0.5f, 2);
+    REQUIRE(particles.count == 2);
+    CHECK(particles.x[0] == 5);
+    CHECK(particles.velocityY[0] == 1);
+    CHECK(particles.y[0] == 0.5f);
+    CHECK(particles.life[0] == 0.5f);
+    CHECK(particles.life[1] == 0.25f);
+
+    updateParticles(particles, 0.5f, 2);
+    CHECK(particles.count == 0);
+    destroyParticles(particles);
+}
+
+TEST_CASE("All particle kernels update the same")
+{
+    const ParticleKernel original = getParticleKernel();
+    Particles reference;
+    initParticles(reference, 2000);
+    emitTestBurst(reference);
+    setParticleKernel(ParticleKernel::Scalar);
+    uint32_t referenceCounts[4];
+    for (uint32_t step = 0; step < 4; step++)
+    {
+        updateParticles(reference, 0.02f, 500);
+        referenceCounts[step] = reference.count;
+    }
+    CHECK(referenceCounts[0] == 1003);
+    CHECK(referenceCounts[3] < 1003);
+    CHECK(referenceCounts[3] > 0);
+
+    for (ParticleKernel kernel : { ParticleKernel::Sse2, ParticleKernel::Avx2 })
+    {
+        if (!isParticleKernelSupported(kernel))
+            continue;
+        CAPTURE(getParticleKernelName(kernel));
+
+        Particles particles;
+        initParticles(particles, 2000);
+        emitTestBurst(particles);
+        setParticleKernel(kernel);
+        for (uint32_t step = 0; step < 4; step++)
+        {
+            updateParticles(particles, 0.02f, 500);
+            CHECK(particles.count == referenceCounts[step]);
+        }
+
+        const size_t size = reference.count * sizeof(float);
+        CHECK(memcmp(particles.x, reference.x, size) == 0);
+        CHECK(memcmp(particles.y, reference.y, size) == 0);
+        CHECK(memcmp(particles.velocityX, reference.velocityX, size) == 0);
+        CHECK(memcmp(particles.velocityY, reference.velocityY, size) == 0);
+        CHECK(memcmp(particles.life, reference.life, size) == 0);
+        CHECK(memcmp(particles.sizePerLife, reference.sizePerLife, size) == 0);
+        CHECK(memcmp(particles.colors, reference.colors, reference.count * sizeof(uint32_t)) == 0);
+        destroyParticles(particles);
+    }
+
+    setParticleKernel(original);
+    destroyParticles(reference);
+}
+
+TEST_CASE("Particles are drawn as a single run of quads")
+{
+    for (QuadMode mode : { QuadMode::Instanced, QuadMode::Indexed })
+    {
+        CAPTURE(mode == QuadMode::Instanced ? "instanced" : "indexed");
+        initRenderer(RenderBackend::Recording, 64, 128, 80, mode, StreamBufferMode::Fenced, nullptr);
+        const uint16_t texture = createTexture(1, 1, &white_pixel);
+        const Sprite sprite = Sprite{ texture, 0, 0, 65535, 65535 };
+
+        Particles particles;
+        initParticles(particles, 100);
+        uint32_t random = 3;
+        emitParticles(particles, ParticleBurst{ 0, 0, 10, 10, 1, 0, 1, 4, Color{ 1, 0, 0 }, 100 }, random);
+
+        beginDrawing();
+        drawQuad(0, 0, 1, 1, Color{ 0, 0, 1 }, DrawOrder{ 1, 0 });
+        drawQuad(0, 0, 1, 1, Color{ 0, 1, 0 }, DrawOrder{ 0, 0 });
+        // Only as many as fit into the frame are drawn.
+        drawParticles(particles, sprite, DrawOrder{ 0, 1 });
+        CHECK(getFreeQuadCount() == 0);
+        endDrawing();
+
+        const RecordedFrame frame = getRecordedFrame();
+        REQUIRE(frame.drawCount == 3);
+        REQUIRE(frame.quadCount == 64);
+        CHECK(frame.draws[0].count == 1);
+        CHECK(frame.draws[1].texture == texture);
+        CHECK(frame.draws[1].count == 62);
+        CHECK(frame.draws[2].count == 1);
+
+        // The particles keep their order within the run.
+        static uint8_t expected[100 * sizeof(Quad)];
+        writeParticleQuads(particles, sprite, mode, expected);
+        const size_t quadSize = getQuadSize(mode);
+        CHECK(memcmp(frame.quads + quadSize, expected, 62 * quadSize) == 0);
+
+        destroyParticles(particles);
+        destroyRenderer();
+    }
+}
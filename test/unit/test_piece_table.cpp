@@ -0,0 +1,92 @@
+#include <catch.hpp>
+
+#include <board/board.h>
+#include <board/piece.h>
+#include <board/piece_table.h>
+
+namespace {
+
+// The columns of a mask that hold a cell in any row.
+uint16_t getMaskColumns(PieceMask mask)
+{
+    return uint16_t(mask | (mask >> 16) | (mask >> 32) | (mask >> 48));
+}
+
+}
+
+TEST_CASE("Piece tables agree with the board about the walls")
+{
+    constexpr const PieceTable<board_width>& table = piece_table<board_width>;
+    const Board board = makeBoard();
+
+    for (int32_t type = 0; type < piece_type_count; type++)
+    {
+        for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+        {
+            CAPTURE(type, rotation);
+            const PieceMask mask = getPieceMask(PieceType(type), rotation);
+            CHECK(table.masks[type][rotation][0] == mask);
+            for (int32_t x = -board_left_wall; x + board_left_wall < piece_column_count; x++)
+            {
+                CAPTURE(x);
+                const bool inside =
+                    x >= table.minX[type][rotation] && x <= table.maxX[type][rotation];
+                CHECK(collides(board, mask, x, 5) == !inside);
+                CHECK(table.masks[type][rotation][x + board_left_wall] ==
+                      mask << (x + board_left_wall));
+            }
+        }
+    }
+}
+
+TEST_CASE("Piece tables turn pieces in both directions")
+{
+    constexpr const PieceTable<board_width>& table = piece_table<board_width>;
+
+    int32_t rotation = 0;
+    for (int32_t turn = 0; turn < rotation_count; turn++)
+    {
+        const int32_t next = table.turns[rotation][int32_t(PieceTurn::Clockwise)];
+        CHECK(next == (rotation + 1) % rotation_count);
+        CHECK(table.turns[next][int32_t(PieceTurn::CounterClockwise)] == rotation);
+        rotation = next;
+    }
+    CHECK(rotation == 0);
+
+    for (int32_t type = 0; type < piece_type_count; type++)
+    {
+        for (int32_t kick = 0; kick < piece_kick_count; kick++)
+        {
+            CHECK(table.kicks[type][2][int32_t(PieceTurn::Clockwise)][kick] ==
+                  piece_kick_offsets[kick]);
+        }
+    }
+}
+
+TEST_CASE("Piece tables fit boards of other widths")
+{
+    constexpr int32_t width = 6;
+    constexpr const PieceTable<width>& table = piece_table<width>;
+    constexpr int32_t left_wall = PieceTable<width>::left_wall;
+
+    for (int32_t type = 0; type < piece_type_count; type++)
+    {
+        for (int32_t rotation = 0; rotation < rotation_count; rotation++)
+        {
+            CAPTURE(type, rotation);
+            // At the ends of the range the piece touches the walls.
+            const PieceMask leftmost = getPieceMaskAt<width>(
+                PieceType(type),
+                rotation,
+                table.minX[type][rotation]);
+            const PieceMask rightmost = getPieceMaskAt<width>(
+                PieceType(type),
+                rotation,
+                table.maxX[type][rotation]);
+            CHECK(getMaskColumns(leftmost) & (1u << left_wall));
+            CHECK(!(getMaskColumns(leftmost) & ((1u << left_wall) - 1)));
+            CHECK(getMaskColumns(rightmost) & (1u << (left_wall + width - 1)));
+            CHECK(!(getMaskColumns(rightmost) >> (left_wall + width)));
+        }
+    }
+}
@@ -0,0 +1,39 @@
+#include <catch.hpp>
+
+#include <util/pool.h>
+
+TEST_CASE("Pools hand out every element once")
+{
+    Pool<int> pool;
+    initPool(pool, 3);
+
+    int* first = takeFromPool(pool);
+    int* second = takeFromPool(pool);
+    int* third = takeFromPool(pool);
+    REQUIRE(first != nullptr);
+    REQUIRE(second != nullptr);
+    REQUIRE(third != nullptr);
+    CHECK(first != second);
+    CHECK(second != third);
+    CHECK(first != third);
+    CHECK(takeFromPool(pool) == nullptr);
+
+    destroyPool(pool);
+}
+
+TEST_CASE("Elements put back into a pool are handed out again")
+{
+    Pool<int> pool;
+    initPool(pool, 2);
+
+    int* first = takeFromPool(pool);
+    int* second = takeFromPool(pool);
+    putBackIntoPool(pool, first);
+    CHECK(pool.freeCount == 1);
+    CHECK(takeFromPool(pool) == first);
+    putBackIntoPool(pool, second);
+    putBackIntoPool(pool, first);
+    CHECK(pool.freeCount == 2);
+
+    destroyPool(pool);
+}
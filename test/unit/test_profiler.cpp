@@ -0,0 +1,89 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <thread>
+#include <profiler/profiler.h>
+
+TEST_CASE("Profilers collect events from every thread")
+{
+    initProfiler(1024);
+
+    recordProfileZone("main", 10, 30);
+    std::thread thread([]()
+    {
+        setProfileThreadName("worker");
+        recordProfileZone("worker", 20, 25);
+        recordProfileCounter("count", 7);
+    });
+    thread.join();
+
+    collectProfileEvents();
+    const ListView<ProfileEvent> events = getProfileEvents();
+    REQUIRE(events.count == 3);
+
+    const ProfileEvent& zone = events[0];
+    CHECK(strcmp(zone.name, "main") == 0);
+    CHECK(zone.kind == ProfileEventKind::Zone);
+    CHECK(zone.time == 10);
+    CHECK(zone.value == 20);
+
+    const ProfileEvent& counter = events[2];
+    CHECK(strcmp(counter.name, "count") == 0);
+    CHECK(counter.kind == ProfileEventKind::Counter);
+    CHECK(counter.value == 7);
+    CHECK(counter.thread != zone.thread);
+
+    destroyProfiler();
+}
+
+TEST_CASE("Profilers drop events when their buffers are full")
+{
+    initProfiler(1024);
+
+    for (size_t index = 0; index < profiler_thread_buffer_size + 10; index++)
+    {
+        recordProfileZone("zone", 0, 1);
+    }
+    collectProfileEvents();
+
+    CHECK(getProfileEvents().count == 1024);
+    CHECK(getDroppedProfileEventCount() ==
+          profiler_thread_buffer_size + 10 - 1024);
+
+    destroyProfiler();
+}
+
+TEST_CASE("Profilers record nothing when not initialized")
+{
+    recordProfileZone("zone", 0, 1);
+    collectProfileEvents();
+
+    CHECK(getProfileEvents().count == 0);
+}
+
+TEST_CASE("Profilers export Chrome traces")
+{
+    initProfiler(16);
+    setProfileThreadName("main");
+    recordProfileZone("frame", 1000, 3500);
+    recordProfileCounter("quads", 42);
+    collectProfileEvents();
+
+    const char* path = "test_profiler_trace.json";
+    REQUIRE(writeChromeTrace(path));
+    destroyProfiler();
+
+    FILE* file = fopen(path, "r");
+    REQUIRE(file != nullptr);
+    char contents[1024] = {};
+    fread(contents, 1, sizeof(contents) - 1, file);
+    fclose(file);
+    remove(path);
+
+    CHECK(strncmp(contents, "{\"traceEvents\":[", 16) == 0);
+    CHECK(strstr(contents, "\"args\":{\"name\":\"main\"}") != nullptr);
+    CHECK(strstr(contents, "\"name\":\"frame\",\"ph\":\"X\"") != nullptr);
+    CHECK(strstr(contents, "\"ts\":1.000,\"dur\":2.500") != nullptr);
+    CHECK(strstr(contents, "\"args\":{\"value\":42}") != nullptr);
+}
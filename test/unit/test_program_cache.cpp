@@ -0,0 +1,104 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <cstring>
+#include <program_cache.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+std::string getProgramPath(const char* name)
+{
+    return std::string(TEST_OUTPUT_DIR) + "/" + name + ".program";
+}
+
+std::vector<uint8_t> readFile(const std::string& path)
+{
+    std::vector<uint8_t> bytes;
+    FILE* file = fopen(path.c_str(), "rb");
+    REQUIRE(file != nullptr);
+    int byte;
+    while ((byte = fgetc(file)) != EOF)
+    {
+        bytes.push_back(uint8_t(byte));
+    }
+    fclose(file);
+    return bytes;
+}
+
+void writeFile(const std::string& path, const std::vector<uint8_t>& bytes)
+{
+    FILE* file = fopen(path.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    fwrite(bytes.data(), 1, bytes.size(), file);
+    fclose(file);
+}
+
+}
+
+TEST_CASE("Program keys change with every string")
+{
+    const char* strings[] = { "vendor", "renderer", "4.6", "vertex", "fragment" };
+    const uint64_t key = hashProgramKey(strings, 5);
+    CHECK(hashProgramKey(strings, 5) == key);
+
+    const char* newerDriver[] = { "vendor", "renderer", "4.6.1", "vertex", "fragment" };
+    CHECK(hashProgramKey(newerDriver, 5) != key);
+    const char* otherShader[] = { "vendor", "renderer", "4.6", "vertex", "fragment2" };
+    CHECK(hashProgramKey(otherShader, 5) != key);
+    const char* shifted[] = { "vendor", "renderer", "4.6", "vertexf", "ragment" };
+    CHECK(hashProgramKey(shifted, 5) != key);
+}
+
+TEST_CASE("Programs are read back from the cache for the same key")
+{
+    const std::string path = getProgramPath("cached");
+    uint8_t bytes[300];
+    for (size_t index = 0; index < sizeof(bytes); index++)
+    {
+        bytes[index] = uint8_t(index * 7);
+    }
+    REQUIRE(writeProgramCache(path.c_str(), 42, ProgramBinary{ 0x1234, sizeof(bytes), bytes }));
+
+    ProgramBinary binary;
+    REQUIRE(readProgramCache(path.c_str(), 42, binary));
+    CHECK(binary.format == 0x1234);
+    REQUIRE(binary.size == sizeof(bytes));
+    CHECK(memcmp(binary.bytes, bytes, sizeof(bytes)) == 0);
+    destroyProgramBinary(binary);
+
+    CHECK(!readProgramCache(path.c_str(), 43, binary));
+    CHECK(!readProgramCache(getProgramPath("missing").c_str(), 42, binary));
+
+    remove(path.c_str());
+}
+
+TEST_CASE("Damaged programs are not read from the cache")
+{
+    const std::string path = getProgramPath("damaged");
+    uint8_t bytes[64] = { 1, 2, 3 };
+    REQUIRE(writeProgramCache(path.c_str(), 7, ProgramBinary{ 1, sizeof(bytes), bytes }));
+    const std::vector<uint8_t> file = readFile(path);
+
+    ProgramBinary binary;
+    std::vector<uint8_t> truncated(file.begin(), file.end() - 1);
+    writeFile(path, truncated);
+    CHECK(!readProgramCache(path.c_str(), 7, binary));
+
+    std::vector<uint8_t> longer = file;
+    longer.push_back(0);
+    writeFile(path, longer);
+    CHECK(!readProgramCache(path.c_str(), 7, binary));
+
+    std::vector<uint8_t> flipped = file;
+    flipped.back() ^= 1;
+    writeFile(path, flipped);
+    CHECK(!readProgramCache(path.c_str(), 7, binary));
+
+    writeFile(path, file);
+    REQUIRE(readProgramCache(path.c_str(), 7, binary));
+    destroyProgramBinary(binary);
+
+    remove(path.c_str());
+}
@@ -0,0 +1,60 @@
+#include <catch.hpp>
+
+#include <util/radix_sort.h>
+
+TEST_CASE("radixSort sorts by key")
+{
+    constexpr uint32_t count = 1000;
+    SortItem items[count];
+    SortItem scratch[count];
+    uint64_t state = 0x9E3779B97F4A7C15;
+    for (uint32_t index = 0; index < count; index++)
+    {
+        state = state * 6364136223846793005 + 1442695040888963407;
+        items[index] = SortItem{ state, index };
+    }
+
+    radixSort(items, scratch, count);
+
+    for (uint32_t index = 1; index < count; index++)
+    {
+        REQUIRE(items[index - 1].key <= items[index].key);
+    }
+}
+
+TEST_CASE("radixSort keeps items with equal keys in order")
+{
+    SortItem items[] = {
+        { 0x0300000000000002, 0 },
+        { 0x0100000000000001, 1 },
+        { 0x0300000000000002, 2 },
+        { 0x0100000000000001, 3 },
+        { 0x0200000000000000, 4 },
+        { 0x0100000000000001, 5 }
+    };
+    SortItem scratch[6];
+
+    radixSort(items, scratch, 6);
+
+    const uint32_t expected[] = { 1, 3, 5, 4, 0, 2 };
+    for (int32_t index = 0; index < 6; index++)
+    {
+        CHECK(items[index].value == expected[index]);
+    }
+}
+
+TEST_CASE("radixSort sorts keys that differ in a single byte")
+{
+    SortItem items[] = {
+        { 0xAA00FF0000000000, 0 },
+        { 0xAA00010000000000, 1 },
+        { 0xAA00800000000000, 2 }
+    };
+    SortItem scratch[3];
+
+    radixSort(items, scratch, 3);
+
+    CHECK(items[0].value == 1);
+    CHECK(items[1].value == 2);
+    CHECK(items[2].value == 0);
+}
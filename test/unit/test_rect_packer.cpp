@@ -0,0 +1,89 @@
+#include <catch.hpp>
+
+#include <util/rect_packer.h>
+
+namespace {
+
+struct Rect
+{
+    uint32_t x;
+    uint32_t y;
+    uint32_t width;
+    uint32_t height;
+};
+
+bool overlap(const Rect& first, const Rect& second)
+{
+    return first.x < second.x + second.width &&
+           second.x < first.x + first.width &&
+           first.y < second.y + second.height &&
+           second.y < first.y + first.height;
+}
+
+}
+
+TEST_CASE("RectPackers place rectangles bottom left first")
+{
+    SkylineNode nodes[16];
+    RectPacker packer = makeRectPacker(16, 16, nodes, 16);
+
+    uint32_t x;
+    uint32_t y;
+    REQUIRE(packRect(packer, 10, 4, x, y));
+    CHECK(x == 0);
+    CHECK(y == 0);
+    REQUIRE(packRect(packer, 6, 2, x, y));
+    CHECK(x == 10);
+    CHECK(y == 0);
+    REQUIRE(packRect(packer, 8, 2, x, y));
+    CHECK(x == 0);
+    CHECK(y == 4);
+    REQUIRE(packRect(packer, 6, 2, x, y));
+    CHECK(x == 10);
+    CHECK(y == 2);
+}
+
+TEST_CASE("RectPackers reject rectangles that do not fit")
+{
+    SkylineNode nodes[8];
+    RectPacker packer = makeRectPacker(8, 8, nodes, 8);
+
+    uint32_t x;
+    uint32_t y;
+    CHECK_FALSE(packRect(packer, 9, 1, x, y));
+    CHECK_FALSE(packRect(packer, 1, 9, x, y));
+    REQUIRE(packRect(packer, 8, 6, x, y));
+    CHECK_FALSE(packRect(packer, 4, 4, x, y));
+    CHECK(packRect(packer, 4, 2, x, y));
+}
+
+TEST_CASE("RectPackers never overlap rectangles")
+{
+    SkylineNode nodes[64];
+    RectPacker packer = makeRectPacker(64, 64, nodes, 64);
+
+    Rect rects[128];
+    int32_t rectCount = 0;
+    uint32_t state = 12345;
+    for (int32_t attempt = 0; attempt < 128; attempt++)
+    {
+        state = state * 1103515245 + 12345;
+        const uint32_t width = 1 + (state >> 16) % 12;
+        const uint32_t height = 1 + (state >> 8) % 12;
+        uint32_t x;
+        uint32_t y;
+        if (!packRect(packer, width, height, x, y))
+            continue;
+
+        const Rect rect = Rect{ x, y, width, height };
+        REQUIRE(x + width <= 64);
+        REQUIRE(y + height <= 64);
+        for (int32_t index = 0; index < rectCount; index++)
+        {
+            REQUIRE_FALSE(overlap(rect, rects[index]));
+        }
+        rects[rectCount++] = rect;
+    }
+
+    CHECK(rectCount > 32);
+}
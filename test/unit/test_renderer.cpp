@@ -0,0 +1,293 @@
+#include <catch.hpp>
+
+#include <atlas.h>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <font.h>
+#include <renderer.h>
+#include <string>
+#include <util/allocation_hook.h>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t max_quad_count = 256;
+constexpr uint32_t width = 128;
+constexpr uint32_t height = 80;
+constexpr uint32_t atlas_size = 64;
+
+constexpr Color red = Color{ 1, 0, 0 };
+constexpr Color green = Color{ 0, 1, 0 };
+constexpr Color blue = Color{ 0, 0, 1 };
+constexpr Color white = Color{ 1, 1, 1 };
+constexpr uint32_t white_pixel = 0xFFFFFFFF;
+
+void initHeadlessRenderer(RenderBackend backend, QuadMode mode)
+{
+    initRenderer(
+        backend,
+        max_quad_count,
+        width,
+        height,
+        mode,
+        StreamBufferMode::Fenced,
+        nullptr);
+}
+
+Font loadFont()
+{
+    static uint32_t pixels[font_pixel_count];
+    Image images[font_glyph_count];
+    makeFontImages(pixels, images);
+
+    Sprite glyphs[font_glyph_count];
+    REQUIRE(buildAtlas(atlas_size, images, font_glyph_count, glyphs));
+    return makeFont(glyphs);
+}
+
+// Overlapping quads on several layers, straddling the tile edges and the
+// borders of the framebuffer.
+void drawQuadScene()
+{
+    drawQuad(-8, -8, 40, 30, red, DrawOrder{ 0, 0 });
+    drawQuad(20, 10, 60, 40, green, DrawOrder{ 1, 0 });
+    drawQuad(50, 30, 100, 70, blue, DrawOrder{ 0, 1 });
+    drawQuad(62.5f, 0.25f, 3.5f, 79.5f, white, DrawOrder{ 2, 0 });
+}
+
+void drawTextScene(const Font& font)
+{
+    drawQuad(0, 0, 128, 20, blue, DrawOrder{ 0, 0 });
+    drawText(font, "SCORE 1234", 4, 6, 1, white, DrawOrder{ 1, 0 });
+    drawText(font, "TETRIS", 10, 30, 3, Color{ 1, 0.5f, 0 }, DrawOrder{ 1, 0 });
+}
+
+void drawLayerScene(QuadLayer layer, const Sprite& blank)
+{
+    for (uint32_t index = 0; index < 8; index++)
+    {
+        const Color color = Color{ index / 7.0f, 1 - index / 7.0f, 0.5f };
+        setLayerSprite(layer, index, index * 16.0f, 60, 15, 15, blank, color);
+    }
+    hideLayerQuad(layer, 3);
+    drawQuadLayer(layer);
+    drawQuad(0, 64, 128, 4, white, DrawOrder{ 2, 0 });
+}
+
+std::string getGoldenImagePath(const char* name)
+{
+    return std::string(GOLDEN_IMAGE_DIR) + "/" + name + ".ppm";
+}
+
+// Golden images are binary PPM files, which hold no alpha.
+bool readGoldenImage(const char* name, std::vector<uint8_t>& rgb)
+{
+    FILE* file = fopen(getGoldenImagePath(name).c_str(), "rb");
+    if (file == nullptr)
+        return false;
+
+    uint32_t fileWidth = 0;
+    uint32_t fileHeight = 0;
+    uint32_t maxValue = 0;
+    const bool valid =
+        fscanf(file, "P6 %u %u %u", &fileWidth, &fileHeight, &maxValue) == 3 &&
+        fgetc(file) != EOF &&
+        fileWidth == width &&
+        fileHeight == height &&
+        maxValue == 255;
+    rgb.resize(width * height * 3);
+    const bool read =
+        valid && fread(rgb.data(), 1, rgb.size(), file) == rgb.size();
+    fclose(file);
+    return read;
+}
+
+void writeGoldenImage(const char* name, const std::vector<uint8_t>& rgb)
+{
+    FILE* file = fopen(getGoldenImagePath(name).c_str(), "wb");
+    REQUIRE(file != nullptr);
+    fprintf(file, "P6\n%u %u\n255\n", width, height);
+    fwrite(rgb.data(), 1, rgb.size(), file);
+    fclose(file);
+}
+
+std::vector<uint8_t> getFramebufferColors()
+{
+    const uint32_t* pixels = getSoftwareFramebuffer();
+    std::vector<uint8_t> rgb(width * height * 3);
+    for (uint32_t index = 0; index < width * height; index++)
+    {
+        rgb[index * 3] = uint8_t(pixels[index]);
+        rgb[index * 3 + 1] = uint8_t(pixels[index] >> 8);
+        rgb[index * 3 + 2] = uint8_t(pixels[index] >> 16);
+    }
+    return rgb;
+}
+
+// Compares the framebuffer to the golden image. Setting the environment
+// variable UPDATE_GOLDEN_IMAGES writes the framebuffer as the new golden
+// image instead.
+void checkGoldenImage(const char* name)
+{
+    const std::vector<uint8_t> rgb = getFramebufferColors();
+    if (getenv("UPDATE_GOLDEN_IMAGES") != nullptr) {
+        writeGoldenImage(name, rgb);
+        return;
+    }
+
+    std::vector<uint8_t> golden;
+    INFO("Golden image " << getGoldenImagePath(name));
+    REQUIRE(readGoldenImage(name, golden));
+
+    uint32_t differentPixelCount = 0;
+    for (uint32_t index = 0; index < width * height; index++)
+    {
+        differentPixelCount +=
+            memcmp(&rgb[index * 3], &golden[index * 3], 3) != 0;
+    }
+    CHECK(differentPixelCount == 0);
+}
+
+}
+
+TEST_CASE("The recording backend captures the batched draw calls")
+{
+    initHeadlessRenderer(RenderBackend::Recording, QuadMode::Instanced);
+    const uint16_t texture = createTexture(1, 1, &white_pixel);
+    const Sprite sprite = Sprite{ texture, 0, 0, 65535, 65535 };
+
+    beginDrawing();
+    drawQuad(0, 0, 1, 1, red, DrawOrder{ 1, 0 });
+    drawSprite(0, 0, 1, 1, sprite, green, DrawOrder{ 0, 0 });
+    drawQuad(2, 0, 1, 1, blue, DrawOrder{ 0, 1 });
+    drawQuad(4, 0, 1, 1, white, DrawOrder{ 0, 2 });
+    endDrawing();
+
+    const RecordedFrame frame = getRecordedFrame();
+    CHECK(frame.quadSize == 28);
+    REQUIRE(frame.drawCount == 3);
+    REQUIRE(frame.quadCount == 4);
+
+    // The blank sprite is the first texture, so layer 0 draws it first.
+    CHECK(frame.draws[0].texture == 0);
+    CHECK(frame.draws[0].first == 0);
+    CHECK(frame.draws[0].count == 2);
+    CHECK(frame.draws[1].texture == texture);
+    CHECK(frame.draws[1].first == 2);
+    CHECK(frame.draws[1].count == 1);
+    CHECK(frame.draws[2].texture == 0);
+    CHECK(frame.draws[2].first == 3);
+    CHECK(frame.draws[2].count == 1);
+
+    const RenderStats stats = getRenderStats();
+    CHECK(stats.quadCount == 4);
+    CHECK(stats.drawCallCount == 3);
+    // The shader and texture of the first draw, then two texture switches.
+    CHECK(stats.stateChangeCount == 4);
+    CHECK(stats.uploadByteCount == 4 * 28);
+
+    destroyRenderer();
+}
+
+TEST_CASE("Recorded frames hash the same only when they draw the same")
+{
+    initHeadlessRenderer(RenderBackend::Recording, QuadMode::Indexed);
+
+    uint64_t hashes[3];
+    for (uint64_t& hash : hashes)
+    {
+        beginDrawing();
+        drawQuadScene();
+        if (&hash == &hashes[2])
+            drawQuad(1, 1, 1, 1, red, DrawOrder{ 3, 0 });
+        endDrawing();
+        hash = hashRecordedFrame(getRecordedFrame());
+    }
+    CHECK(hashes[0] == hashes[1]);
+    CHECK(hashes[0] != hashes[2]);
+
+    destroyRenderer();
+}
+
+TEST_CASE("The software backend covers the pixels whose centers are inside a quad")
+{
+    initHeadlessRenderer(RenderBackend::Software, QuadMode::Instanced);
+
+    beginDrawing();
+    drawQuad(2.5f, 3, 4, 5.5f, white, DrawOrder{ 0, 0 });
+    endDrawing();
+
+    const uint32_t* pixels = getSoftwareFramebuffer();
+    for (uint32_t y = 0; y < height; y++)
+    {
+        for (uint32_t x = 0; x < width; x++)
+        {
+            const bool inside = x >= 2 && x < 6 && y >= 3 && y < 8;
+            CAPTURE(x, y);
+            CHECK(pixels[y * width + x] == (inside ? 0xFFFFFFFF : 0xFF000000));
+        }
+    }
+
+    destroyRenderer();
+}
+
+TEST_CASE("The software backend matches the golden images in both quad modes")
+{
+    for (QuadMode mode : { QuadMode::Instanced, QuadMode::Indexed })
+    {
+        CAPTURE(mode == QuadMode::Instanced ? "instanced" : "indexed");
+        initHeadlessRenderer(RenderBackend::Software, mode);
+        const Font font = loadFont();
+        const uint16_t texture = createTexture(1, 1, &white_pixel);
+        const Sprite blank = Sprite{ texture, 0, 0, 65535, 65535 };
+        const QuadLayer layer = createQuadLayer(8, texture, DrawOrder{ 1, 0 });
+
+        beginDrawing();
+        drawQuadScene();
+        endDrawing();
+        checkGoldenImage("quads");
+
+        beginDrawing();
+        drawTextScene(font);
+        endDrawing();
+        checkGoldenImage("text");
+
+        beginDrawing();
+        drawLayerScene(layer, blank);
+        endDrawing();
+        checkGoldenImage("layer");
+
+        destroyRenderer();
+    }
+}
+
+TEST_CASE("Drawing frames does not allocate once the renderer is set up")
+{
+    for (RenderBackend backend : { RenderBackend::Recording, RenderBackend::Software })
+    {
+        CAPTURE(backend == RenderBackend::Recording ? "recording" : "software");
+        initHeadlessRenderer(backend, QuadMode::Instanced);
+        const Font font = loadFont();
+        const uint16_t texture = createTexture(1, 1, &white_pixel);
+        const Sprite blank = Sprite{ texture, 0, 0, 65535, 65535 };
+        const QuadLayer layer = createQuadLayer(8, texture, DrawOrder{ 1, 0 });
+
+        // An allocation fails the run right where it happens.
+        const uint64_t allocationCount = getThreadAllocationCount();
+        setThreadAllocationsForbidden(true);
+        for (int32_t frame = 0; frame < 10; frame++)
+        {
+            beginDrawing();
+            drawQuadScene();
+            drawTextScene(font);
+            drawLayerScene(layer, blank);
+            allocateArray<uint8_t>(getFrameArena(), 1024);
+            endDrawing();
+        }
+        setThreadAllocationsForbidden(false);
+        CHECK(getThreadAllocationCount() == allocationCount);
+
+        destroyRenderer();
+    }
+}
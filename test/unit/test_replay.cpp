@@ -0,0 +1,169 @@
+#include <catch.hpp>
+
+#include <cstdio>
+#include <simulation/game.h>
+#include <simulation/input_source.h>
+#include <simulation/replay.h>
+#include <string>
+#include <vector>
+
+namespace {
+
+constexpr uint32_t keyframe_interval = 64;
+
+std::string getReplayPath(const char* name)
+{
+    return std::string(TEST_OUTPUT_DIR) + "/" + name + ".trpl";
+}
+
+bool haveSameState(const Game& first, const Game& second)
+{
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        if (getRow(first.board, y) != getRow(second.board, y))
+            return false;
+    }
+    return first.tick == second.tick &&
+           first.score == second.score &&
+           first.lines == second.lines &&
+           first.piece.type == second.piece.type &&
+           first.piece.x == second.piece.x &&
+           first.piece.y == second.piece.y &&
+           first.piece.rotation == second.piece.rotation &&
+           first.random == second.random &&
+           first.over == second.over;
+}
+
+// Plays a game with random input to the end while recording it, and returns
+// the state before every tick and the inputs.
+void recordGame(const std::string& path,
+                uint32_t seed,
+                std::vector<Game>& states,
+                std::vector<uint8_t>& inputs)
+{
+    ReplayWriter writer;
+    REQUIRE(openReplayWriter(writer, path.c_str(), seed, keyframe_interval));
+
+    InputSource source = makeRandomInputSource(seed);
+    Game game = makeGame(seed);
+    GameInput input;
+    while (!game.over)
+    {
+        states.push_back(game);
+        REQUIRE(readInput(source, game, input));
+        inputs.push_back(packGameInput(input));
+        writeReplayInput(writer, game, input);
+        updateGame(game, input);
+    }
+    states.push_back(game);
+    REQUIRE(closeReplayWriter(writer));
+}
+
+}
+
+TEST_CASE("Replays play back the inputs they were written with")
+{
+    const std::string path = getReplayPath("inputs");
+    std::vector<Game> states;
+    std::vector<uint8_t> inputs;
+    recordGame(path, 3, states, inputs);
+
+    Replay replay;
+    REQUIRE(openReplay(replay, path.c_str()));
+    CHECK(replay.seed == 3);
+    CHECK(replay.keyframeInterval == keyframe_interval);
+    CHECK(replay.tickCount == inputs.size());
+    CHECK(replay.chunkCount ==
+          (inputs.size() + keyframe_interval - 1) / keyframe_interval);
+    // Random input holds buttons for a few ticks, so runs take less than a
+    // byte per tick even with the keyframes.
+    CHECK(replay.size < inputs.size() + replay.chunkCount * sizeof(Game) + 512);
+
+    ReplayCursor cursor = makeReplayCursor(replay, 0);
+    GameInput input;
+    for (size_t tick = 0; tick < inputs.size(); tick++)
+    {
+        REQUIRE(readReplayInput(cursor, input));
+        REQUIRE(packGameInput(input) == inputs[tick]);
+    }
+    CHECK(!readReplayInput(cursor, input));
+
+    closeReplay(replay);
+    remove(path.c_str());
+}
+
+TEST_CASE("Seeking a replay restores the game at any tick")
+{
+    const std::string path = getReplayPath("seek");
+    std::vector<Game> states;
+    std::vector<uint8_t> inputs;
+    recordGame(path, 5, states, inputs);
+
+    Replay replay;
+    REQUIRE(openReplay(replay, path.c_str()));
+    for (uint64_t tick = 0; tick <= replay.tickCount; tick++)
+    {
+        CAPTURE(tick);
+        REQUIRE(haveSameState(seekReplay(replay, tick), states[tick]));
+
+        ReplayCursor cursor = makeReplayCursor(replay, tick);
+        GameInput input;
+        if (tick < replay.tickCount) {
+            REQUIRE(readReplayInput(cursor, input));
+            REQUIRE(packGameInput(input) == inputs[tick]);
+        }
+        else {
+            REQUIRE(!readReplayInput(cursor, input));
+        }
+    }
+    CHECK(seekReplay(replay, replay.tickCount).over);
+
+    closeReplay(replay);
+    remove(path.c_str());
+}
+
+TEST_CASE("Long runs of the same input are stored in a few bytes")
+{
+    const std::string path = getReplayPath("runs");
+    ReplayWriter writer;
+    REQUIRE(openReplayWriter(writer, path.c_str(), 1, 100000));
+    const Game game = makeGame(1);
+    GameInput input = {};
+    for (uint32_t tick = 0; tick < 50000; tick++)
+    {
+        input.left = tick >= 20000;
+        writeReplayInput(writer, game, input);
+    }
+    REQUIRE(closeReplayWriter(writer));
+
+    Replay replay;
+    REQUIRE(openReplay(replay, path.c_str()));
+    CHECK(replay.chunkCount == 1);
+    // The runs take four bytes each, the rest is headers and the keyframe.
+    CHECK(replay.size == 16 + 17 + sizeof(Game) + 8 + 16 + 28);
+
+    ReplayCursor cursor = makeReplayCursor(replay, 19999);
+    REQUIRE(readReplayInput(cursor, input));
+    CHECK(!input.left);
+    REQUIRE(readReplayInput(cursor, input));
+    CHECK(input.left);
+
+    closeReplay(replay);
+    remove(path.c_str());
+}
+
+TEST_CASE("Files that are not replays are not opened")
+{
+    const std::string path = getReplayPath("invalid");
+    FILE* file = fopen(path.c_str(), "wb");
+    REQUIRE(file != nullptr);
+    const char text[] = "This is not a replay, just some text that is long enough.";
+    fwrite(text, 1, sizeof(text), file);
+    fclose(file);
+
+    Replay replay;
+    CHECK(!openReplay(replay, path.c_str()));
+    CHECK(!openReplay(replay, getReplayPath("missing").c_str()));
+
+    remove(path.c_str());
+}
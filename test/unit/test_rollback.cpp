@@ -0,0 +1,212 @@
+#include <catch.hpp>
+
+#include <cstring>
+#include <net/rollback.h>
+#include <simulation/input_source.h>
+#include <simulation/versus.h>
+
+namespace {
+
+constexpr uint64_t match_tick_count = 600;
+// Ticks are run until the one checked is confirmed on both sides.
+constexpr uint64_t run_tick_count = match_tick_count + max_rollback_ticks;
+constexpr int32_t max_packet_count = 64;
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Holds a random set of buttons for a while, and hard drops rarely, so the
+// remote input is mispredicted now and then and the match lasts.
+void makePlayerInputs(uint32_t seed, uint8_t* inputs, uint64_t count)
+{
+    uint32_t random = seed;
+    uint8_t held = 0;
+    for (uint64_t tick = 0; tick < count; tick++)
+    {
+        if (nextRandom(random) % 8 == 0) {
+            GameInput input = unpackGameInput(uint8_t(nextRandom(random)));
+            input.drop = nextRandom(random) % 4 == 0;
+            input.down = false;
+            held = packGameInput(input);
+        }
+        inputs[tick] = held;
+    }
+}
+
+struct QueuedPacket
+{
+    uint64_t deliveryStep;
+    size_t size;
+    uint8_t bytes[max_rollback_packet_size];
+};
+
+// Carries packets one way, delayed by a number of steps and dropped at
+// random, in order.
+struct TestChannel
+{
+    QueuedPacket packets[max_packet_count];
+    int32_t first;
+    int32_t count;
+    uint32_t random;
+    uint64_t delay;
+    uint32_t lossPercent;
+};
+
+void sendPacket(TestChannel& channel,
+                const RollbackSession& session,
+                uint64_t step)
+{
+    if (nextRandom(channel.random) % 100 < channel.lossPercent ||
+        channel.count == max_packet_count)
+        return;
+
+    QueuedPacket& packet =
+        channel.packets[(channel.first + channel.count) % max_packet_count];
+    packet.deliveryStep = step + channel.delay;
+    packet.size = writeRollbackPacket(session, packet.bytes);
+    channel.count++;
+}
+
+void deliverPackets(TestChannel& channel, RollbackSession& session, uint64_t step)
+{
+    while (channel.count > 0 &&
+           channel.packets[channel.first].deliveryStep <= step)
+    {
+        const QueuedPacket& packet = channel.packets[channel.first];
+        REQUIRE(readRollbackPacket(session, packet.bytes, packet.size));
+        channel.first = (channel.first + 1) % max_packet_count;
+        channel.count--;
+    }
+}
+
+struct TestMatch
+{
+    RollbackSession sessions[versus_player_count];
+    TestChannel channels[versus_player_count];
+    uint8_t inputs[versus_player_count][run_tick_count];
+};
+
+// Plays a match between two sessions, one tick per step, with each
+// channel leading to the session at its index. Returns the number of steps
+// it took until both sessions ran every tick and have every input.
+uint64_t playTestMatch(TestMatch& match, uint64_t delay, uint32_t lossPercent)
+{
+    for (int32_t player = 0; player < versus_player_count; player++)
+    {
+        makePlayerInputs(11 + player, match.inputs[player], run_tick_count);
+        TestChannel& channel = match.channels[player];
+        channel.first = 0;
+        channel.count = 0;
+        channel.random = 5 + player;
+        channel.delay = delay;
+        channel.lossPercent = lossPercent;
+    }
+
+    uint64_t step = 0;
+    for (;; step++)
+    {
+        bool done = true;
+        for (int32_t player = 0; player < versus_player_count; player++)
+        {
+            RollbackSession& session = match.sessions[player];
+            deliverPackets(match.channels[player], session, step);
+            const uint64_t tick = session.game.tick;
+            if (tick < run_tick_count) {
+                advanceRollbackSession(
+                    session,
+                    unpackGameInput(match.inputs[player][tick]));
+            }
+            sendPacket(match.channels[1 - player], session, step);
+            done = done &&
+                session.game.tick == run_tick_count &&
+                session.remoteTick == run_tick_count;
+        }
+        if (done)
+            return step;
+        REQUIRE(step < 100 * run_tick_count);
+    }
+}
+
+uint32_t getReferenceChecksum(const TestMatch& match)
+{
+    VersusGame game = makeVersusGame(9);
+    for (uint64_t tick = 0; tick < match_tick_count; tick++)
+    {
+        const GameInput inputs[versus_player_count] = {
+            unpackGameInput(match.inputs[0][tick]),
+            unpackGameInput(match.inputs[1][tick])
+        };
+        updateVersusGame(game, inputs);
+        game.tick = tick + 1;
+    }
+    return getVersusChecksum(game);
+}
+
+}
+
+TEST_CASE("Rolled back matches end up where the real inputs lead")
+{
+    uint64_t delay = GENERATE(0, 3, 7);
+    uint32_t lossPercent = GENERATE(0, 20);
+    CAPTURE(delay, lossPercent);
+
+    static TestMatch match;
+    initRollbackSession(match.sessions[0], 9, 0);
+    initRollbackSession(match.sessions[1], 9, 1);
+    const uint64_t stepCount = playTestMatch(match, delay, lossPercent);
+
+    const uint32_t checksum = getReferenceChecksum(match);
+    uint64_t rollbackCount = 0;
+    for (const RollbackSession& session : match.sessions)
+    {
+        CHECK(session.checksums[match_tick_count % rollback_window] == checksum);
+        CHECK(!session.desynced);
+        CHECK(session.stats.maxRollbackDepth <= max_rollback_ticks);
+        rollbackCount += session.stats.rollbackCount;
+    }
+    CHECK(rollbackCount > 0);
+    // Waiting for the other side only adds a few steps.
+    CHECK(stepCount < run_tick_count + 4 * (delay + max_rollback_ticks));
+}
+
+TEST_CASE("Rollback sessions stop predicting too far ahead")
+{
+    static RollbackSession session;
+    initRollbackSession(session, 1, 0);
+    for (int32_t tick = 0; tick < max_rollback_ticks; tick++)
+    {
+        REQUIRE(advanceRollbackSession(session, GameInput{}));
+    }
+    CHECK(!advanceRollbackSession(session, GameInput{}));
+    CHECK(session.game.tick == max_rollback_ticks);
+    CHECK(session.stats.stallCount == 1);
+}
+
+TEST_CASE("Sessions started from different seeds detect the desync")
+{
+    static TestMatch match;
+    initRollbackSession(match.sessions[0], 9, 0);
+    initRollbackSession(match.sessions[1], 10, 1);
+    playTestMatch(match, 2, 0);
+
+    CHECK(match.sessions[0].desynced);
+    CHECK(match.sessions[1].desynced);
+}
+
+TEST_CASE("Rollback sessions reject packets that are not theirs")
+{
+    static RollbackSession session;
+    initRollbackSession(session, 1, 0);
+    uint8_t bytes[max_rollback_packet_size];
+    const size_t size = writeRollbackPacket(session, bytes);
+    CHECK(readRollbackPacket(session, bytes, size));
+    CHECK(!readRollbackPacket(session, bytes, size - 1));
+
+    bytes[0] = 'X';
+    CHECK(!readRollbackPacket(session, bytes, size));
+}
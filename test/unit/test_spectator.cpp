@@ -0,0 +1,237 @@
+#include <catch.hpp>
+
+#include <chrono>
+#include <net/spectator_server.h>
+#include <net/spectator_stream.h>
+#include <simulation/input_source.h>
+#include <thread>
+
+namespace {
+
+uint32_t nextRandom(uint32_t& state)
+{
+    state ^= state << 13;
+    state ^= state >> 17;
+    state ^= state << 5;
+    return state;
+}
+
+// Plays with random buttons and starts over when the game is lost, so the
+// stream goes through line clears, holds and game overs.
+void advanceGame(Game& game, uint32_t& random)
+{
+    if (game.over) {
+        game = makeGame(nextRandom(random));
+        return;
+    }
+    GameInput input = unpackGameInput(uint8_t(nextRandom(random)));
+    input.drop = nextRandom(random) % 16 == 0;
+    updateGame(game, input);
+}
+
+// Whether a spectator shows the same as the game, which is all the stream
+// carries.
+bool isDrawnAlike(const Game& expected, const Game& actual)
+{
+    for (int32_t y = 0; y < board_height; y++)
+    {
+        if (getRow(expected.board, y) != getRow(actual.board, y))
+            return false;
+    }
+    for (int32_t index = 0; index < preview_count; index++)
+    {
+        if (expected.previews[index] != actual.previews[index])
+            return false;
+    }
+    return expected.piece.type == actual.piece.type &&
+           expected.piece.rotation == actual.piece.rotation &&
+           expected.piece.x == actual.piece.x &&
+           expected.piece.y == actual.piece.y &&
+           expected.hasHold == actual.hasHold &&
+           (!expected.hasHold || expected.hold == actual.hold) &&
+           expected.score == actual.score &&
+           expected.lines == actual.lines &&
+           expected.level == actual.level &&
+           expected.tick == actual.tick &&
+           expected.over == actual.over;
+}
+
+// Publishes the next tick and lets the server and the spectators catch up,
+// in place of the threads of the game.
+void publishAndPoll(SpectatorServer& server,
+                    const Game& game,
+                    SpectatorClient* clients,
+                    int32_t clientCount)
+{
+    publishSpectatorGame(server, game);
+    REQUIRE(pollSpectatorServer(server, 0));
+    for (int32_t index = 0; index < clientCount; index++)
+    {
+        REQUIRE(readSpectatorClient(clients[index]));
+    }
+}
+
+// Loopback frames arrive right away, but not necessarily by the time the
+// server is done writing them.
+bool waitUntilAlike(SpectatorServer& server, const Game& game, SpectatorClient& client)
+{
+    for (int32_t attempt = 0; attempt < 1000; attempt++)
+    {
+        REQUIRE(pollSpectatorServer(server, 0));
+        REQUIRE(readSpectatorClient(client));
+        if (client.synced && isDrawnAlike(game, client.game))
+            return true;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+    return false;
+}
+
+void waitForSpectators(SpectatorServer& server, int32_t count)
+{
+    for (int32_t attempt = 0; attempt < 1000 && server.spectatorCount < count; attempt++)
+    {
+        REQUIRE(pollSpectatorServer(server, 1));
+    }
+    REQUIRE(server.spectatorCount == count);
+}
+
+}
+
+TEST_CASE("Spectator frames rebuild what is drawn")
+{
+    uint32_t random = 7;
+    Game game = makeGame(3);
+    uint8_t bytes[max_spectator_frame_size];
+    Game spectated = makeGame(0);
+    REQUIRE(applySpectatorFrame(spectated, bytes, encodeSpectatorKeyframe(game, bytes)));
+    CHECK(isDrawnAlike(game, spectated));
+
+    size_t totalSize = 0;
+    for (int32_t tick = 0; tick < 5000; tick++)
+    {
+        const Game previous = game;
+        advanceGame(game, random);
+        const size_t size = encodeSpectatorDelta(previous, game, bytes);
+        totalSize += size;
+        REQUIRE(applySpectatorFrame(spectated, bytes, size));
+        REQUIRE(isDrawnAlike(game, spectated));
+    }
+    // Most ticks only move the piece, if anything.
+    CHECK(totalSize < 5000 * (spectator_frame_header_size + 8));
+
+    CHECK(encodeSpectatorDelta(game, game, bytes) == spectator_frame_header_size);
+}
+
+TEST_CASE("Malformed spectator frames are rejected")
+{
+    Game game = makeGame(3);
+    setRow(game.board, 0, 0x1EF);
+    uint8_t bytes[max_spectator_frame_size];
+    const size_t size = encodeSpectatorKeyframe(game, bytes);
+    Game spectated = makeGame(0);
+
+    CHECK(!applySpectatorFrame(spectated, bytes, size - 1));
+    // The type of the piece, right after the rows.
+    bytes[spectator_frame_header_size + 4 + 2 * board_height] = piece_type_count;
+    CHECK(!applySpectatorFrame(spectated, bytes, size));
+    CHECK(getRow(spectated.board, 0) == 0);
+}
+
+TEST_CASE("Spectators follow a game over loopback")
+{
+    SpectatorServer server;
+    REQUIRE(openSpectatorServer(server, 0, 4));
+
+    constexpr int32_t client_count = 3;
+    SpectatorClient clients[client_count];
+    for (int32_t index = 0; index < client_count; index++)
+    {
+        REQUIRE(connectSpectatorClient(clients[index], makeLoopbackAddress(server.port)));
+    }
+    waitForSpectators(server, client_count);
+
+    uint32_t random = 11;
+    Game game = makeGame(5);
+    for (int32_t tick = 0; tick < 600; tick++)
+    {
+        advanceGame(game, random);
+        publishAndPoll(server, game, clients, client_count);
+    }
+    for (int32_t index = 0; index < client_count; index++)
+    {
+        CHECK(waitUntilAlike(server, game, clients[index]));
+        closeSpectatorClient(clients[index]);
+    }
+    CHECK(server.stats.resyncCount == 0);
+    // The clients got the same frames, each of them encoded once.
+    CHECK(server.stats.encodedCount <= 601);
+
+    for (int32_t attempt = 0; attempt < 1000 && server.spectatorCount > 0; attempt++)
+    {
+        REQUIRE(pollSpectatorServer(server, 1));
+    }
+    CHECK(server.spectatorCount == 0);
+    CHECK(server.stats.disconnectedCount == client_count);
+    closeSpectatorServer(server);
+}
+
+TEST_CASE("Spectators that fall behind are sent a keyframe")
+{
+    SpectatorServer server;
+    REQUIRE(openSpectatorServer(server, 0, 2));
+    SpectatorClient clients[2];
+    REQUIRE(connectSpectatorClient(clients[0], makeLoopbackAddress(server.port)));
+    REQUIRE(connectSpectatorClient(clients[1], makeLoopbackAddress(server.port)));
+    waitForSpectators(server, 2);
+
+    // The second spectator stops reading while every tick changes the whole
+    // board, until its socket and queue are full.
+    uint32_t random = 13;
+    Game game = makeGame(5);
+    for (int32_t tick = 0; tick < 100000 && server.stats.resyncCount == 0; tick++)
+    {
+        game.tick++;
+        for (int32_t y = 0; y < board_height; y++)
+        {
+            setRow(game.board, y, uint16_t(nextRandom(random) & 0x3FF));
+        }
+        publishAndPoll(server, game, clients, 1);
+    }
+    CHECK(server.stats.resyncCount > 0);
+    CHECK(isDrawnAlike(game, clients[0].game));
+
+    CHECK(waitUntilAlike(server, game, clients[1]));
+    CHECK(server.stats.resyncCount <= 2);
+
+    closeSpectatorClient(clients[1]);
+    closeSpectatorClient(clients[0]);
+    closeSpectatorServer(server);
+}
+
+TEST_CASE("Spectator servers run on their own thread")
+{
+    SpectatorServer server;
+    REQUIRE(openSpectatorServer(server, 0, 1));
+    startSpectatorServerThread(server);
+
+    SpectatorClient client;
+    REQUIRE(connectSpectatorClient(client, makeLoopbackAddress(server.port)));
+    Game game = makeGame(5);
+    uint32_t random = 17;
+    bool alike = false;
+    for (int32_t attempt = 0; attempt < 2000 && !alike; attempt++)
+    {
+        if (attempt < 120) {
+            advanceGame(game, random);
+            publishSpectatorGame(server, game);
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        REQUIRE(readSpectatorClient(client));
+        alike = attempt >= 120 && client.synced && isDrawnAlike(game, client.game);
+    }
+    CHECK(alike);
+
+    closeSpectatorClient(client);
+    stopSpectatorServerThread(server);
+    closeSpectatorServer(server);
+}
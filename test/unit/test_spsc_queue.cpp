@@ -0,0 +1,59 @@
+#include <catch.hpp>
+
+#include <thread>
+#include <util/spsc_queue.h>
+
+TEST_CASE("SpscQueues return elements in order")
+{
+    static SpscQueue<int, 4> queue;
+
+    CHECK(tryPush(queue, 2));
+    CHECK(tryPush(queue, 9));
+
+    int elem = 0;
+    REQUIRE(tryPop(queue, elem));
+    CHECK(elem == 2);
+    REQUIRE(tryPop(queue, elem));
+    CHECK(elem == 9);
+    CHECK(!tryPop(queue, elem));
+}
+
+TEST_CASE("SpscQueues reject elements when full")
+{
+    static SpscQueue<int, 4> queue;
+
+    for (int index = 0; index < 4; index++)
+    {
+        REQUIRE(tryPush(queue, index));
+    }
+    CHECK(!tryPush(queue, 4));
+
+    int elem = 0;
+    REQUIRE(tryPop(queue, elem));
+    CHECK(elem == 0);
+    CHECK(tryPush(queue, 4));
+}
+
+TEST_CASE("SpscQueues hand elements between threads")
+{
+    static SpscQueue<int, 16> queue;
+    constexpr int elem_count = 100000;
+
+    std::thread producer([]() {
+        for (int index = 0; index < elem_count; index++)
+        {
+            while (!tryPush(queue, index));
+        }
+    });
+
+    bool inOrder = true;
+    for (int expected = 0; expected < elem_count; expected++)
+    {
+        int elem;
+        while (!tryPop(queue, elem));
+        inOrder = inOrder && elem == expected;
+    }
+    producer.join();
+
+    CHECK(inOrder);
+}
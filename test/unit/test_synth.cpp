@@ -0,0 +1,152 @@
+#include <catch.hpp>
+
+#include <cmath>
+#include <cstdlib>
+#include <synth/kernel.h>
+#include <synth/oscillator.h>
+
+namespace {
+
+constexpr uint32_t sample_rate = 48000;
+
+Wavetable sineTable;
+Wavetable squareTable;
+
+const Wavetable& getSineTable()
+{
+    if (sineTable.sampleRate == 0)
+        initWavetable(sineTable, Waveform::Sine, sample_rate);
+    return sineTable;
+}
+
+const Wavetable& getSquareTable()
+{
+    if (squareTable.sampleRate == 0)
+        initWavetable(squareTable, Waveform::Square, sample_rate);
+    return squareTable;
+}
+
+Envelope makeHeldEnvelope()
+{
+    Envelope envelope = makeEnvelope(0, 0, 1, 0, sample_rate);
+    noteOn(envelope);
+    return envelope;
+}
+
+}
+
+TEST_CASE("Sine wavetables contain a sine")
+{
+    const Wavetable& wavetable = getSineTable();
+
+    for (int32_t index = 0; index < wavetable_size; index += 64)
+    {
+        const float expected = sinf(6.2831853f * index / wavetable_size);
+        CHECK(wavetable.levels[0][index] == Approx(expected).margin(1e-5));
+    }
+    CHECK(wavetable.levels[0][wavetable_size] == wavetable.levels[0][0]);
+}
+
+TEST_CASE("Higher wavetable levels have fewer harmonics")
+{
+    const Wavetable& wavetable = getSquareTable();
+
+    // The top level is only left with the fundamental.
+    const float* top = wavetable.levels[wavetable_level_count - 1];
+    for (int32_t index = 0; index < wavetable_size; index += 64)
+    {
+        const float expected = sinf(6.2831853f * index / wavetable_size);
+        CHECK(top[index] == Approx(expected).margin(1e-5));
+    }
+    CHECK(getWavetableLevel(wavetable, 30) == wavetable.levels[0]);
+    CHECK(getWavetableLevel(wavetable, 100) == wavetable.levels[2]);
+}
+
+TEST_CASE("Oscillators play frequencies that do not divide the sample rate")
+{
+    Oscillator oscillator = makeOscillator(getSineTable(), 441, 0.5f);
+    Envelope envelope = makeHeldEnvelope();
+    static int16_t samples[sample_rate];
+
+    renderTone(oscillator, envelope, samples, sample_rate);
+
+    int32_t rises = 0;
+    for (uint32_t index = 1; index < sample_rate; index++)
+    {
+        if (samples[index - 1] < 0 && samples[index] >= 0)
+            rises++;
+    }
+    // The rise at the very first sample has no sample before it.
+    CHECK(rises == 440);
+}
+
+TEST_CASE("All synth kernels produce the same samples")
+{
+    const SynthKernel original = getSynthKernel();
+    constexpr int32_t sample_count = 1001;
+    int16_t reference[sample_count];
+    int16_t samples[sample_count];
+
+    Oscillator oscillator = makeOscillator(getSineTable(), 523.25f, 0.8f);
+    Envelope envelope = makeEnvelope(0.005f, 0.005f, 0.5f, 0.01f, sample_rate);
+    noteOn(envelope);
+    setSynthKernel(SynthKernel::Scalar);
+    renderTone(oscillator, envelope, reference, sample_count);
+
+    for (SynthKernel kernel : { SynthKernel::Sse2, SynthKernel::Avx2 })
+    {
+        if (!isSynthKernelSupported(kernel))
+            continue;
+
+        oscillator = makeOscillator(getSineTable(), 523.25f, 0.8f);
+        envelope = makeEnvelope(0.005f, 0.005f, 0.5f, 0.01f, sample_rate);
+        noteOn(envelope);
+        setSynthKernel(kernel);
+        renderTone(oscillator, envelope, samples, sample_count);
+
+        int32_t maxDifference = 0;
+        for (int32_t index = 0; index < sample_count; index++)
+        {
+            const int32_t difference = abs(samples[index] - reference[index]);
+            maxDifference = difference > maxDifference ? difference : maxDifference;
+        }
+        CHECK(maxDifference <= 2);
+    }
+
+    setSynthKernel(original);
+}
+
+TEST_CASE("Envelopes go through all stages")
+{
+    Envelope envelope = makeEnvelope(0.001f, 0.001f, 0.5f, 0.001f, 1000);
+    CHECK(!isActive(envelope));
+
+    noteOn(envelope);
+    advanceEnvelope(envelope, 1);
+    CHECK(envelope.stage == EnvelopeStage::Decay);
+    CHECK(envelope.level == 1);
+
+    advanceEnvelope(envelope, 1);
+    CHECK(envelope.stage == EnvelopeStage::Sustain);
+    CHECK(envelope.level == 0.5f);
+
+    noteOff(envelope);
+    advanceEnvelope(envelope, 1);
+    CHECK(envelope.stage == EnvelopeStage::Idle);
+    CHECK(envelope.level == 0);
+}
+
+TEST_CASE("Envelope segments end where stages end")
+{
+    Envelope envelope = makeEnvelope(0.01f, 0.01f, 0.5f, 0.01f, 1000);
+    noteOn(envelope);
+
+    float step;
+    CHECK(getEnvelopeSegment(envelope, 100, step) == 10);
+    CHECK(step == Approx(0.1f));
+    CHECK(getEnvelopeSegment(envelope, 4, step) == 4);
+
+    advanceEnvelope(envelope, 10);
+    CHECK(envelope.stage == EnvelopeStage::Decay);
+    CHECK(getEnvelopeSegment(envelope, 100, step) == 5);
+}
@@ -0,0 +1,67 @@
+#include <atomic>
+#include <catch.hpp>
+
+#include <util/task_pool.h>
+
+namespace {
+
+struct CountTask
+{
+    TaskPool* pool;
+    std::atomic<int32_t>* count;
+    // Tasks push two more tasks with one less depth, down to 0.
+    int32_t depth;
+};
+
+CountTask countTasks[1 << 12];
+std::atomic<int32_t> nextCountTask;
+
+void runCountTask(void* data, int32_t worker)
+{
+    const CountTask& task = *static_cast<const CountTask*>(data);
+    task.count->fetch_add(1, std::memory_order_relaxed);
+    if (task.depth == 0)
+        return;
+
+    for (int32_t child = 0; child < 2; child++)
+    {
+        CountTask& childTask = countTasks[nextCountTask.fetch_add(1)];
+        childTask = CountTask{ task.pool, task.count, task.depth - 1 };
+        pushTask(*task.pool, worker, Task{ runCountTask, &childTask });
+    }
+}
+
+}
+
+TEST_CASE("Task pools run every task and the tasks they push")
+{
+    static TaskPool pool;
+    initTaskPool(pool, 4, 1 << 12);
+
+    for (int32_t run = 0; run < 3; run++)
+    {
+        std::atomic<int32_t> count(0);
+        nextCountTask = 1;
+        countTasks[0] = CountTask{ &pool, &count, 10 };
+        pushTask(pool, 0, Task{ runCountTask, &countTasks[0] });
+        runTasks(pool);
+        CHECK(count.load() == (1 << 11) - 1);
+    }
+
+    destroyTaskPool(pool);
+}
+
+TEST_CASE("Task pools with a single thread run the tasks themselves")
+{
+    static TaskPool pool;
+    initTaskPool(pool, 1, 16);
+
+    std::atomic<int32_t> count(0);
+    nextCountTask = 1;
+    countTasks[0] = CountTask{ &pool, &count, 2 };
+    pushTask(pool, 0, Task{ runCountTask, &countTasks[0] });
+    runTasks(pool);
+    CHECK(count.load() == 7);
+
+    destroyTaskPool(pool);
+}
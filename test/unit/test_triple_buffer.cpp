@@ -0,0 +1,78 @@
+#include <catch.hpp>
+
+#include <cstdint>
+#include <thread>
+#include <util/triple_buffer.h>
+
+namespace {
+
+// Large enough that a torn copy would show up as mismatched values.
+struct Frame
+{
+    uint64_t values[64];
+};
+
+}
+
+TEST_CASE("TripleBuffers hand over the newest value")
+{
+    static TripleBuffer<int> buffer;
+
+    CHECK(!acquireFrontBuffer(buffer));
+
+    getBackBuffer(buffer) = 1;
+    publishBackBuffer(buffer);
+    getBackBuffer(buffer) = 2;
+    publishBackBuffer(buffer);
+
+    REQUIRE(acquireFrontBuffer(buffer));
+    CHECK(getFrontBuffer(buffer) == 2);
+    CHECK(!acquireFrontBuffer(buffer));
+    CHECK(getFrontBuffer(buffer) == 2);
+
+    getBackBuffer(buffer) = 3;
+    publishBackBuffer(buffer);
+    REQUIRE(acquireFrontBuffer(buffer));
+    CHECK(getFrontBuffer(buffer) == 3);
+}
+
+TEST_CASE("TripleBuffers hand whole values between threads")
+{
+    static TripleBuffer<Frame> buffer;
+    constexpr uint64_t frame_count = 100000;
+
+    std::thread producer([]() {
+        for (uint64_t frame = 1; frame <= frame_count; frame++)
+        {
+            Frame& back = getBackBuffer(buffer);
+            for (uint64_t& value : back.values)
+            {
+                value = frame;
+            }
+            publishBackBuffer(buffer);
+        }
+    });
+
+    bool whole = true;
+    bool increasing = true;
+    uint64_t last = 0;
+    while (last < frame_count)
+    {
+        if (!acquireFrontBuffer(buffer)) {
+            std::this_thread::yield();
+            continue;
+        }
+
+        const Frame& front = getFrontBuffer(buffer);
+        for (uint64_t value : front.values)
+        {
+            whole = whole && value == front.values[0];
+        }
+        increasing = increasing && front.values[0] > last;
+        last = front.values[0];
+    }
+    producer.join();
+
+    CHECK(whole);
+    CHECK(increasing);
+}
@@ -0,0 +1,104 @@
+#include <catch.hpp>
+
+#include <board/board.h>
+#include <simulation/game.h>
+#include <simulation/versus.h>
+
+namespace {
+
+// An O dropped from its spawn column fills columns 4 and 5 of the bottom
+// two rows.
+constexpr uint16_t row_missing_o = 0b1111001111;
+
+GameInput makeDropInput()
+{
+    GameInput input = {};
+    input.drop = true;
+    return input;
+}
+
+// Sets up the first player to clear two lines with a hard drop.
+void prepareDoubleClear(VersusGame& game)
+{
+    Game& player = game.players[0];
+    player.piece.type = PieceType::O;
+    setRow(player.board, 0, row_missing_o);
+    setRow(player.board, 1, row_missing_o);
+}
+
+}
+
+TEST_CASE("Clearing lines in versus sends garbage to the other player")
+{
+    VersusGame game = makeVersusGame(3);
+    prepareDoubleClear(game);
+
+    const GameInput drop = makeDropInput();
+    const GameInput none = {};
+    const GameInput firstDrops[versus_player_count] = { drop, none };
+    updateVersusGame(game, firstDrops);
+    CHECK(game.players[0].clearedLines == 2);
+    CHECK(game.pendingGarbage[1] == 1);
+    CHECK(getRow(game.players[1].board, 0) == 0);
+
+    // The garbage waits until the next piece of the receiver locks.
+    const GameInput neither[versus_player_count] = { none, none };
+    updateVersusGame(game, neither);
+    CHECK(game.pendingGarbage[1] == 1);
+
+    const GameInput secondDrops[versus_player_count] = { none, drop };
+    updateVersusGame(game, secondDrops);
+    CHECK(game.pendingGarbage[1] == 0);
+    const uint16_t garbage = getRow(game.players[1].board, 0);
+    CHECK(__builtin_popcount(garbage) == board_width - 1);
+    CHECK(getRow(game.players[1].board, 1) != 0);
+    CHECK(!game.over);
+}
+
+TEST_CASE("Clearing lines cancels the garbage waiting for the player")
+{
+    VersusGame game = makeVersusGame(3);
+    prepareDoubleClear(game);
+    game.pendingGarbage[0] = 3;
+
+    const GameInput inputs[versus_player_count] = { makeDropInput(), GameInput{} };
+    updateVersusGame(game, inputs);
+
+    CHECK(game.pendingGarbage[0] == 2);
+    CHECK(game.pendingGarbage[1] == 0);
+}
+
+TEST_CASE("A versus match is over once a player tops out")
+{
+    // A flat I locks in the row every piece spawns into.
+    VersusGame game = makeVersusGame(5);
+    game.players[1].piece.type = PieceType::I;
+    for (int32_t y = 0; y < piece_spawn_y + 2; y++)
+    {
+        setRow(game.players[1].board, y, 0b1111111110);
+    }
+
+    const GameInput inputs[versus_player_count] = { GameInput{}, makeDropInput() };
+    updateVersusGame(game, inputs);
+
+    CHECK(game.over);
+    CHECK(game.winner == 0);
+    const uint32_t checksum = getVersusChecksum(game);
+    updateVersusGame(game, inputs);
+    CHECK(getVersusChecksum(game) == checksum);
+}
+
+TEST_CASE("Versus checksums follow the match")
+{
+    VersusGame game = makeVersusGame(7);
+    VersusGame copy = game;
+    CHECK(getVersusChecksum(copy) == getVersusChecksum(game));
+
+    GameInput left = {};
+    left.left = true;
+    const GameInput first[versus_player_count] = { left, GameInput{} };
+    const GameInput second[versus_player_count] = { GameInput{}, left };
+    updateVersusGame(game, first);
+    updateVersusGame(copy, second);
+    CHECK(getVersusChecksum(copy) != getVersusChecksum(game));
+}